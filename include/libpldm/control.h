@@ -1,5 +1,9 @@
 #pragma once
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #include <libpldm/pldm.h>
 #include <libpldm/base.h>
 #include <libpldm/utils.h>
@@ -14,6 +18,46 @@ enum pldm_control_completion_codes {
 // Static storage can be allocated with PLDM_SIZEOF_CONTROL macro */
 struct pldm_control;
 
+/** @brief Handler for a message of a registered PLDM type and command
+ *
+ * @param[in] ctx - the ctx pointer provided to pldm_control_register_type()
+ * @param[in] tid - the source TID of the message
+ * @param[in] hdr - the unpacked header of msg
+ * @param[in] msg - the PLDM message
+ * @param[in] payload_len - length of the payload of msg
+ * @param[out] resp - PLDM response message buffer, of which the handler
+ * 		      encodes the header and payload
+ * @param[inout] resp_payload_len - space available for the response payload,
+ *				    at least 1 byte for a completion code.
+ *				    Updated with the length written, or 0 if
+ *				    there's no response to send.
+ *
+ * @return 0 on success, a negative errno value on failure.
+ */
+typedef int (*pldm_control_handler_fn)(void *ctx, pldm_tid_t tid,
+				       const struct pldm_header_info *hdr,
+				       const struct pldm_msg *msg,
+				       size_t payload_len,
+				       struct pldm_msg *resp,
+				       size_t *resp_payload_len);
+
+/** @struct pldm_control_handler
+ *
+ * An entry in the handler table of a PLDM type.
+ *
+ * @var command - the PLDM command
+ * @var request - handler for requests, or NULL. Commands with a request
+ *		  handler are reported by GetPLDMCommands.
+ * @var response - handler for responses to requests of the command sent by
+ *		   the application, or NULL. Responses never produce a
+ *		   response.
+ */
+struct pldm_control_handler {
+	uint8_t command;
+	pldm_control_handler_fn request;
+	pldm_control_handler_fn response;
+};
+
 /** @brief Handle a PLDM Control message
  *
  * @param[in] control
@@ -58,3 +102,59 @@ int pldm_control_setup(struct pldm_control *control, size_t pldm_control_size);
 int pldm_control_add_type(struct pldm_control *control, uint8_t pldm_type,
 			  const void *versions, size_t versions_count,
 			  const bitfield8_t *commands);
+
+/** @brief Register handlers for a PLDM type
+ *
+ * The type is reported by GetPLDMTypes and GetPLDMVersion, and the commands
+ * with request handlers by GetPLDMCommands, as for pldm_control_add_type().
+ * The CRC32 for GetPLDMVersion and the command bitmap are generated from the
+ * arguments. Registering a type again replaces its handlers, and registering
+ * PLDM_BASE replaces the built-in control handlers.
+ *
+ * @param[in] control
+ * @param[in] pldm_type - PLDM type, enum pldm_supported_types
+ * @param[in] versions - the versions of the type, without a CRC32. Copied.
+ * @param[in] versions_count - number of entries in versions, from 1 to 4
+ * @param[in] handlers - handler table, with at most one entry per command.
+ *			 The table must remain present for the duration of
+ *			 the pldm_control's lifetime.
+ * @param[in] handlers_count - number of entries in handlers
+ * @param[in] ctx - passed to the handlers
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, or -ENOMEM if
+ *	   there are no spare type slots.
+ */
+int pldm_control_register_type(struct pldm_control *control, uint8_t pldm_type,
+			       const ver32_t *versions, size_t versions_count,
+			       const struct pldm_control_handler *handlers,
+			       size_t handlers_count, void *ctx);
+
+/** @brief Dispatch a message to the handler registered for its type and command
+ *
+ * Requests of a type that is not known are answered with
+ * PLDM_ERROR_INVALID_PLDM_TYPE, and requests for a command without a handler
+ * with PLDM_ERROR_UNSUPPORTED_PLDM_CMD. Messages of a type added by
+ * pldm_control_add_type() have no handlers, so they are left to the
+ * application: -ENOMSG is returned without a response.
+ *
+ * @param[in] control
+ * @param[in] tid - source TID of the message
+ * @param[in] msg - PLDM incoming message
+ * @param[in] msg_len - length of msg
+ * @param[out] resp_msg - PLDM outgoing response message buffer
+ * @param[inout] resp_len - length of available resp_msg buffer, will be updated
+ *                         with the length written to resp_msg.
+ *
+ * @return 0 on success, -ENOMSG for a response without a handler or a message
+ *	   of a type added by pldm_control_add_type(), or another negative errno
+ *	   value on failure.
+ *
+ * Will provide a response to send when resp_len > 0 and returning 0.
+ */
+int pldm_control_dispatch(struct pldm_control *control, pldm_tid_t tid,
+			  const void *msg, size_t msg_len, void *resp_msg,
+			  size_t *resp_len);
+
+#ifdef __cplusplus
+}
+#endif
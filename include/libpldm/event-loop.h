@@ -0,0 +1,228 @@
+/* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#ifndef EVENT_LOOP_PLDM_H
+#define EVENT_LOOP_PLDM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <libpldm/base.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct pldm_requester;
+struct pldm_transport;
+
+/**
+ * @brief Event loop over several transports and timers
+ *
+ * All sources are waited on with a single epoll instance, and received
+ * messages are dispatched to handlers registered for their PLDM type.
+ */
+struct pldm_event_loop;
+
+/**
+ * @brief A timer registered with an event loop
+ */
+struct pldm_event_loop_timer;
+
+/**
+ * @brief Handler for messages of a PLDM type
+ *
+ * @param[in] data - the data pointer provided to
+ * 	      pldm_event_loop_set_handler()
+ * @param[in] transport - the transport on which the message was received, for
+ * 	      use in sending a response
+ * @param[in] tid - the source TID of the message
+ * @param[in] msg - the received message. Only valid for the duration of the
+ * 	      call
+ * @param[in] msg_len - the length of msg
+ */
+typedef void (*pldm_event_loop_msg_handler)(void *data,
+					    struct pldm_transport *transport,
+					    pldm_tid_t tid, const void *msg,
+					    size_t msg_len);
+
+/**
+ * @brief Callback for the expiry of a timer
+ *
+ * @param[in] data - the data pointer provided to pldm_event_loop_add_timer()
+ * @param[in] timer - the timer that expired
+ */
+typedef void (*pldm_event_loop_timer_cb)(void *data,
+					 struct pldm_event_loop_timer *timer);
+
+/**
+ * @brief Callback for the removal of a transport after a hang-up
+ *
+ * @param[in] data - the data pointer provided to
+ * 	      pldm_event_loop_set_hangup_handler()
+ * @param[in] transport - the transport, which is no longer registered with the
+ * 	      event loop and may be destroyed
+ */
+typedef void (*pldm_event_loop_hangup_cb)(void *data,
+					  struct pldm_transport *transport);
+
+/**
+ * @brief Instantiate an event loop
+ *
+ * @param[out] ctx - *ctx must be NULL, and will point to the event loop on
+ * 	       success
+ *
+ * @return 0 on success, -EINVAL if ctx is invalid, -ENOMEM if memory couldn't
+ * 	   be allocated, or a negative errno value if the epoll instance
+ * 	   couldn't be created
+ */
+int pldm_event_loop_init(struct pldm_event_loop **ctx);
+
+/**
+ * @brief Destroy an event loop and its timers
+ *
+ * Registered transports and requesters are not destroyed.
+ *
+ * @param[in] ctx - the event loop to destroy. May be NULL
+ */
+void pldm_event_loop_destroy(struct pldm_event_loop *ctx);
+
+/**
+ * @brief Register a transport with the event loop
+ *
+ * @param[in] ctx - the event loop
+ * @param[in] transport - the transport to wait on. It must provide a file
+ * 	      descriptor through its init_pollfd operation
+ * @param[in] requester - an asynchronous requester using the transport, or
+ * 	      NULL. Responses to its requests are passed to it rather than to
+ * 	      the type handlers, and its timeouts are enforced by the loop
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, -EEXIST if the
+ * 	   transport is already registered, -ENOTSUP if the transport can't be
+ * 	   polled, -ENOMEM if memory couldn't be allocated, or a negative errno
+ * 	   value if the transport couldn't be added to the epoll instance
+ */
+int pldm_event_loop_add_transport(struct pldm_event_loop *ctx,
+				  struct pldm_transport *transport,
+				  struct pldm_requester *requester);
+
+/**
+ * @brief Unregister a transport from the event loop
+ *
+ * May be called from a handler or timer callback.
+ *
+ * @param[in] ctx - the event loop
+ * @param[in] transport - the transport to remove
+ *
+ * @return 0 on success, -EINVAL if ctx is NULL, or -ENOENT if the transport
+ * 	   is not registered
+ */
+int pldm_event_loop_remove_transport(struct pldm_event_loop *ctx,
+				     struct pldm_transport *transport);
+
+/**
+ * @brief Set the handler for messages of a PLDM type
+ *
+ * Messages of types without a handler are discarded.
+ *
+ * @param[in] ctx - the event loop
+ * @param[in] type - the PLDM type
+ * @param[in] handler - the handler, or NULL to remove the current handler
+ * @param[in] data - an opaque pointer passed to handler
+ *
+ * @return 0 on success, or -EINVAL if the arguments are invalid
+ */
+int pldm_event_loop_set_handler(struct pldm_event_loop *ctx, uint8_t type,
+				pldm_event_loop_msg_handler handler,
+				void *data);
+
+/**
+ * @brief Set the callback for transports removed after a hang-up
+ *
+ * @param[in] ctx - the event loop
+ * @param[in] cb - the callback, or NULL to remove the current callback
+ * @param[in] data - an opaque pointer passed to cb
+ *
+ * @return 0 on success, or -EINVAL if ctx is NULL
+ */
+int pldm_event_loop_set_hangup_handler(struct pldm_event_loop *ctx,
+				       pldm_event_loop_hangup_cb cb,
+				       void *data);
+
+/**
+ * @brief Add a timer to the event loop
+ *
+ * @param[in] ctx - the event loop
+ * @param[in] initial_ms - the time until the first expiry, in milliseconds.
+ * 	      Must be greater than zero
+ * @param[in] interval_ms - the period of subsequent expiries, in milliseconds,
+ * 	      or zero for a timer that expires once
+ * @param[in] cb - the callback to invoke on expiry
+ * @param[in] data - an opaque pointer passed to cb
+ * @param[out] timer - the new timer
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, -ENOMEM if memory
+ * 	   couldn't be allocated, or a negative errno value if the timer couldn't
+ * 	   be created
+ */
+int pldm_event_loop_add_timer(struct pldm_event_loop *ctx, uint32_t initial_ms,
+			      uint32_t interval_ms, pldm_event_loop_timer_cb cb,
+			      void *data, struct pldm_event_loop_timer **timer);
+
+/**
+ * @brief Remove a timer from the event loop and destroy it
+ *
+ * Timers that expire once are not removed automatically. May be called from a
+ * handler or timer callback.
+ *
+ * @param[in] ctx - the event loop
+ * @param[in] timer - the timer to remove
+ *
+ * @return 0 on success, or -EINVAL if the arguments are invalid
+ */
+int pldm_event_loop_remove_timer(struct pldm_event_loop *ctx,
+				 struct pldm_event_loop_timer *timer);
+
+/**
+ * @brief Wait for and dispatch one round of events
+ *
+ * Receives one message from each ready transport, invokes the callbacks of
+ * expired timers, and enforces the timeouts of registered requesters.
+ *
+ * A transport whose file descriptor reports a hang-up is unregistered, as if
+ * by pldm_event_loop_remove_transport(), once its pending messages are
+ * received or receiving fails. The same applies to an error on a file
+ * descriptor other than a socket. A pending socket error is cleared and the
+ * transport remains registered. The hang-up callback is invoked for each
+ * transport that is unregistered.
+ *
+ * @param[in] ctx - the event loop
+ * @param[in] timeout_ms - the maximum time to wait, in milliseconds. Zero
+ * 	      returns immediately and a negative value waits indefinitely
+ *
+ * @return The number of events dispatched, -EINVAL if ctx is NULL, or a
+ * 	   negative errno value if waiting failed
+ */
+int pldm_event_loop_run_once(struct pldm_event_loop *ctx, int timeout_ms);
+
+/**
+ * @brief Dispatch events until pldm_event_loop_stop() is called
+ *
+ * @param[in] ctx - the event loop
+ *
+ * @return 0 once stopped, -EINVAL if ctx is NULL, or a negative errno value if
+ * 	   waiting failed
+ */
+int pldm_event_loop_run(struct pldm_event_loop *ctx);
+
+/**
+ * @brief Make pldm_event_loop_run() return once the current round of events is
+ * 	  dispatched
+ *
+ * @param[in] ctx - the event loop
+ */
+void pldm_event_loop_stop(struct pldm_event_loop *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EVENT_LOOP_PLDM_H */
@@ -125,9 +125,11 @@ struct pldm_fd_ops {
 	 *  @param[in] ctx - callback context
 	 *  @param[in] ua_max_transfer_size - size requested by the UA.
 	 *
-	 *  @return The transfer size to use. This will be clamped to
+	 *  @return The maximum transfer size to use. This will be clamped to
 	 *  32 <= size <= ua_max_transfer_size.
-	 *  The final data chunk may be shorter.
+	 *  The final data chunk may be shorter. Requests are shortened
+	 *  while the UA asks for retries or responses go missing, and grow
+	 *  back to this size as responses arrive in good time.
 	 */
 	uint32_t (*transfer_size)(void *ctx, uint32_t ua_max_transfer_size);
 
@@ -145,6 +147,10 @@ struct pldm_fd_ops {
 	 *
 	 * PLDM_FWUP_TRANSFER_SUCCESS will accept the data chunk, other codes will
 	 * abort the transfer, returning that code as TransferComplete
+	 *
+	 * Chunks are provided in offset order, unless a request window larger
+	 * than one is set with pldm_fd_set_request_window(). Each chunk is then
+	 * provided exactly once, in the order the UA's responses arrive.
 	 */
 	uint8_t (*firmware_data)(
 		void *ctx, uint32_t offset, const uint8_t *data, uint32_t len,
@@ -233,6 +239,9 @@ struct pldm_fd_ops {
 	uint64_t (*now)(void *ctx);
 };
 
+/* Most RequestFirmwareData requests that may be outstanding at once */
+#define PLDM_FD_REQUEST_WINDOW_MAX 8
+
 /* Static storage can be allocated with
  * PLDM_SIZEOF_PLDM_FD macro */
 #define PLDM_ALIGNOF_PLDM_FD 8
@@ -246,7 +255,9 @@ struct pldm_fd;
  *                      to ops callbacks
  * @param[in] control - an optional struct pldm_control. If provided
  *                      the FD responder will set PLDM FW update type
- *			and commands for the control.
+ *			and commands for the control, and
+ *			pldm_control_dispatch() will pass PLDM FW update
+ *			messages to pldm_fd_handle_msg().
  *
  * @return a malloced struct pldm_fd, owned by the caller. It should be released
  *         with free(). Returns NULL on failure.
@@ -268,7 +279,9 @@ struct pldm_fd *pldm_fd_new(const struct pldm_fd_ops *ops, void *ops_ctx,
  *                      to ops callbacks
  * @param[in] control - an optional struct pldm_control. If provided
  *                      the FD responder will set PLDM FW update type
- *			and commands for the control.
+ *			and commands for the control, and
+ *			pldm_control_dispatch() will pass PLDM FW update
+ *			messages to pldm_fd_handle_msg().
  *
  * @return 0 on success, a negative errno value on failure.
  */
@@ -312,10 +325,29 @@ int pldm_fd_handle_msg(struct pldm_fd *fd, pldm_tid_t remote_address,
  *
  * This could be called periodically by the application to send retries
  * during an update flow. A 1 second interval is recommended.
+ *
+ * At most one message is returned per call. With a request window set by
+ * pldm_fd_set_request_window(), the application should call pldm_fd_progress()
+ * until it returns no message, to fill the window.
  */
 int pldm_fd_progress(struct pldm_fd *fd, void *out_msg, size_t *out_len,
 		     pldm_tid_t *remote_address);
 
+/** @brief Find when pldm_fd_progress() next has work to do
+ *
+ * @param[in] fd
+ * @param[out] deadline - the time, on the clock of the now() callback, at or
+ *                        after which pldm_fd_progress() should be called
+ *
+ * @return 0 on success, -ENODATA if pldm_fd_progress() has nothing to do until
+ *         a message is handled, or a negative errno value on failure.
+ *
+ * Lets applications schedule pldm_fd_progress() with a timer, such as one of a
+ * struct pldm_timer_wheel, instead of calling it periodically. The deadline
+ * may change whenever a message is handled or progress is made.
+ */
+int pldm_fd_next_deadline(struct pldm_fd *fd, uint64_t *deadline);
+
 /** @brief Set update mode idle timeout
  *
  * @param[in] fd
@@ -345,6 +377,54 @@ int pldm_fd_set_update_idle_timeout(struct pldm_fd *fd, uint32_t time);
  */
 int pldm_fd_set_request_retry_time(struct pldm_fd *fd, uint32_t time);
 
+/** @brief Set the number of RequestFirmwareData requests kept in flight
+ *
+ * @param[in] fd
+ * @param[in] window - Requests that may be outstanding at once during a
+ *                     download, from 1 to PLDM_FD_REQUEST_WINDOW_MAX. The
+ *                     initial default is 1.
+ *
+ * A window larger than one hides the round trip to the UA behind the requests
+ * for further chunks, at the cost of the firmware_data callback receiving
+ * chunks out of offset order. Each chunk is retried separately after FD_T2.
+ * A smaller window takes effect as outstanding requests complete.
+ *
+ * @return 0 on success, a negative errno value on failure.
+ */
+int pldm_fd_set_request_window(struct pldm_fd *fd, uint8_t window);
+
+/** @struct pldm_fd_transfer_stats
+ *
+ *  Progress of the firmware data download for the current or last component,
+ *  from pldm_fd_get_transfer_stats().
+ */
+struct pldm_fd_transfer_stats {
+	/* Length of RequestFirmwareData requests being sent, in bytes */
+	uint32_t transfer_size;
+	/* Bytes passed to the firmware_data callback */
+	uint32_t received;
+	/* Requests that timed out, were answered with a retry or had a
+	 * response of the wrong length */
+	uint32_t failures;
+	/* Smoothed RequestFirmwareData response time, in milliseconds */
+	uint32_t response_time;
+	/* Bytes received per second, from the first request until the
+	 * download finished or now */
+	uint32_t bytes_per_sec;
+};
+
+/** @brief Get the firmware data download statistics
+ *
+ * @param[in] fd
+ * @param[out] stats - statistics for the component being downloaded, or the
+ *                     last one downloaded
+ *
+ * @return 0 on success, -ENODATA if no firmware data has been requested for
+ *         the component, or a negative errno value on failure.
+ */
+int pldm_fd_get_transfer_stats(struct pldm_fd *fd,
+			       struct pldm_fd_transfer_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif
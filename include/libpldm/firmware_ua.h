@@ -0,0 +1,222 @@
+/* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <libpldm/pldm.h>
+#include <libpldm/base.h>
+#include <libpldm/firmware_update.h>
+
+/** @struct pldm_ua_package
+ *
+ *  A parsed PLDM firmware update package. Component images are served from
+ *  the package data in place, so one package can be shared by any number of
+ *  updates running at the same time, on one or more struct pldm_ua.
+ */
+struct pldm_ua_package;
+
+/** @struct pldm_ua
+ *
+ *  An Update Agent, driving updates of firmware devices (FDs) from packages.
+ */
+struct pldm_ua;
+
+/** @brief Parse a firmware update package
+ *
+ * @param[out] pkg - the parsed package, to be freed with
+ *                   pldm_ua_package_destroy()
+ * @param[in] data - the package data. Must remain valid and unchanged until
+ *                   the package is destroyed.
+ * @param[in] len - length of data
+ *
+ * @return 0 on success, -EBADMSG if the package is malformed or its header
+ *         checksum doesn't match, -EOVERFLOW if it is truncated, -ENOTSUP for
+ *         package header formats other than revision 1, -ENOMEM or -EINVAL.
+ */
+int pldm_ua_package_init(struct pldm_ua_package **pkg, const void *data,
+			 size_t len);
+
+/** @brief Free a package
+ *
+ * @param[in] pkg - the package. No update may still be using it.
+ */
+void pldm_ua_package_destroy(struct pldm_ua_package *pkg);
+
+/** @brief Find the firmware device ID record for a device
+ *
+ * @param[in] pkg - the package
+ * @param[in] descriptors - the device's descriptors, from
+ *                          QueryDeviceIdentifiers
+ * @param[in] count - number of descriptors
+ * @param[out] record - index of the first record with all its descriptors
+ *                      among those of the device
+ *
+ * @return 0 on success, -ENOENT if no record matches, or -EINVAL.
+ */
+int pldm_ua_package_match(const struct pldm_ua_package *pkg,
+			  const struct pldm_descriptor *descriptors,
+			  size_t count, size_t *record);
+
+/** @struct pldm_ua_ops
+ *
+ *  Callbacks from the UA to the application.
+ */
+struct pldm_ua_ops {
+	/** @brief Report the end of an update started with pldm_ua_start()
+	 *
+	 *  @param[in] ctx - callback context
+	 *  @param[in] address - the FD that was updated
+	 *  @param[in] result - 0 once the FD has accepted ActivateFirmware,
+	 *                      else a negative errno value: -ECANCELED after
+	 *                      pldm_ua_cancel(), -ETIMEDOUT if the FD stopped
+	 *                      responding, -EALREADY if the FD declined every
+	 *                      component, -EIO if the FD reported a failure,
+	 *                      -EPROTO if it refused a request.
+	 *
+	 *  The address may be used for a new update from within the callback.
+	 */
+	void (*update_complete)(void *ctx, pldm_tid_t address, int result);
+
+	/** @brief Provide a monotonic timestamp in milliseconds
+	 *
+	 *  @param[in] ctx - callback context
+	 */
+	uint64_t (*now)(void *ctx);
+};
+
+/** @brief Allocate a UA
+ *
+ * @param[in] ops - callbacks, must remain valid while the UA is in use
+ * @param[in] ops_ctx - context passed to the callbacks
+ * @param[in] max_devices - number of FDs that can be updated at once
+ *
+ * @return the UA, to be freed with pldm_ua_destroy(), or NULL on failure.
+ */
+struct pldm_ua *pldm_ua_new(const struct pldm_ua_ops *ops, void *ops_ctx,
+			    size_t max_devices);
+
+/** @brief Free a UA, abandoning any updates in progress
+ *
+ * @param[in] ua
+ */
+void pldm_ua_destroy(struct pldm_ua *ua);
+
+/** @brief Start updating an FD
+ *
+ * @param[in] ua
+ * @param[in] address - the FD, used with pldm_ua_handle_msg() and
+ *                      pldm_ua_progress()
+ * @param[in] pkg - the package to update from. Must remain valid until the
+ *                  update_complete callback for the FD.
+ * @param[in] record - the firmware device ID record for the FD, such as from
+ *                     pldm_ua_package_match(). The record's applicable
+ *                     components are updated in package order.
+ *
+ * @return 0 on success, -EBUSY if the FD is already being updated, -ENOSPC if
+ *         max_devices updates are in progress, or -EINVAL.
+ *
+ * The update begins with a RequestUpdate from pldm_ua_progress(). Components
+ * are passed and updated with a ComponentClassificationIndex of 0.
+ */
+int pldm_ua_start(struct pldm_ua *ua, pldm_tid_t address,
+		  const struct pldm_ua_package *pkg, size_t record);
+
+/** @brief Cancel the update of an FD
+ *
+ * @param[in] ua
+ * @param[in] address - the FD
+ *
+ * @return 0 on success, -ENOENT if the FD isn't being updated, or -EINVAL.
+ *
+ * A CancelUpdate is sent to the FD, after which update_complete reports
+ * -ECANCELED.
+ */
+int pldm_ua_cancel(struct pldm_ua *ua, pldm_tid_t address);
+
+/** @brief Handle a PLDM Firmware Update message from an FD
+ *
+ * @param[in] ua
+ * @param[in] remote_address - the FD the message came from
+ * @param[in] in_msg - PLDM message
+ * @param[in] in_len - length of in_msg
+ * @param[out] out_msg - PLDM response message
+ * @param[inout] out_len - length of the out_msg buffer, updated with the
+ *                         length of the response, or 0 if there is none
+ *
+ * @return 0 on success, a negative errno value on failure.
+ *
+ * Requests from the FD are answered in out_msg. Firmware data is copied from
+ * the package, so out_msg must have space for a response of the transfer
+ * size, see pldm_ua_set_transfer_size().
+ */
+int pldm_ua_handle_msg(struct pldm_ua *ua, pldm_tid_t remote_address,
+		       const void *in_msg, size_t in_len, void *out_msg,
+		       size_t *out_len);
+
+/** @brief Handle periodic progress events
+ *
+ * @param[in] ua
+ * @param[out] out_msg - PLDM request message to send
+ * @param[inout] out_len - length of the out_msg buffer, updated with the
+ *                         length of the request, or 0 if there is none
+ * @param[out] remote_address - the FD to send the request to
+ *
+ * @return 0 on success, a negative errno value on failure.
+ *
+ * At most one message is returned per call, with the FDs being served in
+ * turn. The application should call pldm_ua_progress() until it returns no
+ * message, and again by the time from pldm_ua_next_deadline().
+ */
+int pldm_ua_progress(struct pldm_ua *ua, void *out_msg, size_t *out_len,
+		     pldm_tid_t *remote_address);
+
+/** @brief Find when pldm_ua_progress() next has work to do
+ *
+ * @param[in] ua
+ * @param[out] deadline - the time, on the clock of the now() callback, at or
+ *                        after which pldm_ua_progress() should be called
+ *
+ * @return 0 on success, -ENODATA if no update is in progress, or -EINVAL.
+ */
+int pldm_ua_next_deadline(struct pldm_ua *ua, uint64_t *deadline);
+
+/** @brief Set the MaximumTransferSize offered in RequestUpdate
+ *
+ * @param[in] ua
+ * @param[in] size - in bytes, at least 32. The initial default is 512.
+ *
+ * @return 0 on success, a negative errno value on failure.
+ *
+ * Takes effect for updates started afterwards.
+ */
+int pldm_ua_set_transfer_size(struct pldm_ua *ua, uint32_t size);
+
+/** @brief Set request retry time
+ *
+ * @param[in] ua
+ * @param[in] time - Time before a request to an FD is retried, in
+ *                   milliseconds. The initial default is 1000.
+ *
+ * @return 0 on success, a negative errno value on failure.
+ */
+int pldm_ua_set_request_retry_time(struct pldm_ua *ua, uint32_t time);
+
+/** @brief Set the FD idle timeout
+ *
+ * @param[in] ua
+ * @param[in] time - Time without a message from an FD before its update
+ *                   fails with -ETIMEDOUT, in milliseconds. Covers the FD's
+ *                   verify and apply steps. The initial default is 120000.
+ *
+ * @return 0 on success, a negative errno value on failure.
+ */
+int pldm_ua_set_idle_timeout(struct pldm_ua *ua, uint32_t time);
+
+#ifdef __cplusplus
+}
+#endif
@@ -27,6 +27,27 @@ struct pldm_instance_db;
  * */
 int pldm_instance_db_init(struct pldm_instance_db **ctx, const char *dbpath);
 
+/**
+ * @brief Instantiates an instance ID database object backed by shared memory
+ *
+ * Allocations are made by atomic operations on a shared mapping of the file
+ * rather than by file locks, and instance IDs held by processes that have
+ * exited are reclaimed. All users of the database must use this backend, and
+ * a database object must not be used across fork().
+ *
+ * @param[out] ctx - *ctx must be NULL, and will point to a PLDM instance ID
+ * 		     database object on success.
+ * @param[in] fd - a file descriptor for a read-write shared file, such as a
+ * 	      memfd or a file on tmpfs. An empty file is sized and initialised.
+ * 	      The caller retains ownership, and may close it after this call.
+ *
+ * @return int - Returns 0 on success. Returns -EINVAL if ctx is NULL, *ctx is
+ * 		 not NULL, or the file isn't an instance ID database. Returns
+ * 		 -ENOMEM if memory couldn't be allocated. Returns the errno if
+ * 		 the file couldn't be sized or mapped.
+ * */
+int pldm_instance_db_init_shm(struct pldm_instance_db **ctx, int fd);
+
 /**
  * @brief Instantiates an instance ID database object for the default database
  * 	  path
@@ -85,6 +106,62 @@ int pldm_instance_id_alloc(struct pldm_instance_db *ctx, pldm_tid_t tid,
 int pldm_instance_id_free(struct pldm_instance_db *ctx, pldm_tid_t tid,
 			  pldm_instance_id_t iid);
 
+/**
+ * @brief Allocates several instance IDs for a destination TID at once
+ *
+ * @param[in] ctx - PLDM instance ID database object
+ * @param[in] tid - PLDM TID
+ * @param[in] count - the number of instance IDs to allocate, from 1 to 32
+ * @param[out] iids - caller owned pointer to a bitmask. On success, bit n is
+ * 	       set for each instance ID n allocated.
+ *
+ * @return int - Returns 0 on success if all the instance IDs were allocated.
+ * 		 Returns -EINVAL if the arguments are invalid. Otherwise, none
+ * 		 are allocated, and the error of pldm_instance_id_alloc is
+ * 		 returned.
+ */
+int pldm_instance_id_alloc_batch(struct pldm_instance_db *ctx, pldm_tid_t tid,
+				 unsigned int count, uint32_t *iids);
+
+/**
+ * @brief Frees several instance IDs previously allocated for a TID
+ *
+ * @param[in] ctx - PLDM instance ID database object
+ * @param[in] tid - PLDM TID
+ * @param[in] iids - a bitmask of the instance IDs to free, as returned by
+ * 	      pldm_instance_id_alloc_batch or assembled from
+ * 	      pldm_instance_id_alloc
+ *
+ * @return int - Returns 0 on success. Returns -EINVAL, freeing nothing, if any
+ * 		 of the instance IDs is not currently allocated. Otherwise
+ * 		 returns the first error of pldm_instance_id_free.
+ */
+int pldm_instance_id_free_batch(struct pldm_instance_db *ctx, pldm_tid_t tid,
+				uint32_t iids);
+
+/**
+ * @brief Keeps freed instance IDs allocated for reuse by the same object
+ *
+ * With a cache, pldm_instance_id_free holds up to depth instance IDs per TID in
+ * the database object rather than releasing them, and pldm_instance_id_alloc
+ * hands them out again without consulting the database. The instance ID most
+ * recently allocated for a TID isn't reused from the cache by the next
+ * allocation, so a depth of at least two is needed to avoid the database in
+ * alloc/free cycles. Cached instance IDs aren't available to other users of the
+ * database until they're released by reducing the depth or by
+ * pldm_instance_db_destroy.
+ *
+ * @param[in] ctx - PLDM instance ID database object
+ * @param[in] depth - the number of instance IDs to cache per TID, up to 32, or
+ * 	      0 to disable caching. The default is 0.
+ *
+ * @return int - Returns 0 on success. Returns -EINVAL if the arguments are
+ * 		 invalid. Otherwise returns the first error of releasing the
+ * 		 instance IDs that no longer fit in the cache.
+ */
+int pldm_instance_db_set_cache(struct pldm_instance_db *ctx,
+			       unsigned int depth);
+
 #endif /* __STDC_HOSTED__*/
 
 #ifdef __cplusplus
@@ -0,0 +1,386 @@
+/* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#ifndef MULTIPART_PLDM_H
+#define MULTIPART_PLDM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <libpldm/base.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Remembers the transfer parameters negotiated with each peer
+ *
+ * NegotiateTransferParameters settles the largest part each side of a
+ * multipart transfer can handle, and the PLDM types for which both support
+ * multipart transfers. The results are kept per TID, together with the largest
+ * message the transport carries to the peer, so transfers can use the largest
+ * part size all of them allow.
+ */
+struct pldm_multipart_peers;
+
+/**
+ * @brief Instantiate a transfer parameter cache
+ *
+ * @param[out] ctx - *ctx must be NULL, and will point to the cache on success
+ * @param[in] part_size - the largest part this endpoint handles. Must not be
+ * 	      zero
+ * @param[in] protocols - the PLDM types for which this endpoint supports
+ * 	      multipart transfers, as a bitfield indexed by type
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, or -ENOMEM if
+ * 	   memory couldn't be allocated
+ */
+int pldm_multipart_peers_init(struct pldm_multipart_peers **ctx,
+			      uint16_t part_size,
+			      const bitfield8_t protocols[8]);
+
+/**
+ * @brief Destroy a transfer parameter cache
+ *
+ * @param[in] ctx - the cache to destroy. May be NULL
+ */
+void pldm_multipart_peers_destroy(struct pldm_multipart_peers *ctx);
+
+/**
+ * @brief Limit the messages exchanged with a peer
+ *
+ * @param[in] ctx - the cache
+ * @param[in] tid - the peer
+ * @param[in] mtu - the largest PLDM message, including its header, the
+ * 	      transport carries to the peer, or 0 for no limit
+ *
+ * @return 0 on success, or -EINVAL if the arguments are invalid
+ */
+int pldm_multipart_peers_set_mtu(struct pldm_multipart_peers *ctx,
+				 pldm_tid_t tid, size_t mtu);
+
+/**
+ * @brief Forget the parameters negotiated with a peer, such as when its TID is
+ * 	  reassigned
+ *
+ * @param[in] ctx - the cache
+ * @param[in] tid - the peer
+ *
+ * @return 0 on success, or -EINVAL if the arguments are invalid
+ */
+int pldm_multipart_peers_forget(struct pldm_multipart_peers *ctx,
+				pldm_tid_t tid);
+
+/**
+ * @brief Encode a NegotiateTransferParameters request advertising this
+ * 	  endpoint's parameters
+ *
+ * @param[in] ctx - the cache
+ * @param[in] instance_id - the instance ID of the request
+ * @param[out] req_msg - buffer for the request message
+ * @param[inout] req_len - the size of req_msg, updated with the length of the
+ * 		 request
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, or -EOVERFLOW if
+ * 	   req_msg is too small
+ */
+int pldm_multipart_peers_negotiate_req(struct pldm_multipart_peers *ctx,
+				       uint8_t instance_id, void *req_msg,
+				       size_t *req_len);
+
+/**
+ * @brief Record a peer's response to NegotiateTransferParameters
+ *
+ * @param[in] ctx - the cache
+ * @param[in] tid - the peer that responded
+ * @param[in] resp_msg - the response message
+ * @param[in] resp_len - the length of resp_msg
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, or -EPROTO if
+ * 	   the response is malformed or reports an error, in which case the
+ * 	   peer's parameters are forgotten
+ */
+int pldm_multipart_peers_negotiate_resp(struct pldm_multipart_peers *ctx,
+					pldm_tid_t tid, const void *resp_msg,
+					size_t resp_len);
+
+/**
+ * @brief Answer and record a peer's NegotiateTransferParameters request
+ *
+ * @param[in] ctx - the cache
+ * @param[in] tid - the peer that sent the request
+ * @param[in] req_msg - the request message
+ * @param[in] req_len - the length of req_msg
+ * @param[out] resp_msg - buffer for the response message
+ * @param[inout] resp_len - the size of resp_msg, updated with the length of
+ * 		 the response
+ *
+ * @return 0 with a response to send, -EINVAL if the arguments are invalid,
+ * 	   -ENOMSG if req_msg isn't a NegotiateTransferParameters request, or
+ * 	   -EOVERFLOW if resp_msg is too small
+ */
+int pldm_multipart_peers_handle_req(struct pldm_multipart_peers *ctx,
+				    pldm_tid_t tid, const void *req_msg,
+				    size_t req_len, void *resp_msg,
+				    size_t *resp_len);
+
+/**
+ * @brief Find the largest part size for a transfer with a peer
+ *
+ * The part size is the smallest of the part sizes negotiated by each side and
+ * the largest part fitting in a MultipartReceive response within the peer's
+ * MTU.
+ *
+ * @param[in] ctx - the cache
+ * @param[in] tid - the peer
+ * @param[in] pldm_type - the PLDM type of the transfer
+ * @param[out] part_size - the part size to use
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, -ENOENT if no
+ * 	   parameters have been negotiated with the peer, -ENOTSUP if the peer
+ * 	   or this endpoint doesn't support multipart transfers of pldm_type,
+ * 	   or -EMSGSIZE if the MTU leaves no space for data
+ */
+int pldm_multipart_peers_part_size(const struct pldm_multipart_peers *ctx,
+				   pldm_tid_t tid, uint8_t pldm_type,
+				   uint32_t *part_size);
+
+/**
+ * @brief Serves objects to MultipartReceive requesters
+ *
+ * Objects are registered under the PLDM type and transfer context by which
+ * requesters name them. A requested section of an object is served in parts of
+ * at most the negotiated part size, copied straight from the object's memory
+ * or read by a callback into the response. The transfer handle of each part
+ * identifies its offset in the section, and the CRC32 of the section is
+ * accumulated as the parts are served, for the final part. Each requesting TID
+ * has its own transfer of an object, so several may receive it at once.
+ */
+struct pldm_multipart_server;
+
+/**
+ * @brief Read part of an object registered with a callback
+ *
+ * @param[in] data - the data pointer provided to
+ * 	      pldm_multipart_server_add_source()
+ * @param[in] offset - the offset in the object of the first byte to read
+ * @param[out] buf - the buffer to fill
+ * @param[in] len - the number of bytes to read
+ *
+ * @return 0 on success, or a negative errno value if the bytes couldn't be
+ * 	   read, in which case the request is answered with PLDM_ERROR
+ */
+typedef int (*pldm_multipart_read_fn)(void *data, uint32_t offset, void *buf,
+				      size_t len);
+
+/**
+ * @brief Instantiate a MultipartReceive server
+ *
+ * @param[out] ctx - *ctx must be NULL, and will point to the server on success
+ * @param[in] part_size - the largest part to serve, as negotiated by
+ * 	      NegotiateTransferParameters. Must not be zero
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, or -ENOMEM if
+ * 	   memory couldn't be allocated
+ */
+int pldm_multipart_server_init(struct pldm_multipart_server **ctx,
+			       uint32_t part_size);
+
+/**
+ * @brief Destroy a MultipartReceive server
+ *
+ * @param[in] ctx - the server to destroy. May be NULL
+ */
+void pldm_multipart_server_destroy(struct pldm_multipart_server *ctx);
+
+/**
+ * @brief Change the largest part to serve, for parts served after the call
+ *
+ * @param[in] ctx - the server
+ * @param[in] part_size - the largest part to serve. Must not be zero
+ *
+ * @return 0 on success, or -EINVAL if the arguments are invalid
+ */
+int pldm_multipart_server_set_part_size(struct pldm_multipart_server *ctx,
+					uint32_t part_size);
+
+/**
+ * @brief Serve peers parts of the size negotiated with them
+ *
+ * Requests from peers with negotiated parameters for the requested PLDM type
+ * are served in parts no larger than pldm_multipart_peers_part_size() finds,
+ * nor than the server's part size. Those from other peers are served in parts
+ * of the server's part size.
+ *
+ * @param[in] ctx - the server
+ * @param[in] peers - the cache of negotiated parameters, which must outlive
+ * 	      the server, or NULL to serve all peers the server's part size
+ *
+ * @return 0 on success, or -EINVAL if the arguments are invalid
+ */
+int pldm_multipart_server_set_peers(struct pldm_multipart_server *ctx,
+				    const struct pldm_multipart_peers *peers);
+
+/**
+ * @brief Serve an object held in memory, such as a mapped file
+ *
+ * @param[in] ctx - the server
+ * @param[in] pldm_type - the PLDM type in requests for the object
+ * @param[in] transfer_ctx - the transfer context in requests for the object
+ * @param[in] data - the object, which must remain valid until it's removed or
+ * 	      the server is destroyed
+ * @param[in] len - the length of the object, at most UINT32_MAX
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, -EEXIST if an
+ * 	   object is already registered for the type and transfer context, or
+ * 	   -ENOMEM if memory couldn't be allocated
+ */
+int pldm_multipart_server_add_memory(struct pldm_multipart_server *ctx,
+				     uint8_t pldm_type, uint32_t transfer_ctx,
+				     const void *data, size_t len);
+
+/**
+ * @brief Serve an object read by a callback
+ *
+ * @param[in] ctx - the server
+ * @param[in] pldm_type - the PLDM type in requests for the object
+ * @param[in] transfer_ctx - the transfer context in requests for the object
+ * @param[in] len - the length of the object, at most UINT32_MAX
+ * @param[in] read - called to read each part into its response
+ * @param[in] data - passed to read
+ *
+ * @return As for pldm_multipart_server_add_memory()
+ */
+int pldm_multipart_server_add_source(struct pldm_multipart_server *ctx,
+				     uint8_t pldm_type, uint32_t transfer_ctx,
+				     size_t len, pldm_multipart_read_fn read,
+				     void *data);
+
+/**
+ * @brief Stop serving an object, abandoning any transfers in progress
+ *
+ * @param[in] ctx - the server
+ * @param[in] pldm_type - the PLDM type the object was registered with
+ * @param[in] transfer_ctx - the transfer context the object was registered
+ * 	      with
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, or -ENOENT if no
+ * 	   object is registered for the type and transfer context
+ */
+int pldm_multipart_server_remove(struct pldm_multipart_server *ctx,
+				 uint8_t pldm_type, uint32_t transfer_ctx);
+
+/**
+ * @brief Handle a MultipartReceive request
+ *
+ * A section length of zero requests the object from the section offset to its
+ * end, as does a section length reaching beyond the end of the object. The
+ * current part may be requested again with its own transfer handle, or the
+ * first part with the handle 0 of the FirstPart request. If memory for a new
+ * transfer can't be allocated, the request is answered with
+ * PLDM_ERROR_NOT_READY.
+ *
+ * @param[in] ctx - the server
+ * @param[in] tid - the peer that sent the request
+ * @param[in] req_msg - the request message
+ * @param[in] req_len - the length of req_msg
+ * @param[out] resp_msg - buffer for the response message. Must have space for
+ * 	       the response header and fields, the server's part size, and the
+ * 	       CRC32
+ * @param[inout] resp_len - the size of resp_msg, updated with the length of
+ * 		 the response
+ *
+ * @return 0 with a response to send, -EINVAL if the arguments are invalid,
+ * 	   -ENOMSG if req_msg isn't a MultipartReceive request, or -EOVERFLOW if
+ * 	   resp_msg is too small
+ */
+int pldm_multipart_server_handle_msg(struct pldm_multipart_server *ctx,
+				     pldm_tid_t tid, const void *req_msg,
+				     size_t req_len, void *resp_msg,
+				     size_t *resp_len);
+
+/**
+ * @brief Receives an object from a MultipartReceive server
+ *
+ * The client produces each request and consumes its response, leaving the
+ * exchange of messages to the application. The parts are reassembled into a
+ * caller-provided buffer, and the CRC32 of the section is checked. A request
+ * whose response is lost may be produced again and resent.
+ */
+struct pldm_multipart_client;
+
+/**
+ * @brief Instantiate a MultipartReceive client
+ *
+ * @param[out] ctx - *ctx must be NULL, and will point to the client on success
+ * @param[in] pldm_type - the PLDM type naming the object
+ * @param[in] transfer_ctx - the transfer context naming the object
+ * @param[in] section_offset - the offset in the object of the first byte to
+ * 	      receive
+ * @param[out] buf - the buffer receiving the section. Must outlive the client
+ * @param[in] len - the size of buf, and the length of the section requested.
+ * 	      The section received is shorter if the object ends first
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, or -ENOMEM if
+ * 	   memory couldn't be allocated
+ */
+int pldm_multipart_client_init(struct pldm_multipart_client **ctx,
+			       uint8_t pldm_type, uint32_t transfer_ctx,
+			       uint32_t section_offset, void *buf, size_t len);
+
+/**
+ * @brief Destroy a MultipartReceive client
+ *
+ * @param[in] ctx - the client to destroy. May be NULL
+ */
+void pldm_multipart_client_destroy(struct pldm_multipart_client *ctx);
+
+/**
+ * @brief Produce the next request of the transfer
+ *
+ * Until a response to the request is handled, the same request is produced
+ * again, for use as a retry.
+ *
+ * @param[in] ctx - the client
+ * @param[in] instance_id - the instance ID of the request
+ * @param[out] req_msg - buffer for the request message
+ * @param[inout] req_len - the size of req_msg, updated with the length of the
+ * 		 request, or 0 if the transfer has finished
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, or -EOVERFLOW if
+ * 	   req_msg is too small
+ */
+int pldm_multipart_client_next_req(struct pldm_multipart_client *ctx,
+				   uint8_t instance_id, void *req_msg,
+				   size_t *req_len);
+
+/**
+ * @brief Handle the response to the last request produced
+ *
+ * @param[in] ctx - the client
+ * @param[in] resp_msg - the response message
+ * @param[in] resp_len - the length of resp_msg
+ *
+ * @return 0 if there's another request to send, 1 if the transfer has
+ * 	   finished and the section has been received, -EINVAL if the arguments
+ * 	   are invalid, -EPROTO if the response is malformed, out of sequence,
+ * 	   or reports an error, -EOVERFLOW if the server sent more than
+ * 	   requested, or -EBADMSG if the CRC32 of the section doesn't match.
+ * 	   The transfer can't continue after an error.
+ */
+int pldm_multipart_client_handle_resp(struct pldm_multipart_client *ctx,
+				      const void *resp_msg, size_t resp_len);
+
+/**
+ * @brief Report the number of bytes of the section received
+ *
+ * @param[in] ctx - the client
+ *
+ * @return the number of bytes received into the buffer
+ */
+size_t pldm_multipart_client_received(const struct pldm_multipart_client *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MULTIPART_PLDM_H */
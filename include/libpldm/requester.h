@@ -0,0 +1,200 @@
+/* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#ifndef REQUESTER_PLDM_H
+#define REQUESTER_PLDM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <libpldm/base.h>
+#include <libpldm/instance-id.h>
+
+#include <stddef.h>
+
+struct pldm_instance_db;
+struct pldm_transport;
+
+/**
+ * @brief Asynchronous PLDM requester
+ *
+ * Keeps many requests in flight over a transport: up to one per instance ID
+ * for each TID, across any number of TIDs. Responses are correlated with
+ * their requests, and the completion of each request is reported through a
+ * callback.
+ */
+struct pldm_requester;
+
+/**
+ * @brief Completion callback for a request
+ *
+ * @param[in] data - the data pointer provided to pldm_requester_submit()
+ * @param[in] tid - the TID to which the request was sent
+ * @param[in] rc - 0 if a response was received, -ETIMEDOUT if no response
+ * 	      arrived before the timeout of the request's last retry, or
+ * 	      -ECANCELED if the request was cancelled
+ * @param[in] resp - the response message if rc is 0, otherwise NULL. Only
+ * 	      valid for the duration of the callback
+ * @param[in] resp_len - the length of resp
+ *
+ * The callback may submit or cancel requests.
+ */
+typedef void (*pldm_requester_cb)(void *data, pldm_tid_t tid, int rc,
+				  const void *resp, size_t resp_len);
+
+/**
+ * @brief Instantiate an asynchronous requester
+ *
+ * @param[out] ctx - *ctx must be NULL, and will point to the requester on
+ * 	       success
+ * @param[in] transport - the transport over which to exchange messages. Must
+ * 	      outlive the requester
+ * @param[in] db - the instance ID database from which to allocate instance IDs.
+ * 	      May be NULL, in which case the requester assigns instance IDs
+ * 	      itself, and must then be the only requester for its TIDs
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, or -ENOMEM if
+ * 	   memory couldn't be allocated
+ */
+int pldm_requester_init(struct pldm_requester **ctx,
+			struct pldm_transport *transport,
+			struct pldm_instance_db *db);
+
+/**
+ * @brief Destroy an asynchronous requester
+ *
+ * Requests still in flight are completed with -ECANCELED. Their callbacks must
+ * not submit further requests.
+ *
+ * @param[in] ctx - the requester to destroy. May be NULL
+ */
+void pldm_requester_destroy(struct pldm_requester *ctx);
+
+/**
+ * @brief Set the number of times unanswered requests are sent again
+ *
+ * DSP0240 requires requesters to retry a request that isn't answered within
+ * PT2 at least twice (PN1), using the same instance ID, before giving up. The
+ * instance ID stays allocated across the retries, so (retries + 1) times the
+ * request timeout should not exceed PT3, the instance ID expiration interval.
+ *
+ * Applies to requests submitted after the call. Retried requests are copied
+ * when submitted. The initial number of retries is zero.
+ *
+ * @param[in] ctx - the requester
+ * @param[in] retries - the number of retries
+ *
+ * @return 0 on success, or -EINVAL if ctx is NULL
+ */
+int pldm_requester_set_retries(struct pldm_requester *ctx,
+			       unsigned int retries);
+
+/**
+ * @brief Send a request without waiting for the response
+ *
+ * An instance ID is allocated for the request and written into its header
+ * before it is sent. The request buffer is not retained.
+ *
+ * @param[in] ctx - the requester
+ * @param[in] tid - the destination TID
+ * @param[in,out] req_msg - the encoded request message
+ * @param[in] req_len - the length of req_msg
+ * @param[in] timeout_ms - the time to wait for the response to each attempt,
+ * 	      in milliseconds (PT2). Must be greater than zero
+ * @param[in] cb - the completion callback
+ * @param[in] data - an opaque pointer passed to cb
+ * @param[out] iid - the instance ID allocated for the request. May be NULL
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, -EAGAIN if all
+ * 	   instance IDs for the TID are in use, -ENOMEM if memory couldn't be
+ * 	   allocated, or -EIO if the request could not be sent
+ */
+int pldm_requester_submit(struct pldm_requester *ctx, pldm_tid_t tid,
+			  void *req_msg, size_t req_len, int timeout_ms,
+			  pldm_requester_cb cb, void *data,
+			  pldm_instance_id_t *iid);
+
+/**
+ * @brief Cancel a request in flight
+ *
+ * The callback of the request is invoked with -ECANCELED. A response arriving
+ * later is not matched to any request.
+ *
+ * @param[in] ctx - the requester
+ * @param[in] tid - the TID to which the request was sent
+ * @param[in] iid - the instance ID of the request
+ *
+ * @return 0 on success, -EINVAL if ctx is NULL, or -ENOENT if there is no such
+ * 	   request in flight
+ */
+int pldm_requester_cancel(struct pldm_requester *ctx, pldm_tid_t tid,
+			  pldm_instance_id_t iid);
+
+/**
+ * @brief Complete the request to which a received message responds
+ *
+ * For use when the application receives messages from the transport itself,
+ * for example because it also acts as a responder.
+ *
+ * @param[in] ctx - the requester
+ * @param[in] tid - the source TID of the message
+ * @param[in] msg - the received message
+ * @param[in] msg_len - the length of msg
+ *
+ * @return 0 if the message completed a request, -ENOMSG if it is not a
+ * 	   response to a request in flight, or -EINVAL if the arguments are
+ * 	   invalid
+ */
+int pldm_requester_handle_msg(struct pldm_requester *ctx, pldm_tid_t tid,
+			      const void *msg, size_t msg_len);
+
+/**
+ * @brief Complete the requests whose timeouts have expired with -ETIMEDOUT
+ *
+ * @param[in] ctx - the requester
+ *
+ * @return The number of requests that timed out, or -EINVAL if ctx is NULL
+ */
+int pldm_requester_expire(struct pldm_requester *ctx);
+
+/**
+ * @brief Find the time until the next request times out
+ *
+ * @param[in] ctx - the requester
+ *
+ * @return The number of milliseconds until the earliest timeout, 0 if a timeout
+ * 	   has already expired, -1 if no requests are in flight, or -EINVAL if
+ * 	   ctx is NULL. The result is suitable as a poll(2) timeout.
+ */
+int pldm_requester_next_timeout(struct pldm_requester *ctx);
+
+/**
+ * @brief Find the number of requests in flight
+ *
+ * @param[in] ctx - the requester
+ *
+ * @return The number of requests awaiting completion
+ */
+size_t pldm_requester_pending(struct pldm_requester *ctx);
+
+/**
+ * @brief Make progress on the requests in flight
+ *
+ * Waits up to timeout_ms for a message, or until the next request times out if
+ * that is sooner. A received response completes its request, while other
+ * messages are discarded. Expired requests are completed with -ETIMEDOUT.
+ *
+ * @param[in] ctx - the requester
+ * @param[in] timeout_ms - the maximum time to wait, in milliseconds. Zero
+ * 	      returns immediately and a negative value waits until a message
+ * 	      arrives or a request times out
+ *
+ * @return 0 on success, -EINVAL if ctx is NULL, or -EIO if the transport
+ * 	   failed
+ */
+int pldm_requester_process(struct pldm_requester *ctx, int timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REQUESTER_PLDM_H */
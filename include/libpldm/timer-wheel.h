@@ -0,0 +1,139 @@
+/* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#ifndef TIMER_WHEEL_PLDM_H
+#define TIMER_WHEEL_PLDM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Hierarchical timer wheel
+ *
+ * Tracks any number of timers with millisecond resolution. Adding and removing
+ * a timer is O(1), and expiry is O(1) amortized per timer, independent of the
+ * number of timers pending. Time is supplied by the caller in milliseconds
+ * from an arbitrary origin, such as CLOCK_MONOTONIC or the now() callback of
+ * struct pldm_fd_ops, and must not go backwards.
+ */
+struct pldm_timer_wheel;
+
+struct pldm_timer;
+
+/**
+ * @brief Callback for the expiry of a timer
+ *
+ * @param[in] data - the data pointer provided to pldm_timer_wheel_add()
+ * @param[in] timer - the timer that expired. It is no longer pending, so may be
+ * 	      added again
+ *
+ * The callback may add and remove any timers.
+ */
+typedef void (*pldm_timer_cb)(void *data, struct pldm_timer *timer);
+
+/**
+ * @brief A timer, to be embedded in the structure it times out
+ *
+ * The members are private to the timer wheel. Timers must be zeroed before
+ * their first use, and must not be freed while pending.
+ */
+struct pldm_timer {
+	struct pldm_timer *next;
+	struct pldm_timer **pprev;
+	uint64_t expires;
+	pldm_timer_cb cb;
+	void *data;
+};
+
+/**
+ * @brief Instantiate a timer wheel
+ *
+ * @param[out] ctx - *ctx must be NULL, and will point to the timer wheel on
+ * 	       success
+ * @param[in] now - the current time, in milliseconds
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, or -ENOMEM if
+ * 	   memory couldn't be allocated
+ */
+int pldm_timer_wheel_init(struct pldm_timer_wheel **ctx, uint64_t now);
+
+/**
+ * @brief Destroy a timer wheel
+ *
+ * Pending timers are removed without invoking their callbacks.
+ *
+ * @param[in] ctx - the timer wheel to destroy. May be NULL
+ */
+void pldm_timer_wheel_destroy(struct pldm_timer_wheel *ctx);
+
+/**
+ * @brief Start a timer
+ *
+ * @param[in] ctx - the timer wheel
+ * @param[in] timer - the timer, which must not be pending
+ * @param[in] expires - the time at which the timer expires, in milliseconds.
+ * 	      A time that has already passed expires on the next call to
+ * 	      pldm_timer_wheel_advance()
+ * @param[in] cb - the expiry callback
+ * @param[in] data - an opaque pointer passed to cb
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, or -EBUSY if the
+ * 	   timer is already pending
+ */
+int pldm_timer_wheel_add(struct pldm_timer_wheel *ctx, struct pldm_timer *timer,
+			 uint64_t expires, pldm_timer_cb cb, void *data);
+
+/**
+ * @brief Stop a timer
+ *
+ * @param[in] ctx - the timer wheel
+ * @param[in] timer - the timer
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, or -ENOENT if the
+ * 	   timer isn't pending
+ */
+int pldm_timer_wheel_del(struct pldm_timer_wheel *ctx,
+			 struct pldm_timer *timer);
+
+/**
+ * @brief Test whether a timer is pending
+ *
+ * @param[in] timer - the timer
+ *
+ * @return true if the timer has been added and has neither expired nor been
+ * 	   removed
+ */
+bool pldm_timer_pending(const struct pldm_timer *timer);
+
+/**
+ * @brief Invoke the callbacks of the timers that have expired
+ *
+ * @param[in] ctx - the timer wheel
+ * @param[in] now - the current time, in milliseconds
+ *
+ * @return The number of timers that expired, or -EINVAL if ctx is NULL
+ */
+int pldm_timer_wheel_advance(struct pldm_timer_wheel *ctx, uint64_t now);
+
+/**
+ * @brief Find the time until pldm_timer_wheel_advance() should next be called
+ *
+ * Timers far in the future are tracked at a coarser resolution, so the result
+ * may be earlier than the first expiry, but is never later.
+ *
+ * @param[in] ctx - the timer wheel
+ * @param[in] now - the current time, in milliseconds
+ *
+ * @return The number of milliseconds until the next expiry, 0 if a timer has
+ * 	   already expired, -1 if no timers are pending, or -EINVAL if ctx is
+ * 	   NULL. The result is suitable as a poll(2) timeout.
+ */
+int pldm_timer_wheel_next_timeout(struct pldm_timer_wheel *ctx, uint64_t now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIMER_WHEEL_PLDM_H */
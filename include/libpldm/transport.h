@@ -10,9 +10,29 @@ extern "C" {
 #include <libpldm/pldm.h>
 
 #include <stddef.h>
+#include <stdint.h>
 
 struct pldm_transport;
 
+/**
+ * @brief A PLDM message in a batch passed to pldm_transport_send_msgs() or
+ * 	  pldm_transport_recv_msgs()
+ *
+ * @var tid - destination TID when sending, source TID when receiving
+ * @var msg - PLDM message when sending, caller owned buffer when receiving.
+ * 	      The message is not modified when sending.
+ * @var len - size of the PLDM message when sending. When receiving, the size
+ * 	      of the buffer on entry and the size of the received message on
+ * 	      return
+ * @var rc - the result for this message. Set for each message processed
+ */
+struct pldm_transport_msg {
+	pldm_tid_t tid;
+	void *msg;
+	size_t len;
+	pldm_requester_rc_t rc;
+};
+
 /**
  * @brief Waits for a PLDM event.
  *
@@ -30,6 +50,23 @@ struct pldm_transport;
  */
 int pldm_transport_poll(struct pldm_transport *transport, int timeout);
 
+/**
+ * @brief Send the messages held in the outbound queue of a transport
+ *
+ * Transports with an outbound queue, such as af-mctp and mctp-demux once
+ * configured with a send queue, hold messages the socket couldn't accept
+ * without blocking. While messages are queued the transport's pollfd also
+ * requests POLLOUT, and pldm_transport_poll() flushes the queue when the
+ * socket becomes writable. Callers monitoring the pollfd themselves should
+ * call this function when it reports POLLOUT.
+ *
+ * @param[in] transport - pldm transport instance
+ *
+ * @return The number of messages that remain queued, 0 if the transport has no
+ * 	   outbound queue, or PLDM_REQUESTER_INVALID_SETUP if transport is NULL
+ */
+int pldm_transport_flush(struct pldm_transport *transport);
+
 /**
  * @brief Asynchronously send a PLDM message. Control is immediately returned to
  * 	  the caller.
@@ -82,14 +119,104 @@ pldm_requester_rc_t pldm_transport_recv_msg(struct pldm_transport *transport,
 					    pldm_tid_t *tid, void **pldm_msg,
 					    size_t *msg_len);
 
+/**
+ * @brief Asynchronously get a PLDM message into a caller-provided buffer.
+ * 	  Control is immediately returned to the caller.
+ *
+ * Unlike pldm_transport_recv_msg(), no memory is allocated on behalf of the
+ * caller. Where the transport supports it the message is received with a
+ * single system call.
+ *
+ * @pre The pldm transport instance must be initialised; otherwise,
+ * 	PLDM_REQUESTER_INVALID_SETUP is returned. If the transport requires a
+ * 	TID to transport specific identifier mapping, this must already be set
+ * 	up.
+ *
+ * @param[in] transport - pldm transport instance
+ * @param[out] tid - source PLDM TID
+ * @param[out] pldm_msg - caller owned buffer into which the PLDM message is
+ * 	       received. If NULL, PLDM_REQUESTER_INVALID_SETUP is returned.
+ * @param[in,out] msg_len - On entry, the size of the buffer pointed to by
+ * 		  pldm_msg, which must be able to hold at least a PLDM message
+ * 		  header. On PLDM_REQUESTER_SUCCESS or
+ * 		  PLDM_REQUESTER_RECV_TRUNCATED, the size of the PLDM message
+ * 		  that was received.
+ *
+ * @return pldm_requester_rc_t (errno may be set). Failure is returned if no
+ * 	   PLDM messages are available. PLDM_REQUESTER_RECV_TRUNCATED is
+ * 	   returned if the message did not fit in the buffer. In that case the
+ * 	   buffer holds the start of the message, the remainder is discarded,
+ * 	   and no response may be sent for it.
+ */
+pldm_requester_rc_t
+pldm_transport_recv_msg_into(struct pldm_transport *transport, pldm_tid_t *tid,
+			     void *pldm_msg, size_t *msg_len);
+
+/**
+ * @brief Asynchronously send a batch of PLDM messages. Control is immediately
+ * 	  returned to the caller.
+ *
+ * Where the transport supports it, the batch is sent with as few system calls
+ * as possible. Otherwise each message is sent with pldm_transport_send_msg().
+ * Messages are sent in order, and sending stops at the first failure.
+ *
+ * @pre The pldm transport instance must be initialised; otherwise,
+ * 	PLDM_REQUESTER_INVALID_SETUP is returned. If the transport requires a
+ * 	TID to transport specific identifier mapping, this must already be set
+ * 	up.
+ *
+ * @param[in] transport - pldm transport instance
+ * @param[in,out] msgs - caller owned array of messages to send. If any message
+ * 		  is NULL or shorter than a PLDM message header, nothing is
+ * 		  sent and PLDM_REQUESTER_INVALID_SETUP is returned.
+ * @param[in] count - number of messages in msgs
+ *
+ * @return The number of messages sent, whose rc members are set to
+ * 	   PLDM_REQUESTER_SUCCESS, or a negative pldm_requester_rc_t value if
+ * 	   the first message could not be sent (errno may be set).
+ */
+int pldm_transport_send_msgs(struct pldm_transport *transport,
+			     struct pldm_transport_msg *msgs, size_t count);
+
+/**
+ * @brief Asynchronously receive a batch of PLDM messages into caller-provided
+ * 	  buffers. Control is immediately returned to the caller.
+ *
+ * Receives the first message as for pldm_transport_recv_msg_into(), then as
+ * many further messages as are ready without waiting, up to count. Where the
+ * transport supports it, the batch is received with as few system calls as
+ * possible.
+ *
+ * @pre The pldm transport instance must be initialised; otherwise,
+ * 	PLDM_REQUESTER_INVALID_SETUP is returned. If the transport requires a
+ * 	TID to transport specific identifier mapping, this must already be set
+ * 	up.
+ *
+ * @param[in] transport - pldm transport instance
+ * @param[in,out] msgs - caller owned array of receive buffers. If any buffer is
+ * 		  NULL or cannot hold a PLDM message header,
+ * 		  PLDM_REQUESTER_INVALID_SETUP is returned.
+ * @param[in] count - number of buffers in msgs
+ *
+ * @return The number of messages consumed, or a negative pldm_requester_rc_t
+ * 	   value if no message could be received (errno may be set). Each
+ * 	   consumed message has its rc member set as for
+ * 	   pldm_transport_recv_msg_into(); only those with
+ * 	   PLDM_REQUESTER_SUCCESS are complete, valid messages.
+ */
+int pldm_transport_recv_msgs(struct pldm_transport *transport,
+			     struct pldm_transport_msg *msgs, size_t count);
+
 /**
  * @brief Synchronously send a PLDM request and receive the response. Control is
  * 	  returned to the caller once the response is received.
  *
  * pldm_transport_send_recv() will discard messages received on the underlying transport instance
- * that are not a response that matches the request. Do not use this function if you're attempting
- * to use the transport instance asynchronously, as this discard behaviour will affect other
- * responses that you may care about.
+ * that are not a response that matches the request, unless inboxes are enabled with
+ * pldm_transport_inbox_enable(). In that case such messages are queued for retrieval with
+ * pldm_transport_inbox_recv(), and only discarded if their inbox is full. Without inboxes, do not
+ * use this function if you're attempting to use the transport instance asynchronously, as the
+ * discard behaviour will affect other responses that you may care about.
  *
  * @pre The pldm transport instance must be initialised; otherwise,
  * 	PLDM_REQUESTER_INVALID_SETUP is returned. If the transport requires a
@@ -119,6 +246,214 @@ pldm_transport_send_recv_msg(struct pldm_transport *transport, pldm_tid_t tid,
 			     const void *pldm_req_msg, size_t req_msg_len,
 			     void **pldm_resp_msg, size_t *resp_msg_len);
 
+/**
+ * @brief Queue the messages that pldm_transport_send_recv_msg() receives while
+ * 	  waiting for its response, rather than discarding them
+ *
+ * Messages are queued in an inbox for each pair of source TID and PLDM type,
+ * from which they're retrieved in the order received with
+ * pldm_transport_inbox_recv(). Messages arriving at a full inbox are
+ * discarded. The inboxes are released when the transport is destroyed.
+ *
+ * @param[in] transport - pldm transport instance
+ * @param[in] depth - the number of messages each inbox can hold
+ *
+ * @return 0 on success, including if inboxes are already enabled, in which case
+ * 	   their depth is unchanged, -EINVAL if transport is NULL or depth is
+ * 	   0, or -ENOMEM if memory couldn't be allocated
+ */
+int pldm_transport_inbox_enable(struct pldm_transport *transport, size_t depth);
+
+/**
+ * @brief Stop queueing messages, and free those that are queued
+ *
+ * @param[in] transport - pldm transport instance. May be NULL
+ */
+void pldm_transport_inbox_disable(struct pldm_transport *transport);
+
+/**
+ * @brief Take the oldest message from the inbox of a TID and PLDM type
+ *
+ * @param[in] transport - pldm transport instance
+ * @param[in] tid - the TID from which the message was received
+ * @param[in] type - the PLDM type of the message
+ * @param[out] pldm_msg - *pldm_msg will point to the message if the return code
+ * 	       is PLDM_REQUESTER_SUCCESS. The caller must free(*pldm_msg).
+ * @param[out] msg_len - the length of the message
+ *
+ * @return PLDM_REQUESTER_SUCCESS, PLDM_REQUESTER_RECV_FAIL if the inbox is
+ * 	   empty or inboxes are disabled, or PLDM_REQUESTER_INVALID_SETUP if the
+ * 	   arguments are invalid
+ */
+pldm_requester_rc_t pldm_transport_inbox_recv(struct pldm_transport *transport,
+					      pldm_tid_t tid, uint8_t type,
+					      void **pldm_msg, size_t *msg_len);
+
+/**
+ * @brief Count the messages queued in the inbox of a TID and PLDM type
+ *
+ * @param[in] transport - pldm transport instance
+ * @param[in] tid - the TID from which the messages were received
+ * @param[in] type - the PLDM type of the messages
+ *
+ * @return The number of queued messages, 0 if inboxes are disabled
+ */
+size_t pldm_transport_inbox_pending(struct pldm_transport *transport,
+				    pldm_tid_t tid, uint8_t type);
+
+/**
+ * @brief Traffic counters of a transport, maintained while statistics are
+ * 	  enabled with pldm_transport_stats_enable()
+ *
+ * @var tx_msgs - messages sent
+ * @var tx_bytes - bytes of PLDM messages sent
+ * @var tx_errors - messages that could not be sent
+ * @var rx_msgs - messages received
+ * @var rx_bytes - bytes of PLDM messages received
+ * @var rx_drops - receives that failed or yielded a message that couldn't be
+ * 	      delivered, for example as it was truncated or from an unknown
+ * 	      endpoint
+ * @var rx_discarded - received messages that pldm_transport_send_recv_msg()
+ * 	      discarded as they didn't respond to its request, and couldn't be
+ * 	      queued in an inbox
+ * @var timeouts - calls to pldm_transport_send_recv_msg() that received no
+ * 	      response in time
+ * @var sndbuf_resizes - enlargements of the socket send buffer to accommodate a
+ * 	      message
+ * @var rx_queued - received messages that pldm_transport_send_recv_msg()
+ * 	      queued in an inbox as they didn't respond to its request
+ */
+struct pldm_transport_counters {
+	uint64_t tx_msgs;
+	uint64_t tx_bytes;
+	uint64_t tx_errors;
+	uint64_t rx_msgs;
+	uint64_t rx_bytes;
+	uint64_t rx_drops;
+	uint64_t rx_discarded;
+	uint64_t timeouts;
+	uint64_t sndbuf_resizes;
+	uint64_t rx_queued;
+};
+
+/* Latencies below 2^PLDM_TRANSPORT_LATENCY_SUB_BITS microseconds have a bucket
+ * each, and each doubling above is split into that many buckets */
+#define PLDM_TRANSPORT_LATENCY_SUB_BITS 3
+/* Latencies of 2^PLDM_TRANSPORT_LATENCY_MAX_BITS microseconds and above are
+ * counted in the last bucket */
+#define PLDM_TRANSPORT_LATENCY_MAX_BITS 28
+#define PLDM_TRANSPORT_LATENCY_BUCKETS                                         \
+	((PLDM_TRANSPORT_LATENCY_MAX_BITS - PLDM_TRANSPORT_LATENCY_SUB_BITS +  \
+	  1)                                                                   \
+	 << PLDM_TRANSPORT_LATENCY_SUB_BITS)
+
+/**
+ * @brief Log-linear histogram of the latency between sending requests and
+ * 	  receiving their responses
+ *
+ * @var count - the number of responses
+ * @var total_us - the sum of the latencies, in microseconds
+ * @var min_us - the lowest latency, in microseconds
+ * @var max_us - the highest latency, in microseconds
+ * @var buckets - the number of latencies in each bucket. The bounds of the
+ * 	      buckets are given by pldm_transport_latency_bucket_floor()
+ */
+struct pldm_transport_latency {
+	uint64_t count;
+	uint64_t total_us;
+	uint64_t min_us;
+	uint64_t max_us;
+	uint32_t buckets[PLDM_TRANSPORT_LATENCY_BUCKETS];
+};
+
+/**
+ * @brief Start collecting statistics for a transport
+ *
+ * While enabled, traffic through the pldm_transport_*() APIs is counted, and
+ * the latency of each response is recorded against the TID, PLDM type and
+ * command of its request. Collection stops when the transport is destroyed.
+ *
+ * @param[in] transport - pldm transport instance
+ *
+ * @return 0 on success, including if statistics are already enabled, -EINVAL
+ * 	   if transport is NULL, or -ENOMEM if memory couldn't be allocated
+ */
+int pldm_transport_stats_enable(struct pldm_transport *transport);
+
+/**
+ * @brief Stop collecting statistics for a transport and discard them
+ *
+ * @param[in] transport - pldm transport instance. May be NULL
+ */
+void pldm_transport_stats_disable(struct pldm_transport *transport);
+
+/**
+ * @brief Discard the statistics collected so far
+ *
+ * @param[in] transport - pldm transport instance
+ *
+ * @return 0 on success, -EINVAL if transport is NULL, or -ENODATA if
+ * 	   statistics are not enabled
+ */
+int pldm_transport_stats_reset(struct pldm_transport *transport);
+
+/**
+ * @brief Read the traffic counters of a transport
+ *
+ * @param[in] transport - pldm transport instance
+ * @param[out] counters - the counters
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, or -ENODATA if
+ * 	   statistics are not enabled
+ */
+int pldm_transport_stats_get_counters(struct pldm_transport *transport,
+				      struct pldm_transport_counters *counters);
+
+/**
+ * @brief Read the response latencies of a command to a TID
+ *
+ * @param[in] transport - pldm transport instance
+ * @param[in] tid - the TID to which the requests were sent
+ * @param[in] type - the PLDM type of the command
+ * @param[in] command - the command code
+ * @param[out] latency - the latency histogram
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, -ENODATA if
+ * 	   statistics are not enabled, or -ENOENT if no response to the command
+ * 	   has been received from the TID
+ */
+int pldm_transport_stats_get_latency(struct pldm_transport *transport,
+				     pldm_tid_t tid, uint8_t type,
+				     uint8_t command,
+				     struct pldm_transport_latency *latency);
+
+/**
+ * @brief Find the lowest latency counted in a histogram bucket
+ *
+ * @param[in] bucket - the index of the bucket, less than
+ * 	      PLDM_TRANSPORT_LATENCY_BUCKETS
+ *
+ * @return The lower bound of the bucket in microseconds. The upper bound is
+ * 	   the lower bound of the next bucket, while the last bucket is
+ * 	   unbounded.
+ */
+uint64_t pldm_transport_latency_bucket_floor(size_t bucket);
+
+/**
+ * @brief Estimate a percentile of the latencies in a histogram
+ *
+ * @param[in] latency - the histogram
+ * @param[in] percentile - the percentile, from 0 to 100
+ * @param[out] us - the upper bound of the bucket holding the percentile, in
+ * 	       microseconds, limited to the highest latency recorded
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, or -ENODATA if
+ * 	   the histogram is empty
+ */
+int pldm_transport_latency_percentile(
+	const struct pldm_transport_latency *latency, unsigned int percentile,
+	uint64_t *us);
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,10 +29,43 @@ int pldm_transport_af_mctp_init_pollfd(struct pldm_transport *t,
 				       struct pollfd *pollfd);
 #endif
 
+/**
+ * @brief Send without blocking, queueing what the socket can't yet accept
+ *
+ * With a send queue, messages the socket can't accept immediately are queued
+ * rather than blocking the caller, and are sent once the socket becomes
+ * writable. See pldm_transport_flush(). A send fails only if the queue is full.
+ *
+ * @param[in] ctx - The AF_MCTP transport instance
+ * @param[in] depth - The number of messages the queue can hold, or 0 to send
+ * 		      with blocking, as by default
+ *
+ * @return 0 on success, -EINVAL if ctx is NULL, -EBUSY if messages are queued,
+ * 	   or -ENOMEM if memory couldn't be allocated
+ */
+int pldm_transport_af_mctp_set_send_queue(struct pldm_transport_af_mctp *ctx,
+					  size_t depth);
+
 /* Inserts a TID-to-EID mapping into the transport's device map */
 int pldm_transport_af_mctp_map_tid(struct pldm_transport_af_mctp *ctx,
 				   pldm_tid_t tid, mctp_eid_t eid);
 
+/**
+ * @brief Inserts a TID-to-endpoint mapping for an endpoint on a specific MCTP
+ * 	  network into the transport's device map
+ *
+ * @param[in] ctx - The AF_MCTP transport instance
+ * @param[in] tid - The TID to map. Must not be 0
+ * @param[in] net - The MCTP network of the endpoint, or MCTP_NET_ANY
+ * @param[in] eid - The EID of the endpoint on the network
+ *
+ * @return 0 on success, or -EINVAL if tid is 0. Any existing mapping of the TID
+ * 	   or of the endpoint is replaced.
+ */
+int pldm_transport_af_mctp_map_tid_net(struct pldm_transport_af_mctp *ctx,
+				       pldm_tid_t tid, uint32_t net,
+				       mctp_eid_t eid);
+
 /* Removes a TID-to-EID mapping from the transport's device map */
 int pldm_transport_af_mctp_unmap_tid(struct pldm_transport_af_mctp *ctx,
 				     pldm_tid_t tid, mctp_eid_t eid);
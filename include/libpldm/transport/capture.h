@@ -0,0 +1,190 @@
+/* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#ifndef LIBPLDM_CAPTURE_H
+#define LIBPLDM_CAPTURE_H
+
+#include <libpldm/base.h>
+#include <libpldm/pldm.h>
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Capture format
+ *
+ * A capture is a 16-byte file header followed by a record for each message,
+ * all fields little-endian:
+ *
+ * File header:
+ * - magic: uint32_t, PLDM_TRANSPORT_CAPTURE_MAGIC
+ * - version: uint16_t, PLDM_TRANSPORT_CAPTURE_VERSION
+ * - reserved: uint16_t, zero
+ * - start: uint64_t, the wall-clock time of the capture, in microseconds
+ *   since the Unix epoch. Informational only
+ *
+ * Record:
+ * - delta: uint32_t, microseconds since the previous record or the start of
+ *   the capture, saturating at UINT32_MAX
+ * - len: uint32_t, the length of the message
+ * - tid: uint8_t, the remote TID, the source or destination of the message
+ * - dir: uint8_t, a value of enum pldm_transport_capture_dir
+ * - msg: len bytes, the PLDM message
+ */
+#define PLDM_TRANSPORT_CAPTURE_MAGIC	   0x50434d50 /* "PMCP" */
+#define PLDM_TRANSPORT_CAPTURE_VERSION	   1
+#define PLDM_TRANSPORT_CAPTURE_HEADER_SIZE 16
+#define PLDM_TRANSPORT_CAPTURE_RECORD_SIZE 10
+
+/* Direction of a captured message, from the point of view of the capturer */
+enum pldm_transport_capture_dir {
+	PLDM_TRANSPORT_CAPTURE_TX = 0,
+	PLDM_TRANSPORT_CAPTURE_RX = 1,
+};
+
+/**
+ * @brief Transport backend recording the traffic of another transport
+ *
+ * Messages sent and received through the capture transport are passed to and
+ * from the inner transport, and successful transfers are appended to a
+ * capture written to a file descriptor. Capture is best-effort: failing to
+ * write the capture doesn't disturb the traffic, but is reported by
+ * pldm_transport_capture_flush().
+ */
+struct pldm_transport_capture;
+
+/**
+ * @brief Start capturing the traffic of a transport
+ *
+ * @param[out] ctx - *ctx must be NULL, and will point to the transport on
+ * 	       success
+ * @param[in] inner - the transport carrying the traffic, which must outlive
+ * 	      the capture transport
+ * @param[in] fd - the file descriptor to which the capture is written. The
+ * 	      caller retains ownership
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, -ENOMEM if memory
+ * 	   couldn't be allocated, or a negative errno value if the file header
+ * 	   couldn't be written
+ */
+int pldm_transport_capture_init(struct pldm_transport_capture **ctx,
+				struct pldm_transport *inner, int fd);
+
+/**
+ * @brief Write the records buffered by the capture transport
+ *
+ * @param[in] ctx - the capture transport
+ *
+ * @return 0 on success, -EINVAL if ctx is NULL, or the negative errno value of
+ * 	   the first failure to write the capture. Records that couldn't be
+ * 	   written are lost, and later records are not written.
+ */
+int pldm_transport_capture_flush(struct pldm_transport_capture *ctx);
+
+/* Flush the capture and destroy the transport backend. Neither the inner
+ * transport nor the file descriptor are closed */
+void pldm_transport_capture_destroy(struct pldm_transport_capture *ctx);
+
+/* Get the core pldm transport struct */
+struct pldm_transport *
+pldm_transport_capture_core(struct pldm_transport_capture *ctx);
+
+#ifdef PLDM_HAS_POLL
+struct pollfd;
+/* Init pollfd for async calls */
+int pldm_transport_capture_init_pollfd(struct pldm_transport *t,
+				       struct pollfd *pollfd);
+#endif
+
+/* Replay the messages as quickly as they're consumed */
+#define PLDM_TRANSPORT_REPLAY_FLAT_OUT 0
+
+/**
+ * @brief Transport backend replaying a capture
+ *
+ * The replay transport stands in for the peers of the capturer: the captured
+ * received messages are received from it, and the captured sent messages are
+ * expected to be sent to it, in the captured order. A received message is
+ * delivered once the sent messages preceding it in the capture have been
+ * sent, and once the captured delay since the previous message, divided by
+ * the replay speed, has elapsed.
+ *
+ * Messages sent need not match the capture exactly. Those that differ are
+ * counted in the progress of the replay. The instance IDs of requests may
+ * differ without being counted, and the instance IDs of the captured responses
+ * are rewritten to those of the requests sent in place of the captured
+ * requests.
+ */
+struct pldm_transport_replay;
+
+/**
+ * @brief Progress of a replay
+ *
+ * @var records - the number of records in the capture
+ * @var received - the number of captured received messages delivered
+ * @var sent - the number of captured sent messages consumed by a send
+ * @var mismatched - the number of messages sent that differed from the
+ * 	      capture other than by instance ID
+ * @var unexpected - the number of messages sent after every captured sent
+ * 	      message was consumed. These sends fail
+ */
+struct pldm_transport_replay_progress {
+	size_t records;
+	size_t received;
+	size_t sent;
+	size_t mismatched;
+	size_t unexpected;
+};
+
+/**
+ * @brief Prepare to replay a capture
+ *
+ * @param[out] ctx - *ctx must be NULL, and will point to the transport on
+ * 	       success
+ * @param[in] capture - the capture, which must outlive the transport
+ * @param[in] len - the length of the capture
+ * @param[in] speed - the factor by which to accelerate the replay, 1 to replay
+ * 	      at the captured pace, or PLDM_TRANSPORT_REPLAY_FLAT_OUT to
+ * 	      ignore the captured timing
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, -EPROTO if the
+ * 	   capture is malformed or truncated, -ENOMEM if memory couldn't be
+ * 	   allocated, or a negative errno value if the timerfd couldn't be
+ * 	   created
+ */
+int pldm_transport_replay_init(struct pldm_transport_replay **ctx,
+			       const void *capture, size_t len,
+			       unsigned int speed);
+
+/* Destroy the transport backend */
+void pldm_transport_replay_destroy(struct pldm_transport_replay *ctx);
+
+/* Get the core pldm transport struct */
+struct pldm_transport *
+pldm_transport_replay_core(struct pldm_transport_replay *ctx);
+
+/**
+ * @brief Report the progress of a replay
+ *
+ * @param[in] ctx - the replay transport
+ * @param[out] progress - the progress
+ *
+ * @return 1 if every captured message has been received or sent, 0 if the
+ * 	   replay is incomplete, or -EINVAL if the arguments are invalid
+ */
+int pldm_transport_replay_get_progress(
+	struct pldm_transport_replay *ctx,
+	struct pldm_transport_replay_progress *progress);
+
+#ifdef PLDM_HAS_POLL
+/* Init pollfd for async calls */
+int pldm_transport_replay_init_pollfd(struct pldm_transport *t,
+				      struct pollfd *pollfd);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBPLDM_CAPTURE_H */
@@ -0,0 +1,125 @@
+/* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#ifndef LIBPLDM_IO_URING_H
+#define LIBPLDM_IO_URING_H
+
+#include <libpldm/base.h>
+#include <libpldm/pldm.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Transport backend driving an MCTP socket through io_uring
+ *
+ * Messages are received by a multishot receive into a ring of buffers provided
+ * to the kernel, so receiving does not require a system call per message, and
+ * batches of messages are sent with a single system call.
+ */
+struct pldm_transport_io_uring;
+
+/**
+ * @brief The framing of the messages carried by the socket
+ */
+enum pldm_transport_io_uring_framing {
+	/** An AF_MCTP datagram socket, addressing endpoints by sockaddr_mctp */
+	PLDM_TRANSPORT_IO_URING_AF_MCTP,
+	/**
+	 * A sequenced-packet socket connected to the mctp-demux-daemon, where
+	 * each message is prefixed by the EID of the endpoint and the MCTP
+	 * message type
+	 */
+	PLDM_TRANSPORT_IO_URING_MCTP_DEMUX,
+};
+
+/**
+ * @brief Handler for a message received by pldm_transport_io_uring_process()
+ *
+ * @param[in] data - the data pointer provided to
+ * 	      pldm_transport_io_uring_process()
+ * @param[in] tid - the source TID of the message
+ * @param[in] msg - the received message, in the receive buffer of the
+ * 	      transport. Only valid for the duration of the call
+ * @param[in] msg_len - the length of msg
+ */
+typedef void (*pldm_transport_io_uring_msg_handler)(void *data, pldm_tid_t tid,
+						    const void *msg,
+						    size_t msg_len);
+
+/**
+ * @brief Init the transport backend
+ *
+ * @param[out] ctx - *ctx must be NULL, and will point to the transport on
+ * 	       success
+ * @param[in] socket - the socket over which to exchange messages. It must
+ * 	      outlive the transport, and is not closed by
+ * 	      pldm_transport_io_uring_destroy(). An AF_MCTP socket must be bound
+ * 	      to receive requests
+ * @param[in] framing - the framing of the messages carried by socket
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, -ENOMEM if memory
+ * 	   couldn't be allocated, or a negative errno value if the io_uring
+ * 	   instance couldn't be set up
+ */
+int pldm_transport_io_uring_init(struct pldm_transport_io_uring **ctx,
+				 int socket,
+				 enum pldm_transport_io_uring_framing framing);
+
+/* Destroy the transport backend */
+void pldm_transport_io_uring_destroy(struct pldm_transport_io_uring *ctx);
+
+/* Get the core pldm transport struct */
+struct pldm_transport *
+pldm_transport_io_uring_core(struct pldm_transport_io_uring *ctx);
+
+#ifdef PLDM_HAS_POLL
+struct pollfd;
+/* Init pollfd for async calls */
+int pldm_transport_io_uring_init_pollfd(struct pldm_transport *t,
+					struct pollfd *pollfd);
+#endif
+
+/**
+ * @brief Inserts a TID-to-endpoint mapping into the transport's device map
+ *
+ * @param[in] ctx - The io_uring transport instance
+ * @param[in] tid - The TID to map. Must not be 0
+ * @param[in] net - The MCTP network of the endpoint, or MCTP_NET_ANY. Ignored
+ * 	      for PLDM_TRANSPORT_IO_URING_MCTP_DEMUX
+ * @param[in] eid - The EID of the endpoint
+ *
+ * @return 0 on success, or -EINVAL if tid is 0
+ */
+int pldm_transport_io_uring_map_tid(struct pldm_transport_io_uring *ctx,
+				    pldm_tid_t tid, uint32_t net,
+				    mctp_eid_t eid);
+
+/* Removes a TID-to-EID mapping from the transport's device map */
+int pldm_transport_io_uring_unmap_tid(struct pldm_transport_io_uring *ctx,
+				      pldm_tid_t tid, mctp_eid_t eid);
+
+/**
+ * @brief Pass the messages already received to a handler without copying them
+ *
+ * Does not wait for messages. Messages from unmapped endpoints, and messages
+ * too short or too long for the transport, are discarded.
+ *
+ * @param[in] ctx - The io_uring transport instance
+ * @param[in] handler - The handler invoked for each message
+ * @param[in] data - an opaque pointer passed to handler
+ *
+ * @return The number of messages passed to handler, -EINVAL if the arguments
+ * 	   are invalid, or -EIO if receiving failed
+ */
+int pldm_transport_io_uring_process(struct pldm_transport_io_uring *ctx,
+				    pldm_transport_io_uring_msg_handler handler,
+				    void *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBPLDM_IO_URING_H */
@@ -28,6 +28,23 @@ int pldm_transport_mctp_demux_init_pollfd(struct pldm_transport *t,
 					  struct pollfd *pollfd);
 #endif
 
+/**
+ * @brief Send without blocking, queueing what the socket can't yet accept
+ *
+ * With a send queue, messages the socket can't accept immediately are queued
+ * rather than blocking the caller, and are sent once the socket becomes
+ * writable. See pldm_transport_flush(). A send fails only if the queue is full.
+ *
+ * @param[in] ctx - The mctp-demux transport instance
+ * @param[in] depth - The number of messages the queue can hold, or 0 to send
+ * 		      with blocking, as by default
+ *
+ * @return 0 on success, -EINVAL if ctx is NULL, -EBUSY if messages are queued,
+ * 	   or -ENOMEM if memory couldn't be allocated
+ */
+int pldm_transport_mctp_demux_set_send_queue(
+	struct pldm_transport_mctp_demux *ctx, size_t depth);
+
 /* Inserts a TID-to-EID mapping into the transport's device map */
 int pldm_transport_mctp_demux_map_tid(struct pldm_transport_mctp_demux *ctx,
 				      pldm_tid_t tid, mctp_eid_t eid);
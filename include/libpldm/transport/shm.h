@@ -0,0 +1,135 @@
+/* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#ifndef LIBPLDM_SHM_H
+#define LIBPLDM_SHM_H
+
+#include <libpldm/base.h>
+#include <libpldm/pldm.h>
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The maximum number of endpoints sharing a region */
+#define PLDM_TRANSPORT_SHM_MAX_ENDPOINTS 16
+
+/**
+ * @brief Shared memory connecting co-located PLDM endpoints
+ *
+ * Each endpoint attached to the region has an inbox: a bounded ring of
+ * fixed-size message slots. Any number of endpoints, in any number of
+ * threads or processes, may send to an inbox concurrently, and the owner of
+ * the inbox is woken through an eventfd.
+ *
+ * The region is backed by a memfd. Processes share it by inheriting the region
+ * across fork(2), or by passing the file descriptors obtained from
+ * pldm_transport_shm_region_fds() to pldm_transport_shm_region_open().
+ */
+struct pldm_transport_shm_region;
+
+/**
+ * @brief Transport backend for an endpoint attached to a shared memory region
+ */
+struct pldm_transport_shm;
+
+/**
+ * @brief Create a shared memory region
+ *
+ * @param[out] region - *region must be NULL, and will point to the region on
+ * 	       success
+ * @param[in] endpoints - the number of endpoints that may attach, at most
+ * 	      PLDM_TRANSPORT_SHM_MAX_ENDPOINTS
+ * @param[in] slots - the capacity of each inbox in messages. Must be a power
+ * 	      of two
+ * @param[in] msg_size - the size of the largest message that can be sent.
+ * 	      Must be at least the size of a PLDM message header and at most
+ * 	      65536
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, -ENOMEM if memory
+ * 	   couldn't be allocated, or a negative errno value if the memfd or
+ * 	   eventfds couldn't be created
+ */
+int pldm_transport_shm_region_create(struct pldm_transport_shm_region **region,
+				     size_t endpoints, size_t slots,
+				     size_t msg_size);
+
+/**
+ * @brief Open a shared memory region created by another process
+ *
+ * The file descriptors are duplicated, so the caller retains ownership of
+ * those passed.
+ *
+ * @param[out] region - *region must be NULL, and will point to the region on
+ * 	       success
+ * @param[in] memfd - the memfd of the region
+ * @param[in] eventfds - the eventfds of the region's inboxes
+ * @param[in] count - the number of eventfds, which must match the number of
+ * 	      endpoints of the region
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid or the memfd
+ * 	   doesn't hold a region, -ENOMEM if memory couldn't be allocated, or a
+ * 	   negative errno value if the region couldn't be mapped
+ */
+int pldm_transport_shm_region_open(struct pldm_transport_shm_region **region,
+				   int memfd, const int *eventfds,
+				   size_t count);
+
+/**
+ * @brief Get the file descriptors for sharing a region with another process
+ *
+ * @param[in] region - the region
+ * @param[out] memfd - the memfd of the region
+ * @param[out] eventfds - receives the eventfds of the region's inboxes
+ * @param[in] count - the capacity of eventfds, which must be at least the
+ * 	      number of endpoints of the region
+ *
+ * @return The number of eventfds, or -EINVAL if the arguments are invalid
+ */
+int pldm_transport_shm_region_fds(struct pldm_transport_shm_region *region,
+				  int *memfd, int *eventfds, size_t count);
+
+/**
+ * @brief Unmap a shared memory region and close its file descriptors
+ *
+ * @param[in] region - the region. Endpoints attached through it must be
+ * 	      destroyed first. May be NULL
+ */
+void pldm_transport_shm_region_destroy(
+	struct pldm_transport_shm_region *region);
+
+/**
+ * @brief Attach an endpoint to a shared memory region
+ *
+ * @param[out] ctx - *ctx must be NULL, and will point to the transport on
+ * 	       success
+ * @param[in] region - the region, which must outlive the transport
+ * @param[in] tid - the TID of the endpoint. Messages sent to it are received
+ * 	      by this transport, and messages it sends are received from it
+ *
+ * @return 0 on success, -EINVAL if the arguments are invalid, -EEXIST if an
+ * 	   endpoint with the TID is already attached, -ENOSPC if all inboxes
+ * 	   are in use, or -ENOMEM if memory couldn't be allocated
+ */
+int pldm_transport_shm_init(struct pldm_transport_shm **ctx,
+			    struct pldm_transport_shm_region *region,
+			    pldm_tid_t tid);
+
+/* Detach the endpoint and destroy the transport backend */
+void pldm_transport_shm_destroy(struct pldm_transport_shm *ctx);
+
+/* Get the core pldm transport struct */
+struct pldm_transport *pldm_transport_shm_core(struct pldm_transport_shm *ctx);
+
+#ifdef PLDM_HAS_POLL
+struct pollfd;
+/* Init pollfd for async calls */
+int pldm_transport_shm_init_pollfd(struct pldm_transport *t,
+				   struct pollfd *pollfd);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBPLDM_SHM_H */
@@ -31,6 +31,50 @@ struct variable_field {
 uint8_t pldm_edac_crc8(const void *data, size_t size);
 uint8_t crc8(const void *data, size_t size);
 
+/** @struct pldm_edac_crc8_ctx
+ *
+ *  State for an incremental CRC8 computation. The member is private to the
+ *  implementation.
+ */
+struct pldm_edac_crc8_ctx {
+	uint8_t state;
+};
+
+/** @brief Begin an incremental crc8 computation
+ *
+ *  @param[out] ctx - The CRC8 state to initialise
+ *  @return 0 on success, or -EINVAL if ctx is NULL
+ */
+int pldm_edac_crc8_init(struct pldm_edac_crc8_ctx *ctx);
+
+/** @brief Feed data into an incremental crc8 computation
+ *
+ *  @param[in,out] ctx - The CRC8 state, initialised by pldm_edac_crc8_init()
+ *  @param[in] data - Pointer to the next segment of data
+ *  @param[in] size - Size of the data segment
+ *  @return 0 on success, or -EINVAL if ctx is NULL, or data is NULL while size
+ *	    is non-zero
+ */
+int pldm_edac_crc8_update(struct pldm_edac_crc8_ctx *ctx, const void *data,
+			  size_t size);
+
+/** @brief Extract the checksum from an incremental crc8 computation
+ *
+ *  @param[in] ctx - The CRC8 state
+ *  @param[out] crc - The checksum over all data fed to ctx so far
+ *  @return 0 on success, or -EINVAL if ctx or crc are NULL
+ */
+int pldm_edac_crc8_final(const struct pldm_edac_crc8_ctx *ctx, uint8_t *crc);
+
+/** @brief Combine the crc8 checksums of two adjacent segments
+ *
+ *  @param[in] crc1 - The checksum of the first segment
+ *  @param[in] crc2 - The checksum of the second segment
+ *  @param[in] len2 - The length of the second segment
+ *  @return The checksum of the concatenated segments
+ */
+uint8_t pldm_edac_crc8_combine(uint8_t crc1, uint8_t crc2, size_t len2);
+
 /** @brief Compute crc32 (same as the one used by IEEE802.3)
  *
  *  @param[in] data - Pointer to the target data
@@ -40,6 +84,61 @@ uint8_t crc8(const void *data, size_t size);
 uint32_t pldm_edac_crc32(const void *data, size_t size);
 uint32_t crc32(const void *data, size_t size);
 
+/** @struct pldm_edac_crc32_ctx
+ *
+ *  State for an incremental CRC32 computation. The member is private to the
+ *  implementation.
+ */
+struct pldm_edac_crc32_ctx {
+	uint32_t state;
+};
+
+/** @brief Begin an incremental crc32 computation
+ *
+ *  Feeding the same bytes to pldm_edac_crc32_update(), in one or more calls,
+ *  yields the same result from pldm_edac_crc32_final() as pldm_edac_crc32()
+ *  over the concatenated data.
+ *
+ *  @param[out] ctx - The CRC32 state to initialise
+ *  @return 0 on success, or -EINVAL if ctx is NULL
+ */
+int pldm_edac_crc32_init(struct pldm_edac_crc32_ctx *ctx);
+
+/** @brief Feed data into an incremental crc32 computation
+ *
+ *  @param[in,out] ctx - The CRC32 state, initialised by pldm_edac_crc32_init()
+ *  @param[in] data - Pointer to the next segment of data
+ *  @param[in] size - Size of the data segment
+ *  @return 0 on success, or -EINVAL if ctx is NULL, or data is NULL while size
+ *	    is non-zero
+ */
+int pldm_edac_crc32_update(struct pldm_edac_crc32_ctx *ctx, const void *data,
+			   size_t size);
+
+/** @brief Extract the checksum from an incremental crc32 computation
+ *
+ *  The state is not modified, and may continue to be updated afterwards.
+ *
+ *  @param[in] ctx - The CRC32 state
+ *  @param[out] crc - The checksum over all data fed to ctx so far
+ *  @return 0 on success, or -EINVAL if ctx or crc are NULL
+ */
+int pldm_edac_crc32_final(const struct pldm_edac_crc32_ctx *ctx, uint32_t *crc);
+
+/** @brief Combine the crc32 checksums of two adjacent segments
+ *
+ *  Given crc1 = pldm_edac_crc32(A, len1) and crc2 = pldm_edac_crc32(B, len2),
+ *  computes pldm_edac_crc32() over A followed by B without access to the data.
+ *  This allows segments of a large object to be checksummed independently,
+ *  for example in parallel.
+ *
+ *  @param[in] crc1 - The checksum of the first segment
+ *  @param[in] crc2 - The checksum of the second segment
+ *  @param[in] len2 - The length of the second segment
+ *  @return The checksum of the concatenated segments
+ */
+uint32_t pldm_edac_crc32_combine(uint32_t crc1, uint32_t crc2, size_t len2);
+
 /** @brief Convert ver32_t to string
  *  @param[in] version - Pointer to ver32_t
  *  @param[out] buffer - Pointer to the buffer
@@ -9,10 +9,20 @@
 #include <compiler.h>
 #include <msgbuf.h>
 
+#include <libpldm/control.h>
+
 #ifndef PLDM_CONTROL_MAX_VERSION_TYPES
 #define PLDM_CONTROL_MAX_VERSION_TYPES 6
 #endif
 
+/* Versions a type registered with handlers may report, excluding the CRC32 */
+#ifndef PLDM_CONTROL_MAX_VERSIONS
+#define PLDM_CONTROL_MAX_VERSIONS 4
+#endif
+
+/* PLDM types are six bits in the message header */
+#define PLDM_CONTROL_MAX_TYPES 64
+
 struct pldm_type_versions {
 	/* A buffer of ver32_t/uint32_t of version values, followed by crc32 */
 	/* NULL for unused entries */
@@ -24,8 +34,22 @@ struct pldm_type_versions {
 	const bitfield8_t *commands;
 
 	uint8_t pldm_type;
+
+	/* Set by pldm_control_register_type(), NULL for report-only types */
+	const struct pldm_control_handler *handlers;
+	void *ctx;
+	/* One more than the index in handlers for each command, or 0 */
+	uint8_t handler_index[256];
+
+	/* Storage for the versions and commands generated at registration */
+	uint32_t versions_buf[PLDM_CONTROL_MAX_VERSIONS + 1];
+	bitfield8_t commands_buf[32];
 };
 
 struct pldm_control {
 	struct pldm_type_versions types[PLDM_CONTROL_MAX_VERSION_TYPES];
+	/* One more than the index in types for each PLDM type, or 0 */
+	uint8_t type_index[PLDM_CONTROL_MAX_TYPES];
+	/* The GetPLDMTypes response payload, kept up to date with types */
+	uint8_t types_resp[PLDM_GET_TYPES_RESP_BYTES];
 };
@@ -1,3 +1,4 @@
+#include <endian.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
@@ -9,21 +10,12 @@
 #include <compiler.h>
 #include <msgbuf.h>
 
+#include "array.h"
 #include "control-internal.h"
 
-#define PLDM_BASE_VERSIONS_COUNT 2
-static const uint32_t PLDM_BASE_VERSIONS[PLDM_BASE_VERSIONS_COUNT] = {
-	/* PLDM 1.1.0 is current implemented. */
-	0xf1f1f000,
-	/* CRC. Calculated with python:
-	hex(crccheck.crc.Crc32.calc(struct.pack('<I', 0xf1f1f000)))
-	*/
-	0x539dbeba,
-};
-const bitfield8_t PLDM_CONTROL_COMMANDS[32] = {
-	// 0x00..0x07
-	{ .byte = (1 << PLDM_GET_TID | 1 << PLDM_GET_PLDM_VERSION |
-		   1 << PLDM_GET_PLDM_TYPES | 1 << PLDM_GET_PLDM_COMMANDS) }
+/* PLDM 1.1.0 is current implemented. */
+static const ver32_t PLDM_BASE_VERSIONS[] = {
+	{ .major = 0xf1, .minor = 0xf1, .update = 0xf0, .alpha = 0x00 },
 };
 
 static int pldm_control_reply_error(uint8_t ccode,
@@ -39,15 +31,17 @@ static int pldm_control_reply_error(uint8_t ccode,
 	}
 	*resp_payload_len = 1;
 
-	rc = encode_cc_only_resp(req_hdr->instance, PLDM_FWUP, req_hdr->command,
-				 ccode, resp);
+	rc = encode_cc_only_resp(req_hdr->instance, req_hdr->pldm_type,
+				 req_hdr->command, ccode, resp);
 	if (rc != PLDM_SUCCESS) {
 		return -EINVAL;
 	}
 	return 0;
 }
 
-static int pldm_control_get_tid(const struct pldm_header_info *hdr,
+static int pldm_control_get_tid(void *ctx LIBPLDM_CC_UNUSED,
+				pldm_tid_t tid LIBPLDM_CC_UNUSED,
+				const struct pldm_header_info *hdr,
 				const struct pldm_msg *req LIBPLDM_CC_UNUSED,
 				size_t req_payload_len, struct pldm_msg *resp,
 				size_t *resp_payload_len)
@@ -71,13 +65,46 @@ static int pldm_control_get_tid(const struct pldm_header_info *hdr,
 	return 0;
 }
 
-static int pldm_control_get_version(struct pldm_control *control,
+/* Responses echo the instance ID, type and command of the request */
+static void pldm_control_reply_header(const struct pldm_header_info *hdr,
+				      struct pldm_msg *resp)
+{
+	resp->hdr.request = 0;
+	resp->hdr.datagram = 0;
+	resp->hdr.reserved = 0;
+	resp->hdr.instance_id = hdr->instance;
+	resp->hdr.header_ver = PLDM_CURRENT_VERSION;
+	resp->hdr.type = hdr->pldm_type;
+	resp->hdr.command = hdr->command;
+}
+
+static const struct pldm_type_versions *
+pldm_control_find_type(const struct pldm_control *control, uint8_t pldm_type)
+{
+	const struct pldm_type_versions *v;
+
+	if (pldm_type >= PLDM_CONTROL_MAX_TYPES ||
+	    !control->type_index[pldm_type]) {
+		return NULL;
+	}
+
+	v = &control->types[control->type_index[pldm_type] - 1];
+	return v->versions ? v : NULL;
+}
+
+static int pldm_control_get_version(void *ctx,
+				    pldm_tid_t tid LIBPLDM_CC_UNUSED,
 				    const struct pldm_header_info *hdr,
 				    const struct pldm_msg *req,
 				    size_t req_payload_len,
 				    struct pldm_msg *resp,
 				    size_t *resp_payload_len)
 {
+	/* Completion code, next transfer handle and transfer flag. The
+	 * response is always sent as a single transfer */
+	static const uint8_t prefix[] = { PLDM_SUCCESS, 0, 0, 0, 0,
+					  PLDM_START_AND_END };
+	struct pldm_control *control = ctx;
 	uint8_t cc;
 
 	uint32_t handle;
@@ -90,92 +117,67 @@ static int pldm_control_get_version(struct pldm_control *control,
 						resp_payload_len);
 	}
 
-	/* Response is always sent as a single transfer */
 	if (opflag != PLDM_GET_FIRSTPART) {
 		return pldm_control_reply_error(
 			PLDM_CONTROL_INVALID_TRANSFER_OPERATION_FLAG, hdr, resp,
 			resp_payload_len);
 	}
 
-	const struct pldm_type_versions *v = NULL;
-	for (int i = 0; i < PLDM_CONTROL_MAX_VERSION_TYPES; i++) {
-		if (control->types[i].pldm_type == type &&
-		    control->types[i].versions) {
-			v = &control->types[i];
-			break;
-		}
-	}
-
+	const struct pldm_type_versions *v =
+		pldm_control_find_type(control, type);
 	if (!v) {
 		return pldm_control_reply_error(
 			PLDM_CONTROL_INVALID_PLDM_TYPE_IN_REQUEST_DATA, hdr,
 			resp, resp_payload_len);
 	}
 
-	/* encode_get_version_resp doesn't have length checking */
-	uint32_t required_resp_payload =
-		1 + 4 + 1 + v->versions_count * sizeof(ver32_t);
-	if (*resp_payload_len < required_resp_payload) {
+	/* crc32 is included in the versions buffer */
+	size_t versions_len = v->versions_count * sizeof(ver32_t);
+	if (*resp_payload_len < sizeof(prefix) + versions_len) {
 		return -EOVERFLOW;
 	}
-	*resp_payload_len = required_resp_payload;
+	*resp_payload_len = sizeof(prefix) + versions_len;
 
-	/* crc32 is included in the versions buffer */
-	cc = encode_get_version_resp(hdr->instance, PLDM_SUCCESS, 0,
-				     PLDM_START_AND_END, v->versions,
-				     v->versions_count * sizeof(ver32_t), resp);
-	if (cc) {
-		return pldm_control_reply_error(cc, hdr, resp,
-						resp_payload_len);
-	}
+	pldm_control_reply_header(hdr, resp);
+	memcpy(resp->payload, prefix, sizeof(prefix));
+	memcpy(resp->payload + sizeof(prefix), v->versions, versions_len);
 	return 0;
 }
 
-static int pldm_control_get_types(struct pldm_control *control,
+static int pldm_control_get_types(void *ctx,
+				  pldm_tid_t tid LIBPLDM_CC_UNUSED,
 				  const struct pldm_header_info *hdr,
 				  const struct pldm_msg *req LIBPLDM_CC_UNUSED,
 				  size_t req_payload_len, struct pldm_msg *resp,
 				  size_t *resp_payload_len)
 {
-	uint8_t cc;
+	struct pldm_control *control = ctx;
 
 	if (req_payload_len != PLDM_GET_TYPES_REQ_BYTES) {
 		return pldm_control_reply_error(PLDM_ERROR_INVALID_LENGTH, hdr,
 						resp, resp_payload_len);
 	}
 
-	bitfield8_t types[8];
-	memset(types, 0, sizeof(types));
-	for (int i = 0; i < PLDM_CONTROL_MAX_VERSION_TYPES; i++) {
-		uint8_t ty = control->types[i].pldm_type;
-		if (ty < 64 && control->types[i].versions) {
-			uint8_t bit = 1 << (ty % 8);
-			types[ty / 8].byte |= bit;
-		}
-	}
-
-	/* encode_get_types_resp doesn't have length checking */
-	uint32_t required_resp_payload = 1 + 8;
-	if (*resp_payload_len < required_resp_payload) {
+	if (*resp_payload_len < sizeof(control->types_resp)) {
 		return -EOVERFLOW;
 	}
-	*resp_payload_len = required_resp_payload;
+	*resp_payload_len = sizeof(control->types_resp);
 
-	cc = encode_get_types_resp(hdr->instance, PLDM_SUCCESS, types, resp);
-	if (cc) {
-		return pldm_control_reply_error(cc, hdr, resp,
-						resp_payload_len);
-	}
+	pldm_control_reply_header(hdr, resp);
+	memcpy(resp->payload, control->types_resp,
+	       sizeof(control->types_resp));
 	return 0;
 }
 
-static int pldm_control_get_commands(struct pldm_control *control,
+static int pldm_control_get_commands(void *ctx,
+				     pldm_tid_t tid LIBPLDM_CC_UNUSED,
 				     const struct pldm_header_info *hdr,
 				     const struct pldm_msg *req,
 				     size_t req_payload_len,
 				     struct pldm_msg *resp,
 				     size_t *resp_payload_len)
 {
+	struct pldm_control *control = ctx;
 	uint8_t cc;
 
 	uint8_t ty;
@@ -187,104 +189,146 @@ static int pldm_control_get_commands(struct pldm_control *control,
 						resp_payload_len);
 	}
 
-	const struct pldm_type_versions *v = NULL;
-	for (int i = 0; i < PLDM_CONTROL_MAX_VERSION_TYPES; i++) {
-		if (control->types[i].pldm_type == ty &&
-		    control->types[i].versions && control->types[i].commands) {
-			v = &control->types[i];
-			break;
-		}
-	}
-
-	if (!v) {
+	const struct pldm_type_versions *v =
+		pldm_control_find_type(control, ty);
+	if (!v || !v->commands) {
 		return pldm_control_reply_error(
 			PLDM_CONTROL_INVALID_PLDM_TYPE_IN_REQUEST_DATA, hdr,
 			resp, resp_payload_len);
 	}
 
-	/* encode_get_commands_resp doesn't have length checking */
-	uint32_t required_resp_payload = 1 + 32;
-	if (*resp_payload_len < required_resp_payload) {
+	/* Completion code and the command bitmap */
+	if (*resp_payload_len < PLDM_GET_COMMANDS_RESP_BYTES) {
 		return -EOVERFLOW;
 	}
-	*resp_payload_len = required_resp_payload;
+	*resp_payload_len = PLDM_GET_COMMANDS_RESP_BYTES;
 
-	cc = encode_get_commands_resp(hdr->instance, PLDM_SUCCESS, v->commands,
-				      resp);
-	if (cc) {
-		return pldm_control_reply_error(cc, hdr, resp,
-						resp_payload_len);
-	}
+	pldm_control_reply_header(hdr, resp);
+	resp->payload[0] = PLDM_SUCCESS;
+	memcpy(resp->payload + 1, v->commands,
+	       PLDM_GET_COMMANDS_RESP_BYTES - 1);
 	return 0;
 }
 
-/* A response should only be used when this returns 0, and *resp_len > 0 */
+static const struct pldm_control_handler PLDM_CONTROL_HANDLERS[] = {
+	{ .command = PLDM_GET_TID, .request = pldm_control_get_tid },
+	{ .command = PLDM_GET_PLDM_VERSION, .request = pldm_control_get_version },
+	{ .command = PLDM_GET_PLDM_TYPES, .request = pldm_control_get_types },
+	{ .command = PLDM_GET_PLDM_COMMANDS,
+	  .request = pldm_control_get_commands },
+};
+
 LIBPLDM_ABI_TESTING
-int pldm_control_handle_msg(struct pldm_control *control, const void *req_msg,
-			    size_t req_len, void *resp_msg, size_t *resp_len)
+int pldm_control_dispatch(struct pldm_control *control, pldm_tid_t tid,
+			  const void *msg, size_t msg_len, void *resp_msg,
+			  size_t *resp_len)
 {
+	const struct pldm_control_handler *handler = NULL;
+	const struct pldm_type_versions *v = NULL;
+	const struct pldm_msg *req = msg;
+	struct pldm_msg *resp = resp_msg;
+	struct pldm_header_info hdr;
+	size_t resp_payload_len;
+	size_t req_payload_len;
+	uint8_t slot;
+	uint8_t cc;
 	int rc;
 
-	/* Space for header plus completion code */
-	if (*resp_len < sizeof(struct pldm_msg_hdr) + 1) {
-		return -EOVERFLOW;
+	if (!control || !msg || !resp_msg || !resp_len) {
+		return -EINVAL;
 	}
-	size_t resp_payload_len = *resp_len - sizeof(struct pldm_msg_hdr);
-	struct pldm_msg *resp = resp_msg;
 
-	if (req_len < sizeof(struct pldm_msg_hdr)) {
+	if (msg_len < sizeof(struct pldm_msg_hdr)) {
 		return -EOVERFLOW;
 	}
-	size_t req_payload_len = req_len - sizeof(struct pldm_msg_hdr);
-	const struct pldm_msg *req = req_msg;
+	req_payload_len = msg_len - sizeof(struct pldm_msg_hdr);
 
-	struct pldm_header_info hdr;
 	rc = unpack_pldm_header(&req->hdr, &hdr);
 	if (rc != PLDM_SUCCESS) {
 		return -EINVAL;
 	}
 
-	if (hdr.pldm_type != PLDM_BASE) {
-		/* Caller should not have passed non-control */
-		return -ENOMSG;
+	/* The type and command index the handler tables directly */
+	slot = control->type_index[hdr.pldm_type % PLDM_CONTROL_MAX_TYPES];
+	if (slot) {
+		v = &control->types[slot - 1];
+		if (v->handlers && v->handler_index[hdr.command]) {
+			handler =
+				&v->handlers[v->handler_index[hdr.command] - 1];
+		}
+	}
+
+	if (hdr.msg_type == PLDM_RESPONSE) {
+		*resp_len = 0;
+		if (!handler || !handler->response) {
+			return -ENOMSG;
+		}
+		resp_payload_len = 0;
+		return handler->response(v->ctx, tid, &hdr, req,
+					 req_payload_len, resp,
+					 &resp_payload_len);
 	}
 
 	if (hdr.msg_type != PLDM_REQUEST) {
-		return -EINVAL;
+		return -EPROTO;
+	}
+
+	/* Types added without handlers are answered by the application */
+	if (v && !v->handlers) {
+		*resp_len = 0;
+		return -ENOMSG;
+	}
+
+	/* Space for header plus completion code */
+	if (*resp_len < sizeof(struct pldm_msg_hdr) + 1) {
+		return -EOVERFLOW;
 	}
+	resp_payload_len = *resp_len - sizeof(struct pldm_msg_hdr);
 
-	/* Dispatch command */
-	switch (hdr.command) {
-	case PLDM_GET_TID:
-		rc = pldm_control_get_tid(&hdr, req, req_payload_len, resp,
-					  &resp_payload_len);
-		break;
-	case PLDM_GET_PLDM_VERSION:
-		rc = pldm_control_get_version(control, &hdr, req,
-					      req_payload_len, resp,
+	if (handler && handler->request) {
+		rc = handler->request(v->ctx, tid, &hdr, req, req_payload_len,
+				      resp, &resp_payload_len);
+	} else {
+		cc = v ? PLDM_ERROR_UNSUPPORTED_PLDM_CMD :
+			 PLDM_ERROR_INVALID_PLDM_TYPE;
+		rc = pldm_control_reply_error(cc, &hdr, resp,
 					      &resp_payload_len);
-		break;
-	case PLDM_GET_PLDM_TYPES:
-		rc = pldm_control_get_types(control, &hdr, req, req_payload_len,
-					    resp, &resp_payload_len);
-		break;
-	case PLDM_GET_PLDM_COMMANDS:
-		rc = pldm_control_get_commands(control, &hdr, req,
-					       req_payload_len, resp,
-					       &resp_payload_len);
-		break;
-	default:
-		rc = pldm_control_reply_error(PLDM_ERROR_UNSUPPORTED_PLDM_CMD,
-					      &hdr, resp, &resp_payload_len);
 	}
 
 	if (rc == 0) {
-		*resp_len = resp_payload_len + sizeof(struct pldm_msg_hdr);
+		*resp_len = resp_payload_len ?
+				    resp_payload_len +
+					    sizeof(struct pldm_msg_hdr) :
+				    0;
 	}
 
 	return rc;
 }
 
+/* A response should only be used when this returns 0, and *resp_len > 0 */
+LIBPLDM_ABI_TESTING
+int pldm_control_handle_msg(struct pldm_control *control, const void *req_msg,
+			    size_t req_len, void *resp_msg, size_t *resp_len)
+{
+	const struct pldm_msg *req = req_msg;
+
+	if (req_len < sizeof(struct pldm_msg_hdr)) {
+		return -EOVERFLOW;
+	}
+
+	if (req->hdr.type != PLDM_BASE) {
+		/* Caller should not have passed non-control */
+		return -ENOMSG;
+	}
+
+	if (req->hdr.request != 1 || req->hdr.datagram) {
+		return -EINVAL;
+	}
+
+	return pldm_control_dispatch(control, 0, req_msg, req_len, resp_msg,
+				     resp_len);
+}
+
 LIBPLDM_ABI_TESTING
 int pldm_control_setup(struct pldm_control *control, size_t pldm_control_size)
 {
@@ -296,9 +340,11 @@ int pldm_control_setup(struct pldm_control *control, size_t pldm_control_size)
 
 	memset(control, 0, sizeof(struct pldm_control));
 
-	rc = pldm_control_add_type(control, PLDM_BASE, &PLDM_BASE_VERSIONS,
-				   PLDM_BASE_VERSIONS_COUNT,
-				   PLDM_CONTROL_COMMANDS);
+	rc = pldm_control_register_type(control, PLDM_BASE, PLDM_BASE_VERSIONS,
+					ARRAY_SIZE(PLDM_BASE_VERSIONS),
+					PLDM_CONTROL_HANDLERS,
+					ARRAY_SIZE(PLDM_CONTROL_HANDLERS),
+					control);
 	if (rc) {
 		return rc;
 	}
@@ -306,35 +352,119 @@ int pldm_control_setup(struct pldm_control *control, size_t pldm_control_size)
 	return 0;
 }
 
-LIBPLDM_ABI_TESTING
-int pldm_control_add_type(struct pldm_control *control, uint8_t pldm_type,
-			  const void *versions, size_t versions_count,
-			  const bitfield8_t *commands)
+/* The GetPLDMTypes response payload is rebuilt whenever a type is added */
+static void pldm_control_update_types(struct pldm_control *control)
 {
-	if (versions_count < 2) {
-		/* At least one version must be provided, along with a CRC32 */
-		return -EINVAL;
+	memset(control->types_resp, 0, sizeof(control->types_resp));
+	control->types_resp[0] = PLDM_SUCCESS;
+	for (int i = 0; i < PLDM_CONTROL_MAX_VERSION_TYPES; i++) {
+		uint8_t ty = control->types[i].pldm_type;
+		if (ty < 64 && control->types[i].versions) {
+			control->types_resp[1 + ty / 8] |= 1 << (ty % 8);
+		}
 	}
+}
 
-	struct pldm_type_versions *v = NULL;
+static struct pldm_type_versions *
+pldm_control_type_slot(struct pldm_control *control, uint8_t pldm_type)
+{
 	for (int i = 0; i < PLDM_CONTROL_MAX_VERSION_TYPES; i++) {
 		if (control->types[i].versions == NULL ||
 		    (control->types[i].versions != NULL &&
 		     control->types[i].pldm_type == pldm_type)) {
-			v = &control->types[i];
-			break;
+			if (pldm_type < PLDM_CONTROL_MAX_TYPES) {
+				control->type_index[pldm_type] = i + 1;
+			}
+			return &control->types[i];
 		}
 	}
 
+	/* No spare slots */
+	return NULL;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_control_add_type(struct pldm_control *control, uint8_t pldm_type,
+			  const void *versions, size_t versions_count,
+			  const bitfield8_t *commands)
+{
+	if (versions_count < 2) {
+		/* At least one version must be provided, along with a CRC32 */
+		return -EINVAL;
+	}
+
+	struct pldm_type_versions *v = pldm_control_type_slot(control, pldm_type);
 	if (!v) {
 		return -ENOMEM;
-		// No spare slots
 	}
 
 	v->pldm_type = pldm_type;
 	v->versions = versions;
 	v->versions_count = versions_count;
 	v->commands = commands;
+	v->handlers = NULL;
+	pldm_control_update_types(control);
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_control_register_type(struct pldm_control *control, uint8_t pldm_type,
+			       const ver32_t *versions, size_t versions_count,
+			       const struct pldm_control_handler *handlers,
+			       size_t handlers_count, void *ctx)
+{
+	uint8_t handler_index[256] = { 0 };
+	bitfield8_t commands[32] = { 0 };
+	struct pldm_type_versions *v;
+	size_t i;
+
+	if (!control || !versions || versions_count < 1 ||
+	    versions_count > PLDM_CONTROL_MAX_VERSIONS) {
+		return -EINVAL;
+	}
+
+	if (pldm_type >= PLDM_CONTROL_MAX_TYPES) {
+		return -EINVAL;
+	}
+
+	if ((!handlers && handlers_count) || handlers_count > UINT8_MAX) {
+		return -EINVAL;
+	}
+
+	for (i = 0; i < handlers_count; i++) {
+		uint8_t command = handlers[i].command;
+
+		if (handler_index[command] ||
+		    (!handlers[i].request && !handlers[i].response)) {
+			return -EINVAL;
+		}
+		handler_index[command] = i + 1;
+
+		if (handlers[i].request) {
+			commands[command / 8].byte |= 1 << (command % 8);
+		}
+	}
+
+	v = pldm_control_type_slot(control, pldm_type);
+	if (!v) {
+		return -ENOMEM;
+	}
+
+	/* The CRC32 covers the versions as they're sent */
+	memcpy(v->versions_buf, versions, versions_count * sizeof(ver32_t));
+	v->versions_buf[versions_count] = htole32(pldm_edac_crc32(
+		v->versions_buf, versions_count * sizeof(ver32_t)));
+	memcpy(v->commands_buf, commands, sizeof(commands));
+	memcpy(v->handler_index, handler_index, sizeof(handler_index));
+
+	v->pldm_type = pldm_type;
+	v->versions = v->versions_buf;
+	v->versions_count = versions_count + 1;
+	v->commands = v->commands_buf;
+	v->handlers = handlers;
+	v->ctx = ctx;
+	pldm_control_update_types(control);
 
 	return 0;
 }
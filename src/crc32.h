@@ -0,0 +1,50 @@
+/* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#ifndef LIBPLDM_SRC_CRC32_H
+#define LIBPLDM_SRC_CRC32_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) && __has_attribute(target)
+#define PLDM_CRC32_HAVE_HW 1
+#elif defined(__aarch64__) && __has_attribute(target) &&                      \
+	__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define PLDM_CRC32_HAVE_HW 1
+#else
+#define PLDM_CRC32_HAVE_HW 0
+#endif
+
+/*
+ * The functions below operate on the raw CRC register for the reflected IEEE
+ * 802.3 polynomial (0xedb88320). Callers are responsible for the initial and
+ * final inversion, see pldm_edac_crc32().
+ *
+ * pldm_crc32_update() selects the fastest implementation available on the
+ * running CPU. The remaining implementations are exposed for testing and
+ * benchmarking, and must produce identical results for identical input.
+ */
+uint32_t pldm_crc32_update(uint32_t crc, const void *data, size_t size);
+
+/* Byte-at-a-time, using a single 256-entry table */
+uint32_t pldm_crc32_update_bytewise(uint32_t crc, const void *data,
+				    size_t size);
+
+/* Slicing-by-8, consuming 8 bytes per iteration */
+uint32_t pldm_crc32_update_slice8(uint32_t crc, const void *data, size_t size);
+
+/* Slicing-by-16, consuming 16 bytes per iteration */
+uint32_t pldm_crc32_update_slice16(uint32_t crc, const void *data,
+				   size_t size);
+
+#if PLDM_CRC32_HAVE_HW
+/*
+ * Hardware-assisted implementation: PCLMULQDQ folding on x86-64, or the ARMv8
+ * CRC32 instructions on AArch64. Must only be called if
+ * pldm_crc32_hw_supported() returns true.
+ */
+bool pldm_crc32_hw_supported(void);
+uint32_t pldm_crc32_update_hw(uint32_t crc, const void *data, size_t size);
+#endif
+
+#endif
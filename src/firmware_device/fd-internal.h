@@ -34,11 +34,55 @@ struct pldm_fd_req {
 	/* Only valid in SENT state */
 	uint8_t instance_id;
 	uint8_t command;
+	/* Also the time of the last poll of a pending verify or apply */
 	pldm_fd_time_t sent_time;
 };
 
+/* A RequestFirmwareData request in the download window */
+struct pldm_fd_chunk {
+	enum pldm_fd_chunk_state {
+		// Slot is unused
+		PLDM_FD_CHUNK_FREE = 0,
+		// Split from a failed chunk, waiting to be requested
+		PLDM_FD_CHUNK_PENDING,
+		// Waiting for a response
+		PLDM_FD_CHUNK_SENT,
+		// Answered with a failure, resent after FD_T2
+		PLDM_FD_CHUNK_RETRY,
+	} state;
+
+	uint8_t instance_id;
+	uint32_t offset;
+	uint32_t length;
+	pldm_fd_time_t sent_time;
+	/* Resent or failed, so its response time isn't sampled */
+	bool retried;
+};
+
 struct pldm_fd_download {
+	/* Offset of the next chunk to request */
 	uint32_t offset;
+	struct pldm_fd_chunk chunks[PLDM_FD_REQUEST_WINDOW_MAX];
+};
+
+/* RequestFirmwareData length control and statistics. The length is kept
+ * across the components of an update, the statistics are per component */
+struct pldm_fd_transfer {
+	/* Length of new requests, between the baseline and max_transfer */
+	uint32_t size;
+	/* Smoothed response time in milliseconds, scaled by 8. 0 until the
+	 * first sample */
+	pldm_fd_time_t srtt;
+
+	/* Bytes passed to the firmware_data callback */
+	uint32_t received;
+	uint32_t failures;
+	/* Set when the first request of the component is sent */
+	bool started;
+	pldm_fd_time_t start_time;
+	/* Set when the download of the component finishes */
+	bool finished;
+	pldm_fd_time_t end_time;
 };
 
 struct pldm_fd_verify {
@@ -69,7 +113,9 @@ struct pldm_fd {
 	struct pldm_firmware_update_component update_comp;
 	bitfield32_t update_flags;
 
-	/* Used for download/verify/apply requests */
+	/* Used for download/verify/apply requests. While downloading, the
+	 * RequestFirmwareData requests themselves are tracked by the window in
+	 * struct pldm_fd_download */
 	struct pldm_fd_req req;
 
 	/* Address of the UA */
@@ -79,6 +125,11 @@ struct pldm_fd {
 	/* Maximum size allowed by the UA or platform implementation */
 	uint32_t max_transfer;
 
+	/* RequestFirmwareData requests that may be outstanding at once */
+	uint8_t request_window;
+
+	struct pldm_fd_transfer xfer;
+
 	/* Timestamp for FD T1 timeout, milliseconds */
 	pldm_fd_time_t update_timestamp_fd_t1;
 
@@ -11,6 +11,7 @@
 #include <compiler.h>
 #include <msgbuf.h>
 
+#include "array.h"
 #include "fd-internal.h"
 
 /* FD_T1 Update mode idle timeout, 120 seconds (range [60s, 120s])*/
@@ -19,34 +20,16 @@ static const pldm_fd_time_t DEFAULT_FD_T1_TIMEOUT = 120000;
 /* FD_T2 "Retry request for firmware data", 1 second (range [1s, 5s]) */
 static const pldm_fd_time_t DEFAULT_FD_T2_RETRY_TIME = 1000;
 
+/* RequestFirmwareData length is halved on a failure, and grows by this much
+ * for each timely response */
+static const uint32_t FWDATA_SIZE_STEP = PLDM_FWUP_BASELINE_TRANSFER_SIZE;
+
 static const uint8_t INSTANCE_ID_COUNT = 32;
 static const uint8_t PROGRESS_PERCENT_NOT_SUPPORTED = 101;
 
-#define PLDM_FD_VERSIONS_COUNT 2
-static const uint32_t PLDM_FD_VERSIONS[PLDM_FD_VERSIONS_COUNT] = {
-	/* Only PLDM Firmware 1.1.0 is current implemented. */
-	0xf1f1f000,
-	/* CRC. Calculated with python:
-	hex(crccheck.crc.Crc32.calc(struct.pack('<I', 0xf1f1f000)))
-	*/
-	0x539dbeba,
-};
-const bitfield8_t PLDM_FD_COMMANDS[32] = {
-	// 0x00..0x07
-	{ .byte = (1 << PLDM_QUERY_DEVICE_IDENTIFIERS |
-		   1 << PLDM_GET_FIRMWARE_PARAMETERS) },
-	{ 0 },
-	// 0x10..0x17
-	{ .byte = (1u << PLDM_REQUEST_UPDATE | 1u << PLDM_PASS_COMPONENT_TABLE |
-		   1u << PLDM_UPDATE_COMPONENT) >>
-		  0x10 },
-	// 0x18..0x1f
-	{
-		.byte = (1u << PLDM_ACTIVATE_FIRMWARE | 1u << PLDM_GET_STATUS |
-			 1u << PLDM_CANCEL_UPDATE_COMPONENT |
-			 1u << PLDM_CANCEL_UPDATE) >>
-			0x18,
-	},
+/* Only PLDM Firmware 1.1.0 is current implemented. */
+static const ver32_t PLDM_FD_VERSIONS[] = {
+	{ .major = 0xf1, .minor = 0xf1, .update = 0xf0, .alpha = 0x00 },
 };
 
 /* Ensure that public definition is kept updated */
@@ -232,6 +215,65 @@ static uint8_t pldm_fd_req_next_instance(struct pldm_fd_req *req)
 	return req->instance_id;
 }
 
+LIBPLDM_CC_NONNULL
+static struct pldm_fd_chunk *pldm_fd_chunk_by_instance(struct pldm_fd *fd,
+						       uint8_t instance_id)
+{
+	struct pldm_fd_download *dl = &fd->specific.download;
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(dl->chunks); i++) {
+		if (dl->chunks[i].state == PLDM_FD_CHUNK_SENT &&
+		    dl->chunks[i].instance_id == instance_id) {
+			return &dl->chunks[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Allocate the next instance ID for a RequestFirmwareData request, skipping
+ * those of requests still in the window. The window is smaller than the range,
+ * so one is always free */
+LIBPLDM_CC_NONNULL
+static uint8_t pldm_fd_chunk_next_instance(struct pldm_fd *fd)
+{
+	do {
+		pldm_fd_req_next_instance(&fd->req);
+	} while (pldm_fd_chunk_by_instance(fd, fd->req.instance_id));
+
+	return fd->req.instance_id;
+}
+
+/* Whether the FD is downloading data, rather than completing the transfer */
+LIBPLDM_CC_NONNULL
+static bool pldm_fd_downloading(const struct pldm_fd *fd)
+{
+	return fd->state == PLDM_FD_STATE_DOWNLOAD &&
+	       fd->req.state == PLDM_FD_REQ_READY && !fd->req.complete;
+}
+
+/* Whether a response from the UA is awaited */
+LIBPLDM_CC_NONNULL
+static bool pldm_fd_req_pending(const struct pldm_fd *fd)
+{
+	const struct pldm_fd_download *dl = &fd->specific.download;
+	size_t i;
+
+	if (!pldm_fd_downloading(fd)) {
+		return fd->req.state == PLDM_FD_REQ_SENT;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(dl->chunks); i++) {
+		if (dl->chunks[i].state == PLDM_FD_CHUNK_SENT ||
+		    dl->chunks[i].state == PLDM_FD_CHUNK_RETRY) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 LIBPLDM_CC_NONNULL
 static int pldm_fd_qdi(struct pldm_fd *fd, const struct pldm_header_info *hdr,
 		       const struct pldm_msg *req LIBPLDM_CC_UNUSED,
@@ -414,6 +456,10 @@ static int pldm_fd_request_update(struct pldm_fd *fd,
 	fd->ua_address = address;
 	fd->ua_address_set = true;
 
+	/* Start each update at the full size, and learn the link afresh */
+	memset(&fd->xfer, 0x0, sizeof(fd->xfer));
+	fd->xfer.size = fd->max_transfer;
+
 	pldm_fd_set_state(fd, PLDM_FD_STATE_LEARN_COMPONENTS);
 
 	return 0;
@@ -602,6 +648,10 @@ static int pldm_fd_update_comp(struct pldm_fd *fd,
 	/* Set up download state */
 	if (comp_response_code == PLDM_CRC_COMP_CAN_BE_UPDATED) {
 		memset(&fd->specific, 0x0, sizeof(fd->specific));
+		fd->xfer.received = 0;
+		fd->xfer.failures = 0;
+		fd->xfer.started = false;
+		fd->xfer.finished = false;
 		fd->update_flags = update_flags;
 		fd->req.state = PLDM_FD_REQ_READY;
 		fd->req.complete = false;
@@ -647,7 +697,7 @@ static int pldm_fd_get_status(struct pldm_fd *fd,
 				one_percent += 1;
 			}
 			st.progress_percent =
-				(fd->specific.download.offset / one_percent);
+				(fd->xfer.received / one_percent);
 		}
 		st.update_option_flags_enabled = fd->update_flags;
 		break;
@@ -812,83 +862,155 @@ static uint32_t pldm_fd_fwdata_size(struct pldm_fd *fd)
 	}
 	size = fd->update_comp.comp_image_size - fd->specific.download.offset;
 
-	if (size > fd->max_transfer) {
-		size = fd->max_transfer;
+	if (size > fd->xfer.size) {
+		size = fd->xfer.size;
 	}
 	return size;
 }
 
+/* Sample the response time of a chunk, and grow the request length unless the
+ * response was slow enough to suggest congestion. Retried chunks aren't
+ * sampled, their response may be to an earlier request */
+LIBPLDM_CC_NONNULL
+static void pldm_fd_transfer_success(struct pldm_fd *fd,
+				     const struct pldm_fd_chunk *chunk)
+{
+	struct pldm_fd_transfer *xfer = &fd->xfer;
+	pldm_fd_time_t now = pldm_fd_now(fd);
+	pldm_fd_time_t sample;
+	bool slow = false;
+
+	if (!chunk->retried && now >= chunk->sent_time) {
+		sample = now - chunk->sent_time;
+		if (xfer->srtt == 0) {
+			xfer->srtt = sample * 8;
+		} else {
+			/* Slower than twice the smoothed time */
+			slow = sample * 4 > xfer->srtt;
+			xfer->srtt = xfer->srtt - xfer->srtt / 8 + sample;
+		}
+	}
+
+	if (!slow) {
+		xfer->size += FWDATA_SIZE_STEP;
+		if (xfer->size > fd->max_transfer) {
+			xfer->size = fd->max_transfer;
+		}
+	}
+}
+
+/* Halve the request length after a chunk failed. The chunk itself is cut to
+ * the new length for its retry when a slot is free for the remainder */
+LIBPLDM_CC_NONNULL
+static void pldm_fd_transfer_failed(struct pldm_fd *fd,
+				    struct pldm_fd_chunk *chunk)
+{
+	struct pldm_fd_download *dl = &fd->specific.download;
+	struct pldm_fd_transfer *xfer = &fd->xfer;
+	size_t i;
+
+	xfer->failures++;
+	xfer->size /= 2;
+	if (xfer->size < PLDM_FWUP_BASELINE_TRANSFER_SIZE) {
+		xfer->size = PLDM_FWUP_BASELINE_TRANSFER_SIZE;
+	}
+	chunk->retried = true;
+
+	if (chunk->length <= xfer->size) {
+		return;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(dl->chunks); i++) {
+		struct pldm_fd_chunk *rest = &dl->chunks[i];
+
+		if (rest->state == PLDM_FD_CHUNK_FREE) {
+			rest->state = PLDM_FD_CHUNK_PENDING;
+			rest->offset = chunk->offset + xfer->size;
+			rest->length = chunk->length - xfer->size;
+			rest->retried = false;
+			chunk->length = xfer->size;
+			return;
+		}
+	}
+}
+
+/* Finish the download with a TransferComplete of result, dropping requests
+ * still in the window */
+LIBPLDM_CC_NONNULL
+static void pldm_fd_download_complete(struct pldm_fd *fd, uint8_t result)
+{
+	struct pldm_fd_download *dl = &fd->specific.download;
+
+	memset(dl->chunks, 0x0, sizeof(dl->chunks));
+	fd->req.state = PLDM_FD_REQ_READY;
+	fd->req.complete = true;
+	fd->req.result = result;
+	fd->xfer.finished = true;
+	fd->xfer.end_time = pldm_fd_now(fd);
+}
+
 LIBPLDM_CC_NONNULL
 static int pldm_fd_handle_fwdata_resp(struct pldm_fd *fd,
 				      const struct pldm_msg *resp,
 				      size_t resp_payload_len)
 {
-	struct pldm_fd_download *dl;
-	uint32_t fwdata_size;
+	struct pldm_fd_chunk *chunk;
 	uint8_t res;
 
-	if (fd->state != PLDM_FD_STATE_DOWNLOAD) {
+	if (!pldm_fd_downloading(fd)) {
+		/* Not waiting for data, or received data after completion */
 		return -EPROTO;
 	}
 
-	if (fd->req.state != PLDM_FD_REQ_SENT) {
-		/* Not waiting for a response, ignore it */
+	chunk = pldm_fd_chunk_by_instance(fd, resp->hdr.instance_id);
+	if (!chunk) {
+		/* Response wasn't for a request in the window */
 		return -EPROTO;
 	}
 
-	dl = &fd->specific.download;
-	if (fd->req.complete) {
-		/* Received data after completion */
-		return -EPROTO;
-	}
+	fd->update_timestamp_fd_t1 = pldm_fd_now(fd);
 
 	switch (resp->payload[0]) {
 	case PLDM_SUCCESS:
 		break;
 	case PLDM_FWUP_RETRY_REQUEST_FW_DATA:
-		/* Just return, let the retry timer send another request later */
+		/* Let the retry timer send a shorter request later */
+		pldm_fd_transfer_failed(fd, chunk);
+		chunk->state = PLDM_FD_CHUNK_RETRY;
 		return 0;
 	default:
 		/* Send a TransferComplete failure */
-		fd->req.state = PLDM_FD_REQ_READY;
-		fd->req.complete = true;
-		fd->req.result = PLDM_FWUP_FD_ABORTED_TRANSFER;
+		pldm_fd_download_complete(fd, PLDM_FWUP_FD_ABORTED_TRANSFER);
 		return 0;
 	}
 
 	/* Handle the received data */
 
-	fwdata_size = pldm_fd_fwdata_size(fd);
-	if (resp_payload_len != fwdata_size + 1) {
+	if (resp_payload_len != chunk->length + 1) {
 		/* Data is incorrect size. Could indicate MCTP corruption, drop it
 		 * and let retry timer handle it */
+		pldm_fd_transfer_failed(fd, chunk);
+		chunk->state = PLDM_FD_CHUNK_RETRY;
 		return -EOVERFLOW;
 	}
 
-	/* Check pldm_fd_fwdata_size calculation, should not fail */
-	if (dl->offset + fwdata_size < dl->offset ||
-	    dl->offset + fwdata_size > fd->update_comp.comp_image_size) {
-		assert(false);
-		return -EINVAL;
-	}
+	pldm_fd_transfer_success(fd, chunk);
 
 	/* Provide the data chunk to the device */
-	res = fd->ops->firmware_data(fd->ops_ctx, dl->offset, &resp->payload[1],
-				     fwdata_size, &fd->update_comp);
-
-	fd->req.state = PLDM_FD_REQ_READY;
-	if (res == PLDM_FWUP_TRANSFER_SUCCESS) {
-		/* Move to next offset */
-		dl->offset += fwdata_size;
-		if (dl->offset == fd->update_comp.comp_image_size) {
-			/* Mark as complete, next progress() call will send the TransferComplete request */
-			fd->req.complete = true;
-			fd->req.result = PLDM_FWUP_TRANSFER_SUCCESS;
-		}
-	} else {
+	res = fd->ops->firmware_data(fd->ops_ctx, chunk->offset,
+				     &resp->payload[1], chunk->length,
+				     &fd->update_comp);
+	if (res != PLDM_FWUP_TRANSFER_SUCCESS) {
 		/* Pass the callback error as the TransferResult */
-		fd->req.complete = true;
-		fd->req.result = res;
+		pldm_fd_download_complete(fd, res);
+		return 0;
+	}
+
+	fd->xfer.received += chunk->length;
+	chunk->state = PLDM_FD_CHUNK_FREE;
+	if (fd->xfer.received == fd->update_comp.comp_image_size) {
+		/* Mark as complete, next progress() call will send the TransferComplete request */
+		pldm_fd_download_complete(fd, PLDM_FWUP_TRANSFER_SUCCESS);
 	}
 
 	return 0;
@@ -1013,6 +1135,15 @@ static int pldm_fd_handle_resp(struct pldm_fd *fd, pldm_tid_t address,
 	}
 	resp_payload_len = resp_len - sizeof(struct pldm_msg_hdr);
 
+	/* Data responses are matched to their request in the window */
+	if (pldm_fd_downloading(fd)) {
+		if (resp->hdr.command != PLDM_REQUEST_FIRMWARE_DATA) {
+			// Response wasn't for an outstanding request
+			return -EPROTO;
+		}
+		return pldm_fd_handle_fwdata_resp(fd, resp, resp_payload_len);
+	}
+
 	if (fd->req.state != PLDM_FD_REQ_SENT) {
 		// No response was expected
 		return -EPROTO;
@@ -1030,9 +1161,6 @@ static int pldm_fd_handle_resp(struct pldm_fd *fd, pldm_tid_t address,
 	fd->update_timestamp_fd_t1 = pldm_fd_now(fd);
 
 	switch (resp->hdr.command) {
-	case PLDM_REQUEST_FIRMWARE_DATA:
-		return pldm_fd_handle_fwdata_resp(fd, resp, resp_payload_len);
-		break;
 	case PLDM_TRANSFER_COMPLETE:
 		return pldm_fd_handle_transfer_complete_resp(fd, resp,
 							     resp_payload_len);
@@ -1052,37 +1180,134 @@ static int pldm_fd_handle_resp(struct pldm_fd *fd, pldm_tid_t address,
 	}
 }
 
+/* Pick the request to send next from the window: the first whose retry time
+ * has elapsed, else if the window has space the remainder of a failed chunk,
+ * else a new chunk */
+LIBPLDM_CC_NONNULL
+static struct pldm_fd_chunk *pldm_fd_next_chunk(struct pldm_fd *fd)
+{
+	struct pldm_fd_download *dl = &fd->specific.download;
+	struct pldm_fd_chunk *pending_chunk = NULL;
+	struct pldm_fd_chunk *free_chunk = NULL;
+	pldm_fd_time_t now = pldm_fd_now(fd);
+	size_t outstanding = 0;
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(dl->chunks); i++) {
+		struct pldm_fd_chunk *chunk = &dl->chunks[i];
+
+		if (chunk->state == PLDM_FD_CHUNK_FREE) {
+			if (!free_chunk) {
+				free_chunk = chunk;
+			}
+			continue;
+		}
+
+		if (chunk->state == PLDM_FD_CHUNK_PENDING) {
+			if (!pending_chunk) {
+				pending_chunk = chunk;
+			}
+			continue;
+		}
+
+		/* Time going backwards doesn't trigger a retry */
+		if (now >= chunk->sent_time &&
+		    now - chunk->sent_time >= fd->fd_t2_retry_time) {
+			if (chunk->state == PLDM_FD_CHUNK_SENT) {
+				/* No response, possibly lost for its size */
+				pldm_fd_transfer_failed(fd, chunk);
+			}
+			return chunk;
+		}
+		outstanding++;
+	}
+
+	if (outstanding >= fd->request_window) {
+		return NULL;
+	}
+
+	if (pending_chunk) {
+		return pending_chunk;
+	}
+
+	if (!free_chunk || dl->offset == fd->update_comp.comp_image_size) {
+		return NULL;
+	}
+
+	free_chunk->offset = dl->offset;
+	free_chunk->length = pldm_fd_fwdata_size(fd);
+	free_chunk->retried = false;
+	dl->offset += free_chunk->length;
+
+	return free_chunk;
+}
+
+LIBPLDM_CC_NONNULL
+static int pldm_fd_progress_fwdata(struct pldm_fd *fd, struct pldm_msg *req,
+				   size_t *req_payload_len)
+{
+	struct pldm_request_firmware_data_req req_params;
+	struct pldm_fd_chunk *chunk;
+	uint8_t instance_id;
+	int rc;
+
+	if (fd->update_comp.comp_image_size == 0) {
+		/* Nothing to request */
+		pldm_fd_download_complete(fd, PLDM_FWUP_TRANSFER_SUCCESS);
+		*req_payload_len = 0;
+		return 0;
+	}
+
+	chunk = pldm_fd_next_chunk(fd);
+	if (!chunk) {
+		/* Nothing to do */
+		*req_payload_len = 0;
+		return 0;
+	}
+
+	instance_id = pldm_fd_chunk_next_instance(fd);
+	req_params.offset = chunk->offset;
+	req_params.length = chunk->length;
+	rc = encode_request_firmware_data_req(instance_id, &req_params, req,
+					      req_payload_len);
+	if (rc) {
+		return rc;
+	}
+
+	/* Wait for response */
+	chunk->state = PLDM_FD_CHUNK_SENT;
+	chunk->instance_id = instance_id;
+	chunk->sent_time = pldm_fd_now(fd);
+
+	if (!fd->xfer.started) {
+		fd->xfer.started = true;
+		fd->xfer.start_time = chunk->sent_time;
+	}
+
+	return 0;
+}
+
 LIBPLDM_CC_NONNULL
 static int pldm_fd_progress_download(struct pldm_fd *fd, struct pldm_msg *req,
 				     size_t *req_payload_len)
 {
 	uint8_t instance_id;
-	struct pldm_fd_download *dl;
 	int rc;
 
+	if (pldm_fd_downloading(fd)) {
+		return pldm_fd_progress_fwdata(fd, req, req_payload_len);
+	}
+
 	if (!pldm_fd_req_should_send(fd)) {
 		/* Nothing to do */
 		*req_payload_len = 0;
 		return 0;
 	}
 
+	/* Send TransferComplete */
 	instance_id = pldm_fd_req_next_instance(&fd->req);
-	dl = &fd->specific.download;
-	if (fd->req.complete) {
-		/* Send TransferComplete */
-		rc = encode_transfer_complete_req(instance_id, fd->req.result,
-						  req, req_payload_len);
-	} else {
-		/* Send a new RequestFirmwareData */
-		const struct pldm_request_firmware_data_req req_params = {
-			.offset = dl->offset,
-			.length = pldm_fd_fwdata_size(fd),
-		};
-
-		rc = encode_request_firmware_data_req(instance_id, &req_params,
-						      req, req_payload_len);
-	}
-
+	rc = encode_transfer_complete_req(instance_id, fd->req.result, req,
+					  req_payload_len);
 	if (rc) {
 		return rc;
 	}
@@ -1118,6 +1343,7 @@ static int pldm_fd_progress_verify(struct pldm_fd *fd, struct pldm_msg *req,
 			if (res == PLDM_FWUP_VERIFY_SUCCESS) {
 				/* Return without a VerifyComplete request.
 				* Will call verify() again on next call */
+				fd->req.sent_time = pldm_fd_now(fd);
 				*req_payload_len = 0;
 				return 0;
 			}
@@ -1166,6 +1392,7 @@ static int pldm_fd_progress_apply(struct pldm_fd *fd, struct pldm_msg *req,
 			if (res == PLDM_FWUP_APPLY_SUCCESS) {
 				/* Return without a ApplyComplete request.
 				* Will call apply() again on next call */
+				fd->req.sent_time = pldm_fd_now(fd);
 				*req_payload_len = 0;
 				return 0;
 			}
@@ -1201,6 +1428,43 @@ static int pldm_fd_progress_apply(struct pldm_fd *fd, struct pldm_msg *req,
 	return 0;
 }
 
+static int pldm_fd_dispatch(void *ctx, pldm_tid_t tid,
+			    const struct pldm_header_info *hdr LIBPLDM_CC_UNUSED,
+			    const struct pldm_msg *msg, size_t payload_len,
+			    struct pldm_msg *resp, size_t *resp_payload_len)
+{
+	size_t resp_len = *resp_payload_len + sizeof(struct pldm_msg_hdr);
+	int rc;
+
+	rc = pldm_fd_handle_msg(ctx, tid, msg,
+				payload_len + sizeof(struct pldm_msg_hdr), resp,
+				&resp_len);
+	if (rc == 0) {
+		*resp_payload_len =
+			resp_len ? resp_len - sizeof(struct pldm_msg_hdr) : 0;
+	}
+
+	return rc;
+}
+
+/* Requests handled by pldm_fd_handle_msg(), and responses to the FD's
+ * requests */
+static const struct pldm_control_handler PLDM_FD_HANDLERS[] = {
+	{ PLDM_QUERY_DEVICE_IDENTIFIERS, pldm_fd_dispatch, NULL },
+	{ PLDM_GET_FIRMWARE_PARAMETERS, pldm_fd_dispatch, NULL },
+	{ PLDM_REQUEST_UPDATE, pldm_fd_dispatch, NULL },
+	{ PLDM_PASS_COMPONENT_TABLE, pldm_fd_dispatch, NULL },
+	{ PLDM_UPDATE_COMPONENT, pldm_fd_dispatch, NULL },
+	{ PLDM_ACTIVATE_FIRMWARE, pldm_fd_dispatch, NULL },
+	{ PLDM_GET_STATUS, pldm_fd_dispatch, NULL },
+	{ PLDM_CANCEL_UPDATE_COMPONENT, pldm_fd_dispatch, NULL },
+	{ PLDM_CANCEL_UPDATE, pldm_fd_dispatch, NULL },
+	{ PLDM_REQUEST_FIRMWARE_DATA, NULL, pldm_fd_dispatch },
+	{ PLDM_TRANSFER_COMPLETE, NULL, pldm_fd_dispatch },
+	{ PLDM_VERIFY_COMPLETE, NULL, pldm_fd_dispatch },
+	{ PLDM_APPLY_COMPLETE, NULL, pldm_fd_dispatch },
+};
+
 LIBPLDM_ABI_TESTING
 struct pldm_fd *pldm_fd_new(const struct pldm_fd_ops *ops, void *ops_ctx,
 			    struct pldm_control *control)
@@ -1246,12 +1510,13 @@ int pldm_fd_setup(struct pldm_fd *fd, size_t pldm_fd_size,
 	fd->ops_ctx = ops_ctx;
 	fd->fd_t1_timeout = DEFAULT_FD_T1_TIMEOUT;
 	fd->fd_t2_retry_time = DEFAULT_FD_T2_RETRY_TIME;
+	fd->request_window = 1;
 
 	if (control) {
-		rc = pldm_control_add_type(control, PLDM_FWUP,
-					   &PLDM_FD_VERSIONS,
-					   PLDM_FD_VERSIONS_COUNT,
-					   PLDM_FD_COMMANDS);
+		rc = pldm_control_register_type(
+			control, PLDM_FWUP, PLDM_FD_VERSIONS,
+			ARRAY_SIZE(PLDM_FD_VERSIONS), PLDM_FD_HANDLERS,
+			ARRAY_SIZE(PLDM_FD_HANDLERS), fd);
 		if (rc) {
 			return rc;
 		}
@@ -1341,7 +1606,7 @@ int pldm_fd_handle_msg(struct pldm_fd *fd, pldm_tid_t remote_address,
 	}
 
 	/* Dispatch command.
-	 Update PLDM_FD_COMMANDS if adding new handlers */
+	 Update PLDM_FD_HANDLERS if adding new handlers */
 	switch (hdr.command) {
 	case PLDM_QUERY_DEVICE_IDENTIFIERS:
 		rc = pldm_fd_qdi(fd, &hdr, req, req_payload_len, resp,
@@ -1434,7 +1699,7 @@ int pldm_fd_progress(struct pldm_fd *fd, void *out_msg, size_t *out_len,
 	case PLDM_FD_STATE_VERIFY:
 	case PLDM_FD_STATE_APPLY:
 		// FD-driven states will time out if a response isn't received
-		ua_timeout_check = (fd->req.state == PLDM_FD_REQ_SENT);
+		ua_timeout_check = pldm_fd_req_pending(fd);
 		break;
 	case PLDM_FD_STATE_IDLE:
 		ua_timeout_check = false;
@@ -1462,6 +1727,98 @@ int pldm_fd_progress(struct pldm_fd *fd, void *out_msg, size_t *out_len,
 	return rc;
 }
 
+/* A new chunk can be requested now if the window has space, otherwise the
+ * earliest retry is due at FD_T2 after its request, unless FD_T1 expires
+ * first */
+LIBPLDM_CC_NONNULL
+static pldm_fd_time_t pldm_fd_download_deadline(struct pldm_fd *fd)
+{
+	const struct pldm_fd_download *dl = &fd->specific.download;
+	bool more = dl->offset < fd->update_comp.comp_image_size;
+	pldm_fd_time_t deadline;
+	size_t outstanding = 0;
+	size_t i;
+
+	deadline = fd->update_timestamp_fd_t1 + fd->fd_t1_timeout + 1;
+	for (i = 0; i < ARRAY_SIZE(dl->chunks); i++) {
+		const struct pldm_fd_chunk *chunk = &dl->chunks[i];
+		pldm_fd_time_t retry;
+
+		if (chunk->state == PLDM_FD_CHUNK_PENDING) {
+			more = true;
+			continue;
+		}
+
+		if (chunk->state != PLDM_FD_CHUNK_SENT &&
+		    chunk->state != PLDM_FD_CHUNK_RETRY) {
+			continue;
+		}
+
+		retry = chunk->sent_time + fd->fd_t2_retry_time;
+		if (retry < deadline) {
+			deadline = retry;
+		}
+		outstanding++;
+	}
+
+	if (!outstanding || (outstanding < fd->request_window && more)) {
+		return pldm_fd_now(fd);
+	}
+
+	return deadline;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_fd_next_deadline(struct pldm_fd *fd, uint64_t *deadline)
+{
+	pldm_fd_time_t retry;
+	pldm_fd_time_t t1;
+
+	if (fd == NULL || deadline == NULL) {
+		return -EINVAL;
+	}
+
+	/* pldm_fd_progress() times out once FD_T1 is exceeded */
+	t1 = fd->update_timestamp_fd_t1 + fd->fd_t1_timeout + 1;
+	retry = fd->req.sent_time + fd->fd_t2_retry_time;
+
+	switch (fd->state) {
+	case PLDM_FD_STATE_IDLE:
+		return -ENODATA;
+	case PLDM_FD_STATE_DOWNLOAD:
+	case PLDM_FD_STATE_VERIFY:
+	case PLDM_FD_STATE_APPLY:
+		break;
+	default:
+		*deadline = t1;
+		return 0;
+	}
+
+	if (pldm_fd_downloading(fd)) {
+		*deadline = pldm_fd_download_deadline(fd);
+		return 0;
+	}
+
+	switch (fd->req.state) {
+	case PLDM_FD_REQ_READY:
+		/* Pending verify and apply operations are polled at FD_T2 */
+		if (fd->state == PLDM_FD_STATE_DOWNLOAD || fd->req.complete) {
+			*deadline = pldm_fd_now(fd);
+		} else {
+			*deadline = retry;
+		}
+		return 0;
+	case PLDM_FD_REQ_SENT:
+		*deadline = retry < t1 ? retry : t1;
+		return 0;
+	case PLDM_FD_REQ_UNUSED:
+	case PLDM_FD_REQ_FAILED:
+		break;
+	}
+
+	return -ENODATA;
+}
+
 LIBPLDM_ABI_TESTING
 int pldm_fd_set_update_idle_timeout(struct pldm_fd *fd, uint32_t time)
 {
@@ -1483,3 +1840,49 @@ int pldm_fd_set_request_retry_time(struct pldm_fd *fd, uint32_t time)
 	fd->fd_t2_retry_time = time;
 	return 0;
 }
+
+LIBPLDM_ABI_TESTING
+int pldm_fd_set_request_window(struct pldm_fd *fd, uint8_t window)
+{
+	if (fd == NULL || window == 0 || window > PLDM_FD_REQUEST_WINDOW_MAX) {
+		return -EINVAL;
+	}
+
+	fd->request_window = window;
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_fd_get_transfer_stats(struct pldm_fd *fd,
+			       struct pldm_fd_transfer_stats *stats)
+{
+	const struct pldm_fd_transfer *xfer;
+	pldm_fd_time_t elapsed = 0;
+	pldm_fd_time_t end;
+	uint64_t rate;
+
+	if (fd == NULL || stats == NULL) {
+		return -EINVAL;
+	}
+
+	xfer = &fd->xfer;
+	if (!xfer->started) {
+		return -ENODATA;
+	}
+
+	end = xfer->finished ? xfer->end_time : pldm_fd_now(fd);
+	if (end > xfer->start_time) {
+		elapsed = end - xfer->start_time;
+	}
+
+	stats->transfer_size = xfer->size;
+	stats->received = xfer->received;
+	stats->failures = xfer->failures;
+	stats->response_time = xfer->srtt / 8 > UINT32_MAX ?
+				       UINT32_MAX :
+				       (uint32_t)(xfer->srtt / 8);
+	rate = elapsed ? (uint64_t)xfer->received * 1000 / elapsed : 0;
+	stats->bytes_per_sec = rate > UINT32_MAX ? UINT32_MAX : (uint32_t)rate;
+
+	return 0;
+}
@@ -0,0 +1,1165 @@
+/* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#include "api.h"
+#include "compiler.h"
+#include "dsp/base.h"
+#include "msgbuf.h"
+
+#include <libpldm/base.h>
+#include <libpldm/control.h>
+#include <libpldm/multipart.h>
+#include <libpldm/utils.h>
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Response fields preceding the data: cc, flag, next handle and length */
+#define PLDM_MULTIPART_RESP_HDR_BYTES PLDM_BASE_MULTIPART_RECEIVE_RESP_MIN_BYTES
+#define PLDM_MULTIPART_CRC_BYTES      4
+
+struct pldm_multipart_source {
+	uint8_t pldm_type;
+	uint32_t transfer_ctx;
+	uint32_t len;
+	/* Either mem is set, or the object is read through read */
+	const uint8_t *mem;
+	pldm_multipart_read_fn read;
+	void *data;
+};
+
+/* A requester's transfer of an object, keyed by the TID and the object */
+struct pldm_multipart_transfer {
+	pldm_tid_t tid;
+	uint8_t pldm_type;
+	uint32_t transfer_ctx;
+	bool active;
+	uint32_t section_offset;
+	uint32_t section_length;
+	/* The part last served, relative to the section */
+	uint32_t part_offset;
+	uint32_t part_len;
+	/* Whether the part at part_offset has been served */
+	bool served;
+	/* Over the section up to the end of the part last served */
+	struct pldm_edac_crc32_ctx crc;
+};
+
+struct pldm_multipart_peer {
+	bool negotiated;
+	/* The part size agreed with the peer */
+	uint16_t part_size;
+	/* The PLDM types both sides support, bit n for type n */
+	uint64_t protocols;
+	size_t mtu;
+};
+
+struct pldm_multipart_peers {
+	uint16_t part_size;
+	uint64_t protocols;
+	struct pldm_multipart_peer peers[256];
+};
+
+struct pldm_multipart_server {
+	uint32_t part_size;
+	const struct pldm_multipart_peers *peers;
+	size_t count;
+	struct pldm_multipart_source *sources;
+	/* Entries that aren't active are reused by later transfers */
+	size_t transfers_count;
+	struct pldm_multipart_transfer *transfers;
+};
+
+static uint64_t pldm_multipart_protocols(const bitfield8_t protocols[8])
+{
+	uint64_t bits = 0;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		bits |= (uint64_t)protocols[i].byte << (i * 8);
+	}
+
+	return bits;
+}
+
+static void pldm_multipart_protocols_set(bitfield8_t protocols[8],
+					 uint64_t bits)
+{
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		protocols[i].byte = bits >> (i * 8);
+	}
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_multipart_peers_init(struct pldm_multipart_peers **ctx,
+			      uint16_t part_size,
+			      const bitfield8_t protocols[8])
+{
+	struct pldm_multipart_peers *peers;
+
+	if (!ctx || *ctx || !part_size || !protocols) {
+		return -EINVAL;
+	}
+
+	peers = calloc(1, sizeof(*peers));
+	if (!peers) {
+		return -ENOMEM;
+	}
+
+	peers->part_size = part_size;
+	peers->protocols = pldm_multipart_protocols(protocols);
+	*ctx = peers;
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+void pldm_multipart_peers_destroy(struct pldm_multipart_peers *ctx)
+{
+	free(ctx);
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_multipart_peers_set_mtu(struct pldm_multipart_peers *ctx,
+				 pldm_tid_t tid, size_t mtu)
+{
+	if (!ctx) {
+		return -EINVAL;
+	}
+
+	ctx->peers[tid].mtu = mtu;
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_multipart_peers_forget(struct pldm_multipart_peers *ctx,
+				pldm_tid_t tid)
+{
+	if (!ctx) {
+		return -EINVAL;
+	}
+
+	ctx->peers[tid].negotiated = false;
+
+	return 0;
+}
+
+/* Both sides are bound by the smaller part size and the common types */
+static void pldm_multipart_peers_record(struct pldm_multipart_peers *ctx,
+					pldm_tid_t tid, uint16_t part_size,
+					uint64_t protocols)
+{
+	struct pldm_multipart_peer *peer = &ctx->peers[tid];
+
+	peer->negotiated = true;
+	peer->part_size =
+		part_size < ctx->part_size ? part_size : ctx->part_size;
+	peer->protocols = protocols & ctx->protocols;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_multipart_peers_negotiate_req(struct pldm_multipart_peers *ctx,
+				       uint8_t instance_id, void *req_msg,
+				       size_t *req_len)
+{
+	const size_t len = sizeof(struct pldm_msg_hdr) +
+			   PLDM_BASE_NEGOTIATE_TRANSFER_PARAMETERS_REQ_BYTES;
+	struct pldm_base_negotiate_transfer_params_req req = { 0 };
+	int rc;
+
+	if (!ctx || !req_msg || !req_len) {
+		return -EINVAL;
+	}
+
+	if (*req_len < len) {
+		return -EOVERFLOW;
+	}
+
+	req.requester_part_size = ctx->part_size;
+	pldm_multipart_protocols_set(req.requester_protocol_support,
+				     ctx->protocols);
+	rc = encode_pldm_base_negotiate_transfer_params_req(
+		instance_id, &req, req_msg,
+		PLDM_BASE_NEGOTIATE_TRANSFER_PARAMETERS_REQ_BYTES);
+	if (rc) {
+		return rc;
+	}
+	*req_len = len;
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_multipart_peers_negotiate_resp(struct pldm_multipart_peers *ctx,
+					pldm_tid_t tid, const void *resp_msg,
+					size_t resp_len)
+{
+	struct pldm_base_negotiate_transfer_params_resp resp = { 0 };
+	const struct pldm_msg *msg = resp_msg;
+	int rc;
+
+	if (!ctx || !resp_msg) {
+		return -EINVAL;
+	}
+
+	ctx->peers[tid].negotiated = false;
+
+	if (resp_len < sizeof(struct pldm_msg_hdr)) {
+		return -EPROTO;
+	}
+
+	rc = decode_pldm_base_negotiate_transfer_params_resp(
+		msg, resp_len - sizeof(struct pldm_msg_hdr), &resp);
+	if (rc || resp.completion_code != PLDM_SUCCESS ||
+	    !resp.responder_part_size) {
+		return -EPROTO;
+	}
+
+	pldm_multipart_peers_record(
+		ctx, tid, resp.responder_part_size,
+		pldm_multipart_protocols(resp.responder_protocol_support));
+
+	return 0;
+}
+
+static int pldm_multipart_decode_negotiate_req(const struct pldm_msg *msg,
+					       size_t payload_len,
+					       uint16_t *part_size,
+					       bitfield8_t protocols[8])
+{
+	PLDM_MSGBUF_DEFINE_P(buf);
+	int rc;
+
+	rc = pldm_msgbuf_init_errno(
+		buf, PLDM_BASE_NEGOTIATE_TRANSFER_PARAMETERS_REQ_BYTES,
+		msg->payload, payload_len);
+	if (rc) {
+		return rc;
+	}
+
+	pldm_msgbuf_extract_p(buf, part_size);
+	rc = pldm_msgbuf_extract_array(buf, 8, (uint8_t *)protocols, 8);
+	if (rc) {
+		return pldm_msgbuf_discard(buf, rc);
+	}
+
+	return pldm_msgbuf_complete_consumed(buf);
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_multipart_peers_handle_req(struct pldm_multipart_peers *ctx,
+				    pldm_tid_t tid, const void *req_msg,
+				    size_t req_len, void *resp_msg,
+				    size_t *resp_len)
+{
+	const size_t len = sizeof(struct pldm_msg_hdr) +
+			   PLDM_BASE_NEGOTIATE_TRANSFER_PARAMETERS_RESP_BYTES;
+	const struct pldm_msg *req = req_msg;
+	struct pldm_msg *resp = resp_msg;
+	bitfield8_t protocols[8] = { 0 };
+	struct pldm_header_info hdr;
+	PLDM_MSGBUF_DEFINE_P(buf);
+	uint16_t part_size = 0;
+	size_t payload_len;
+	uint8_t cc;
+	int rc;
+
+	if (!ctx || !req_msg || !resp_msg || !resp_len) {
+		return -EINVAL;
+	}
+
+	if (req_len < sizeof(struct pldm_msg_hdr)) {
+		return -ENOMSG;
+	}
+
+	rc = unpack_pldm_header_errno(&req->hdr, &hdr);
+	if (rc || hdr.msg_type != PLDM_REQUEST ||
+	    hdr.pldm_type != PLDM_BASE ||
+	    hdr.command != PLDM_NEGOTIATE_TRANSFER_PARAMETERS) {
+		return -ENOMSG;
+	}
+
+	if (*resp_len < len) {
+		return -EOVERFLOW;
+	}
+	payload_len = *resp_len - sizeof(struct pldm_msg_hdr);
+
+	rc = pldm_multipart_decode_negotiate_req(
+		req, req_len - sizeof(struct pldm_msg_hdr), &part_size,
+		protocols);
+	if (rc) {
+		cc = PLDM_ERROR_INVALID_LENGTH;
+	} else if (!part_size) {
+		cc = PLDM_ERROR_INVALID_DATA;
+	} else {
+		cc = PLDM_SUCCESS;
+	}
+
+	if (cc) {
+		ctx->peers[tid].negotiated = false;
+		*resp_len = sizeof(struct pldm_msg_hdr) + 1;
+		return encode_cc_only_resp(hdr.instance, hdr.pldm_type,
+					   hdr.command, cc, resp) ?
+			       -EINVAL :
+			       0;
+	}
+
+	pldm_multipart_peers_record(ctx, tid, part_size,
+				    pldm_multipart_protocols(protocols));
+	pldm_multipart_protocols_set(protocols, ctx->peers[tid].protocols);
+
+	hdr.msg_type = PLDM_RESPONSE;
+	rc = pack_pldm_header_errno(&hdr, &resp->hdr);
+	if (rc) {
+		return rc;
+	}
+
+	rc = pldm_msgbuf_init_errno(
+		buf, PLDM_BASE_NEGOTIATE_TRANSFER_PARAMETERS_RESP_BYTES,
+		resp->payload, payload_len);
+	if (rc) {
+		return rc;
+	}
+
+	pldm_msgbuf_insert_uint8(buf, PLDM_SUCCESS);
+	pldm_msgbuf_insert_uint16(buf, ctx->peers[tid].part_size);
+	rc = pldm_msgbuf_insert_array(buf, sizeof(protocols),
+				      (uint8_t *)protocols, sizeof(protocols));
+	if (rc) {
+		return pldm_msgbuf_discard(buf, rc);
+	}
+
+	rc = pldm_msgbuf_complete_used(buf, payload_len, &payload_len);
+	if (rc) {
+		return rc;
+	}
+	*resp_len = sizeof(struct pldm_msg_hdr) + payload_len;
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_multipart_peers_part_size(const struct pldm_multipart_peers *ctx,
+				   pldm_tid_t tid, uint8_t pldm_type,
+				   uint32_t *part_size)
+{
+	const struct pldm_multipart_peer *peer;
+	/* The MultipartReceive response around the part */
+	const size_t overhead = sizeof(struct pldm_msg_hdr) +
+				PLDM_MULTIPART_RESP_HDR_BYTES +
+				PLDM_MULTIPART_CRC_BYTES;
+	uint32_t size;
+
+	if (!ctx || !part_size) {
+		return -EINVAL;
+	}
+
+	peer = &ctx->peers[tid];
+	if (!peer->negotiated) {
+		return -ENOENT;
+	}
+
+	if (pldm_type >= 64 ||
+	    !(peer->protocols & (UINT64_C(1) << pldm_type))) {
+		return -ENOTSUP;
+	}
+
+	size = peer->part_size;
+	if (peer->mtu) {
+		if (peer->mtu <= overhead) {
+			return -EMSGSIZE;
+		}
+		if (peer->mtu - overhead < size) {
+			size = peer->mtu - overhead;
+		}
+	}
+
+	*part_size = size;
+
+	return 0;
+}
+
+/*
+ * A part's transfer handle is its offset in the section plus one, so no part
+ * has the handle 0 that marks the end of the section.
+ */
+static uint32_t pldm_multipart_handle(uint32_t offset)
+{
+	return offset + 1;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_multipart_server_init(struct pldm_multipart_server **ctx,
+			       uint32_t part_size)
+{
+	struct pldm_multipart_server *server;
+
+	if (!ctx || *ctx || !part_size) {
+		return -EINVAL;
+	}
+
+	server = calloc(1, sizeof(*server));
+	if (!server) {
+		return -ENOMEM;
+	}
+
+	server->part_size = part_size;
+	*ctx = server;
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+void pldm_multipart_server_destroy(struct pldm_multipart_server *ctx)
+{
+	if (!ctx) {
+		return;
+	}
+
+	free(ctx->transfers);
+	free(ctx->sources);
+	free(ctx);
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_multipart_server_set_part_size(struct pldm_multipart_server *ctx,
+					uint32_t part_size)
+{
+	if (!ctx || !part_size) {
+		return -EINVAL;
+	}
+
+	ctx->part_size = part_size;
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_multipart_server_set_peers(struct pldm_multipart_server *ctx,
+				    const struct pldm_multipart_peers *peers)
+{
+	if (!ctx) {
+		return -EINVAL;
+	}
+
+	ctx->peers = peers;
+
+	return 0;
+}
+
+static struct pldm_multipart_source *
+pldm_multipart_server_find(struct pldm_multipart_server *ctx,
+			   uint8_t pldm_type, uint32_t transfer_ctx)
+{
+	size_t i;
+
+	for (i = 0; i < ctx->count; i++) {
+		struct pldm_multipart_source *source = &ctx->sources[i];
+
+		if (source->pldm_type == pldm_type &&
+		    source->transfer_ctx == transfer_ctx) {
+			return source;
+		}
+	}
+
+	return NULL;
+}
+
+static struct pldm_multipart_transfer *
+pldm_multipart_transfer_find(struct pldm_multipart_server *ctx, pldm_tid_t tid,
+			     uint8_t pldm_type, uint32_t transfer_ctx)
+{
+	size_t i;
+
+	for (i = 0; i < ctx->transfers_count; i++) {
+		struct pldm_multipart_transfer *transfer = &ctx->transfers[i];
+
+		if (transfer->active && transfer->tid == tid &&
+		    transfer->pldm_type == pldm_type &&
+		    transfer->transfer_ctx == transfer_ctx) {
+			return transfer;
+		}
+	}
+
+	return NULL;
+}
+
+/* Find the requester's transfer of the object, or somewhere to start one */
+static struct pldm_multipart_transfer *
+pldm_multipart_transfer_get(struct pldm_multipart_server *ctx, pldm_tid_t tid,
+			    uint8_t pldm_type, uint32_t transfer_ctx)
+{
+	struct pldm_multipart_transfer *transfers;
+	size_t i;
+
+	transfers = pldm_multipart_transfer_find(ctx, tid, pldm_type,
+						 transfer_ctx);
+	if (transfers) {
+		/* Starting again abandons the transfer in progress */
+		return transfers;
+	}
+
+	for (i = 0; i < ctx->transfers_count; i++) {
+		if (!ctx->transfers[i].active) {
+			break;
+		}
+	}
+
+	if (i == ctx->transfers_count) {
+		transfers = realloc(ctx->transfers,
+				    (i + 1) * sizeof(*transfers));
+		if (!transfers) {
+			return NULL;
+		}
+		ctx->transfers = transfers;
+		ctx->transfers_count++;
+	}
+
+	memset(&ctx->transfers[i], 0, sizeof(ctx->transfers[i]));
+	ctx->transfers[i].tid = tid;
+	ctx->transfers[i].pldm_type = pldm_type;
+	ctx->transfers[i].transfer_ctx = transfer_ctx;
+
+	return &ctx->transfers[i];
+}
+
+static int pldm_multipart_server_add(struct pldm_multipart_server *ctx,
+				     const struct pldm_multipart_source *source)
+{
+	struct pldm_multipart_source *sources;
+
+	if (pldm_multipart_server_find(ctx, source->pldm_type,
+				       source->transfer_ctx)) {
+		return -EEXIST;
+	}
+
+	sources = realloc(ctx->sources, (ctx->count + 1) * sizeof(*sources));
+	if (!sources) {
+		return -ENOMEM;
+	}
+
+	sources[ctx->count++] = *source;
+	ctx->sources = sources;
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_multipart_server_add_memory(struct pldm_multipart_server *ctx,
+				     uint8_t pldm_type, uint32_t transfer_ctx,
+				     const void *data, size_t len)
+{
+	struct pldm_multipart_source source = { 0 };
+
+	if (!ctx || (!data && len) || len > UINT32_MAX) {
+		return -EINVAL;
+	}
+
+	source.pldm_type = pldm_type;
+	source.transfer_ctx = transfer_ctx;
+	source.len = len;
+	source.mem = data;
+
+	return pldm_multipart_server_add(ctx, &source);
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_multipart_server_add_source(struct pldm_multipart_server *ctx,
+				     uint8_t pldm_type, uint32_t transfer_ctx,
+				     size_t len, pldm_multipart_read_fn read,
+				     void *data)
+{
+	struct pldm_multipart_source source = { 0 };
+
+	if (!ctx || !read || len > UINT32_MAX) {
+		return -EINVAL;
+	}
+
+	source.pldm_type = pldm_type;
+	source.transfer_ctx = transfer_ctx;
+	source.len = len;
+	source.read = read;
+	source.data = data;
+
+	return pldm_multipart_server_add(ctx, &source);
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_multipart_server_remove(struct pldm_multipart_server *ctx,
+				 uint8_t pldm_type, uint32_t transfer_ctx)
+{
+	struct pldm_multipart_source *source;
+	size_t i;
+
+	if (!ctx) {
+		return -EINVAL;
+	}
+
+	source = pldm_multipart_server_find(ctx, pldm_type, transfer_ctx);
+	if (!source) {
+		return -ENOENT;
+	}
+
+	/* Order doesn't matter, so fill the gap with the last source */
+	*source = ctx->sources[--ctx->count];
+
+	for (i = 0; i < ctx->transfers_count; i++) {
+		struct pldm_multipart_transfer *transfer = &ctx->transfers[i];
+
+		if (transfer->pldm_type == pldm_type &&
+		    transfer->transfer_ctx == transfer_ctx) {
+			transfer->active = false;
+		}
+	}
+
+	return 0;
+}
+
+static int pldm_multipart_reply_error(uint8_t cc,
+				      const struct pldm_header_info *hdr,
+				      struct pldm_msg *resp, size_t *resp_len)
+{
+	*resp_len = sizeof(struct pldm_msg_hdr) + 1;
+	if (encode_cc_only_resp(hdr->instance, hdr->pldm_type, hdr->command, cc,
+				resp)) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int pldm_multipart_reply_ack(struct pldm_msg *resp, size_t *resp_len)
+{
+	size_t payload_len = *resp_len - sizeof(struct pldm_msg_hdr);
+	PLDM_MSGBUF_DEFINE_P(buf);
+	int rc;
+
+	rc = pldm_msgbuf_init_errno(buf, PLDM_MULTIPART_RESP_HDR_BYTES,
+				    resp->payload, payload_len);
+	if (rc) {
+		return rc;
+	}
+
+	pldm_msgbuf_insert_uint8(buf, PLDM_SUCCESS);
+	pldm_msgbuf_insert_uint8(
+		buf, PLDM_BASE_MULTIPART_RECEIVE_TRANSFER_FLAG_ACK_COMPLETION);
+	pldm_msgbuf_insert_uint32(buf, 0);
+	pldm_msgbuf_insert_uint32(buf, 0);
+
+	rc = pldm_msgbuf_complete_used(buf, payload_len, &payload_len);
+	if (rc) {
+		return rc;
+	}
+	*resp_len = sizeof(struct pldm_msg_hdr) + payload_len;
+
+	return 0;
+}
+
+/*
+ * Serve the part of the transfer's section at part_offset, reading it directly
+ * from the source into the response. The CRC is only advanced for a part not
+ * served before, as a retry resends the part already accounted for.
+ */
+static int pldm_multipart_reply_part(uint32_t part_size,
+				     const struct pldm_multipart_source *source,
+				     struct pldm_multipart_transfer *transfer,
+				     uint32_t part_offset, bool retry,
+				     const struct pldm_header_info *hdr,
+				     struct pldm_msg *resp, size_t *resp_len)
+{
+	size_t payload_len = *resp_len - sizeof(struct pldm_msg_hdr);
+	uint32_t remaining = transfer->section_length - part_offset;
+	PLDM_MSGBUF_DEFINE_P(buf);
+	uint32_t part_len;
+	uint8_t flag;
+	bool end;
+	void *data;
+	int rc;
+
+	part_len = retry ? transfer->part_len :
+			   (remaining < part_size ? remaining : part_size);
+	end = part_len == remaining;
+	if (part_offset == 0 && end) {
+		flag = PLDM_BASE_MULTIPART_RECEIVE_TRANSFER_FLAG_START_AND_END;
+	} else if (part_offset == 0) {
+		flag = PLDM_BASE_MULTIPART_RECEIVE_TRANSFER_FLAG_START;
+	} else if (end) {
+		flag = PLDM_BASE_MULTIPART_RECEIVE_TRANSFER_FLAG_END;
+	} else {
+		flag = PLDM_BASE_MULTIPART_RECEIVE_TRANSFER_FLAG_MIDDLE;
+	}
+
+	rc = pldm_msgbuf_init_errno(buf, PLDM_MULTIPART_RESP_HDR_BYTES,
+				    resp->payload, payload_len);
+	if (rc) {
+		return rc;
+	}
+
+	pldm_msgbuf_insert_uint8(buf, PLDM_SUCCESS);
+	pldm_msgbuf_insert_uint8(buf, flag);
+	pldm_msgbuf_insert_uint32(
+		buf, end ? 0 : pldm_multipart_handle(part_offset + part_len));
+	pldm_msgbuf_insert_uint32(buf, part_len);
+	rc = pldm_msgbuf_span_required(buf, part_len, &data);
+	if (rc) {
+		return pldm_msgbuf_discard(buf, rc);
+	}
+
+	if (source->read) {
+		rc = source->read(source->data,
+				  transfer->section_offset + part_offset, data,
+				  part_len);
+		if (rc) {
+			rc = pldm_multipart_reply_error(PLDM_ERROR, hdr, resp,
+							resp_len);
+			return pldm_msgbuf_discard(buf, rc);
+		}
+	} else if (part_len) {
+		memcpy(data,
+		       source->mem + transfer->section_offset + part_offset,
+		       part_len);
+	}
+
+	if (!retry) {
+		pldm_edac_crc32_update(&transfer->crc, data, part_len);
+		transfer->part_offset = part_offset;
+		transfer->part_len = part_len;
+		transfer->served = true;
+	}
+
+	if (end) {
+		uint32_t crc;
+
+		pldm_edac_crc32_final(&transfer->crc, &crc);
+		pldm_msgbuf_insert_uint32(buf, crc);
+	}
+
+	rc = pldm_msgbuf_complete_used(buf, payload_len, &payload_len);
+	if (rc) {
+		return rc;
+	}
+	*resp_len = sizeof(struct pldm_msg_hdr) + payload_len;
+
+	return 0;
+}
+
+/* Start a transfer of the requested section, clipped to the object */
+static uint8_t pldm_multipart_start(const struct pldm_multipart_source *source,
+				    struct pldm_multipart_transfer *transfer,
+				    uint32_t section_offset,
+				    uint32_t section_length)
+{
+	uint32_t available;
+
+	if (section_offset > source->len) {
+		return PLDM_ERROR_INVALID_DATA;
+	}
+
+	available = source->len - section_offset;
+	if (!section_length || section_length > available) {
+		section_length = available;
+	}
+
+	transfer->active = true;
+	transfer->served = false;
+	transfer->section_offset = section_offset;
+	transfer->section_length = section_length;
+	transfer->part_offset = 0;
+	transfer->part_len = 0;
+	pldm_edac_crc32_init(&transfer->crc);
+
+	return PLDM_SUCCESS;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_multipart_server_handle_msg(struct pldm_multipart_server *ctx,
+				     pldm_tid_t tid, const void *req_msg,
+				     size_t req_len, void *resp_msg,
+				     size_t *resp_len)
+{
+	struct pldm_multipart_transfer *transfer;
+	const struct pldm_msg *req = req_msg;
+	struct pldm_multipart_source *source;
+	struct pldm_msg *resp = resp_msg;
+	struct pldm_header_info hdr;
+	PLDM_MSGBUF_DEFINE_P(buf);
+	uint32_t section_offset = 0;
+	uint32_t section_length = 0;
+	uint32_t transfer_ctx = 0;
+	uint8_t pldm_type = 0;
+	uint32_t handle = 0;
+	uint8_t opflag = 0;
+	uint32_t negotiated;
+	uint32_t part_size;
+	uint32_t next;
+	int rc;
+
+	if (!ctx || !req_msg || !resp_msg || !resp_len) {
+		return -EINVAL;
+	}
+
+	if (req_len < sizeof(struct pldm_msg_hdr)) {
+		return -ENOMSG;
+	}
+
+	rc = unpack_pldm_header_errno(&req->hdr, &hdr);
+	if (rc) {
+		return -ENOMSG;
+	}
+
+	if (hdr.msg_type != PLDM_REQUEST || hdr.pldm_type != PLDM_BASE ||
+	    hdr.command != PLDM_MULTIPART_RECEIVE) {
+		return -ENOMSG;
+	}
+
+	if (*resp_len < sizeof(struct pldm_msg_hdr) +
+				PLDM_MULTIPART_RESP_HDR_BYTES +
+				(size_t)ctx->part_size +
+				PLDM_MULTIPART_CRC_BYTES) {
+		return -EOVERFLOW;
+	}
+
+	rc = pldm_msgbuf_init_errno(buf, PLDM_MULTIPART_RECEIVE_REQ_BYTES,
+				    req->payload,
+				    req_len - sizeof(struct pldm_msg_hdr));
+	if (rc) {
+		return pldm_multipart_reply_error(PLDM_ERROR_INVALID_LENGTH,
+						  &hdr, resp, resp_len);
+	}
+
+	pldm_msgbuf_extract(buf, pldm_type);
+	pldm_msgbuf_extract(buf, opflag);
+	pldm_msgbuf_extract(buf, transfer_ctx);
+	pldm_msgbuf_extract(buf, handle);
+	pldm_msgbuf_extract(buf, section_offset);
+	pldm_msgbuf_extract(buf, section_length);
+	rc = pldm_msgbuf_complete_consumed(buf);
+	if (rc) {
+		return pldm_multipart_reply_error(PLDM_ERROR_INVALID_LENGTH,
+						  &hdr, resp, resp_len);
+	}
+
+	if (opflag > PLDM_XFER_CURRENT_PART) {
+		return pldm_multipart_reply_error(
+			PLDM_CONTROL_INVALID_TRANSFER_OPERATION_FLAG, &hdr,
+			resp, resp_len);
+	}
+
+	source = pldm_multipart_server_find(ctx, pldm_type, transfer_ctx);
+	if (!source) {
+		return pldm_multipart_reply_error(PLDM_ERROR_INVALID_DATA, &hdr,
+						  resp, resp_len);
+	}
+
+	/* Parts no larger than negotiated with the peer, if it has been */
+	part_size = ctx->part_size;
+	if (ctx->peers && !pldm_multipart_peers_part_size(ctx->peers, tid,
+							  pldm_type,
+							  &negotiated)) {
+		if (negotiated < part_size) {
+			part_size = negotiated;
+		}
+	}
+
+	hdr.msg_type = PLDM_RESPONSE;
+	rc = pack_pldm_header_errno(&hdr, &resp->hdr);
+	if (rc) {
+		return rc;
+	}
+
+	/* Each requester has its own transfer of an object */
+	if (opflag == PLDM_XFER_FIRST_PART) {
+		transfer = pldm_multipart_transfer_get(ctx, tid, pldm_type,
+						       transfer_ctx);
+		if (!transfer) {
+			return pldm_multipart_reply_error(PLDM_ERROR_NOT_READY,
+							  &hdr, resp,
+							  resp_len);
+		}
+
+		rc = pldm_multipart_start(source, transfer, section_offset,
+					  section_length);
+		if (rc) {
+			return pldm_multipart_reply_error(rc, &hdr, resp,
+							  resp_len);
+		}
+		return pldm_multipart_reply_part(part_size, source, transfer, 0,
+						 false, &hdr, resp, resp_len);
+	}
+
+	transfer = pldm_multipart_transfer_find(ctx, tid, pldm_type,
+						transfer_ctx);
+	switch (opflag) {
+	case PLDM_XFER_NEXT_PART:
+	case PLDM_XFER_CURRENT_PART:
+		if (!transfer) {
+			break;
+		}
+
+		/*
+		 * The part already served, again, when its response was lost.
+		 * A retry of the first part may carry the handle of the
+		 * FirstPart request, which is 0.
+		 */
+		if (handle == pldm_multipart_handle(transfer->part_offset) ||
+		    (opflag == PLDM_XFER_CURRENT_PART && handle == 0 &&
+		     transfer->part_offset == 0)) {
+			return pldm_multipart_reply_part(
+				part_size, source, transfer,
+				transfer->part_offset, transfer->served, &hdr,
+				resp, resp_len);
+		}
+
+		next = transfer->part_offset + transfer->part_len;
+		if (opflag == PLDM_XFER_NEXT_PART && transfer->served &&
+		    next < transfer->section_length &&
+		    handle == pldm_multipart_handle(next)) {
+			return pldm_multipart_reply_part(part_size, source,
+							 transfer, next, false,
+							 &hdr, resp, resp_len);
+		}
+		break;
+	case PLDM_XFER_ABORT:
+	case PLDM_XFER_COMPLETE:
+		if (transfer) {
+			transfer->active = false;
+		}
+		return pldm_multipart_reply_ack(resp, resp_len);
+	default:
+		break;
+	}
+
+	return pldm_multipart_reply_error(
+		PLDM_CONTROL_INVALID_DATA_TRANSFER_HANDLE, &hdr, resp,
+		resp_len);
+}
+
+enum pldm_multipart_client_state {
+	PLDM_MULTIPART_CLIENT_FIRST,
+	PLDM_MULTIPART_CLIENT_NEXT,
+	PLDM_MULTIPART_CLIENT_COMPLETE,
+	PLDM_MULTIPART_CLIENT_DONE,
+};
+
+struct pldm_multipart_client {
+	enum pldm_multipart_client_state state;
+	uint8_t pldm_type;
+	uint32_t transfer_ctx;
+	uint32_t section_offset;
+	uint32_t handle;
+	uint8_t *buf;
+	size_t len;
+	size_t received;
+	struct pldm_edac_crc32_ctx crc;
+};
+
+LIBPLDM_ABI_TESTING
+int pldm_multipart_client_init(struct pldm_multipart_client **ctx,
+			       uint8_t pldm_type, uint32_t transfer_ctx,
+			       uint32_t section_offset, void *buf, size_t len)
+{
+	struct pldm_multipart_client *client;
+
+	if (!ctx || *ctx || !buf || !len || len > UINT32_MAX) {
+		return -EINVAL;
+	}
+
+	client = calloc(1, sizeof(*client));
+	if (!client) {
+		return -ENOMEM;
+	}
+
+	client->state = PLDM_MULTIPART_CLIENT_FIRST;
+	client->pldm_type = pldm_type;
+	client->transfer_ctx = transfer_ctx;
+	client->section_offset = section_offset;
+	client->buf = buf;
+	client->len = len;
+	pldm_edac_crc32_init(&client->crc);
+	*ctx = client;
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+void pldm_multipart_client_destroy(struct pldm_multipart_client *ctx)
+{
+	free(ctx);
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_multipart_client_next_req(struct pldm_multipart_client *ctx,
+				   uint8_t instance_id, void *req_msg,
+				   size_t *req_len)
+{
+	struct pldm_multipart_receive_req req = { 0 };
+	int rc;
+
+	if (!ctx || !req_msg || !req_len) {
+		return -EINVAL;
+	}
+
+	if (ctx->state == PLDM_MULTIPART_CLIENT_DONE) {
+		*req_len = 0;
+		return 0;
+	}
+
+	if (*req_len < sizeof(struct pldm_msg_hdr) +
+			       PLDM_MULTIPART_RECEIVE_REQ_BYTES) {
+		return -EOVERFLOW;
+	}
+
+	req.pldm_type = ctx->pldm_type;
+	req.transfer_ctx = ctx->transfer_ctx;
+	req.section_offset = ctx->section_offset;
+	req.section_length = ctx->len;
+	switch (ctx->state) {
+	case PLDM_MULTIPART_CLIENT_FIRST:
+		req.transfer_opflag = PLDM_XFER_FIRST_PART;
+		break;
+	case PLDM_MULTIPART_CLIENT_NEXT:
+		req.transfer_opflag = PLDM_XFER_NEXT_PART;
+		req.transfer_handle = ctx->handle;
+		break;
+	default:
+		req.transfer_opflag = PLDM_XFER_COMPLETE;
+		break;
+	}
+
+	rc = encode_base_multipart_receive_req(
+		instance_id, &req, req_msg, PLDM_MULTIPART_RECEIVE_REQ_BYTES);
+	if (rc) {
+		return rc;
+	}
+	*req_len = sizeof(struct pldm_msg_hdr) +
+		   PLDM_MULTIPART_RECEIVE_REQ_BYTES;
+
+	return 0;
+}
+
+/* Append a part to the section, checking the CRC32 once it ends */
+static int
+pldm_multipart_client_part(struct pldm_multipart_client *ctx,
+			   const struct pldm_multipart_receive_resp *resp,
+			   uint32_t checksum)
+{
+	bool first = ctx->state == PLDM_MULTIPART_CLIENT_FIRST;
+	uint32_t crc;
+
+	switch (resp->transfer_flag) {
+	case PLDM_BASE_MULTIPART_RECEIVE_TRANSFER_FLAG_START:
+	case PLDM_BASE_MULTIPART_RECEIVE_TRANSFER_FLAG_START_AND_END:
+		if (!first) {
+			return -EPROTO;
+		}
+		break;
+	case PLDM_BASE_MULTIPART_RECEIVE_TRANSFER_FLAG_MIDDLE:
+	case PLDM_BASE_MULTIPART_RECEIVE_TRANSFER_FLAG_END:
+		if (first) {
+			return -EPROTO;
+		}
+		break;
+	default:
+		return -EPROTO;
+	}
+
+	if (resp->data.length > ctx->len - ctx->received) {
+		return -EOVERFLOW;
+	}
+
+	if (resp->data.length) {
+		memcpy(ctx->buf + ctx->received, resp->data.ptr,
+		       resp->data.length);
+		pldm_edac_crc32_update(&ctx->crc, resp->data.ptr,
+				       resp->data.length);
+		ctx->received += resp->data.length;
+	}
+
+	if (resp->transfer_flag ==
+		    PLDM_BASE_MULTIPART_RECEIVE_TRANSFER_FLAG_END ||
+	    resp->transfer_flag ==
+		    PLDM_BASE_MULTIPART_RECEIVE_TRANSFER_FLAG_START_AND_END) {
+		pldm_edac_crc32_final(&ctx->crc, &crc);
+		if (crc != checksum) {
+			return -EBADMSG;
+		}
+		ctx->state = PLDM_MULTIPART_CLIENT_COMPLETE;
+		return 0;
+	}
+
+	if (!resp->next_transfer_handle) {
+		return -EPROTO;
+	}
+
+	ctx->handle = resp->next_transfer_handle;
+	ctx->state = PLDM_MULTIPART_CLIENT_NEXT;
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_multipart_client_handle_resp(struct pldm_multipart_client *ctx,
+				      const void *resp_msg, size_t resp_len)
+{
+	struct pldm_multipart_receive_resp resp = { 0 };
+	const struct pldm_msg *msg = resp_msg;
+	struct pldm_header_info hdr;
+	uint32_t checksum = 0;
+	int rc;
+
+	if (!ctx || !resp_msg) {
+		return -EINVAL;
+	}
+
+	if (ctx->state == PLDM_MULTIPART_CLIENT_DONE ||
+	    resp_len < sizeof(struct pldm_msg_hdr)) {
+		return -EPROTO;
+	}
+
+	rc = unpack_pldm_header_errno(&msg->hdr, &hdr);
+	if (rc || hdr.msg_type != PLDM_RESPONSE ||
+	    hdr.pldm_type != PLDM_BASE ||
+	    hdr.command != PLDM_MULTIPART_RECEIVE) {
+		rc = -EPROTO;
+		goto out_done;
+	}
+
+	rc = decode_base_multipart_receive_resp(
+		msg, resp_len - sizeof(struct pldm_msg_hdr), &resp, &checksum);
+	if (rc || resp.completion_code != PLDM_SUCCESS) {
+		rc = -EPROTO;
+		goto out_done;
+	}
+
+	if (ctx->state == PLDM_MULTIPART_CLIENT_COMPLETE) {
+		if (resp.transfer_flag !=
+		    PLDM_BASE_MULTIPART_RECEIVE_TRANSFER_FLAG_ACK_COMPLETION) {
+			rc = -EPROTO;
+			goto out_done;
+		}
+		ctx->state = PLDM_MULTIPART_CLIENT_DONE;
+		return 1;
+	}
+
+	rc = pldm_multipart_client_part(ctx, &resp, checksum);
+	if (rc) {
+		goto out_done;
+	}
+
+	return 0;
+
+out_done:
+	ctx->state = PLDM_MULTIPART_CLIENT_DONE;
+	return rc;
+}
+
+LIBPLDM_ABI_TESTING
+size_t pldm_multipart_client_received(const struct pldm_multipart_client *ctx)
+{
+	return ctx ? ctx->received : 0;
+}
@@ -5,7 +5,10 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
 #include <stdlib.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -19,11 +22,30 @@
 struct pldm_tid_state {
 	pldm_instance_id_t prev;
 	uint32_t allocations;
+	/* Freed by the caller, but still allocated in the database */
+	uint32_t cached;
+};
+
+/*
+ * The shared-memory database is a header followed by the PID of the owner of
+ * each TID's instance IDs, or zero if the instance ID is free. Instance IDs
+ * are allocated and freed by compare-and-swap on the owner, and those owned by
+ * processes that have exited are reclaimed.
+ */
+#define PLDM_INSTANCE_DB_SHM_MAGIC 0x44494950 /* "PIID" */
+
+struct pldm_instance_db_shm {
+	uint32_t magic;
+	uint32_t reserved[15];
+	uint32_t owners[PLDM_TID_MAX][PLDM_INST_ID_MAX];
 };
 
 struct pldm_instance_db {
 	struct pldm_tid_state state[PLDM_TID_MAX];
 	int lock_db_fd;
+	struct pldm_instance_db_shm *shm;
+	uint32_t pid;
+	unsigned int cache_depth;
 };
 
 static inline int iid_next(pldm_instance_id_t cur)
@@ -80,6 +102,65 @@ int pldm_instance_db_init(struct pldm_instance_db **ctx, const char *dbpath)
 	return 0;
 }
 
+LIBPLDM_ABI_TESTING
+int pldm_instance_db_init_shm(struct pldm_instance_db **ctx, int fd)
+{
+	struct pldm_instance_db_shm *shm;
+	struct pldm_instance_db *l_ctx;
+	struct stat statbuf;
+	uint32_t expected;
+
+	if (!ctx || *ctx || fd < 0) {
+		return -EINVAL;
+	}
+
+	if (fstat(fd, &statbuf) < 0) {
+		return -errno;
+	}
+
+	/* Whoever finds the database empty sizes it. Zeroed, it's valid */
+	if (statbuf.st_size == 0 && ftruncate(fd, sizeof(*shm)) < 0) {
+		return -errno;
+	}
+
+	if (statbuf.st_size != 0 && statbuf.st_size < (off_t)sizeof(*shm)) {
+		return -EINVAL;
+	}
+
+	shm = mmap(NULL, sizeof(*shm), PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+		   0);
+	if (shm == MAP_FAILED) {
+		return -errno;
+	}
+
+	expected = 0;
+	if (!__atomic_compare_exchange_n(&shm->magic, &expected,
+					 PLDM_INSTANCE_DB_SHM_MAGIC, false,
+					 __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) &&
+	    expected != PLDM_INSTANCE_DB_SHM_MAGIC) {
+		munmap(shm, sizeof(*shm));
+		return -EINVAL;
+	}
+
+	l_ctx = calloc(1, sizeof(struct pldm_instance_db));
+	if (!l_ctx) {
+		munmap(shm, sizeof(*shm));
+		return -ENOMEM;
+	}
+
+	/* Initialise previous ID values so the next one is zero */
+	for (int i = 0; i < PLDM_TID_MAX; i++) {
+		l_ctx->state[i].prev = 31;
+	}
+
+	l_ctx->lock_db_fd = -1;
+	l_ctx->shm = shm;
+	l_ctx->pid = getpid();
+	*ctx = l_ctx;
+
+	return 0;
+}
+
 LIBPLDM_ABI_STABLE
 int pldm_instance_db_init_default(struct pldm_instance_db **ctx)
 {
@@ -93,11 +174,159 @@ int pldm_instance_db_destroy(struct pldm_instance_db *ctx)
 	if (!ctx) {
 		return 0;
 	}
-	close(ctx->lock_db_fd);
+
+	/* The OFD locks are released as the descriptor is closed, but the
+	 * shared-memory allocations must be released explicitly */
+	if (ctx->shm) {
+		for (int tid = 0; tid < PLDM_TID_MAX; tid++) {
+			for (int iid = 0; iid < PLDM_INST_ID_MAX; iid++) {
+				uint32_t *owner = &ctx->shm->owners[tid][iid];
+				uint32_t expected = ctx->pid;
+
+				if (!(ctx->state[tid].allocations & BIT(iid))) {
+					continue;
+				}
+
+				__atomic_compare_exchange_n(owner, &expected, 0,
+							    false,
+							    __ATOMIC_RELEASE,
+							    __ATOMIC_RELAXED);
+			}
+		}
+		munmap(ctx->shm, sizeof(*ctx->shm));
+	}
+
+	if (ctx->lock_db_fd >= 0) {
+		close(ctx->lock_db_fd);
+	}
 	free(ctx);
 	return 0;
 }
 
+/* A process we can't signal for lack of permission still exists. The PID may
+ * have been reused since the owner exited, in which case the instance ID is
+ * held until the new process exits too */
+static bool pldm_instance_db_shm_owner_exited(uint32_t owner)
+{
+	return kill((pid_t)owner, 0) < 0 && errno == ESRCH;
+}
+
+/*
+ * Claim count instance IDs in one scan of the TID's owners. Those claimed are
+ * set in *iids, and remain claimed if there weren't enough.
+ */
+static int pldm_instance_id_alloc_shm(struct pldm_instance_db *ctx,
+				      pldm_tid_t tid, unsigned int count,
+				      uint32_t *iids)
+{
+	uint32_t *owners = ctx->shm->owners[tid];
+	uint8_t l_iid;
+	uint32_t expected;
+	int pass;
+	int i;
+
+	/* Claim free instance IDs, and failing that, reclaim those held by
+	 * exited processes. The second pass costs a syscall per instance ID.
+	 * As for the lock database, the previous allocation is skipped */
+	for (pass = 0; pass < 2; pass++) {
+		l_iid = ctx->state[tid].prev;
+		for (i = 0; i < PLDM_INST_ID_MAX - 1; i++) {
+			l_iid = iid_next(l_iid);
+
+			if (ctx->state[tid].allocations & BIT(l_iid)) {
+				continue;
+			}
+
+			expected = __atomic_load_n(&owners[l_iid],
+						   __ATOMIC_RELAXED);
+			if (pass == 0 && expected != 0) {
+				continue;
+			}
+
+			if (pass == 1 &&
+			    (expected == 0 || expected == ctx->pid ||
+			     !pldm_instance_db_shm_owner_exited(expected))) {
+				continue;
+			}
+
+			if (!__atomic_compare_exchange_n(
+				    &owners[l_iid], &expected, ctx->pid, false,
+				    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+				continue;
+			}
+
+			ctx->state[tid].allocations |= BIT(l_iid);
+			*iids |= BIT(l_iid);
+			if (!--count) {
+				ctx->state[tid].prev = l_iid;
+				return 0;
+			}
+		}
+	}
+
+	return -EAGAIN;
+}
+
+static int pldm_instance_id_free_shm(struct pldm_instance_db *ctx,
+				     pldm_tid_t tid, pldm_instance_id_t iid)
+{
+	uint32_t expected = ctx->pid;
+	bool released;
+
+	released = __atomic_compare_exchange_n(&ctx->shm->owners[tid][iid],
+					       &expected, 0, false,
+					       __ATOMIC_RELEASE,
+					       __ATOMIC_RELAXED);
+	ctx->state[tid].allocations &= ~BIT(iid);
+
+	/* Someone reclaimed the instance ID while we were alive */
+	return released ? 0 : -EPROTO;
+}
+
+/*
+ * Take the cached instance ID following the previous allocation. The previous
+ * allocation itself is skipped so consecutive requests to a TID never share an
+ * instance ID.
+ */
+static bool pldm_instance_id_take_cached(struct pldm_instance_db *ctx,
+					 pldm_tid_t tid,
+					 pldm_instance_id_t *iid)
+{
+	struct pldm_tid_state *state = &ctx->state[tid];
+	uint8_t l_iid = state->prev;
+	int i;
+
+	if (!state->cached) {
+		return false;
+	}
+
+	for (i = 0; i < PLDM_INST_ID_MAX - 1; i++) {
+		l_iid = iid_next(l_iid);
+		if (state->cached & BIT(l_iid)) {
+			state->cached &= ~BIT(l_iid);
+			state->prev = l_iid;
+			*iid = l_iid;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool pldm_instance_id_cache(struct pldm_instance_db *ctx,
+				   pldm_tid_t tid, pldm_instance_id_t iid)
+{
+	struct pldm_tid_state *state = &ctx->state[tid];
+
+	if ((unsigned int)__builtin_popcount(state->cached) >=
+	    ctx->cache_depth) {
+		return false;
+	}
+
+	state->cached |= BIT(iid);
+	return true;
+}
+
 static const struct flock pldm_instance_id_cfls = {
 	.l_type = F_RDLCK,
 	.l_whence = SEEK_SET,
@@ -116,26 +345,31 @@ static const struct flock pldm_instance_id_cflu = {
 	.l_len = 1,
 };
 
-LIBPLDM_ABI_STABLE
-int pldm_instance_id_alloc(struct pldm_instance_db *ctx, pldm_tid_t tid,
-			   pldm_instance_id_t *iid)
+/*
+ * Reserve count instance IDs in one scan of the lock database. Those reserved
+ * are set in *iids, and remain reserved if there weren't enough.
+ */
+static int pldm_instance_id_alloc_lock_db(struct pldm_instance_db *ctx,
+					  pldm_tid_t tid, unsigned int count,
+					  uint32_t *iids)
 {
 	uint8_t l_iid;
-
-	if (!ctx || !iid) {
-		return -EINVAL;
-	}
+	int i;
 
 	l_iid = ctx->state[tid].prev;
 	if (l_iid >= PLDM_INST_ID_MAX) {
 		return -EPROTO;
 	}
 
-	while ((l_iid = iid_next(l_iid)) != ctx->state[tid].prev) {
+	/* Skip the previous allocation, a late response to it mustn't match
+	 * the next request */
+	for (i = 0; i < PLDM_INST_ID_MAX - 1; i++) {
 		struct flock flop;
 		off_t loff;
 		int rc;
 
+		l_iid = iid_next(l_iid);
+
 		/* Have we already allocated this instance ID? */
 		if (ctx->state[tid].allocations & BIT(l_iid)) {
 			continue;
@@ -182,10 +416,13 @@ int pldm_instance_id_alloc(struct pldm_instance_db *ctx, pldm_tid_t tid,
 		/* F_UNLCK is the type of the lock if we could successfully
 		 * promote it to F_WRLCK */
 		if (flop.l_type == F_UNLCK) {
-			ctx->state[tid].prev = l_iid;
 			ctx->state[tid].allocations |= BIT(l_iid);
-			*iid = l_iid;
-			return 0;
+			*iids |= BIT(l_iid);
+			if (!--count) {
+				ctx->state[tid].prev = l_iid;
+				return 0;
+			}
+			continue;
 		}
 
 		if (flop.l_type != F_RDLCK) {
@@ -207,11 +444,40 @@ int pldm_instance_id_alloc(struct pldm_instance_db *ctx, pldm_tid_t tid,
 		}
 	}
 
-	/* Failed to allocate an IID after a full loop. Make the caller try
-	 * again */
+	/* Failed to allocate enough IIDs after a full loop. Make the caller
+	 * try again */
 	return -EAGAIN;
 }
 
+LIBPLDM_ABI_STABLE
+int pldm_instance_id_alloc(struct pldm_instance_db *ctx, pldm_tid_t tid,
+			   pldm_instance_id_t *iid)
+{
+	uint32_t l_iids = 0;
+	int rc;
+
+	if (!ctx || !iid) {
+		return -EINVAL;
+	}
+
+	if (pldm_instance_id_take_cached(ctx, tid, iid)) {
+		return 0;
+	}
+
+	if (ctx->shm) {
+		rc = pldm_instance_id_alloc_shm(ctx, tid, 1, &l_iids);
+	} else {
+		rc = pldm_instance_id_alloc_lock_db(ctx, tid, 1, &l_iids);
+	}
+	if (rc) {
+		return rc;
+	}
+
+	*iid = __builtin_ctz(l_iids);
+
+	return 0;
+}
+
 LIBPLDM_ABI_STABLE
 int pldm_instance_id_free(struct pldm_instance_db *ctx, pldm_tid_t tid,
 			  pldm_instance_id_t iid)
@@ -225,10 +491,20 @@ int pldm_instance_id_free(struct pldm_instance_db *ctx, pldm_tid_t tid,
 	}
 
 	/* Trying to free an instance ID that is not currently allocated */
-	if (!(ctx->state[tid].allocations & BIT(iid))) {
+	if (iid >= PLDM_INST_ID_MAX ||
+	    !(ctx->state[tid].allocations & BIT(iid)) ||
+	    (ctx->state[tid].cached & BIT(iid))) {
 		return -EINVAL;
 	}
 
+	if (pldm_instance_id_cache(ctx, tid, iid)) {
+		return 0;
+	}
+
+	if (ctx->shm) {
+		return pldm_instance_id_free_shm(ctx, tid, iid);
+	}
+
 	flop = pldm_instance_id_cflu;
 	flop.l_start = tid * PLDM_INST_ID_MAX + iid;
 	rc = fcntl(ctx->lock_db_fd, F_OFD_SETLK, &flop);
@@ -244,3 +520,99 @@ int pldm_instance_id_free(struct pldm_instance_db *ctx, pldm_tid_t tid,
 
 	return 0;
 }
+
+LIBPLDM_ABI_TESTING
+int pldm_instance_id_alloc_batch(struct pldm_instance_db *ctx, pldm_tid_t tid,
+				 unsigned int count, uint32_t *iids)
+{
+	pldm_instance_id_t iid;
+	uint32_t l_iids = 0;
+	int rc;
+
+	if (!ctx || !iids || count == 0 || count > PLDM_INST_ID_MAX) {
+		return -EINVAL;
+	}
+
+	/* Use up the cache before reserving the rest in a single scan */
+	while (count && pldm_instance_id_take_cached(ctx, tid, &iid)) {
+		l_iids |= BIT(iid);
+		count--;
+	}
+
+	rc = 0;
+	if (count && ctx->shm) {
+		rc = pldm_instance_id_alloc_shm(ctx, tid, count, &l_iids);
+	} else if (count) {
+		rc = pldm_instance_id_alloc_lock_db(ctx, tid, count, &l_iids);
+	}
+	if (rc) {
+		pldm_instance_id_free_batch(ctx, tid, l_iids);
+		return rc;
+	}
+
+	*iids = l_iids;
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_instance_id_free_batch(struct pldm_instance_db *ctx, pldm_tid_t tid,
+				uint32_t iids)
+{
+	int result = 0;
+	int rc;
+
+	if (!ctx) {
+		return -EINVAL;
+	}
+
+	if ((ctx->state[tid].allocations & ~ctx->state[tid].cached & iids) !=
+	    iids) {
+		return -EINVAL;
+	}
+
+	/* Free them all, reporting the first failure */
+	while (iids) {
+		rc = pldm_instance_id_free(ctx, tid, __builtin_ctz(iids));
+		if (rc && !result) {
+			result = rc;
+		}
+		iids &= iids - 1;
+	}
+
+	return result;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_instance_db_set_cache(struct pldm_instance_db *ctx,
+			       unsigned int depth)
+{
+	uint32_t cached;
+	int result = 0;
+	int tid;
+	int rc;
+
+	if (!ctx || depth > PLDM_INST_ID_MAX) {
+		return -EINVAL;
+	}
+
+	ctx->cache_depth = depth;
+
+	/* Release what no longer fits in the cache */
+	for (tid = 0; tid < PLDM_TID_MAX; tid++) {
+		struct pldm_tid_state *state = &ctx->state[tid];
+
+		while ((unsigned int)__builtin_popcount(state->cached) >
+		       depth) {
+			cached = state->cached;
+			state->cached &= cached - 1;
+			rc = pldm_instance_id_free(ctx, tid,
+						   __builtin_ctz(cached));
+			if (rc && !result) {
+				result = rc;
+			}
+		}
+	}
+
+	return result;
+}
@@ -0,0 +1,468 @@
+/* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#include <libpldm/base.h>
+#include <libpldm/instance-id.h>
+#include <libpldm/pldm.h>
+#include <libpldm/requester.h>
+#include <libpldm/timer-wheel.h>
+#include <libpldm/transport.h>
+
+#include "transport/container-of.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BIT(i) (1UL << (i))
+
+#define PLDM_TID_MAX	 256
+#define PLDM_INST_ID_MAX 32
+
+/* Large enough for any MCTP message, as for the capture transport */
+#define PLDM_REQUESTER_RX_SIZE 65536
+
+struct pldm_requester_req {
+	struct pldm_timer timer;
+	pldm_requester_cb cb;
+	void *data;
+	pldm_tid_t tid;
+	struct pldm_msg_hdr hdr;
+	int timeout_ms;
+	unsigned int retries;
+	/* A copy of the request while it may be retried. The buffer is kept
+	 * with the slot and only grows, so it is reused by later requests */
+	void *msg;
+	size_t len;
+	size_t msg_size;
+};
+
+struct pldm_requester_peer {
+	uint32_t busy;
+	pldm_instance_id_t prev;
+	struct pldm_requester_req reqs[PLDM_INST_ID_MAX];
+};
+
+struct pldm_requester {
+	struct pldm_transport *transport;
+	struct pldm_instance_db *db;
+	/* Allocated on the first request to each TID */
+	struct pldm_requester_peer *peers[PLDM_TID_MAX];
+	struct pldm_timer_wheel *wheel;
+	unsigned int retries;
+	size_t pending;
+	/* The time of the expiry in progress, and the requests it timed out */
+	uint64_t now;
+	int expired;
+	/* Receive buffer for pldm_requester_process() */
+	uint8_t rx[PLDM_REQUESTER_RX_SIZE];
+};
+
+static int requester_now(uint64_t *now)
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) < 0) {
+		return -errno;
+	}
+
+	*now = (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+
+	return 0;
+}
+
+static int requester_alloc_iid(struct pldm_requester *ctx,
+			       struct pldm_requester_peer *peer, pldm_tid_t tid,
+			       pldm_instance_id_t *iid)
+{
+	pldm_instance_id_t cur;
+	int rc;
+	int i;
+
+	if (ctx->db) {
+		rc = pldm_instance_id_alloc(ctx->db, tid, &cur);
+		if (rc) {
+			return rc;
+		}
+
+		/* Instance IDs from the database must not already be ours */
+		if (peer->busy & BIT(cur)) {
+			pldm_instance_id_free(ctx->db, tid, cur);
+			return -EPROTO;
+		}
+
+		*iid = cur;
+		return 0;
+	}
+
+	for (i = 1; i <= PLDM_INST_ID_MAX; i++) {
+		cur = (peer->prev + i) % PLDM_INST_ID_MAX;
+		if (!(peer->busy & BIT(cur))) {
+			peer->prev = cur;
+			*iid = cur;
+			return 0;
+		}
+	}
+
+	return -EAGAIN;
+}
+
+static void requester_complete(struct pldm_requester *ctx,
+			       struct pldm_requester_req *req, int rc,
+			       const void *resp, size_t resp_len)
+{
+	struct pldm_requester_peer *peer = ctx->peers[req->tid];
+	pldm_instance_id_t iid = req->hdr.instance_id;
+	pldm_requester_cb cb = req->cb;
+	void *data = req->data;
+	pldm_tid_t tid = req->tid;
+
+	/* Release the request first, so the callback can reuse its slot */
+	pldm_timer_wheel_del(ctx->wheel, &req->timer);
+	peer->busy &= ~BIT(iid);
+	ctx->pending--;
+	if (ctx->db) {
+		pldm_instance_id_free(ctx->db, tid, iid);
+	}
+
+	cb(data, tid, rc, resp, resp_len);
+}
+
+static void requester_timeout(void *data, struct pldm_timer *timer)
+{
+	struct pldm_requester_req *req =
+		container_of(timer, struct pldm_requester_req, timer);
+	struct pldm_requester *ctx = data;
+	pldm_requester_rc_t prc;
+
+	/* Retries reuse the instance ID, so a late response still matches */
+	while (req->retries) {
+		req->retries--;
+		prc = pldm_transport_send_msg(ctx->transport, req->tid,
+					      req->msg, req->len);
+		if (prc == PLDM_REQUESTER_SUCCESS) {
+			pldm_timer_wheel_add(ctx->wheel, &req->timer,
+					     ctx->now + req->timeout_ms,
+					     requester_timeout, ctx);
+			return;
+		}
+	}
+
+	ctx->expired++;
+	requester_complete(ctx, req, -ETIMEDOUT, NULL, 0);
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_requester_init(struct pldm_requester **ctx,
+			struct pldm_transport *transport,
+			struct pldm_instance_db *db)
+{
+	struct pldm_requester *requester;
+	uint64_t now;
+	int rc;
+
+	if (!ctx || *ctx || !transport) {
+		return -EINVAL;
+	}
+
+	rc = requester_now(&now);
+	if (rc) {
+		return rc;
+	}
+
+	requester = calloc(1, sizeof(*requester));
+	if (!requester) {
+		return -ENOMEM;
+	}
+
+	rc = pldm_timer_wheel_init(&requester->wheel, now);
+	if (rc) {
+		free(requester);
+		return rc;
+	}
+
+	requester->transport = transport;
+	requester->db = db;
+	*ctx = requester;
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+void pldm_requester_destroy(struct pldm_requester *ctx)
+{
+	struct pldm_requester_peer *peer;
+	size_t i;
+	size_t j;
+
+	if (!ctx) {
+		return;
+	}
+
+	for (i = 0; i < PLDM_TID_MAX; i++) {
+		peer = ctx->peers[i];
+		while (peer && peer->busy) {
+			requester_complete(ctx,
+					   &peer->reqs[__builtin_ctz(peer->busy)],
+					   -ECANCELED, NULL, 0);
+		}
+		for (j = 0; peer && j < PLDM_INST_ID_MAX; j++) {
+			free(peer->reqs[j].msg);
+		}
+		free(peer);
+	}
+
+	pldm_timer_wheel_destroy(ctx->wheel);
+	free(ctx);
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_requester_set_retries(struct pldm_requester *ctx,
+			       unsigned int retries)
+{
+	if (!ctx) {
+		return -EINVAL;
+	}
+
+	ctx->retries = retries;
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_requester_submit(struct pldm_requester *ctx, pldm_tid_t tid,
+			  void *req_msg, size_t req_len, int timeout_ms,
+			  pldm_requester_cb cb, void *data,
+			  pldm_instance_id_t *iid)
+{
+	struct pldm_requester_peer *peer;
+	struct pldm_requester_req *req;
+	struct pldm_msg_hdr *hdr;
+	pldm_requester_rc_t prc;
+	pldm_instance_id_t cur;
+	uint64_t now;
+	int rc;
+
+	if (!ctx || !req_msg || req_len < sizeof(*hdr) || timeout_ms <= 0 ||
+	    !cb) {
+		return -EINVAL;
+	}
+
+	hdr = req_msg;
+	if (!hdr->request) {
+		return -EINVAL;
+	}
+
+	rc = requester_now(&now);
+	if (rc) {
+		return rc;
+	}
+
+	peer = ctx->peers[tid];
+	if (!peer) {
+		peer = calloc(1, sizeof(*peer));
+		if (!peer) {
+			return -ENOMEM;
+		}
+		/* Start the rotation at instance ID 0 */
+		peer->prev = PLDM_INST_ID_MAX - 1;
+		ctx->peers[tid] = peer;
+	}
+
+	rc = requester_alloc_iid(ctx, peer, tid, &cur);
+	if (rc) {
+		return rc;
+	}
+
+	hdr->instance_id = cur;
+	req = &peer->reqs[cur];
+	if (ctx->retries) {
+		if (req->msg_size < req_len) {
+			void *msg = realloc(req->msg, req_len);
+			if (!msg) {
+				rc = -ENOMEM;
+				goto cleanup_iid;
+			}
+			req->msg = msg;
+			req->msg_size = req_len;
+		}
+		memcpy(req->msg, req_msg, req_len);
+	}
+
+	prc = pldm_transport_send_msg(ctx->transport, tid, req_msg, req_len);
+	if (prc != PLDM_REQUESTER_SUCCESS) {
+		rc = -EIO;
+		goto cleanup_iid;
+	}
+
+	req->cb = cb;
+	req->data = data;
+	req->tid = tid;
+	req->hdr = *hdr;
+	req->timeout_ms = timeout_ms;
+	req->retries = ctx->retries;
+	req->len = req_len;
+	pldm_timer_wheel_add(ctx->wheel, &req->timer,
+			     now + (uint64_t)timeout_ms, requester_timeout,
+			     ctx);
+	peer->busy |= BIT(cur);
+	ctx->pending++;
+
+	if (iid) {
+		*iid = cur;
+	}
+
+	return 0;
+
+cleanup_iid:
+	if (ctx->db) {
+		pldm_instance_id_free(ctx->db, tid, cur);
+	}
+
+	return rc;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_requester_cancel(struct pldm_requester *ctx, pldm_tid_t tid,
+			  pldm_instance_id_t iid)
+{
+	struct pldm_requester_peer *peer;
+
+	if (!ctx) {
+		return -EINVAL;
+	}
+
+	peer = ctx->peers[tid];
+	if (!peer || iid >= PLDM_INST_ID_MAX || !(peer->busy & BIT(iid))) {
+		return -ENOENT;
+	}
+
+	requester_complete(ctx, &peer->reqs[iid], -ECANCELED, NULL, 0);
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_requester_handle_msg(struct pldm_requester *ctx, pldm_tid_t tid,
+			      const void *msg, size_t msg_len)
+{
+	const struct pldm_msg_hdr *hdr = msg;
+	struct pldm_requester_peer *peer;
+	struct pldm_requester_req *req;
+
+	if (!ctx || !msg) {
+		return -EINVAL;
+	}
+
+	if (msg_len < sizeof(*hdr) || hdr->request) {
+		return -ENOMSG;
+	}
+
+	peer = ctx->peers[tid];
+	if (!peer || !(peer->busy & BIT(hdr->instance_id))) {
+		return -ENOMSG;
+	}
+
+	req = &peer->reqs[hdr->instance_id];
+	if (!pldm_msg_hdr_correlate_response(&req->hdr, hdr)) {
+		return -ENOMSG;
+	}
+
+	requester_complete(ctx, req, 0, msg, msg_len);
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_requester_expire(struct pldm_requester *ctx)
+{
+	uint64_t now;
+	int rc;
+
+	if (!ctx) {
+		return -EINVAL;
+	}
+
+	if (!ctx->pending) {
+		return 0;
+	}
+
+	rc = requester_now(&now);
+	if (rc) {
+		return rc;
+	}
+
+	ctx->now = now;
+	ctx->expired = 0;
+	pldm_timer_wheel_advance(ctx->wheel, now);
+
+	return ctx->expired;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_requester_next_timeout(struct pldm_requester *ctx)
+{
+	uint64_t now;
+	int rc;
+
+	if (!ctx) {
+		return -EINVAL;
+	}
+
+	if (!ctx->pending) {
+		return -1;
+	}
+
+	rc = requester_now(&now);
+	if (rc) {
+		return rc;
+	}
+
+	return pldm_timer_wheel_next_timeout(ctx->wheel, now);
+}
+
+LIBPLDM_ABI_TESTING
+size_t pldm_requester_pending(struct pldm_requester *ctx)
+{
+	return ctx ? ctx->pending : 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_requester_process(struct pldm_requester *ctx, int timeout_ms)
+{
+	pldm_requester_rc_t prc;
+	size_t msg_len;
+	pldm_tid_t tid;
+	int wait;
+	int rc;
+
+	rc = pldm_requester_expire(ctx);
+	if (rc < 0) {
+		return rc;
+	}
+
+	wait = pldm_requester_next_timeout(ctx);
+	if (wait < 0 || (timeout_ms >= 0 && timeout_ms < wait)) {
+		wait = timeout_ms;
+	}
+
+	rc = pldm_transport_poll(ctx->transport, wait);
+	if (rc < 0) {
+		return -EIO;
+	}
+
+	if (rc > 0) {
+		msg_len = sizeof(ctx->rx);
+		prc = pldm_transport_recv_msg_into(ctx->transport, &tid,
+						   ctx->rx, &msg_len);
+		/* Failing to receive one message doesn't affect the others */
+		if (prc == PLDM_REQUESTER_SUCCESS) {
+			pldm_requester_handle_msg(ctx, tid, ctx->rx, msg_len);
+		}
+	}
+
+	rc = pldm_requester_expire(ctx);
+
+	return rc < 0 ? rc : 0;
+}
@@ -5,6 +5,7 @@
 #include <libpldm/pldm.h>
 
 #include <stdbool.h>
+#include <string.h>
 
 static bool pldm_responder_cookie_eq(const struct pldm_responder_cookie *left,
 				     const struct pldm_responder_cookie *right)
@@ -14,57 +15,151 @@ static bool pldm_responder_cookie_eq(const struct pldm_responder_cookie *left,
 	       left->type == right->type && left->command == right->command;
 }
 
-int pldm_responder_cookie_track(struct pldm_responder_cookie *jar,
+static struct pldm_responder_cookie **
+pldm_responder_cookie_bucket(struct pldm_responder_cookie_jar *jar,
+			     const struct pldm_responder_cookie *cookie)
+{
+	uint32_t key;
+
+	key = (uint32_t)cookie->tid | (uint32_t)cookie->instance_id << 8 |
+	      (uint32_t)cookie->type << 13 | (uint32_t)cookie->command << 19;
+
+	/* Fibonacci hashing, taking the top bits of the product */
+	return &jar->buckets[((key * 2654435761U) >> 24) &
+			     (PLDM_RESPONDER_COOKIE_JAR_BUCKETS - 1)];
+}
+
+static void pldm_responder_cookie_unlink(struct pldm_responder_cookie_jar *jar,
+					 struct pldm_responder_cookie *cookie)
+{
+	if (cookie->older) {
+		cookie->older->newer = cookie->newer;
+	} else {
+		jar->oldest = cookie->newer;
+	}
+
+	if (cookie->newer) {
+		cookie->newer->older = cookie->older;
+	} else {
+		jar->newest = cookie->older;
+	}
+
+	cookie->older = NULL;
+	cookie->newer = NULL;
+}
+
+void pldm_responder_cookie_jar_init(struct pldm_responder_cookie_jar *jar)
+{
+	memset(jar, 0, sizeof(*jar));
+}
+
+int pldm_responder_cookie_track(struct pldm_responder_cookie_jar *jar,
 				struct pldm_responder_cookie *cookie)
 {
+	struct pldm_responder_cookie **bucket;
 	struct pldm_responder_cookie *current;
-	struct pldm_responder_cookie *next;
 
 	if (!jar || !cookie) {
 		return PLDM_REQUESTER_INVALID_SETUP;
 	}
 
-	current = jar;
-	next = current->next;
-	while (next) {
+	bucket = pldm_responder_cookie_bucket(jar, cookie);
+	for (current = *bucket; current; current = current->next) {
 		/* Cookie must not already be known */
-		if (pldm_responder_cookie_eq(next, cookie)) {
+		if (pldm_responder_cookie_eq(current, cookie)) {
 			return PLDM_REQUESTER_INVALID_SETUP;
 		}
-		current = next;
-		next = next->next;
 	}
 
-	cookie->next = NULL;
-	current->next = cookie;
+	cookie->next = *bucket;
+	*bucket = cookie;
+	cookie->older = jar->newest;
+	cookie->newer = NULL;
+	if (jar->newest) {
+		jar->newest->newer = cookie;
+	} else {
+		jar->oldest = cookie;
+	}
+	jar->newest = cookie;
+	jar->count++;
 
 	return PLDM_REQUESTER_SUCCESS;
 }
 
 struct pldm_responder_cookie *
-pldm_responder_cookie_untrack(struct pldm_responder_cookie *jar, pldm_tid_t tid,
-			      pldm_instance_id_t instance_id, uint8_t type,
-			      uint8_t command)
+pldm_responder_cookie_untrack(struct pldm_responder_cookie_jar *jar,
+			      pldm_tid_t tid, pldm_instance_id_t instance_id,
+			      uint8_t type, uint8_t command)
 {
-	const struct pldm_responder_cookie cookie = { tid, instance_id, type,
-						      command, NULL };
-	struct pldm_responder_cookie *current;
-	struct pldm_responder_cookie *next;
+	const struct pldm_responder_cookie cookie = {
+		tid, instance_id, type, command, NULL, NULL, NULL
+	};
+	struct pldm_responder_cookie **link;
+	struct pldm_responder_cookie *found;
+
+	if (!jar) {
+		return NULL;
+	}
+
+	link = pldm_responder_cookie_bucket(jar, &cookie);
+	while (*link && !pldm_responder_cookie_eq(*link, &cookie)) {
+		link = &(*link)->next;
+	}
+
+	found = *link;
+	if (found) {
+		*link = found->next;
+		found->next = NULL;
+		pldm_responder_cookie_unlink(jar, found);
+		jar->count--;
+	}
+
+	return found;
+}
+
+struct pldm_responder_cookie *
+pldm_responder_cookie_evict(struct pldm_responder_cookie_jar *jar)
+{
+	struct pldm_responder_cookie *oldest;
+
+	if (!jar || !jar->oldest) {
+		return NULL;
+	}
+
+	oldest = jar->oldest;
+
+	return pldm_responder_cookie_untrack(jar, oldest->tid,
+					     oldest->instance_id, oldest->type,
+					     oldest->command);
+}
+
+struct pldm_responder_cookie *
+pldm_responder_cookie_get(struct pldm_responder_cookie_jar *jar)
+{
+	struct pldm_responder_cookie *cookie;
 
 	if (!jar) {
 		return NULL;
 	}
 
-	current = jar;
-	next = current->next;
-	while (next && !pldm_responder_cookie_eq(next, &cookie)) {
-		current = next;
-		next = next->next;
+	cookie = jar->unused;
+	if (!cookie) {
+		return pldm_responder_cookie_evict(jar);
 	}
 
-	if (next) {
-		current->next = next->next;
+	jar->unused = cookie->next;
+	cookie->next = NULL;
+
+	return cookie;
+}
+
+void pldm_responder_cookie_put(struct pldm_responder_cookie_jar *jar,
+			       struct pldm_responder_cookie *cookie)
+{
+	if (!jar || !cookie) {
+		return;
 	}
 
-	return next;
+	cookie->next = jar->unused;
+	jar->unused = cookie;
 }
@@ -5,22 +5,61 @@
 #include <libpldm/base.h>
 #include <libpldm/instance-id.h>
 
+#include <stddef.h>
 #include <stdint.h>
 
+/* Must be a power of two */
+#define PLDM_RESPONDER_COOKIE_JAR_BUCKETS 256
+
 struct pldm_responder_cookie {
 	pldm_tid_t tid;
 	pldm_instance_id_t instance_id;
 	uint8_t type;
 	uint8_t command;
 	struct pldm_responder_cookie *next;
+	/* Neighbours in the jar's age order, maintained by the jar */
+	struct pldm_responder_cookie *older;
+	struct pldm_responder_cookie *newer;
+};
+
+/*
+ * Tracks the requests awaiting a response, hashed on (tid, instance_id, type,
+ * command). Cookies are provided by the caller and chained through their next
+ * member, so tracking never allocates. Callers with a fixed pool of cookies
+ * can hand the unused ones to the jar with pldm_responder_cookie_put(). When
+ * those run out, pldm_responder_cookie_get() reclaims the cookie tracked
+ * longest ago, whose requester has most likely given up on a response.
+ */
+struct pldm_responder_cookie_jar {
+	struct pldm_responder_cookie *buckets[PLDM_RESPONDER_COOKIE_JAR_BUCKETS];
+	/* Tracked cookies in the order they were tracked */
+	struct pldm_responder_cookie *oldest;
+	struct pldm_responder_cookie *newest;
+	/* Untracked cookies, linked through next */
+	struct pldm_responder_cookie *unused;
+	size_t count;
 };
 
-int pldm_responder_cookie_track(struct pldm_responder_cookie *jar,
+void pldm_responder_cookie_jar_init(struct pldm_responder_cookie_jar *jar);
+
+int pldm_responder_cookie_track(struct pldm_responder_cookie_jar *jar,
 				struct pldm_responder_cookie *cookie);
 
 struct pldm_responder_cookie *
-pldm_responder_cookie_untrack(struct pldm_responder_cookie *jar, pldm_tid_t tid,
-			      pldm_instance_id_t instance_id, uint8_t type,
-			      uint8_t command);
+pldm_responder_cookie_untrack(struct pldm_responder_cookie_jar *jar,
+			      pldm_tid_t tid, pldm_instance_id_t instance_id,
+			      uint8_t type, uint8_t command);
+
+/* Untrack and return the cookie tracked longest ago, or NULL if none are */
+struct pldm_responder_cookie *
+pldm_responder_cookie_evict(struct pldm_responder_cookie_jar *jar);
+
+/* Take an unused cookie, evicting the oldest tracked cookie if none remain */
+struct pldm_responder_cookie *
+pldm_responder_cookie_get(struct pldm_responder_cookie_jar *jar);
+
+/* Return an untracked cookie for use by pldm_responder_cookie_get() */
+void pldm_responder_cookie_put(struct pldm_responder_cookie_jar *jar,
+			       struct pldm_responder_cookie *cookie);
 
 #endif
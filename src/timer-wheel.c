@@ -0,0 +1,360 @@
+/* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#include "compiler.h"
+
+#include <libpldm/timer-wheel.h>
+
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define WHEEL_BITS   6
+#define WHEEL_SLOTS  (1U << WHEEL_BITS)
+#define WHEEL_MASK   (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS 6
+/* Timers further out are parked at the horizon until it comes closer */
+#define WHEEL_HORIZON ((UINT64_C(1) << (WHEEL_BITS * WHEEL_LEVELS)) - 1)
+
+/*
+ * Level n has slots of 64^n milliseconds. A timer is placed in the lowest level
+ * whose span covers its distance from the current tick, and moved down a level
+ * when the tick reaches the start of its slot. Each timer is therefore moved at
+ * most once per level before it expires.
+ */
+struct pldm_timer_wheel {
+	/* The next tick to process */
+	uint64_t clk;
+	size_t count;
+	/* Timers added with an expiry before clk */
+	struct pldm_timer *expired;
+	/* Slots that may hold timers. Bits are cleared lazily on removal */
+	uint64_t occupied[WHEEL_LEVELS];
+	struct pldm_timer *slots[WHEEL_LEVELS][WHEEL_SLOTS];
+};
+
+static void timer_link(struct pldm_timer **head, struct pldm_timer *timer)
+{
+	timer->next = *head;
+	if (timer->next) {
+		timer->next->pprev = &timer->next;
+	}
+	*head = timer;
+	timer->pprev = head;
+}
+
+static void timer_unlink(struct pldm_timer *timer)
+{
+	*timer->pprev = timer->next;
+	if (timer->next) {
+		timer->next->pprev = timer->pprev;
+	}
+	timer->next = NULL;
+	timer->pprev = NULL;
+}
+
+static void wheel_place(struct pldm_timer_wheel *ctx, struct pldm_timer *timer)
+{
+	uint64_t expires = timer->expires;
+	unsigned int level;
+	uint64_t delta;
+	unsigned int i;
+
+	if (expires < ctx->clk) {
+		timer_link(&ctx->expired, timer);
+		return;
+	}
+
+	delta = expires - ctx->clk;
+	if (delta > WHEEL_HORIZON) {
+		delta = WHEEL_HORIZON;
+		expires = ctx->clk + delta;
+	}
+
+	for (level = 0; level < WHEEL_LEVELS - 1; level++) {
+		if (delta < (UINT64_C(1) << (WHEEL_BITS * (level + 1)))) {
+			break;
+		}
+	}
+
+	i = (expires >> (WHEEL_BITS * level)) & WHEEL_MASK;
+	timer_link(&ctx->slots[level][i], timer);
+	ctx->occupied[level] |= UINT64_C(1) << i;
+}
+
+static struct pldm_timer *wheel_take(struct pldm_timer_wheel *ctx,
+				     unsigned int level, unsigned int i)
+{
+	struct pldm_timer *list = ctx->slots[level][i];
+
+	ctx->slots[level][i] = NULL;
+	ctx->occupied[level] &= ~(UINT64_C(1) << i);
+
+	return list;
+}
+
+/* Move the timers of the slots starting at the current tick down a level */
+static void wheel_cascade(struct pldm_timer_wheel *ctx)
+{
+	struct pldm_timer *timer;
+	struct pldm_timer *list;
+	unsigned int level;
+	unsigned int i;
+
+	for (level = 1; level < WHEEL_LEVELS; level++) {
+		i = (ctx->clk >> (WHEEL_BITS * level)) & WHEEL_MASK;
+		list = wheel_take(ctx, level, i);
+		while (list) {
+			timer = list;
+			list = timer->next;
+			wheel_place(ctx, timer);
+		}
+
+		if (i) {
+			break;
+		}
+	}
+}
+
+/* Invoke the callbacks of a list of expired timers */
+static int wheel_fire(struct pldm_timer_wheel *ctx, struct pldm_timer *list)
+{
+	struct pldm_timer *timer;
+	int fired = 0;
+
+	/* Callbacks may remove timers still on the list */
+	if (list) {
+		list->pprev = &list;
+	}
+
+	while (list) {
+		timer = list;
+		timer_unlink(timer);
+		ctx->count--;
+		timer->cb(timer->data, timer);
+		fired++;
+	}
+
+	return fired;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_timer_wheel_init(struct pldm_timer_wheel **ctx, uint64_t now)
+{
+	struct pldm_timer_wheel *wheel;
+
+	if (!ctx || *ctx) {
+		return -EINVAL;
+	}
+
+	wheel = calloc(1, sizeof(*wheel));
+	if (!wheel) {
+		return -ENOMEM;
+	}
+
+	wheel->clk = now;
+	*ctx = wheel;
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+void pldm_timer_wheel_destroy(struct pldm_timer_wheel *ctx)
+{
+	unsigned int level;
+	unsigned int i;
+
+	if (!ctx) {
+		return;
+	}
+
+	/* Leave the timers ready for reuse */
+	while (ctx->expired) {
+		timer_unlink(ctx->expired);
+	}
+
+	for (level = 0; level < WHEEL_LEVELS; level++) {
+		for (i = 0; i < WHEEL_SLOTS; i++) {
+			while (ctx->slots[level][i]) {
+				timer_unlink(ctx->slots[level][i]);
+			}
+		}
+	}
+
+	free(ctx);
+}
+
+LIBPLDM_ABI_TESTING
+bool pldm_timer_pending(const struct pldm_timer *timer)
+{
+	return timer && timer->pprev;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_timer_wheel_add(struct pldm_timer_wheel *ctx, struct pldm_timer *timer,
+			 uint64_t expires, pldm_timer_cb cb, void *data)
+{
+	if (!ctx || !timer || !cb) {
+		return -EINVAL;
+	}
+
+	if (pldm_timer_pending(timer)) {
+		return -EBUSY;
+	}
+
+	timer->expires = expires;
+	timer->cb = cb;
+	timer->data = data;
+	wheel_place(ctx, timer);
+	ctx->count++;
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_timer_wheel_del(struct pldm_timer_wheel *ctx, struct pldm_timer *timer)
+{
+	if (!ctx || !timer) {
+		return -EINVAL;
+	}
+
+	if (!pldm_timer_pending(timer)) {
+		return -ENOENT;
+	}
+
+	timer_unlink(timer);
+	ctx->count--;
+
+	return 0;
+}
+
+static uint64_t rotr64(uint64_t v, unsigned int n)
+{
+	return n ? (v >> n) | (v << (64 - n)) : v;
+}
+
+/* The earliest time at which a slot of the level needs attention */
+static uint64_t wheel_level_next(struct pldm_timer_wheel *ctx,
+				 unsigned int level)
+{
+	unsigned int shift = WHEEL_BITS * level;
+	unsigned int c = (ctx->clk >> shift) & WHEEL_MASK;
+	bool boundary = !(ctx->clk & ((UINT64_C(1) << shift) - 1));
+	uint64_t rot;
+	unsigned int d;
+	unsigned int i;
+
+	while (ctx->occupied[level]) {
+		rot = rotr64(ctx->occupied[level], c);
+
+		/*
+		 * Above level 0 the current slot was cascaded when the tick
+		 * entered it, unless the tick is yet to be processed, so it
+		 * comes due a full revolution later.
+		 */
+		if (!level || ((rot & 1) && boundary)) {
+			d = __builtin_ctzll(rot);
+		} else if (rot & ~UINT64_C(1)) {
+			d = __builtin_ctzll(rot & ~UINT64_C(1));
+		} else {
+			d = WHEEL_SLOTS;
+		}
+
+		i = (c + d) & WHEEL_MASK;
+		if (!ctx->slots[level][i]) {
+			ctx->occupied[level] &= ~(UINT64_C(1) << i);
+			continue;
+		}
+
+		return ((ctx->clk >> shift) + d) << shift;
+	}
+
+	return UINT64_MAX;
+}
+
+/* The earliest tick at which a timer expires or must be cascaded */
+static uint64_t wheel_next_event(struct pldm_timer_wheel *ctx)
+{
+	uint64_t earliest = UINT64_MAX;
+	unsigned int level;
+	uint64_t next;
+
+	for (level = 0; level < WHEEL_LEVELS; level++) {
+		next = wheel_level_next(ctx, level);
+		if (next < earliest) {
+			earliest = next;
+		}
+	}
+
+	return earliest;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_timer_wheel_advance(struct pldm_timer_wheel *ctx, uint64_t now)
+{
+	struct pldm_timer *list;
+	unsigned int i;
+	uint64_t next;
+	int fired;
+
+	if (!ctx) {
+		return -EINVAL;
+	}
+
+	/* Timers added late by the callbacks expire on the next call */
+	list = ctx->expired;
+	ctx->expired = NULL;
+	fired = wheel_fire(ctx, list);
+
+	/* Jump between the ticks with work, however far apart they are */
+	while (ctx->clk <= now) {
+		next = wheel_next_event(ctx);
+		if (next > now) {
+			ctx->clk = now + 1;
+			break;
+		}
+
+		ctx->clk = next;
+		i = ctx->clk & WHEEL_MASK;
+		if (!i) {
+			wheel_cascade(ctx);
+		}
+
+		ctx->clk++;
+		fired += wheel_fire(ctx, wheel_take(ctx, 0, i));
+	}
+
+	return fired;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_timer_wheel_next_timeout(struct pldm_timer_wheel *ctx, uint64_t now)
+{
+	uint64_t earliest;
+
+	if (!ctx) {
+		return -EINVAL;
+	}
+
+	if (!ctx->count) {
+		return -1;
+	}
+
+	if (ctx->expired) {
+		return 0;
+	}
+
+	earliest = wheel_next_event(ctx);
+
+	/* Only timers being fired by an expiry callback remain */
+	if (earliest <= now || earliest == UINT64_MAX) {
+		return 0;
+	}
+
+	if (earliest - now > INT_MAX) {
+		return INT_MAX;
+	}
+
+	return (int)(earliest - now);
+}
@@ -2,8 +2,8 @@
 #include "compiler.h"
 #include "container-of.h"
 #include "mctp-defines.h"
-#include "responder.h"
 #include "socket.h"
+#include "tid-eid-map.h"
 #include "transport.h"
 
 #include <libpldm/base.h>
@@ -23,22 +23,16 @@
 #include <sys/un.h>
 #include <unistd.h>
 
-struct pldm_responder_cookie_af_mctp {
-	struct pldm_responder_cookie req;
-	struct sockaddr_mctp smctp;
-};
-
-#define cookie_to_af_mctp(c)                                                   \
-	container_of((c), struct pldm_responder_cookie_af_mctp, req)
-
 #define AF_MCTP_NAME "AF_MCTP"
+#define AF_MCTP_BATCH_MAX 32
 struct pldm_transport_af_mctp {
 	struct pldm_transport transport;
 	int socket;
-	pldm_tid_t tid_eid_map[MCTP_MAX_NUM_EID];
+	struct pldm_tid_eid_map tid_eid_map;
 	struct pldm_socket_sndbuf socket_send_buf;
+	struct pldm_socket_txq txq;
 	bool bound;
-	struct pldm_responder_cookie cookie_jar;
+	struct pldm_socket_mctp_responder responder;
 };
 
 #define transport_to_af_mctp(ptr)                                              \
@@ -58,50 +52,63 @@ int pldm_transport_af_mctp_init_pollfd(struct pldm_transport *t,
 	struct pldm_transport_af_mctp *ctx = transport_to_af_mctp(t);
 	pollfd->fd = ctx->socket;
 	pollfd->events = POLLIN;
+	if (ctx->txq.count) {
+		pollfd->events |= POLLOUT;
+	}
 	return 0;
 }
 
-static int pldm_transport_af_mctp_get_eid(struct pldm_transport_af_mctp *ctx,
-					  pldm_tid_t tid, mctp_eid_t *eid)
+static int pldm_transport_af_mctp_flush(struct pldm_transport *t)
 {
-	int i;
-	for (i = 0; i < MCTP_MAX_NUM_EID; i++) {
-		if (ctx->tid_eid_map[i] == tid) {
-			*eid = i;
-			return 0;
-		}
-	}
-	*eid = -1;
-	return -1;
+	struct pldm_transport_af_mctp *af_mctp = transport_to_af_mctp(t);
+
+	return pldm_socket_txq_flush(&af_mctp->txq, af_mctp->socket);
 }
 
-static int pldm_transport_af_mctp_get_tid(struct pldm_transport_af_mctp *ctx,
-					  mctp_eid_t eid, pldm_tid_t *tid)
+LIBPLDM_ABI_TESTING
+int pldm_transport_af_mctp_set_send_queue(struct pldm_transport_af_mctp *ctx,
+					  size_t depth)
 {
-	if (ctx->tid_eid_map[eid] != 0) {
-		*tid = ctx->tid_eid_map[eid];
-		return 0;
+	if (!ctx) {
+		return -EINVAL;
 	}
-	return -1;
+
+	return pldm_socket_txq_set_depth(&ctx->txq, depth);
 }
 
 LIBPLDM_ABI_STABLE
 int pldm_transport_af_mctp_map_tid(struct pldm_transport_af_mctp *ctx,
 				   pldm_tid_t tid, mctp_eid_t eid)
 {
-	ctx->tid_eid_map[eid] = tid;
+	return pldm_tid_eid_map_insert(&ctx->tid_eid_map, tid, MCTP_NET_ANY,
+				       eid);
+}
 
-	return 0;
+LIBPLDM_ABI_TESTING
+int pldm_transport_af_mctp_map_tid_net(struct pldm_transport_af_mctp *ctx,
+				       pldm_tid_t tid, uint32_t net,
+				       mctp_eid_t eid)
+{
+	return pldm_tid_eid_map_insert(&ctx->tid_eid_map, tid, net, eid);
 }
 
 LIBPLDM_ABI_STABLE
 int pldm_transport_af_mctp_unmap_tid(struct pldm_transport_af_mctp *ctx,
-				     LIBPLDM_CC_UNUSED pldm_tid_t tid,
-				     mctp_eid_t eid)
+				     pldm_tid_t tid, mctp_eid_t eid)
 {
-	ctx->tid_eid_map[eid] = 0;
+	return pldm_tid_eid_map_remove(&ctx->tid_eid_map, tid, eid);
+}
 
-	return 0;
+/* Resolve the source TID, and track the source address of requests so the
+ * response can be routed back to it */
+static pldm_requester_rc_t
+pldm_transport_af_mctp_accept(struct pldm_transport_af_mctp *af_mctp,
+			      const struct sockaddr_mctp *addr,
+			      const struct pldm_msg_hdr *hdr, pldm_tid_t *tid)
+{
+	return pldm_socket_mctp_accept(&af_mctp->responder,
+				       &af_mctp->tid_eid_map, af_mctp->bound,
+				       addr, hdr, tid);
 }
 
 static pldm_requester_rc_t pldm_transport_af_mctp_recv(struct pldm_transport *t,
@@ -112,12 +119,9 @@ static pldm_requester_rc_t pldm_transport_af_mctp_recv(struct pldm_transport *t,
 	struct pldm_transport_af_mctp *af_mctp = transport_to_af_mctp(t);
 	struct sockaddr_mctp addr = { 0 };
 	socklen_t addrlen = sizeof(addr);
-	struct pldm_msg_hdr *hdr;
 	pldm_requester_rc_t res;
-	mctp_eid_t eid = 0;
 	ssize_t length;
 	void *msg;
-	int rc;
 
 	length = recv(af_mctp->socket, NULL, 0, MSG_PEEK | MSG_TRUNC);
 	if (length <= 0) {
@@ -136,38 +140,11 @@ static pldm_requester_rc_t pldm_transport_af_mctp_recv(struct pldm_transport *t,
 		goto cleanup_msg;
 	}
 
-	eid = addr.smctp_addr.s_addr;
-	rc = pldm_transport_af_mctp_get_tid(af_mctp, eid, tid);
-	if (rc) {
-		res = PLDM_REQUESTER_RECV_FAIL;
+	res = pldm_transport_af_mctp_accept(af_mctp, &addr, msg, tid);
+	if (res != PLDM_REQUESTER_SUCCESS) {
 		goto cleanup_msg;
 	}
 
-	hdr = msg;
-
-	if (af_mctp->bound && hdr->request) {
-		struct pldm_responder_cookie_af_mctp *cookie;
-
-		cookie = malloc(sizeof(*cookie));
-		if (!cookie) {
-			res = PLDM_REQUESTER_RECV_FAIL;
-			goto cleanup_msg;
-		}
-
-		cookie->req.tid = *tid,
-		cookie->req.instance_id = hdr->instance_id,
-		cookie->req.type = hdr->type,
-		cookie->req.command = hdr->command;
-		cookie->smctp = addr;
-
-		rc = pldm_responder_cookie_track(&af_mctp->cookie_jar,
-						 &cookie->req);
-		if (rc) {
-			res = PLDM_REQUESTER_RECV_FAIL;
-			goto cleanup_msg;
-		}
-	}
-
 	*pldm_msg = msg;
 	*msg_len = length;
 
@@ -179,47 +156,77 @@ cleanup_msg:
 	return res;
 }
 
+static pldm_requester_rc_t
+pldm_transport_af_mctp_recv_into(struct pldm_transport *t, pldm_tid_t *tid,
+				 void *pldm_msg, size_t *msg_len)
+{
+	struct pldm_transport_af_mctp *af_mctp = transport_to_af_mctp(t);
+	struct sockaddr_mctp addr = { 0 };
+	struct msghdr msg = { 0 };
+	struct iovec iov;
+	ssize_t length;
+
+	iov.iov_base = pldm_msg;
+	iov.iov_len = *msg_len;
+	msg.msg_name = &addr;
+	msg.msg_namelen = sizeof(addr);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+
+	/* MSG_TRUNC yields the full length of the datagram */
+	length = recvmsg(af_mctp->socket, &msg, MSG_TRUNC);
+	if (length < 0) {
+		return PLDM_REQUESTER_RECV_FAIL;
+	}
+
+	if (length < (ssize_t)sizeof(struct pldm_msg_hdr)) {
+		return PLDM_REQUESTER_INVALID_RECV_LEN;
+	}
+
+	*msg_len = length;
+	if (msg.msg_flags & MSG_TRUNC) {
+		/* The message is lost, so don't track it for a response */
+		return PLDM_REQUESTER_RECV_TRUNCATED;
+	}
+
+	return pldm_transport_af_mctp_accept(af_mctp, &addr, pldm_msg, tid);
+}
+
+/* Resolve the destination address of a message. Responses claim the cookie of
+ * the request, which the caller must pass to pldm_socket_mctp_sent() */
+static pldm_requester_rc_t
+pldm_transport_af_mctp_route(struct pldm_transport_af_mctp *af_mctp,
+			     pldm_tid_t tid, const struct pldm_msg_hdr *hdr,
+			     struct sockaddr_mctp *addr,
+			     struct pldm_socket_mctp_cookie **cookie)
+{
+	return pldm_socket_mctp_route(&af_mctp->responder,
+				      &af_mctp->tid_eid_map, af_mctp->bound,
+				      tid, hdr, addr, cookie);
+}
+
 static pldm_requester_rc_t pldm_transport_af_mctp_send(struct pldm_transport *t,
 						       pldm_tid_t tid,
 						       const void *pldm_msg,
 						       size_t msg_len)
 {
 	struct pldm_transport_af_mctp *af_mctp = transport_to_af_mctp(t);
-	const struct pldm_msg_hdr *hdr;
-	struct sockaddr_mctp addr = { 0 };
+	struct pldm_socket_mctp_cookie *cookie;
+	struct sockaddr_mctp addr;
+	struct msghdr msg = { 0 };
+	pldm_requester_rc_t res;
+	struct iovec iov;
 
 	if (msg_len < (ssize_t)sizeof(struct pldm_msg_hdr)) {
 		return PLDM_REQUESTER_SEND_FAIL;
 	}
 
-	hdr = pldm_msg;
-	if (af_mctp->bound && !hdr->request) {
-		struct pldm_responder_cookie_af_mctp *cookie;
-		struct pldm_responder_cookie *req;
-
-		req = pldm_responder_cookie_untrack(&af_mctp->cookie_jar, tid,
-						    hdr->instance_id, hdr->type,
-						    hdr->command);
-		if (!req) {
-			return PLDM_REQUESTER_SEND_FAIL;
-		}
-
-		cookie = cookie_to_af_mctp(req);
-		addr = cookie->smctp;
-		/* Clear the TO to indicate a response */
-		addr.smctp_tag &= ~MCTP_TAG_OWNER;
-		free(cookie);
-	} else {
-		mctp_eid_t eid = 0;
-		if (pldm_transport_af_mctp_get_eid(af_mctp, tid, &eid)) {
-			return PLDM_REQUESTER_SEND_FAIL;
-		}
-
-		addr.smctp_family = AF_MCTP;
-		addr.smctp_addr.s_addr = eid;
-		addr.smctp_type = MCTP_MSG_TYPE_PLDM;
-		addr.smctp_tag = MCTP_TAG_OWNER;
+	res = pldm_transport_af_mctp_route(af_mctp, tid, pldm_msg, &addr,
+					   &cookie);
+	if (res != PLDM_REQUESTER_SUCCESS) {
+		return res;
 	}
+	pldm_socket_mctp_sent(&af_mctp->responder, cookie, true);
 
 	if (msg_len > INT_MAX ||
 	    pldm_socket_sndbuf_accomodate(&(af_mctp->socket_send_buf),
@@ -227,13 +234,179 @@ static pldm_requester_rc_t pldm_transport_af_mctp_send(struct pldm_transport *t,
 		return PLDM_REQUESTER_SEND_FAIL;
 	}
 
-	ssize_t rc = sendto(af_mctp->socket, pldm_msg, msg_len, 0,
-			    (struct sockaddr *)&addr, sizeof(addr));
-	if (rc == -1) {
-		return PLDM_REQUESTER_SEND_FAIL;
+	iov.iov_base = (void *)pldm_msg;
+	iov.iov_len = msg_len;
+	msg.msg_name = &addr;
+	msg.msg_namelen = sizeof(addr);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+
+	return pldm_socket_txq_send(&af_mctp->txq, af_mctp->socket, &msg);
+}
+
+static int pldm_transport_af_mctp_send_msgs(struct pldm_transport *t,
+					    struct pldm_transport_msg *msgs,
+					    size_t count)
+{
+	struct pldm_transport_af_mctp *af_mctp = transport_to_af_mctp(t);
+	struct pldm_socket_mctp_cookie *cookies[AF_MCTP_BATCH_MAX];
+	struct sockaddr_mctp addrs[AF_MCTP_BATCH_MAX];
+	struct mmsghdr mmsgs[AF_MCTP_BATCH_MAX];
+	struct iovec iovs[AF_MCTP_BATCH_MAX];
+	pldm_requester_rc_t res = PLDM_REQUESTER_SUCCESS;
+	size_t sent = 0;
+
+	/* Queued messages must go first, so send one at a time */
+	if (af_mctp->txq.depth) {
+		for (sent = 0; sent < count; sent++) {
+			res = pldm_transport_af_mctp_send(t, msgs[sent].tid,
+							  msgs[sent].msg,
+							  msgs[sent].len);
+			if (res != PLDM_REQUESTER_SUCCESS) {
+				break;
+			}
+			msgs[sent].rc = PLDM_REQUESTER_SUCCESS;
+		}
+
+		return sent ? (int)sent : res;
 	}
 
-	return PLDM_REQUESTER_SUCCESS;
+	while (sent < count) {
+		size_t batch = count - sent;
+		size_t prepared;
+		size_t max_len;
+		size_t i;
+		int rc;
+
+		if (batch > AF_MCTP_BATCH_MAX) {
+			batch = AF_MCTP_BATCH_MAX;
+		}
+
+		max_len = 0;
+		for (prepared = 0; prepared < batch; prepared++) {
+			struct pldm_transport_msg *m = &msgs[sent + prepared];
+			struct mmsghdr *mmsg = &mmsgs[prepared];
+
+			res = pldm_transport_af_mctp_route(af_mctp, m->tid,
+							   m->msg,
+							   &addrs[prepared],
+							   &cookies[prepared]);
+			if (res != PLDM_REQUESTER_SUCCESS) {
+				break;
+			}
+
+			iovs[prepared].iov_base = m->msg;
+			iovs[prepared].iov_len = m->len;
+			memset(mmsg, 0, sizeof(*mmsg));
+			mmsg->msg_hdr.msg_name = &addrs[prepared];
+			mmsg->msg_hdr.msg_namelen = sizeof(addrs[prepared]);
+			mmsg->msg_hdr.msg_iov = &iovs[prepared];
+			mmsg->msg_hdr.msg_iovlen = 1;
+
+			if (m->len > max_len) {
+				max_len = m->len;
+			}
+		}
+
+		if (!prepared) {
+			break;
+		}
+
+		if (max_len > INT_MAX ||
+		    pldm_socket_sndbuf_accomodate(&(af_mctp->socket_send_buf),
+						  (int)max_len)) {
+			rc = 0;
+		} else {
+			rc = sendmmsg(af_mctp->socket, mmsgs, prepared, 0);
+			if (rc < 0) {
+				rc = 0;
+			}
+		}
+
+		/*
+		 * Drop the cookies of the responses that were sent. Keep
+		 * tracking the rest so the caller can try them again.
+		 */
+		for (i = 0; i < prepared; i++) {
+			pldm_socket_mctp_sent(&af_mctp->responder, cookies[i],
+					      i < (size_t)rc);
+		}
+
+		for (i = 0; i < (size_t)rc; i++) {
+			msgs[sent + i].rc = PLDM_REQUESTER_SUCCESS;
+		}
+		sent += rc;
+
+		if ((size_t)rc < batch) {
+			res = PLDM_REQUESTER_SEND_FAIL;
+			break;
+		}
+	}
+
+	return sent ? (int)sent : res;
+}
+
+static int pldm_transport_af_mctp_recv_msgs(struct pldm_transport *t,
+					    struct pldm_transport_msg *msgs,
+					    size_t count)
+{
+	struct pldm_transport_af_mctp *af_mctp = transport_to_af_mctp(t);
+	struct sockaddr_mctp addrs[AF_MCTP_BATCH_MAX];
+	struct mmsghdr mmsgs[AF_MCTP_BATCH_MAX];
+	struct iovec iovs[AF_MCTP_BATCH_MAX];
+	/* Wait for the first message only, as for a single receive */
+	int flags = MSG_TRUNC | MSG_WAITFORONE;
+	size_t received = 0;
+
+	while (received < count) {
+		size_t batch = count - received;
+		size_t i;
+		int rc;
+
+		if (batch > AF_MCTP_BATCH_MAX) {
+			batch = AF_MCTP_BATCH_MAX;
+		}
+
+		memset(mmsgs, 0, batch * sizeof(mmsgs[0]));
+		memset(addrs, 0, batch * sizeof(addrs[0]));
+		for (i = 0; i < batch; i++) {
+			iovs[i].iov_base = msgs[received + i].msg;
+			iovs[i].iov_len = msgs[received + i].len;
+			mmsgs[i].msg_hdr.msg_name = &addrs[i];
+			mmsgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+			mmsgs[i].msg_hdr.msg_iov = &iovs[i];
+			mmsgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		/* MSG_TRUNC yields the full length of each datagram */
+		rc = recvmmsg(af_mctp->socket, mmsgs, batch, flags, NULL);
+		if (rc <= 0) {
+			break;
+		}
+
+		for (i = 0; i < (size_t)rc; i++) {
+			struct pldm_transport_msg *m = &msgs[received + i];
+
+			m->len = mmsgs[i].msg_len;
+			if (m->len < sizeof(struct pldm_msg_hdr)) {
+				m->rc = PLDM_REQUESTER_INVALID_RECV_LEN;
+			} else if (mmsgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+				m->rc = PLDM_REQUESTER_RECV_TRUNCATED;
+			} else {
+				m->rc = pldm_transport_af_mctp_accept(
+					af_mctp, &addrs[i], m->msg, &m->tid);
+			}
+		}
+		received += rc;
+
+		if ((size_t)rc < batch) {
+			break;
+		}
+
+		flags = MSG_TRUNC | MSG_DONTWAIT;
+	}
+
+	return received ? (int)received : PLDM_REQUESTER_RECV_FAIL;
 }
 
 LIBPLDM_ABI_STABLE
@@ -252,10 +425,14 @@ int pldm_transport_af_mctp_init(struct pldm_transport_af_mctp **ctx)
 	af_mctp->transport.name = AF_MCTP_NAME;
 	af_mctp->transport.version = 1;
 	af_mctp->transport.recv = pldm_transport_af_mctp_recv;
+	af_mctp->transport.recv_into = pldm_transport_af_mctp_recv_into;
+	af_mctp->transport.send_msgs = pldm_transport_af_mctp_send_msgs;
+	af_mctp->transport.recv_msgs = pldm_transport_af_mctp_recv_msgs;
 	af_mctp->transport.send = pldm_transport_af_mctp_send;
 	af_mctp->transport.init_pollfd = pldm_transport_af_mctp_init_pollfd;
+	af_mctp->transport.flush = pldm_transport_af_mctp_flush;
 	af_mctp->bound = false;
-	af_mctp->cookie_jar.next = NULL;
+	pldm_socket_mctp_responder_init(&af_mctp->responder);
 	af_mctp->socket = socket(AF_MCTP, SOCK_DGRAM, 0);
 	if (af_mctp->socket == -1) {
 		free(af_mctp);
@@ -263,7 +440,7 @@ int pldm_transport_af_mctp_init(struct pldm_transport_af_mctp **ctx)
 	}
 
 	if (pldm_socket_sndbuf_init(&af_mctp->socket_send_buf,
-				    af_mctp->socket)) {
+				    &af_mctp->transport, af_mctp->socket)) {
 		close(af_mctp->socket);
 		free(af_mctp);
 		return -1;
@@ -279,6 +456,9 @@ void pldm_transport_af_mctp_destroy(struct pldm_transport_af_mctp *ctx)
 	if (!ctx) {
 		return;
 	}
+	pldm_transport_stats_disable(&ctx->transport);
+	pldm_transport_inbox_disable(&ctx->transport);
+	pldm_socket_txq_destroy(&ctx->txq);
 	close(ctx->socket);
 	free(ctx);
 }
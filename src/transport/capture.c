@@ -0,0 +1,652 @@
+/* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#include "compiler.h"
+#include "container-of.h"
+#include "transport.h"
+
+#include <libpldm/base.h>
+#include <libpldm/pldm.h>
+#include <libpldm/transport.h>
+#include <libpldm/transport/capture.h>
+
+#include <endian.h>
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CAPTURE_NAME	 "CAPTURE"
+#define REPLAY_NAME	 "REPLAY"
+#define CAPTURE_BUF_SIZE 65536
+
+struct pldm_transport_capture {
+	struct pldm_transport transport;
+	struct pldm_transport *inner;
+	int fd;
+	/* The first failure to write the capture, after which it's abandoned */
+	int error;
+	uint64_t last_us;
+	size_t used;
+	uint8_t buf[CAPTURE_BUF_SIZE];
+};
+
+#define transport_to_capture(ptr)                                              \
+	container_of(ptr, struct pldm_transport_capture, transport)
+
+static uint64_t pldm_capture_now_us(clockid_t clockid)
+{
+	struct timespec now;
+
+	if (clock_gettime(clockid, &now) < 0) {
+		return 0;
+	}
+
+	return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+}
+
+static int pldm_capture_write(struct pldm_transport_capture *capture,
+			      const void *data, size_t len)
+{
+	const uint8_t *p = data;
+	ssize_t written;
+
+	while (len) {
+		written = write(capture->fd, p, len);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -errno;
+		}
+		p += written;
+		len -= written;
+	}
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_capture_flush(struct pldm_transport_capture *ctx)
+{
+	int rc;
+
+	if (!ctx) {
+		return -EINVAL;
+	}
+
+	if (ctx->error) {
+		return ctx->error;
+	}
+
+	rc = pldm_capture_write(ctx, ctx->buf, ctx->used);
+	ctx->used = 0;
+	if (rc) {
+		ctx->error = rc;
+	}
+
+	return rc;
+}
+
+static void pldm_capture_record(struct pldm_transport_capture *capture,
+				enum pldm_transport_capture_dir dir,
+				pldm_tid_t tid, const void *msg, size_t len)
+{
+	uint8_t *rec;
+	uint64_t now;
+	uint64_t delta;
+	uint32_t le;
+
+	if (capture->error) {
+		return;
+	}
+
+	if (len > UINT32_MAX) {
+		capture->error = -EOVERFLOW;
+		return;
+	}
+
+	if (capture->used + PLDM_TRANSPORT_CAPTURE_RECORD_SIZE + len >
+	    sizeof(capture->buf)) {
+		if (pldm_transport_capture_flush(capture)) {
+			return;
+		}
+	}
+
+	now = pldm_capture_now_us(CLOCK_MONOTONIC);
+	delta = now > capture->last_us ? now - capture->last_us : 0;
+	capture->last_us = now;
+
+	rec = &capture->buf[capture->used];
+	le = htole32(delta > UINT32_MAX ? UINT32_MAX : (uint32_t)delta);
+	memcpy(rec, &le, sizeof(le));
+	le = htole32((uint32_t)len);
+	memcpy(rec + 4, &le, sizeof(le));
+	rec[8] = tid;
+	rec[9] = dir;
+
+	/* Messages too large to buffer are written directly */
+	if (capture->used + PLDM_TRANSPORT_CAPTURE_RECORD_SIZE + len >
+	    sizeof(capture->buf)) {
+		capture->used += PLDM_TRANSPORT_CAPTURE_RECORD_SIZE;
+		if (!pldm_transport_capture_flush(capture)) {
+			capture->error = pldm_capture_write(capture, msg, len);
+		}
+		return;
+	}
+
+	memcpy(rec + PLDM_TRANSPORT_CAPTURE_RECORD_SIZE, msg, len);
+	capture->used += PLDM_TRANSPORT_CAPTURE_RECORD_SIZE + len;
+}
+
+static pldm_requester_rc_t
+pldm_transport_capture_recv(struct pldm_transport *t, pldm_tid_t *tid,
+			    void **pldm_msg, size_t *msg_len)
+{
+	struct pldm_transport_capture *capture = transport_to_capture(t);
+	pldm_requester_rc_t rc;
+
+	rc = pldm_transport_recv_msg(capture->inner, tid, pldm_msg, msg_len);
+	if (rc == PLDM_REQUESTER_SUCCESS) {
+		pldm_capture_record(capture, PLDM_TRANSPORT_CAPTURE_RX, *tid,
+				    *pldm_msg, *msg_len);
+	}
+
+	return rc;
+}
+
+static pldm_requester_rc_t
+pldm_transport_capture_recv_into(struct pldm_transport *t, pldm_tid_t *tid,
+				 void *pldm_msg, size_t *msg_len)
+{
+	struct pldm_transport_capture *capture = transport_to_capture(t);
+	pldm_requester_rc_t rc;
+
+	rc = pldm_transport_recv_msg_into(capture->inner, tid, pldm_msg,
+					  msg_len);
+	if (rc == PLDM_REQUESTER_SUCCESS) {
+		pldm_capture_record(capture, PLDM_TRANSPORT_CAPTURE_RX, *tid,
+				    pldm_msg, *msg_len);
+	}
+
+	return rc;
+}
+
+static int pldm_transport_capture_recv_msgs(struct pldm_transport *t,
+					    struct pldm_transport_msg *msgs,
+					    size_t count)
+{
+	struct pldm_transport_capture *capture = transport_to_capture(t);
+	int received;
+	int i;
+
+	received = pldm_transport_recv_msgs(capture->inner, msgs, count);
+	for (i = 0; i < received; i++) {
+		if (msgs[i].rc == PLDM_REQUESTER_SUCCESS) {
+			pldm_capture_record(capture, PLDM_TRANSPORT_CAPTURE_RX,
+					    msgs[i].tid, msgs[i].msg,
+					    msgs[i].len);
+		}
+	}
+
+	return received;
+}
+
+static pldm_requester_rc_t
+pldm_transport_capture_send(struct pldm_transport *t, pldm_tid_t tid,
+			    const void *pldm_msg, size_t msg_len)
+{
+	struct pldm_transport_capture *capture = transport_to_capture(t);
+	pldm_requester_rc_t rc;
+
+	rc = pldm_transport_send_msg(capture->inner, tid, pldm_msg, msg_len);
+	if (rc == PLDM_REQUESTER_SUCCESS) {
+		pldm_capture_record(capture, PLDM_TRANSPORT_CAPTURE_TX, tid,
+				    pldm_msg, msg_len);
+	}
+
+	return rc;
+}
+
+static int pldm_transport_capture_send_msgs(struct pldm_transport *t,
+					    struct pldm_transport_msg *msgs,
+					    size_t count)
+{
+	struct pldm_transport_capture *capture = transport_to_capture(t);
+	int sent;
+	int i;
+
+	sent = pldm_transport_send_msgs(capture->inner, msgs, count);
+	for (i = 0; i < sent; i++) {
+		pldm_capture_record(capture, PLDM_TRANSPORT_CAPTURE_TX,
+				    msgs[i].tid, msgs[i].msg, msgs[i].len);
+	}
+
+	return sent;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_capture_init_pollfd(struct pldm_transport *t,
+				       struct pollfd *pollfd)
+{
+	struct pldm_transport_capture *capture = transport_to_capture(t);
+
+	return capture->inner->init_pollfd(capture->inner, pollfd);
+}
+
+LIBPLDM_ABI_TESTING
+struct pldm_transport *
+pldm_transport_capture_core(struct pldm_transport_capture *ctx)
+{
+	return &ctx->transport;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_capture_init(struct pldm_transport_capture **ctx,
+				struct pldm_transport *inner, int fd)
+{
+	struct pldm_transport_capture *capture;
+	uint8_t hdr[PLDM_TRANSPORT_CAPTURE_HEADER_SIZE] = { 0 };
+	uint64_t start;
+	uint32_t magic;
+	uint16_t version;
+	int rc;
+
+	if (!ctx || *ctx || !inner || fd < 0) {
+		return -EINVAL;
+	}
+
+	capture = calloc(1, sizeof(*capture));
+	if (!capture) {
+		return -ENOMEM;
+	}
+
+	capture->transport.name = CAPTURE_NAME;
+	capture->transport.version = 1;
+	capture->transport.recv = pldm_transport_capture_recv;
+	capture->transport.recv_into = pldm_transport_capture_recv_into;
+	capture->transport.send = pldm_transport_capture_send;
+	capture->transport.send_msgs = pldm_transport_capture_send_msgs;
+	capture->transport.recv_msgs = pldm_transport_capture_recv_msgs;
+	/* Without polling, the core assumes the transport is always ready */
+	if (inner->init_pollfd) {
+		capture->transport.init_pollfd =
+			pldm_transport_capture_init_pollfd;
+	}
+	capture->inner = inner;
+	capture->fd = fd;
+
+	magic = htole32(PLDM_TRANSPORT_CAPTURE_MAGIC);
+	version = htole16(PLDM_TRANSPORT_CAPTURE_VERSION);
+	start = htole64(pldm_capture_now_us(CLOCK_REALTIME));
+	memcpy(&hdr[0], &magic, sizeof(magic));
+	memcpy(&hdr[4], &version, sizeof(version));
+	memcpy(&hdr[8], &start, sizeof(start));
+
+	rc = pldm_capture_write(capture, hdr, sizeof(hdr));
+	if (rc) {
+		free(capture);
+		return rc;
+	}
+
+	capture->last_us = pldm_capture_now_us(CLOCK_MONOTONIC);
+	*ctx = capture;
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+void pldm_transport_capture_destroy(struct pldm_transport_capture *ctx)
+{
+	if (!ctx) {
+		return;
+	}
+
+	pldm_transport_capture_flush(ctx);
+	pldm_transport_stats_disable(&ctx->transport);
+	pldm_transport_inbox_disable(&ctx->transport);
+	free(ctx);
+}
+
+struct pldm_replay_record {
+	const uint8_t *msg;
+	uint32_t len;
+	uint32_t delta_us;
+	pldm_tid_t tid;
+	uint8_t dir;
+	/* When the record was received or sent during the replay */
+	uint64_t consumed_us;
+};
+
+struct pldm_transport_replay {
+	struct pldm_transport transport;
+	struct pldm_replay_record *records;
+	size_t count;
+	unsigned int speed;
+	uint64_t start_us;
+	/* The next captured received message to deliver, and sent message to
+	 * expect. Equal to count once there are no more */
+	size_t next_rx;
+	size_t next_tx;
+	int timerfd;
+	struct pldm_transport_replay_progress progress;
+	/* The instance IDs sent in place of those of captured requests, plus
+	 * one, or zero if not yet sent */
+	uint8_t iids[PLDM_MAX_TIDS][PLDM_INSTANCE_MAX + 1];
+};
+
+#define transport_to_replay(ptr)                                               \
+	container_of(ptr, struct pldm_transport_replay, transport)
+
+static size_t pldm_replay_find(struct pldm_transport_replay *replay, size_t i,
+			       enum pldm_transport_capture_dir dir)
+{
+	while (i < replay->count && replay->records[i].dir != dir) {
+		i++;
+	}
+
+	return i;
+}
+
+/*
+ * Find when the next captured received message is due, returning false if it
+ * must first wait for captured sent messages, or there are no more
+ */
+static bool pldm_replay_due(struct pldm_transport_replay *replay,
+			    uint64_t *due_us)
+{
+	size_t i = replay->next_rx;
+	uint64_t base;
+
+	if (i >= replay->count || replay->next_tx < i) {
+		return false;
+	}
+
+	if (replay->speed == PLDM_TRANSPORT_REPLAY_FLAT_OUT) {
+		*due_us = 0;
+		return true;
+	}
+
+	base = i ? replay->records[i - 1].consumed_us : replay->start_us;
+	*due_us = base + replay->records[i].delta_us / replay->speed;
+
+	return true;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_replay_init_pollfd(struct pldm_transport *t,
+				      struct pollfd *pollfd)
+{
+	struct pldm_transport_replay *replay = transport_to_replay(t);
+	struct itimerspec timer = { 0 };
+	uint64_t now;
+	uint64_t due;
+	int flags = 0;
+
+	if (pldm_replay_due(replay, &due)) {
+		now = pldm_capture_now_us(CLOCK_MONOTONIC);
+		if (due > now) {
+			timer.it_value.tv_sec = (time_t)(due / 1000000);
+			timer.it_value.tv_nsec = (long)(due % 1000000) * 1000;
+			flags = TFD_TIMER_ABSTIME;
+		} else {
+			/* Expire the timer immediately so it appears ready */
+			timer.it_value.tv_nsec = 1;
+		}
+	}
+
+	/* Otherwise the timer is disarmed, as no message can arrive */
+	if (timerfd_settime(replay->timerfd, flags, &timer, NULL) < 0) {
+		return PLDM_REQUESTER_POLL_FAIL;
+	}
+
+	pollfd->fd = replay->timerfd;
+	pollfd->events = POLLIN;
+
+	return 0;
+}
+
+static pldm_requester_rc_t
+pldm_transport_replay_recv(struct pldm_transport *t, pldm_tid_t *tid,
+			   void **pldm_msg, size_t *msg_len)
+{
+	struct pldm_transport_replay *replay = transport_to_replay(t);
+	struct pldm_replay_record *rec;
+	uint8_t *msg;
+	uint64_t now;
+	uint64_t due;
+	uint8_t iid;
+
+	if (!pldm_replay_due(replay, &due)) {
+		return PLDM_REQUESTER_RECV_FAIL;
+	}
+
+	now = pldm_capture_now_us(CLOCK_MONOTONIC);
+	if (due > now) {
+		return PLDM_REQUESTER_RECV_FAIL;
+	}
+
+	rec = &replay->records[replay->next_rx];
+	msg = malloc(rec->len);
+	if (!msg) {
+		return PLDM_REQUESTER_RECV_FAIL;
+	}
+
+	memcpy(msg, rec->msg, rec->len);
+
+	/* Respond to the instance ID of the request that was actually sent */
+	if (!(msg[0] & 0x80)) {
+		iid = replay->iids[rec->tid][msg[0] & PLDM_INSTANCE_MAX];
+		if (iid) {
+			msg[0] = (msg[0] & ~PLDM_INSTANCE_MAX) | (iid - 1);
+		}
+	}
+
+	rec->consumed_us = now;
+	replay->next_rx = pldm_replay_find(replay, replay->next_rx + 1,
+					   PLDM_TRANSPORT_CAPTURE_RX);
+	replay->progress.received++;
+
+	*tid = rec->tid;
+	*pldm_msg = msg;
+	*msg_len = rec->len;
+
+	return PLDM_REQUESTER_SUCCESS;
+}
+
+static pldm_requester_rc_t
+pldm_transport_replay_send(struct pldm_transport *t, pldm_tid_t tid,
+			   const void *pldm_msg, size_t msg_len)
+{
+	struct pldm_transport_replay *replay = transport_to_replay(t);
+	const uint8_t *msg = pldm_msg;
+	struct pldm_replay_record *rec;
+	bool match;
+
+	if (replay->next_tx >= replay->count) {
+		replay->progress.unexpected++;
+		return PLDM_REQUESTER_SEND_FAIL;
+	}
+
+	rec = &replay->records[replay->next_tx];
+
+	/* Instance IDs are allocated afresh, so may differ from the capture */
+	match = rec->tid == tid && rec->len == msg_len &&
+		!((rec->msg[0] ^ msg[0]) & ~PLDM_INSTANCE_MAX) &&
+		!memcmp(rec->msg + 1, msg + 1, msg_len - 1);
+	if (!match) {
+		replay->progress.mismatched++;
+	}
+
+	if ((rec->msg[0] & 0x80) && (msg[0] & 0x80) && rec->tid == tid) {
+		replay->iids[tid][rec->msg[0] & PLDM_INSTANCE_MAX] =
+			(msg[0] & PLDM_INSTANCE_MAX) + 1;
+	}
+
+	rec->consumed_us = pldm_capture_now_us(CLOCK_MONOTONIC);
+	replay->next_tx = pldm_replay_find(replay, replay->next_tx + 1,
+					   PLDM_TRANSPORT_CAPTURE_TX);
+	replay->progress.sent++;
+
+	return PLDM_REQUESTER_SUCCESS;
+}
+
+/* Walk the records of a capture, storing them if records is not NULL */
+static int pldm_replay_parse(const uint8_t *capture, size_t len,
+			     struct pldm_replay_record *records, size_t *count)
+{
+	const uint8_t *end = capture + len;
+	const uint8_t *p = capture;
+	uint32_t magic;
+	uint16_t version;
+	uint32_t delta;
+	uint32_t mlen;
+	size_t n = 0;
+
+	if (len < PLDM_TRANSPORT_CAPTURE_HEADER_SIZE) {
+		return -EPROTO;
+	}
+
+	memcpy(&magic, &p[0], sizeof(magic));
+	memcpy(&version, &p[4], sizeof(version));
+	if (le32toh(magic) != PLDM_TRANSPORT_CAPTURE_MAGIC ||
+	    le16toh(version) != PLDM_TRANSPORT_CAPTURE_VERSION) {
+		return -EPROTO;
+	}
+	p += PLDM_TRANSPORT_CAPTURE_HEADER_SIZE;
+
+	while (p < end) {
+		if ((size_t)(end - p) < PLDM_TRANSPORT_CAPTURE_RECORD_SIZE) {
+			return -EPROTO;
+		}
+
+		memcpy(&delta, &p[0], sizeof(delta));
+		memcpy(&mlen, &p[4], sizeof(mlen));
+		mlen = le32toh(mlen);
+		if (p[9] > PLDM_TRANSPORT_CAPTURE_RX ||
+		    mlen < sizeof(struct pldm_msg_hdr) ||
+		    mlen > (size_t)(end - p) -
+				   PLDM_TRANSPORT_CAPTURE_RECORD_SIZE) {
+			return -EPROTO;
+		}
+
+		if (records) {
+			records[n].msg = p + PLDM_TRANSPORT_CAPTURE_RECORD_SIZE;
+			records[n].len = mlen;
+			records[n].delta_us = le32toh(delta);
+			records[n].tid = p[8];
+			records[n].dir = p[9];
+		}
+
+		p += PLDM_TRANSPORT_CAPTURE_RECORD_SIZE + mlen;
+		n++;
+	}
+
+	*count = n;
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+struct pldm_transport *
+pldm_transport_replay_core(struct pldm_transport_replay *ctx)
+{
+	return &ctx->transport;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_replay_init(struct pldm_transport_replay **ctx,
+			       const void *capture, size_t len,
+			       unsigned int speed)
+{
+	struct pldm_transport_replay *replay;
+	size_t count;
+	int rc;
+
+	if (!ctx || *ctx || !capture) {
+		return -EINVAL;
+	}
+
+	rc = pldm_replay_parse(capture, len, NULL, &count);
+	if (rc) {
+		return rc;
+	}
+
+	replay = calloc(1, sizeof(*replay));
+	if (!replay) {
+		return -ENOMEM;
+	}
+
+	if (count) {
+		replay->records = calloc(count, sizeof(*replay->records));
+		if (!replay->records) {
+			rc = -ENOMEM;
+			goto cleanup_replay;
+		}
+	}
+
+	rc = pldm_replay_parse(capture, len, replay->records, &count);
+	if (rc) {
+		goto cleanup_records;
+	}
+
+	replay->timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+	if (replay->timerfd < 0) {
+		rc = -errno;
+		goto cleanup_records;
+	}
+
+	replay->transport.name = REPLAY_NAME;
+	replay->transport.version = 1;
+	replay->transport.recv = pldm_transport_replay_recv;
+	replay->transport.send = pldm_transport_replay_send;
+	replay->transport.init_pollfd = pldm_transport_replay_init_pollfd;
+	replay->count = count;
+	replay->speed = speed;
+	replay->progress.records = count;
+	replay->next_rx = pldm_replay_find(replay, 0, PLDM_TRANSPORT_CAPTURE_RX);
+	replay->next_tx = pldm_replay_find(replay, 0, PLDM_TRANSPORT_CAPTURE_TX);
+	replay->start_us = pldm_capture_now_us(CLOCK_MONOTONIC);
+
+	*ctx = replay;
+
+	return 0;
+
+cleanup_records:
+	free(replay->records);
+cleanup_replay:
+	free(replay);
+	return rc;
+}
+
+LIBPLDM_ABI_TESTING
+void pldm_transport_replay_destroy(struct pldm_transport_replay *ctx)
+{
+	if (!ctx) {
+		return;
+	}
+
+	pldm_transport_stats_disable(&ctx->transport);
+	pldm_transport_inbox_disable(&ctx->transport);
+	close(ctx->timerfd);
+	free(ctx->records);
+	free(ctx);
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_replay_get_progress(
+	struct pldm_transport_replay *ctx,
+	struct pldm_transport_replay_progress *progress)
+{
+	if (!ctx || !progress) {
+		return -EINVAL;
+	}
+
+	*progress = ctx->progress;
+
+	return ctx->progress.received + ctx->progress.sent == ctx->count;
+}
@@ -0,0 +1,619 @@
+/* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#include "container-of.h"
+#include "transport.h"
+
+#include <libpldm/base.h>
+#include <libpldm/event-loop.h>
+#include <libpldm/pldm.h>
+#include <libpldm/requester.h>
+#include <libpldm/transport.h>
+
+#include <errno.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+/* The PLDM type field of the message header is 6 bits wide */
+#define PLDM_EVENT_LOOP_TYPES	   64
+#define PLDM_EVENT_LOOP_MAX_EVENTS 16
+/* Large enough for any MCTP message, as for the capture transport */
+#define PLDM_EVENT_LOOP_RX_SIZE	   65536
+
+enum pldm_event_loop_source_kind {
+	PLDM_EVENT_LOOP_SOURCE_TRANSPORT,
+	PLDM_EVENT_LOOP_SOURCE_TIMER,
+};
+
+struct pldm_event_loop_source {
+	enum pldm_event_loop_source_kind kind;
+	int fd;
+	bool removed;
+	struct pldm_event_loop_source *next;
+	struct pldm_event_loop_source *next_removed;
+};
+
+struct pldm_event_loop_transport {
+	struct pldm_event_loop_source source;
+	struct pldm_transport *transport;
+	struct pldm_requester *requester;
+	/* The epoll events of interest */
+	uint32_t events;
+};
+
+struct pldm_event_loop_timer {
+	struct pldm_event_loop_source source;
+	pldm_event_loop_timer_cb cb;
+	void *data;
+};
+
+struct pldm_event_loop_handler {
+	pldm_event_loop_msg_handler handler;
+	void *data;
+};
+
+struct pldm_event_loop {
+	int epoll;
+	bool stopped;
+	bool dispatching;
+	struct pldm_event_loop_source *sources;
+	/* Sources removed while dispatching, freed once dispatch completes */
+	struct pldm_event_loop_source *removed;
+	struct pldm_event_loop_handler handlers[PLDM_EVENT_LOOP_TYPES];
+	pldm_event_loop_hangup_cb hangup;
+	void *hangup_data;
+	/* Messages are received here, and are valid during their dispatch */
+	uint8_t rx[PLDM_EVENT_LOOP_RX_SIZE];
+};
+
+#define source_to_transport(ptr)                                               \
+	(container_of(ptr, struct pldm_event_loop_transport, source))
+
+#define source_to_timer(ptr)                                                   \
+	(container_of(ptr, struct pldm_event_loop_timer, source))
+
+static void event_loop_free_source(struct pldm_event_loop_source *source)
+{
+	if (source->kind == PLDM_EVENT_LOOP_SOURCE_TIMER) {
+		close(source->fd);
+		free(source_to_timer(source));
+	} else {
+		free(source_to_transport(source));
+	}
+}
+
+static void event_loop_remove_source(struct pldm_event_loop *ctx,
+				     struct pldm_event_loop_source *source)
+{
+	struct pldm_event_loop_source **link;
+
+	for (link = &ctx->sources; *link; link = &(*link)->next) {
+		if (*link == source) {
+			*link = source->next;
+			break;
+		}
+	}
+
+	epoll_ctl(ctx->epoll, EPOLL_CTL_DEL, source->fd, NULL);
+	source->removed = true;
+
+	/* Events for the source may still be pending dispatch */
+	if (ctx->dispatching) {
+		source->next_removed = ctx->removed;
+		ctx->removed = source;
+	} else {
+		event_loop_free_source(source);
+	}
+}
+
+static void event_loop_reap(struct pldm_event_loop *ctx)
+{
+	struct pldm_event_loop_source *source;
+
+	while ((source = ctx->removed)) {
+		ctx->removed = source->next_removed;
+		event_loop_free_source(source);
+	}
+}
+
+static int event_loop_add_source(struct pldm_event_loop *ctx,
+				 struct pldm_event_loop_source *source,
+				 uint32_t events)
+{
+	struct epoll_event event = { 0 };
+
+	event.events = events;
+	event.data.ptr = source;
+	if (epoll_ctl(ctx->epoll, EPOLL_CTL_ADD, source->fd, &event) < 0) {
+		return -errno;
+	}
+
+	source->next = ctx->sources;
+	ctx->sources = source;
+
+	return 0;
+}
+
+static void ms_to_timespec(uint32_t ms, struct timespec *ts)
+{
+	ts->tv_sec = ms / 1000;
+	ts->tv_nsec = (long)(ms % 1000) * 1000000;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_event_loop_init(struct pldm_event_loop **ctx)
+{
+	struct pldm_event_loop *loop;
+	int rc;
+
+	if (!ctx || *ctx) {
+		return -EINVAL;
+	}
+
+	loop = calloc(1, sizeof(*loop));
+	if (!loop) {
+		return -ENOMEM;
+	}
+
+	loop->epoll = epoll_create1(EPOLL_CLOEXEC);
+	if (loop->epoll < 0) {
+		rc = -errno;
+		free(loop);
+		return rc;
+	}
+
+	*ctx = loop;
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+void pldm_event_loop_destroy(struct pldm_event_loop *ctx)
+{
+	struct pldm_event_loop_source *source;
+
+	if (!ctx) {
+		return;
+	}
+
+	while ((source = ctx->sources)) {
+		ctx->sources = source->next;
+		event_loop_free_source(source);
+	}
+	event_loop_reap(ctx);
+
+	close(ctx->epoll);
+	free(ctx);
+}
+
+static uint32_t event_loop_poll_events(short events)
+{
+	uint32_t epoll_events = 0;
+
+	if (events & POLLIN) {
+		epoll_events |= EPOLLIN;
+	}
+	if (events & POLLOUT) {
+		epoll_events |= EPOLLOUT;
+	}
+
+	return epoll_events;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_event_loop_add_transport(struct pldm_event_loop *ctx,
+				  struct pldm_transport *transport,
+				  struct pldm_requester *requester)
+{
+	struct pldm_event_loop_transport *reg;
+	struct pldm_event_loop_source *source;
+	struct pollfd pollfd = { 0 };
+	uint32_t events;
+	int rc;
+
+	if (!ctx || !transport) {
+		return -EINVAL;
+	}
+
+	for (source = ctx->sources; source; source = source->next) {
+		if (source->kind == PLDM_EVENT_LOOP_SOURCE_TRANSPORT &&
+		    source_to_transport(source)->transport == transport) {
+			return -EEXIST;
+		}
+	}
+
+	if (!transport->init_pollfd) {
+		return -ENOTSUP;
+	}
+
+	if (transport->init_pollfd(transport, &pollfd) < 0) {
+		return -ENOTSUP;
+	}
+
+	reg = calloc(1, sizeof(*reg));
+	if (!reg) {
+		return -ENOMEM;
+	}
+
+	reg->source.kind = PLDM_EVENT_LOOP_SOURCE_TRANSPORT;
+	reg->source.fd = pollfd.fd;
+	reg->transport = transport;
+	reg->requester = requester;
+
+	events = event_loop_poll_events(pollfd.events);
+	reg->events = events;
+
+	rc = event_loop_add_source(ctx, &reg->source, events);
+	if (rc) {
+		free(reg);
+		return rc;
+	}
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_event_loop_remove_transport(struct pldm_event_loop *ctx,
+				     struct pldm_transport *transport)
+{
+	struct pldm_event_loop_source *source;
+
+	if (!ctx) {
+		return -EINVAL;
+	}
+
+	for (source = ctx->sources; source; source = source->next) {
+		if (source->kind == PLDM_EVENT_LOOP_SOURCE_TRANSPORT &&
+		    source_to_transport(source)->transport == transport) {
+			event_loop_remove_source(ctx, source);
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_event_loop_set_handler(struct pldm_event_loop *ctx, uint8_t type,
+				pldm_event_loop_msg_handler handler, void *data)
+{
+	if (!ctx || type >= PLDM_EVENT_LOOP_TYPES) {
+		return -EINVAL;
+	}
+
+	ctx->handlers[type].handler = handler;
+	ctx->handlers[type].data = handler ? data : NULL;
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_event_loop_set_hangup_handler(struct pldm_event_loop *ctx,
+				       pldm_event_loop_hangup_cb cb,
+				       void *data)
+{
+	if (!ctx) {
+		return -EINVAL;
+	}
+
+	ctx->hangup = cb;
+	ctx->hangup_data = cb ? data : NULL;
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_event_loop_add_timer(struct pldm_event_loop *ctx, uint32_t initial_ms,
+			      uint32_t interval_ms, pldm_event_loop_timer_cb cb,
+			      void *data, struct pldm_event_loop_timer **timer)
+{
+	struct pldm_event_loop_timer *t;
+	struct itimerspec spec = { 0 };
+	int rc;
+
+	if (!ctx || !initial_ms || !cb || !timer) {
+		return -EINVAL;
+	}
+
+	t = calloc(1, sizeof(*t));
+	if (!t) {
+		return -ENOMEM;
+	}
+
+	t->source.kind = PLDM_EVENT_LOOP_SOURCE_TIMER;
+	t->cb = cb;
+	t->data = data;
+
+	t->source.fd = timerfd_create(CLOCK_MONOTONIC,
+				      TFD_NONBLOCK | TFD_CLOEXEC);
+	if (t->source.fd < 0) {
+		rc = -errno;
+		goto cleanup_timer;
+	}
+
+	ms_to_timespec(initial_ms, &spec.it_value);
+	ms_to_timespec(interval_ms, &spec.it_interval);
+	if (timerfd_settime(t->source.fd, 0, &spec, NULL) < 0) {
+		rc = -errno;
+		goto cleanup_fd;
+	}
+
+	rc = event_loop_add_source(ctx, &t->source, EPOLLIN);
+	if (rc) {
+		goto cleanup_fd;
+	}
+
+	*timer = t;
+
+	return 0;
+
+cleanup_fd:
+	close(t->source.fd);
+cleanup_timer:
+	free(t);
+
+	return rc;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_event_loop_remove_timer(struct pldm_event_loop *ctx,
+				 struct pldm_event_loop_timer *timer)
+{
+	if (!ctx || !timer || timer->source.removed) {
+		return -EINVAL;
+	}
+
+	event_loop_remove_source(ctx, &timer->source);
+
+	return 0;
+}
+
+/*
+ * Follow the transport's interest in writability, which it has while its
+ * outbound queue holds messages
+ */
+static void event_loop_update_interest(struct pldm_event_loop *ctx,
+				       struct pldm_event_loop_transport *reg)
+{
+	struct epoll_event event = { 0 };
+	struct pollfd pollfd = { 0 };
+	uint32_t events;
+
+	if (!reg->transport->flush) {
+		return;
+	}
+
+	if (reg->transport->init_pollfd(reg->transport, &pollfd) < 0) {
+		return;
+	}
+
+	events = event_loop_poll_events(pollfd.events);
+	if (events == reg->events) {
+		return;
+	}
+
+	event.events = events;
+	event.data.ptr = &reg->source;
+	if (!epoll_ctl(ctx->epoll, EPOLL_CTL_MOD, reg->source.fd, &event)) {
+		reg->events = events;
+	}
+}
+
+/*
+ * Reading a socket's pending error clears it, and the socket remains usable.
+ * An error on any other fd persists.
+ */
+static bool event_loop_clear_error(int fd)
+{
+	socklen_t len = sizeof(int);
+	int err;
+
+	return !getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+}
+
+static void event_loop_hangup(struct pldm_event_loop *ctx,
+			      struct pldm_event_loop_transport *reg)
+{
+	/* Level-triggered, the fd would report the condition on every wait */
+	event_loop_remove_source(ctx, &reg->source);
+
+	if (ctx->hangup) {
+		ctx->hangup(ctx->hangup_data, reg->transport);
+	}
+}
+
+static int event_loop_dispatch_transport(struct pldm_event_loop *ctx,
+					 struct pldm_event_loop_transport *reg,
+					 uint32_t events)
+{
+	struct pldm_event_loop_handler *handler;
+	const struct pldm_msg_hdr *hdr;
+	pldm_requester_rc_t rc;
+	size_t msg_len;
+	pldm_tid_t tid;
+
+	if (events & EPOLLOUT) {
+		pldm_transport_flush(reg->transport);
+	}
+
+	if ((events & EPOLLERR) && !event_loop_clear_error(reg->source.fd)) {
+		event_loop_hangup(ctx, reg);
+		return 0;
+	}
+
+	/* Messages received before a hang-up are drained before removal */
+	if (!(events & EPOLLIN)) {
+		if (events & EPOLLHUP) {
+			event_loop_hangup(ctx, reg);
+		}
+		return 0;
+	}
+
+	msg_len = sizeof(ctx->rx);
+	rc = pldm_transport_recv_msg_into(reg->transport, &tid, ctx->rx,
+					  &msg_len);
+	if (rc != PLDM_REQUESTER_SUCCESS) {
+		/* Otherwise the remaining data is reported indefinitely */
+		if (events & EPOLLHUP) {
+			event_loop_hangup(ctx, reg);
+		}
+		return 0;
+	}
+
+	if (reg->requester && !pldm_requester_handle_msg(reg->requester, tid,
+							 ctx->rx, msg_len)) {
+		return 1;
+	}
+
+	hdr = (const struct pldm_msg_hdr *)ctx->rx;
+	handler = &ctx->handlers[hdr->type];
+	if (handler->handler) {
+		handler->handler(handler->data, reg->transport, tid, ctx->rx,
+				 msg_len);
+	}
+
+	return 1;
+}
+
+static int event_loop_dispatch_timer(struct pldm_event_loop_timer *timer)
+{
+	uint64_t expirations;
+
+	if (read(timer->source.fd, &expirations, sizeof(expirations)) !=
+	    sizeof(expirations)) {
+		return 0;
+	}
+
+	timer->cb(timer->data, timer);
+
+	return 1;
+}
+
+static int event_loop_wait_time(struct pldm_event_loop *ctx, int timeout_ms)
+{
+	struct pldm_event_loop_source *source;
+	struct pldm_requester *requester;
+	int wait = timeout_ms;
+	int next;
+
+	for (source = ctx->sources; source; source = source->next) {
+		if (source->kind != PLDM_EVENT_LOOP_SOURCE_TRANSPORT) {
+			continue;
+		}
+
+		requester = source_to_transport(source)->requester;
+		if (!requester) {
+			continue;
+		}
+
+		next = pldm_requester_next_timeout(requester);
+		if (next >= 0 && (wait < 0 || next < wait)) {
+			wait = next;
+		}
+	}
+
+	return wait;
+}
+
+static void event_loop_expire(struct pldm_event_loop *ctx)
+{
+	struct pldm_event_loop_source *source;
+	struct pldm_requester *requester;
+
+	/* Callbacks may remove sources, whose links stay valid until reaped */
+	for (source = ctx->sources; source; source = source->next) {
+		if (source->removed ||
+		    source->kind != PLDM_EVENT_LOOP_SOURCE_TRANSPORT) {
+			continue;
+		}
+
+		requester = source_to_transport(source)->requester;
+		if (requester) {
+			pldm_requester_expire(requester);
+		}
+	}
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_event_loop_run_once(struct pldm_event_loop *ctx, int timeout_ms)
+{
+	struct epoll_event events[PLDM_EVENT_LOOP_MAX_EVENTS];
+	struct pldm_event_loop_source *source;
+	int dispatched = 0;
+	int n;
+	int i;
+
+	if (!ctx) {
+		return -EINVAL;
+	}
+
+	for (source = ctx->sources; source; source = source->next) {
+		if (source->kind == PLDM_EVENT_LOOP_SOURCE_TRANSPORT) {
+			event_loop_update_interest(ctx,
+						   source_to_transport(source));
+		}
+	}
+
+	n = epoll_wait(ctx->epoll, events, PLDM_EVENT_LOOP_MAX_EVENTS,
+		       event_loop_wait_time(ctx, timeout_ms));
+	if (n < 0) {
+		return errno == EINTR ? 0 : -errno;
+	}
+
+	ctx->dispatching = true;
+
+	for (i = 0; i < n; i++) {
+		source = events[i].data.ptr;
+		if (source->removed) {
+			continue;
+		}
+
+		if (source->kind == PLDM_EVENT_LOOP_SOURCE_TIMER) {
+			dispatched += event_loop_dispatch_timer(
+				source_to_timer(source));
+		} else {
+			dispatched += event_loop_dispatch_transport(
+				ctx, source_to_transport(source),
+				events[i].events);
+		}
+	}
+
+	event_loop_expire(ctx);
+
+	ctx->dispatching = false;
+	event_loop_reap(ctx);
+
+	return dispatched;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_event_loop_run(struct pldm_event_loop *ctx)
+{
+	int rc;
+
+	if (!ctx) {
+		return -EINVAL;
+	}
+
+	ctx->stopped = false;
+	while (!ctx->stopped) {
+		rc = pldm_event_loop_run_once(ctx, -1);
+		if (rc < 0) {
+			return rc;
+		}
+	}
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+void pldm_event_loop_stop(struct pldm_event_loop *ctx)
+{
+	if (ctx) {
+		ctx->stopped = true;
+	}
+}
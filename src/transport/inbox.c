@@ -0,0 +1,166 @@
+/* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#include "compiler.h"
+#include "inbox.h"
+#include "transport.h"
+
+#include <libpldm/base.h>
+#include <libpldm/transport.h>
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+static struct pldm_transport_inbox_queue *
+pldm_transport_inbox_find(struct pldm_transport_inbox *inbox, pldm_tid_t tid,
+			  uint8_t type)
+{
+	if (!inbox->tids[tid] || type >= PLDM_TRANSPORT_INBOX_TYPES) {
+		return NULL;
+	}
+
+	return &inbox->tids[tid]->queues[type];
+}
+
+bool pldm_transport_inbox_put(struct pldm_transport *transport, pldm_tid_t tid,
+			      void *msg, size_t len)
+{
+	struct pldm_transport_inbox *inbox = transport->inbox;
+	const struct pldm_msg_hdr *hdr = msg;
+	struct pldm_transport_inbox_queue *queue;
+	struct pldm_transport_inbox_msg *slot;
+
+	if (!inbox || len < sizeof(*hdr)) {
+		return false;
+	}
+
+	if (!inbox->tids[tid]) {
+		inbox->tids[tid] = calloc(1, sizeof(*inbox->tids[tid]));
+		if (!inbox->tids[tid]) {
+			return false;
+		}
+	}
+
+	queue = &inbox->tids[tid]->queues[hdr->type];
+	if (!queue->ring) {
+		queue->ring = calloc(inbox->depth, sizeof(*queue->ring));
+		if (!queue->ring) {
+			return false;
+		}
+	}
+
+	/* Keep what's already queued, as it's been waiting longest */
+	if (queue->count == inbox->depth) {
+		return false;
+	}
+
+	slot = &queue->ring[(queue->head + queue->count) % inbox->depth];
+	slot->msg = msg;
+	slot->len = len;
+	queue->count++;
+
+	return true;
+}
+
+static void pldm_transport_inbox_release(struct pldm_transport_inbox *inbox)
+{
+	struct pldm_transport_inbox_queue *queue;
+	size_t i;
+	size_t j;
+
+	for (i = 0; i < PLDM_MAX_TIDS; i++) {
+		if (!inbox->tids[i]) {
+			continue;
+		}
+
+		for (j = 0; j < PLDM_TRANSPORT_INBOX_TYPES; j++) {
+			queue = &inbox->tids[i]->queues[j];
+			while (queue->count) {
+				free(queue->ring[queue->head].msg);
+				queue->head = (queue->head + 1) % inbox->depth;
+				queue->count--;
+			}
+			free(queue->ring);
+		}
+
+		free(inbox->tids[i]);
+	}
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_inbox_enable(struct pldm_transport *transport, size_t depth)
+{
+	if (!transport || !depth) {
+		return -EINVAL;
+	}
+
+	if (transport->inbox) {
+		return 0;
+	}
+
+	transport->inbox = calloc(1, sizeof(*transport->inbox));
+	if (!transport->inbox) {
+		return -ENOMEM;
+	}
+
+	transport->inbox->depth = depth;
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+void pldm_transport_inbox_disable(struct pldm_transport *transport)
+{
+	if (!transport || !transport->inbox) {
+		return;
+	}
+
+	pldm_transport_inbox_release(transport->inbox);
+	free(transport->inbox);
+	transport->inbox = NULL;
+}
+
+LIBPLDM_ABI_TESTING
+pldm_requester_rc_t pldm_transport_inbox_recv(struct pldm_transport *transport,
+					      pldm_tid_t tid, uint8_t type,
+					      void **pldm_msg, size_t *msg_len)
+{
+	struct pldm_transport_inbox_queue *queue;
+	struct pldm_transport_inbox_msg *slot;
+
+	if (!transport || !pldm_msg || !msg_len) {
+		return PLDM_REQUESTER_INVALID_SETUP;
+	}
+
+	if (!transport->inbox) {
+		return PLDM_REQUESTER_RECV_FAIL;
+	}
+
+	queue = pldm_transport_inbox_find(transport->inbox, tid, type);
+	if (!queue || !queue->count) {
+		return PLDM_REQUESTER_RECV_FAIL;
+	}
+
+	slot = &queue->ring[queue->head];
+	*pldm_msg = slot->msg;
+	*msg_len = slot->len;
+	slot->msg = NULL;
+	queue->head = (queue->head + 1) % transport->inbox->depth;
+	queue->count--;
+
+	return PLDM_REQUESTER_SUCCESS;
+}
+
+LIBPLDM_ABI_TESTING
+size_t pldm_transport_inbox_pending(struct pldm_transport *transport,
+				    pldm_tid_t tid, uint8_t type)
+{
+	struct pldm_transport_inbox_queue *queue;
+
+	if (!transport || !transport->inbox) {
+		return 0;
+	}
+
+	queue = pldm_transport_inbox_find(transport->inbox, tid, type);
+
+	return queue ? queue->count : 0;
+}
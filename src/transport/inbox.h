@@ -0,0 +1,46 @@
+/* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#ifndef LIBPLDM_SRC_TRANSPORT_INBOX_H
+#define LIBPLDM_SRC_TRANSPORT_INBOX_H
+
+#include "transport.h"
+
+#include <libpldm/base.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* The PLDM type field of the message header is six bits wide */
+#define PLDM_TRANSPORT_INBOX_TYPES 64
+
+struct pldm_transport_inbox_msg {
+	void *msg;
+	size_t len;
+};
+
+/* A ring of the messages from a TID of a PLDM type, oldest first */
+struct pldm_transport_inbox_queue {
+	struct pldm_transport_inbox_msg *ring;
+	size_t head;
+	size_t count;
+};
+
+struct pldm_transport_inbox_tid {
+	struct pldm_transport_inbox_queue queues[PLDM_TRANSPORT_INBOX_TYPES];
+};
+
+struct pldm_transport_inbox {
+	size_t depth;
+	/* Allocated on the first message queued from each TID */
+	struct pldm_transport_inbox_tid *tids[PLDM_MAX_TIDS];
+};
+
+/*
+ * Take ownership of a received message by queueing it in its inbox. Returns
+ * false if inboxes are disabled, the inbox is full, or memory couldn't be
+ * allocated, in which case the caller retains ownership.
+ */
+bool pldm_transport_inbox_put(struct pldm_transport *transport, pldm_tid_t tid,
+			      void *msg, size_t len);
+
+#endif // LIBPLDM_SRC_TRANSPORT_INBOX_H
@@ -0,0 +1,950 @@
+/* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#include "compiler.h"
+#include "container-of.h"
+#include "mctp-defines.h"
+#include "socket.h"
+#include "tid-eid-map.h"
+#include "transport.h"
+
+#include <libpldm/base.h>
+#include <libpldm/pldm.h>
+#include <libpldm/transport.h>
+#include <libpldm/transport/io-uring.h>
+
+#include <errno.h>
+#include <limits.h>
+#include <linux/io_uring.h>
+#include <linux/mctp.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#define IO_URING_NAME "io_uring"
+#define IO_URING_BATCH_MAX 32
+/* Must be a power of two */
+#define IO_URING_BUFS	  32
+#define IO_URING_BUF_SIZE 8192
+#define IO_URING_BGID	  0
+
+struct pldm_io_uring_ring {
+	int fd;
+	void *sq_ptr;
+	size_t sq_len;
+	void *cq_ptr;
+	size_t cq_len;
+	struct io_uring_sqe *sqes;
+	size_t sqes_len;
+	uint32_t *sq_head;
+	uint32_t *sq_tail;
+	uint32_t *sq_array;
+	uint32_t sq_mask;
+	uint32_t sq_entries;
+	/* SQEs prepared but not yet made visible to the kernel */
+	uint32_t sq_pending;
+	uint32_t *cq_head;
+	uint32_t *cq_tail;
+	uint32_t cq_mask;
+	struct io_uring_cqe *cqes;
+};
+
+/* A message delivered by the multishot receive */
+struct pldm_io_uring_rx {
+	uint16_t bid;
+	pldm_requester_rc_t rc;
+	pldm_tid_t tid;
+	const uint8_t *msg;
+	size_t len;
+};
+
+/* Storage for a send that must remain valid until it completes */
+struct pldm_io_uring_tx {
+	struct msghdr msg;
+	struct iovec iov[2];
+	struct sockaddr_mctp smctp;
+	uint8_t prefix[2];
+};
+
+struct pldm_transport_io_uring {
+	struct pldm_transport transport;
+	int socket;
+	enum pldm_transport_io_uring_framing framing;
+	struct pldm_tid_eid_map tid_eid_map;
+	struct pldm_socket_sndbuf socket_send_buf;
+	/* Only carries the multishot receive, so its CQ holds only messages */
+	struct pldm_io_uring_ring rx_ring;
+	struct pldm_io_uring_ring tx_ring;
+	struct msghdr rx_msg;
+	bool rx_armed;
+	struct io_uring_buf_ring *buf_ring;
+	size_t buf_ring_len;
+	uint16_t buf_tail;
+	uint8_t *bufs;
+	struct pldm_io_uring_tx tx[IO_URING_BATCH_MAX];
+	struct pldm_socket_mctp_responder responder;
+};
+
+#define transport_to_io_uring(ptr)                                             \
+	container_of(ptr, struct pldm_transport_io_uring, transport)
+
+static int pldm_io_uring_setup(unsigned int entries,
+			       struct io_uring_params *params)
+{
+	return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int pldm_io_uring_enter(int fd, unsigned int to_submit,
+			       unsigned int min_complete, unsigned int flags)
+{
+	return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+			    flags, NULL, 0);
+}
+
+static int pldm_io_uring_register(int fd, unsigned int opcode, void *arg,
+				  unsigned int nr_args)
+{
+	return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+static void pldm_io_uring_ring_fini(struct pldm_io_uring_ring *ring)
+{
+	if (ring->sqes) {
+		munmap(ring->sqes, ring->sqes_len);
+	}
+	if (ring->cq_ptr && ring->cq_ptr != ring->sq_ptr) {
+		munmap(ring->cq_ptr, ring->cq_len);
+	}
+	if (ring->sq_ptr) {
+		munmap(ring->sq_ptr, ring->sq_len);
+	}
+	if (ring->fd >= 0) {
+		close(ring->fd);
+	}
+}
+
+static int pldm_io_uring_ring_init(struct pldm_io_uring_ring *ring,
+				   unsigned int entries, unsigned int cq_entries)
+{
+	struct io_uring_params params;
+	void *ptr;
+	int rc;
+
+	memset(ring, 0, sizeof(*ring));
+	memset(&params, 0, sizeof(params));
+	if (cq_entries) {
+		params.flags = IORING_SETUP_CQSIZE;
+		params.cq_entries = cq_entries;
+	}
+
+	ring->fd = pldm_io_uring_setup(entries, &params);
+	if (ring->fd < 0) {
+		return -errno;
+	}
+
+	ring->sq_len = params.sq_off.array +
+		       params.sq_entries * sizeof(uint32_t);
+	ring->cq_len = params.cq_off.cqes +
+		       params.cq_entries * sizeof(struct io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		if (ring->cq_len > ring->sq_len) {
+			ring->sq_len = ring->cq_len;
+		}
+		ring->cq_len = ring->sq_len;
+	}
+
+	ptr = mmap(NULL, ring->sq_len, PROT_READ | PROT_WRITE,
+		   MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	if (ptr == MAP_FAILED) {
+		rc = -errno;
+		goto cleanup_ring;
+	}
+	ring->sq_ptr = ptr;
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		ring->cq_ptr = ring->sq_ptr;
+	} else {
+		ptr = mmap(NULL, ring->cq_len, PROT_READ | PROT_WRITE,
+			   MAP_SHARED | MAP_POPULATE, ring->fd,
+			   IORING_OFF_CQ_RING);
+		if (ptr == MAP_FAILED) {
+			rc = -errno;
+			goto cleanup_ring;
+		}
+		ring->cq_ptr = ptr;
+	}
+
+	ring->sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+	ptr = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE,
+		   MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+	if (ptr == MAP_FAILED) {
+		rc = -errno;
+		goto cleanup_ring;
+	}
+	ring->sqes = ptr;
+
+	ring->sq_head = (uint32_t *)((uint8_t *)ring->sq_ptr +
+				     params.sq_off.head);
+	ring->sq_tail = (uint32_t *)((uint8_t *)ring->sq_ptr +
+				     params.sq_off.tail);
+	ring->sq_array = (uint32_t *)((uint8_t *)ring->sq_ptr +
+				      params.sq_off.array);
+	ring->sq_mask = *(uint32_t *)((uint8_t *)ring->sq_ptr +
+				      params.sq_off.ring_mask);
+	ring->sq_entries = params.sq_entries;
+	ring->cq_head = (uint32_t *)((uint8_t *)ring->cq_ptr +
+				     params.cq_off.head);
+	ring->cq_tail = (uint32_t *)((uint8_t *)ring->cq_ptr +
+				     params.cq_off.tail);
+	ring->cq_mask = *(uint32_t *)((uint8_t *)ring->cq_ptr +
+				      params.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *)((uint8_t *)ring->cq_ptr +
+					     params.cq_off.cqes);
+
+	return 0;
+
+cleanup_ring:
+	pldm_io_uring_ring_fini(ring);
+	memset(ring, 0, sizeof(*ring));
+	ring->fd = -1;
+
+	return rc;
+}
+
+static struct io_uring_sqe *
+pldm_io_uring_get_sqe(struct pldm_io_uring_ring *ring)
+{
+	uint32_t head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+	uint32_t tail = *ring->sq_tail + ring->sq_pending;
+	struct io_uring_sqe *sqe;
+
+	if (tail - head >= ring->sq_entries) {
+		return NULL;
+	}
+
+	ring->sq_array[tail & ring->sq_mask] = tail & ring->sq_mask;
+	sqe = &ring->sqes[tail & ring->sq_mask];
+	memset(sqe, 0, sizeof(*sqe));
+	ring->sq_pending++;
+
+	return sqe;
+}
+
+/* Submit the prepared SQEs, and wait for min_complete completions */
+static int pldm_io_uring_submit(struct pldm_io_uring_ring *ring,
+				unsigned int min_complete)
+{
+	unsigned int to_submit = ring->sq_pending;
+	int rc;
+
+	__atomic_store_n(ring->sq_tail, *ring->sq_tail + to_submit,
+			 __ATOMIC_RELEASE);
+	ring->sq_pending = 0;
+
+	do {
+		rc = pldm_io_uring_enter(ring->fd, to_submit, min_complete,
+					 min_complete ? IORING_ENTER_GETEVENTS :
+							0);
+	} while (rc < 0 && errno == EINTR);
+
+	return rc < 0 ? -errno : rc;
+}
+
+static struct io_uring_cqe *
+pldm_io_uring_peek_cqe(struct pldm_io_uring_ring *ring)
+{
+	uint32_t tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+	uint32_t head = *ring->cq_head;
+
+	if (head == tail) {
+		return NULL;
+	}
+
+	return &ring->cqes[head & ring->cq_mask];
+}
+
+static void pldm_io_uring_cqe_seen(struct pldm_io_uring_ring *ring)
+{
+	__atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+/* Return a receive buffer to the kernel */
+static void pldm_io_uring_buf_recycle(struct pldm_transport_io_uring *ctx,
+				      uint16_t bid)
+{
+	struct io_uring_buf *buf =
+		&ctx->buf_ring->bufs[ctx->buf_tail & (IO_URING_BUFS - 1)];
+
+	buf->addr = (uintptr_t)(ctx->bufs + (size_t)bid * IO_URING_BUF_SIZE);
+	buf->len = IO_URING_BUF_SIZE;
+	buf->bid = bid;
+	ctx->buf_tail++;
+	__atomic_store_n(&ctx->buf_ring->tail, ctx->buf_tail, __ATOMIC_RELEASE);
+}
+
+static int pldm_io_uring_arm_recv(struct pldm_transport_io_uring *ctx)
+{
+	struct io_uring_sqe *sqe;
+	int rc;
+
+	sqe = pldm_io_uring_get_sqe(&ctx->rx_ring);
+	if (!sqe) {
+		return -EBUSY;
+	}
+
+	sqe->opcode = IORING_OP_RECVMSG;
+	sqe->fd = ctx->socket;
+	sqe->addr = (uintptr_t)&ctx->rx_msg;
+	sqe->len = 1;
+	/* MSG_TRUNC yields the full length of each datagram */
+	sqe->msg_flags = MSG_TRUNC;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = IO_URING_BGID;
+
+	rc = pldm_io_uring_submit(&ctx->rx_ring, 0);
+	if (rc < 0) {
+		return rc;
+	}
+
+	ctx->rx_armed = true;
+
+	return 0;
+}
+
+/* Resolve the source TID, and track the source address of requests received
+ * over AF_MCTP so the response can be routed back to it */
+static pldm_requester_rc_t
+pldm_transport_io_uring_accept(struct pldm_transport_io_uring *ctx,
+			       const struct sockaddr_mctp *addr,
+			       const struct pldm_msg_hdr *hdr, pldm_tid_t *tid)
+{
+	bool track = ctx->framing == PLDM_TRANSPORT_IO_URING_AF_MCTP;
+
+	return pldm_socket_mctp_accept(&ctx->responder, &ctx->tid_eid_map,
+				       track, addr, hdr, tid);
+}
+
+/* Locate the message in a receive buffer and resolve its source */
+static void pldm_io_uring_rx_decode(struct pldm_transport_io_uring *ctx,
+				    struct pldm_io_uring_rx *rx)
+{
+	const uint8_t *buf = ctx->bufs + (size_t)rx->bid * IO_URING_BUF_SIZE;
+	const struct io_uring_recvmsg_out *out = (const void *)buf;
+	struct sockaddr_mctp addr = { 0 };
+	const uint8_t *payload;
+	size_t avail;
+
+	payload = buf + sizeof(*out) + ctx->rx_msg.msg_namelen +
+		  ctx->rx_msg.msg_controllen;
+	avail = IO_URING_BUF_SIZE - (size_t)(payload - buf);
+
+	rx->msg = payload;
+	rx->len = out->payloadlen;
+
+	if (ctx->framing == PLDM_TRANSPORT_IO_URING_AF_MCTP) {
+		memcpy(&addr, buf + sizeof(*out), sizeof(addr));
+	} else {
+		/* Strip the EID and MCTP message type prefix */
+		if (rx->len < 2) {
+			rx->len = 0;
+			rx->rc = PLDM_REQUESTER_INVALID_RECV_LEN;
+			return;
+		}
+		if (payload[1] != MCTP_MSG_TYPE_PLDM) {
+			rx->rc = PLDM_REQUESTER_NOT_PLDM_MSG;
+			return;
+		}
+		addr.smctp_network = PLDM_TID_EID_MAP_NET_ANY;
+		addr.smctp_addr.s_addr = payload[0];
+		rx->msg += 2;
+		rx->len -= 2;
+		avail -= 2;
+	}
+
+	if (rx->len < sizeof(struct pldm_msg_hdr)) {
+		rx->rc = PLDM_REQUESTER_INVALID_RECV_LEN;
+		return;
+	}
+
+	if ((out->flags & MSG_TRUNC) || rx->len > avail) {
+		/* The message is lost, so don't track it for a response */
+		rx->rc = PLDM_REQUESTER_RECV_TRUNCATED;
+		return;
+	}
+
+	rx->rc = pldm_transport_io_uring_accept(
+		ctx, &addr, (const struct pldm_msg_hdr *)rx->msg, &rx->tid);
+}
+
+/*
+ * Fetch the next message delivered by the multishot receive, optionally
+ * waiting for one. The buffer must be returned with pldm_io_uring_rx_done().
+ *
+ * Returns 0 if rx holds a message, -EAGAIN if none is available without
+ * waiting, or a negative errno value if receiving failed
+ */
+static int pldm_io_uring_rx_next(struct pldm_transport_io_uring *ctx,
+				 bool wait, struct pldm_io_uring_rx *rx)
+{
+	struct io_uring_cqe *cqe;
+	uint32_t flags;
+	int res;
+	int rc;
+
+	for (;;) {
+		cqe = pldm_io_uring_peek_cqe(&ctx->rx_ring);
+		if (!cqe) {
+			if (!ctx->rx_armed) {
+				rc = pldm_io_uring_arm_recv(ctx);
+				if (rc) {
+					return rc;
+				}
+			}
+
+			if (!wait) {
+				return -EAGAIN;
+			}
+
+			rc = pldm_io_uring_submit(&ctx->rx_ring, 1);
+			if (rc < 0) {
+				return rc;
+			}
+
+			continue;
+		}
+
+		res = cqe->res;
+		flags = cqe->flags;
+		pldm_io_uring_cqe_seen(&ctx->rx_ring);
+
+		if (!(flags & IORING_CQE_F_MORE)) {
+			ctx->rx_armed = false;
+		}
+
+		if (flags & IORING_CQE_F_BUFFER) {
+			rx->bid = flags >> IORING_CQE_BUFFER_SHIFT;
+			pldm_io_uring_rx_decode(ctx, rx);
+			return 0;
+		}
+
+		/*
+		 * Running out of buffers ends the multishot receive, and the
+		 * buffers are all available again once its earlier messages
+		 * are consumed. It's re-armed when the ring is next empty.
+		 */
+		if (res != -ENOBUFS) {
+			return res < 0 ? res : -EIO;
+		}
+	}
+}
+
+static void pldm_io_uring_rx_done(struct pldm_transport_io_uring *ctx,
+				  struct pldm_io_uring_rx *rx)
+{
+	pldm_io_uring_buf_recycle(ctx, rx->bid);
+
+	/* Keep the ring fd readable only while messages may arrive */
+	if (!ctx->rx_armed && !pldm_io_uring_peek_cqe(&ctx->rx_ring)) {
+		pldm_io_uring_arm_recv(ctx);
+	}
+}
+
+LIBPLDM_ABI_TESTING
+struct pldm_transport *
+pldm_transport_io_uring_core(struct pldm_transport_io_uring *ctx)
+{
+	return &ctx->transport;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_io_uring_init_pollfd(struct pldm_transport *t,
+					struct pollfd *pollfd)
+{
+	struct pldm_transport_io_uring *ctx = transport_to_io_uring(t);
+
+	/* The receive ring's fd is readable while it holds completions */
+	pollfd->fd = ctx->rx_ring.fd;
+	pollfd->events = POLLIN;
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_io_uring_map_tid(struct pldm_transport_io_uring *ctx,
+				    pldm_tid_t tid, uint32_t net,
+				    mctp_eid_t eid)
+{
+	if (ctx->framing == PLDM_TRANSPORT_IO_URING_MCTP_DEMUX) {
+		net = PLDM_TID_EID_MAP_NET_ANY;
+	}
+
+	return pldm_tid_eid_map_insert(&ctx->tid_eid_map, tid, net, eid);
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_io_uring_unmap_tid(struct pldm_transport_io_uring *ctx,
+				      pldm_tid_t tid, mctp_eid_t eid)
+{
+	return pldm_tid_eid_map_remove(&ctx->tid_eid_map, tid, eid);
+}
+
+static pldm_requester_rc_t
+pldm_transport_io_uring_recv(struct pldm_transport *t, pldm_tid_t *tid,
+			     void **pldm_msg, size_t *msg_len)
+{
+	struct pldm_transport_io_uring *ctx = transport_to_io_uring(t);
+	pldm_requester_rc_t res;
+	struct pldm_io_uring_rx rx;
+	void *msg;
+
+	if (pldm_io_uring_rx_next(ctx, true, &rx)) {
+		return PLDM_REQUESTER_RECV_FAIL;
+	}
+
+	res = rx.rc;
+	if (res == PLDM_REQUESTER_RECV_TRUNCATED) {
+		res = PLDM_REQUESTER_INVALID_RECV_LEN;
+	}
+	if (res != PLDM_REQUESTER_SUCCESS) {
+		goto cleanup_rx;
+	}
+
+	msg = malloc(rx.len);
+	if (!msg) {
+		res = PLDM_REQUESTER_RECV_FAIL;
+		goto cleanup_rx;
+	}
+
+	memcpy(msg, rx.msg, rx.len);
+	*tid = rx.tid;
+	*pldm_msg = msg;
+	*msg_len = rx.len;
+
+cleanup_rx:
+	pldm_io_uring_rx_done(ctx, &rx);
+
+	return res;
+}
+
+/* Copy a received message out of its buffer, as for recv_into */
+static pldm_requester_rc_t
+pldm_io_uring_rx_copy(struct pldm_io_uring_rx *rx, pldm_tid_t *tid,
+		      void *pldm_msg, size_t *msg_len)
+{
+	size_t len = rx->len;
+
+	if (rx->rc != PLDM_REQUESTER_SUCCESS) {
+		*msg_len = len;
+		return rx->rc;
+	}
+
+	if (len > *msg_len) {
+		*msg_len = len;
+		return PLDM_REQUESTER_RECV_TRUNCATED;
+	}
+
+	memcpy(pldm_msg, rx->msg, len);
+	*tid = rx->tid;
+	*msg_len = len;
+
+	return PLDM_REQUESTER_SUCCESS;
+}
+
+static pldm_requester_rc_t
+pldm_transport_io_uring_recv_into(struct pldm_transport *t, pldm_tid_t *tid,
+				  void *pldm_msg, size_t *msg_len)
+{
+	struct pldm_transport_io_uring *ctx = transport_to_io_uring(t);
+	struct pldm_io_uring_rx rx;
+	pldm_requester_rc_t res;
+
+	if (pldm_io_uring_rx_next(ctx, true, &rx)) {
+		return PLDM_REQUESTER_RECV_FAIL;
+	}
+
+	res = pldm_io_uring_rx_copy(&rx, tid, pldm_msg, msg_len);
+	pldm_io_uring_rx_done(ctx, &rx);
+
+	return res;
+}
+
+static int pldm_transport_io_uring_recv_msgs(struct pldm_transport *t,
+					     struct pldm_transport_msg *msgs,
+					     size_t count)
+{
+	struct pldm_transport_io_uring *ctx = transport_to_io_uring(t);
+	struct pldm_io_uring_rx rx;
+	size_t received;
+
+	/* Wait for the first message only, as for a single receive */
+	for (received = 0; received < count; received++) {
+		struct pldm_transport_msg *m = &msgs[received];
+
+		if (pldm_io_uring_rx_next(ctx, !received, &rx)) {
+			break;
+		}
+
+		m->rc = pldm_io_uring_rx_copy(&rx, &m->tid, m->msg, &m->len);
+		pldm_io_uring_rx_done(ctx, &rx);
+	}
+
+	return received ? (int)received : PLDM_REQUESTER_RECV_FAIL;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_io_uring_process(struct pldm_transport_io_uring *ctx,
+				    pldm_transport_io_uring_msg_handler handler,
+				    void *data)
+{
+	struct pldm_io_uring_rx rx;
+	int dispatched = 0;
+	int rc;
+
+	if (!ctx || !handler) {
+		return -EINVAL;
+	}
+
+	while (!(rc = pldm_io_uring_rx_next(ctx, false, &rx))) {
+		if (rx.rc == PLDM_REQUESTER_SUCCESS) {
+			handler(data, rx.tid, rx.msg, rx.len);
+			dispatched++;
+		}
+		pldm_io_uring_rx_done(ctx, &rx);
+	}
+
+	if (rc != -EAGAIN && !dispatched) {
+		return -EIO;
+	}
+
+	return dispatched;
+}
+
+/* Resolve the destination of a message. Responses over AF_MCTP claim the
+ * cookie of the request, to be passed to pldm_socket_mctp_sent() */
+static pldm_requester_rc_t
+pldm_transport_io_uring_route(struct pldm_transport_io_uring *ctx,
+			      pldm_tid_t tid, const struct pldm_msg_hdr *hdr,
+			      struct pldm_io_uring_tx *tx,
+			      struct pldm_socket_mctp_cookie **cookie)
+{
+	bool respond = ctx->framing == PLDM_TRANSPORT_IO_URING_AF_MCTP;
+
+	return pldm_socket_mctp_route(&ctx->responder, &ctx->tid_eid_map,
+				      respond, tid, hdr, &tx->smctp, cookie);
+}
+
+static void pldm_io_uring_tx_prep(struct pldm_transport_io_uring *ctx,
+				  struct pldm_io_uring_tx *tx,
+				  struct pldm_transport_msg *m)
+{
+	memset(&tx->msg, 0, sizeof(tx->msg));
+
+	if (ctx->framing == PLDM_TRANSPORT_IO_URING_AF_MCTP) {
+		tx->iov[0].iov_base = m->msg;
+		tx->iov[0].iov_len = m->len;
+		tx->msg.msg_name = &tx->smctp;
+		tx->msg.msg_namelen = sizeof(tx->smctp);
+		tx->msg.msg_iovlen = 1;
+	} else {
+		tx->prefix[0] = tx->smctp.smctp_addr.s_addr;
+		tx->prefix[1] = MCTP_MSG_TYPE_PLDM;
+		tx->iov[0].iov_base = tx->prefix;
+		tx->iov[0].iov_len = sizeof(tx->prefix);
+		tx->iov[1].iov_base = m->msg;
+		tx->iov[1].iov_len = m->len;
+		tx->msg.msg_iovlen = 2;
+	}
+	tx->msg.msg_iov = tx->iov;
+}
+
+static int pldm_transport_io_uring_send_msgs(struct pldm_transport *t,
+					     struct pldm_transport_msg *msgs,
+					     size_t count)
+{
+	struct pldm_transport_io_uring *ctx = transport_to_io_uring(t);
+	struct pldm_socket_mctp_cookie *cookies[IO_URING_BATCH_MAX];
+	pldm_requester_rc_t res = PLDM_REQUESTER_SUCCESS;
+	int results[IO_URING_BATCH_MAX];
+	size_t sent = 0;
+
+	while (sent < count) {
+		size_t batch = count - sent;
+		struct io_uring_sqe *last;
+		struct io_uring_sqe *sqe;
+		struct io_uring_cqe *cqe;
+		size_t completed;
+		size_t prepared;
+		size_t queued;
+		size_t max_len;
+		size_t ok;
+		size_t i;
+		int rc;
+
+		if (batch > IO_URING_BATCH_MAX) {
+			batch = IO_URING_BATCH_MAX;
+		}
+
+		max_len = 0;
+		for (prepared = 0; prepared < batch; prepared++) {
+			struct pldm_transport_msg *m = &msgs[sent + prepared];
+			struct pldm_io_uring_tx *tx = &ctx->tx[prepared];
+
+			if (m->len < sizeof(struct pldm_msg_hdr)) {
+				res = PLDM_REQUESTER_SEND_FAIL;
+				break;
+			}
+
+			res = pldm_transport_io_uring_route(ctx, m->tid, m->msg,
+							    tx,
+							    &cookies[prepared]);
+			if (res != PLDM_REQUESTER_SUCCESS) {
+				break;
+			}
+
+			pldm_io_uring_tx_prep(ctx, tx, m);
+			if (m->len > max_len) {
+				max_len = m->len;
+			}
+		}
+
+		if (!prepared) {
+			break;
+		}
+
+		ok = 0;
+		if (max_len <= INT_MAX &&
+		    !pldm_socket_sndbuf_accomodate(&ctx->socket_send_buf,
+						   (int)max_len)) {
+			/*
+			 * Link the sends so they go out in order, and so the
+			 * sends after a failure are cancelled. If the SQ is
+			 * full then end the chain early, leaving the remaining
+			 * messages unsent.
+			 */
+			for (i = 0; i < prepared; i++) {
+				results[i] = -EBUSY;
+			}
+			last = NULL;
+			for (i = 0; i < prepared; i++) {
+				sqe = pldm_io_uring_get_sqe(&ctx->tx_ring);
+				if (!sqe) {
+					break;
+				}
+				sqe->opcode = IORING_OP_SENDMSG;
+				sqe->fd = ctx->socket;
+				sqe->addr = (uintptr_t)&ctx->tx[i].msg;
+				sqe->len = 1;
+				sqe->user_data = i;
+				if (last) {
+					last->flags = IOSQE_IO_LINK;
+				}
+				last = sqe;
+				results[i] = -ECANCELED;
+			}
+			queued = i;
+
+			completed = 0;
+			rc = -EBUSY;
+			if (queued) {
+				rc = pldm_io_uring_submit(&ctx->tx_ring,
+							  queued);
+			}
+			while (rc >= 0) {
+				while ((cqe = pldm_io_uring_peek_cqe(
+						&ctx->tx_ring))) {
+					results[cqe->user_data] = cqe->res;
+					pldm_io_uring_cqe_seen(&ctx->tx_ring);
+					completed++;
+				}
+
+				if (completed == queued) {
+					break;
+				}
+
+				rc = pldm_io_uring_submit(&ctx->tx_ring,
+							  queued - completed);
+			}
+
+			while (ok < prepared && results[ok] >= 0) {
+				ok++;
+			}
+		}
+
+		/*
+		 * Drop the cookies of the responses that were sent. Keep
+		 * tracking the rest so the caller can try them again.
+		 */
+		for (i = 0; i < prepared; i++) {
+			pldm_socket_mctp_sent(&ctx->responder, cookies[i],
+					      i < ok);
+		}
+
+		for (i = 0; i < ok; i++) {
+			msgs[sent + i].rc = PLDM_REQUESTER_SUCCESS;
+		}
+		sent += ok;
+
+		if (ok < batch) {
+			res = PLDM_REQUESTER_SEND_FAIL;
+			break;
+		}
+	}
+
+	return sent ? (int)sent : res;
+}
+
+static pldm_requester_rc_t
+pldm_transport_io_uring_send(struct pldm_transport *t, pldm_tid_t tid,
+			     const void *pldm_msg, size_t msg_len)
+{
+	struct pldm_transport_msg msg = {
+		.tid = tid,
+		.msg = (void *)pldm_msg,
+		.len = msg_len,
+		.rc = PLDM_REQUESTER_SEND_FAIL,
+	};
+	int rc;
+
+	rc = pldm_transport_io_uring_send_msgs(t, &msg, 1);
+
+	return rc == 1 ? PLDM_REQUESTER_SUCCESS : PLDM_REQUESTER_SEND_FAIL;
+}
+
+static int pldm_io_uring_bufs_init(struct pldm_transport_io_uring *ctx)
+{
+	struct io_uring_buf_reg reg;
+	void *ptr;
+	int i;
+
+	ctx->buf_ring_len = IO_URING_BUFS * sizeof(struct io_uring_buf);
+	ptr = mmap(NULL, ctx->buf_ring_len, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (ptr == MAP_FAILED) {
+		return -errno;
+	}
+	ctx->buf_ring = ptr;
+
+	ctx->bufs = malloc((size_t)IO_URING_BUFS * IO_URING_BUF_SIZE);
+	if (!ctx->bufs) {
+		return -ENOMEM;
+	}
+
+	memset(&reg, 0, sizeof(reg));
+	reg.ring_addr = (uintptr_t)ctx->buf_ring;
+	reg.ring_entries = IO_URING_BUFS;
+	reg.bgid = IO_URING_BGID;
+	if (pldm_io_uring_register(ctx->rx_ring.fd, IORING_REGISTER_PBUF_RING,
+				   &reg, 1)) {
+		return -errno;
+	}
+
+	for (i = 0; i < IO_URING_BUFS; i++) {
+		pldm_io_uring_buf_recycle(ctx, i);
+	}
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+void pldm_transport_io_uring_destroy(struct pldm_transport_io_uring *ctx)
+{
+	if (!ctx) {
+		return;
+	}
+
+	pldm_transport_stats_disable(&ctx->transport);
+	pldm_transport_inbox_disable(&ctx->transport);
+	/* Closing the ring cancels the multishot receive */
+	pldm_io_uring_ring_fini(&ctx->tx_ring);
+	pldm_io_uring_ring_fini(&ctx->rx_ring);
+	if (ctx->buf_ring) {
+		munmap(ctx->buf_ring, ctx->buf_ring_len);
+	}
+	free(ctx->bufs);
+	free(ctx);
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_io_uring_init(struct pldm_transport_io_uring **ctx,
+				 int socket,
+				 enum pldm_transport_io_uring_framing framing)
+{
+	struct pldm_transport_io_uring *io_uring;
+	int rc;
+
+	if (!ctx || *ctx || socket < 0) {
+		return -EINVAL;
+	}
+
+	if (framing != PLDM_TRANSPORT_IO_URING_AF_MCTP &&
+	    framing != PLDM_TRANSPORT_IO_URING_MCTP_DEMUX) {
+		return -EINVAL;
+	}
+
+	io_uring = calloc(1, sizeof(*io_uring));
+	if (!io_uring) {
+		return -ENOMEM;
+	}
+
+	io_uring->transport.name = IO_URING_NAME;
+	io_uring->transport.version = 1;
+	io_uring->transport.recv = pldm_transport_io_uring_recv;
+	io_uring->transport.recv_into = pldm_transport_io_uring_recv_into;
+	io_uring->transport.send = pldm_transport_io_uring_send;
+	io_uring->transport.send_msgs = pldm_transport_io_uring_send_msgs;
+	io_uring->transport.recv_msgs = pldm_transport_io_uring_recv_msgs;
+	io_uring->transport.init_pollfd = pldm_transport_io_uring_init_pollfd;
+	io_uring->socket = socket;
+	io_uring->framing = framing;
+	io_uring->rx_ring.fd = -1;
+	io_uring->tx_ring.fd = -1;
+	pldm_tid_eid_map_init(&io_uring->tid_eid_map);
+	pldm_socket_mctp_responder_init(&io_uring->responder);
+
+	if (framing == PLDM_TRANSPORT_IO_URING_AF_MCTP) {
+		io_uring->rx_msg.msg_namelen = sizeof(struct sockaddr_mctp);
+	}
+
+	if (pldm_socket_sndbuf_init(&io_uring->socket_send_buf,
+				    &io_uring->transport, socket)) {
+		rc = -EIO;
+		goto cleanup_io_uring;
+	}
+
+	/*
+	 * Size the receive CQ for a completion per buffer plus the end of the
+	 * multishot receive, so it never overflows
+	 */
+	rc = pldm_io_uring_ring_init(&io_uring->rx_ring, 2, 2 * IO_URING_BUFS);
+	if (rc) {
+		goto cleanup_io_uring;
+	}
+
+	rc = pldm_io_uring_ring_init(&io_uring->tx_ring, IO_URING_BATCH_MAX,
+				     0);
+	if (rc) {
+		goto cleanup_io_uring;
+	}
+
+	rc = pldm_io_uring_bufs_init(io_uring);
+	if (rc) {
+		goto cleanup_io_uring;
+	}
+
+	rc = pldm_io_uring_arm_recv(io_uring);
+	if (rc) {
+		goto cleanup_io_uring;
+	}
+
+	*ctx = io_uring;
+	return 0;
+
+cleanup_io_uring:
+	pldm_transport_io_uring_destroy(io_uring);
+
+	return rc;
+}
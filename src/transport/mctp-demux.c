@@ -3,6 +3,7 @@
 #include "container-of.h"
 #include "mctp-defines.h"
 #include "socket.h"
+#include "tid-eid-map.h"
 #include "transport.h"
 
 #include <libpldm/base.h>
@@ -26,10 +27,10 @@ const uint8_t mctp_msg_type = MCTP_MSG_TYPE_PLDM;
 struct pldm_transport_mctp_demux {
 	struct pldm_transport transport;
 	int socket;
-	/* In the future this probably needs to move to a tid-eid-uuid/network
-	 * id mapping for multi mctp networks */
-	pldm_tid_t tid_eid_map[MCTP_MAX_NUM_EID];
+	/* The demux daemon serves a single MCTP network */
+	struct pldm_tid_eid_map tid_eid_map;
 	struct pldm_socket_sndbuf socket_send_buf;
+	struct pldm_socket_txq txq;
 };
 
 #define transport_to_demux(ptr)                                                \
@@ -76,53 +77,60 @@ int pldm_transport_mctp_demux_init_pollfd(struct pldm_transport *t,
 	struct pldm_transport_mctp_demux *ctx = transport_to_demux(t);
 	pollfd->fd = ctx->socket;
 	pollfd->events = POLLIN;
+	if (ctx->txq.count) {
+		pollfd->events |= POLLOUT;
+	}
 	return 0;
 }
 
+static int pldm_transport_mctp_demux_flush(struct pldm_transport *t)
+{
+	struct pldm_transport_mctp_demux *demux = transport_to_demux(t);
+
+	return pldm_socket_txq_flush(&demux->txq, demux->socket);
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_mctp_demux_set_send_queue(
+	struct pldm_transport_mctp_demux *ctx, size_t depth)
+{
+	if (!ctx) {
+		return -EINVAL;
+	}
+
+	return pldm_socket_txq_set_depth(&ctx->txq, depth);
+}
+
 static int
 pldm_transport_mctp_demux_get_eid(struct pldm_transport_mctp_demux *ctx,
 				  pldm_tid_t tid, mctp_eid_t *eid)
 {
-	int i;
-	for (i = 0; i < MCTP_MAX_NUM_EID; i++) {
-		if (ctx->tid_eid_map[i] == tid) {
-			*eid = i;
-			return 0;
-		}
-	}
-	*eid = -1;
-	return -1;
+	uint32_t net;
+
+	return pldm_tid_eid_map_get_eid(&ctx->tid_eid_map, tid, &net, eid);
 }
 
 static int
 pldm_transport_mctp_demux_get_tid(struct pldm_transport_mctp_demux *ctx,
 				  mctp_eid_t eid, pldm_tid_t *tid)
 {
-	/* mapping exists */
-	if (ctx->tid_eid_map[eid] != 0) {
-		*tid = ctx->tid_eid_map[eid];
-		return 0;
-	}
-	return -1;
+	return pldm_tid_eid_map_get_tid(&ctx->tid_eid_map,
+					PLDM_TID_EID_MAP_NET_ANY, eid, tid);
 }
 
 LIBPLDM_ABI_STABLE
 int pldm_transport_mctp_demux_map_tid(struct pldm_transport_mctp_demux *ctx,
 				      pldm_tid_t tid, mctp_eid_t eid)
 {
-	ctx->tid_eid_map[eid] = tid;
-
-	return 0;
+	return pldm_tid_eid_map_insert(&ctx->tid_eid_map, tid,
+				       PLDM_TID_EID_MAP_NET_ANY, eid);
 }
 
 LIBPLDM_ABI_STABLE
 int pldm_transport_mctp_demux_unmap_tid(struct pldm_transport_mctp_demux *ctx,
-					LIBPLDM_CC_UNUSED pldm_tid_t tid,
-					mctp_eid_t eid)
+					pldm_tid_t tid, mctp_eid_t eid)
 {
-	ctx->tid_eid_map[eid] = 0;
-
-	return 0;
+	return pldm_tid_eid_map_remove(&ctx->tid_eid_map, tid, eid);
 }
 
 static pldm_requester_rc_t
@@ -200,6 +208,59 @@ cleanup_buf:
 	return res;
 }
 
+static pldm_requester_rc_t
+pldm_transport_mctp_demux_recv_into(struct pldm_transport *t, pldm_tid_t *tid,
+				    void *pldm_msg, size_t *msg_len)
+{
+	struct pldm_transport_mctp_demux *demux = transport_to_demux(t);
+	size_t mctp_prefix_len = 2;
+	struct msghdr msg = { 0 };
+	uint8_t mctp_prefix[2];
+	struct iovec iov[2];
+	mctp_eid_t eid = 0;
+	ssize_t min_len;
+	ssize_t length;
+	int rc;
+
+	min_len = sizeof(eid) + sizeof(mctp_msg_type) +
+		  sizeof(struct pldm_msg_hdr);
+
+	iov[0].iov_len = mctp_prefix_len;
+	iov[0].iov_base = mctp_prefix;
+	iov[1].iov_len = *msg_len;
+	iov[1].iov_base = pldm_msg;
+
+	msg.msg_iov = iov;
+	msg.msg_iovlen = sizeof(iov) / sizeof(iov[0]);
+
+	/* MSG_TRUNC yields the full length of the datagram */
+	length = recvmsg(demux->socket, &msg, MSG_TRUNC);
+	if (length < 0) {
+		return PLDM_REQUESTER_RECV_FAIL;
+	}
+
+	if (length < min_len) {
+		return PLDM_REQUESTER_INVALID_RECV_LEN;
+	}
+
+	if (mctp_prefix[1] != mctp_msg_type) {
+		return PLDM_REQUESTER_NOT_PLDM_MSG;
+	}
+
+	*msg_len = length - mctp_prefix_len;
+	if (msg.msg_flags & MSG_TRUNC) {
+		return PLDM_REQUESTER_RECV_TRUNCATED;
+	}
+
+	eid = mctp_prefix[0];
+	rc = pldm_transport_mctp_demux_get_tid(demux, eid, tid);
+	if (rc) {
+		return PLDM_REQUESTER_RECV_FAIL;
+	}
+
+	return PLDM_REQUESTER_SUCCESS;
+}
+
 static pldm_requester_rc_t
 pldm_transport_mctp_demux_send(struct pldm_transport *t, pldm_tid_t tid,
 			       const void *pldm_msg, size_t msg_len)
@@ -228,11 +289,7 @@ pldm_transport_mctp_demux_send(struct pldm_transport *t, pldm_tid_t tid,
 		return PLDM_REQUESTER_SEND_FAIL;
 	}
 
-	ssize_t rc = sendmsg(demux->socket, &msg, 0);
-	if (rc == -1) {
-		return PLDM_REQUESTER_SEND_FAIL;
-	}
-	return PLDM_REQUESTER_SUCCESS;
+	return pldm_socket_txq_send(&demux->txq, demux->socket, &msg);
 }
 
 LIBPLDM_ABI_STABLE
@@ -251,15 +308,18 @@ int pldm_transport_mctp_demux_init(struct pldm_transport_mctp_demux **ctx)
 	demux->transport.name = MCTP_DEMUX_NAME;
 	demux->transport.version = 1;
 	demux->transport.recv = pldm_transport_mctp_demux_recv;
+	demux->transport.recv_into = pldm_transport_mctp_demux_recv_into;
 	demux->transport.send = pldm_transport_mctp_demux_send;
 	demux->transport.init_pollfd = pldm_transport_mctp_demux_init_pollfd;
+	demux->transport.flush = pldm_transport_mctp_demux_flush;
 	demux->socket = pldm_transport_mctp_demux_open();
 	if (demux->socket == -1) {
 		free(demux);
 		return -1;
 	}
 
-	if (pldm_socket_sndbuf_init(&demux->socket_send_buf, demux->socket)) {
+	if (pldm_socket_sndbuf_init(&demux->socket_send_buf,
+				    &demux->transport, demux->socket)) {
 		close(demux->socket);
 		free(demux);
 		return -1;
@@ -275,6 +335,9 @@ void pldm_transport_mctp_demux_destroy(struct pldm_transport_mctp_demux *ctx)
 	if (!ctx) {
 		return;
 	}
+	pldm_transport_stats_disable(&ctx->transport);
+	pldm_transport_inbox_disable(&ctx->transport);
+	pldm_socket_txq_destroy(&ctx->txq);
 	close(ctx->socket);
 	free(ctx);
 }
@@ -292,8 +355,10 @@ pldm_transport_mctp_demux_init_with_fd(int mctp_fd)
 	demux->transport.name = MCTP_DEMUX_NAME;
 	demux->transport.version = 1;
 	demux->transport.recv = pldm_transport_mctp_demux_recv;
+	demux->transport.recv_into = pldm_transport_mctp_demux_recv_into;
 	demux->transport.send = pldm_transport_mctp_demux_send;
 	demux->transport.init_pollfd = pldm_transport_mctp_demux_init_pollfd;
+	demux->transport.flush = pldm_transport_mctp_demux_flush;
 	/* dup is so we can call pldm_transport_mctp_demux_destroy which closes
 	 * the socket, without closing the fd that is being used by the consumer
 	 */
@@ -303,7 +368,8 @@ pldm_transport_mctp_demux_init_with_fd(int mctp_fd)
 		return NULL;
 	}
 
-	if (pldm_socket_sndbuf_init(&demux->socket_send_buf, demux->socket)) {
+	if (pldm_socket_sndbuf_init(&demux->socket_send_buf,
+				    &demux->transport, demux->socket)) {
 		close(demux->socket);
 		free(demux);
 		return NULL;
@@ -0,0 +1,800 @@
+/* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#include "compiler.h"
+#include "container-of.h"
+#include "transport.h"
+
+#include <libpldm/base.h>
+#include <libpldm/pldm.h>
+#include <libpldm/transport.h>
+#include <libpldm/transport/shm.h>
+
+#include <errno.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SHM_NAME	    "SHM"
+#define SHM_MAGIC	    0x4d48534cU /* "LSHM" */
+#define SHM_VERSION	    1
+#define SHM_CACHELINE	    64
+#define SHM_MAX_SLOTS	    65536
+#define SHM_MAX_MSG_SIZE    65536
+#define SHM_MAX_REGION_SIZE (1UL << 30)
+
+#define SHM_ALIGN(x) (((x) + SHM_CACHELINE - 1) & ~(size_t)(SHM_CACHELINE - 1))
+
+/* The layout of the region is shared between processes, so it must not depend
+ * on anything but the parameters recorded in the header */
+struct pldm_shm_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t endpoints;
+	uint32_t slots;
+	uint32_t msg_size;
+	uint32_t slot_stride;
+	uint64_t inbox_stride;
+	/* The inbox index plus one of each attached TID, SHM_TID_CLAIMED while
+	 * the TID's endpoint attaches, or zero */
+	uint8_t tid_inbox[PLDM_MAX_TIDS];
+};
+
+/* Beyond any inbox index, so routing to a TID that is attaching fails */
+#define SHM_TID_CLAIMED 0xff
+
+/*
+ * A bounded multi-producer queue, after Dmitry Vyukov's design. Each slot's
+ * sequence number tells producers and the consumer whose turn it is, so
+ * producers contend only on enqueue_pos. The positions are on separate cache
+ * lines to keep producers and the consumer from contending on them.
+ */
+struct pldm_shm_inbox {
+	uint64_t enqueue_pos;
+	uint8_t pad0[SHM_CACHELINE - sizeof(uint64_t)];
+	uint64_t dequeue_pos;
+	/* Set while the consumer may be waiting on its eventfd */
+	uint32_t armed;
+	uint8_t attached;
+	uint8_t reserved[3];
+	uint8_t pad1[SHM_CACHELINE - 2 * sizeof(uint64_t)];
+};
+
+struct pldm_shm_slot {
+	uint64_t seq;
+	uint32_t len;
+	uint8_t src;
+	uint8_t reserved[3];
+	/* Followed by the message */
+};
+
+struct pldm_transport_shm_region {
+	int memfd;
+	int eventfds[PLDM_TRANSPORT_SHM_MAX_ENDPOINTS];
+	size_t endpoints;
+	void *base;
+	size_t len;
+	struct pldm_shm_header *hdr;
+};
+
+struct pldm_transport_shm {
+	struct pldm_transport transport;
+	struct pldm_transport_shm_region *region;
+	struct pldm_shm_inbox *inbox;
+	int eventfd;
+	pldm_tid_t tid;
+};
+
+#define transport_to_shm(ptr) container_of(ptr, struct pldm_transport_shm, transport)
+
+static int pldm_shm_layout(size_t endpoints, size_t slots, size_t msg_size,
+			   size_t *slot_stride, size_t *inbox_stride,
+			   size_t *len)
+{
+	size_t inboxes;
+	size_t ring;
+
+	*slot_stride = SHM_ALIGN(sizeof(struct pldm_shm_slot) + msg_size);
+	if (__builtin_mul_overflow(*slot_stride, slots, &ring)) {
+		return -EINVAL;
+	}
+
+	*inbox_stride = SHM_ALIGN(sizeof(struct pldm_shm_inbox) + ring);
+	if (__builtin_mul_overflow(*inbox_stride, endpoints, &inboxes)) {
+		return -EINVAL;
+	}
+
+	*len = SHM_ALIGN(sizeof(struct pldm_shm_header)) + inboxes;
+	if (*len > SHM_MAX_REGION_SIZE) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static struct pldm_shm_inbox *
+pldm_shm_inbox(struct pldm_transport_shm_region *region, size_t index)
+{
+	return (struct pldm_shm_inbox *)((uint8_t *)region->base +
+					 SHM_ALIGN(sizeof(*region->hdr)) +
+					 index * region->hdr->inbox_stride);
+}
+
+static struct pldm_shm_slot *
+pldm_shm_slot(struct pldm_transport_shm_region *region,
+	      struct pldm_shm_inbox *inbox, uint64_t pos)
+{
+	uint64_t index = pos & (region->hdr->slots - 1);
+
+	return (struct pldm_shm_slot *)((uint8_t *)(inbox + 1) +
+					index * region->hdr->slot_stride);
+}
+
+static void pldm_shm_inbox_init(struct pldm_transport_shm_region *region,
+				struct pldm_shm_inbox *inbox)
+{
+	uint64_t i;
+
+	memset(inbox, 0, sizeof(*inbox));
+	inbox->armed = 1;
+	for (i = 0; i < region->hdr->slots; i++) {
+		pldm_shm_slot(region, inbox, i)->seq = i;
+	}
+}
+
+static int pldm_shm_enqueue(struct pldm_transport_shm_region *region,
+			    struct pldm_shm_inbox *inbox, pldm_tid_t src,
+			    const void *msg, size_t len)
+{
+	struct pldm_shm_slot *slot;
+	uint64_t pos;
+	uint64_t seq;
+	int64_t dif;
+
+	pos = __atomic_load_n(&inbox->enqueue_pos, __ATOMIC_RELAXED);
+	for (;;) {
+		slot = pldm_shm_slot(region, inbox, pos);
+		seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+		dif = (int64_t)(seq - pos);
+		if (dif == 0) {
+			if (__atomic_compare_exchange_n(
+				    &inbox->enqueue_pos, &pos, pos + 1, true,
+				    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+				break;
+			}
+		} else if (dif < 0) {
+			/* The consumer hasn't freed the slot, so it's full */
+			return -EAGAIN;
+		} else {
+			pos = __atomic_load_n(&inbox->enqueue_pos,
+					      __ATOMIC_RELAXED);
+		}
+	}
+
+	slot->len = len;
+	slot->src = src;
+	memcpy(slot + 1, msg, len);
+	__atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+/* Wake the consumer of an inbox if it may be waiting */
+static void pldm_shm_wake(struct pldm_transport_shm_region *region,
+			  size_t index)
+{
+	struct pldm_shm_inbox *inbox = pldm_shm_inbox(region, index);
+	uint64_t one = 1;
+	ssize_t rc;
+
+	/* Order the publication of the message before the test of armed */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_exchange_n(&inbox->armed, 0, __ATOMIC_SEQ_CST)) {
+		rc = write(region->eventfds[index], &one, sizeof(one));
+		(void)rc;
+	}
+}
+
+static struct pldm_shm_slot *
+pldm_shm_peek(struct pldm_transport_shm_region *region,
+	      struct pldm_shm_inbox *inbox)
+{
+	uint64_t pos = inbox->dequeue_pos;
+	struct pldm_shm_slot *slot = pldm_shm_slot(region, inbox, pos);
+
+	if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + 1) {
+		return NULL;
+	}
+
+	return slot;
+}
+
+static void pldm_shm_release(struct pldm_transport_shm_region *region,
+			     struct pldm_shm_inbox *inbox,
+			     struct pldm_shm_slot *slot)
+{
+	uint64_t pos = inbox->dequeue_pos;
+
+	__atomic_store_n(&slot->seq, pos + region->hdr->slots,
+			 __ATOMIC_RELEASE);
+	inbox->dequeue_pos = pos + 1;
+}
+
+/*
+ * Find the next message for the endpoint. The eventfd stays readable while
+ * the inbox holds messages: it's only drained once the inbox is seen empty,
+ * after which the consumer is armed to be woken by the next producer.
+ */
+static struct pldm_shm_slot *pldm_shm_next(struct pldm_transport_shm *shm)
+{
+	struct pldm_shm_slot *slot;
+	uint64_t count;
+	ssize_t rc;
+
+	slot = pldm_shm_peek(shm->region, shm->inbox);
+	if (slot) {
+		return slot;
+	}
+
+	rc = read(shm->eventfd, &count, sizeof(count));
+	__atomic_store_n(&shm->inbox->armed, 1, __ATOMIC_SEQ_CST);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	slot = pldm_shm_peek(shm->region, shm->inbox);
+	if (slot) {
+		/* A message raced the drain, so restore the readiness */
+		count = 1;
+		rc = write(shm->eventfd, &count, sizeof(count));
+	}
+	(void)rc;
+
+	return slot;
+}
+
+LIBPLDM_ABI_TESTING
+struct pldm_transport *pldm_transport_shm_core(struct pldm_transport_shm *ctx)
+{
+	return &ctx->transport;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_shm_init_pollfd(struct pldm_transport *t,
+				   struct pollfd *pollfd)
+{
+	struct pldm_transport_shm *shm = transport_to_shm(t);
+
+	pollfd->fd = shm->eventfd;
+	pollfd->events = POLLIN;
+	return 0;
+}
+
+/* Read the length of a message once, as any peer can write it. A length
+ * beyond the slot can't be copied */
+static int pldm_shm_slot_len(struct pldm_transport_shm_region *region,
+			     struct pldm_shm_slot *slot, size_t *len)
+{
+	uint32_t slot_len = __atomic_load_n(&slot->len, __ATOMIC_RELAXED);
+
+	if (slot_len > region->hdr->msg_size) {
+		return -EPROTO;
+	}
+
+	*len = slot_len;
+	return 0;
+}
+
+static pldm_requester_rc_t pldm_transport_shm_recv(struct pldm_transport *t,
+						   pldm_tid_t *tid,
+						   void **pldm_msg,
+						   size_t *msg_len)
+{
+	struct pldm_transport_shm *shm = transport_to_shm(t);
+	struct pldm_shm_slot *slot;
+	size_t len;
+	void *msg;
+
+	slot = pldm_shm_next(shm);
+	if (!slot) {
+		return PLDM_REQUESTER_RECV_FAIL;
+	}
+
+	if (pldm_shm_slot_len(shm->region, slot, &len)) {
+		pldm_shm_release(shm->region, shm->inbox, slot);
+		return PLDM_REQUESTER_RECV_FAIL;
+	}
+
+	msg = malloc(len);
+	if (!msg) {
+		/* Leave the message for a later attempt */
+		return PLDM_REQUESTER_RECV_FAIL;
+	}
+
+	memcpy(msg, slot + 1, len);
+	*tid = slot->src;
+	*pldm_msg = msg;
+	*msg_len = len;
+	pldm_shm_release(shm->region, shm->inbox, slot);
+
+	return PLDM_REQUESTER_SUCCESS;
+}
+
+static pldm_requester_rc_t
+pldm_shm_copy(struct pldm_transport_shm *shm, struct pldm_shm_slot *slot,
+	      pldm_tid_t *tid, void *pldm_msg, size_t *msg_len)
+{
+	pldm_requester_rc_t res = PLDM_REQUESTER_SUCCESS;
+	size_t len;
+
+	if (pldm_shm_slot_len(shm->region, slot, &len)) {
+		pldm_shm_release(shm->region, shm->inbox, slot);
+		return PLDM_REQUESTER_RECV_FAIL;
+	}
+
+	if (len > *msg_len) {
+		/* The message is lost, as for a truncated datagram */
+		res = PLDM_REQUESTER_RECV_TRUNCATED;
+	} else {
+		memcpy(pldm_msg, slot + 1, len);
+		*tid = slot->src;
+	}
+	*msg_len = len;
+	pldm_shm_release(shm->region, shm->inbox, slot);
+
+	return res;
+}
+
+static pldm_requester_rc_t
+pldm_transport_shm_recv_into(struct pldm_transport *t, pldm_tid_t *tid,
+			     void *pldm_msg, size_t *msg_len)
+{
+	struct pldm_transport_shm *shm = transport_to_shm(t);
+	struct pldm_shm_slot *slot;
+
+	slot = pldm_shm_next(shm);
+	if (!slot) {
+		return PLDM_REQUESTER_RECV_FAIL;
+	}
+
+	return pldm_shm_copy(shm, slot, tid, pldm_msg, msg_len);
+}
+
+static int pldm_transport_shm_recv_msgs(struct pldm_transport *t,
+					struct pldm_transport_msg *msgs,
+					size_t count)
+{
+	struct pldm_transport_shm *shm = transport_to_shm(t);
+	struct pldm_shm_slot *slot;
+	size_t received;
+
+	for (received = 0; received < count; received++) {
+		struct pldm_transport_msg *m = &msgs[received];
+
+		slot = pldm_shm_next(shm);
+		if (!slot) {
+			break;
+		}
+
+		m->rc = pldm_shm_copy(shm, slot, &m->tid, m->msg, &m->len);
+	}
+
+	return received ? (int)received : PLDM_REQUESTER_RECV_FAIL;
+}
+
+static int pldm_transport_shm_route(struct pldm_transport_shm *shm,
+				    pldm_tid_t tid, size_t len)
+{
+	struct pldm_transport_shm_region *region = shm->region;
+	uint8_t index;
+
+	if (len > region->hdr->msg_size) {
+		return -EMSGSIZE;
+	}
+
+	index = __atomic_load_n(&region->hdr->tid_inbox[tid], __ATOMIC_ACQUIRE);
+	if (!index || index > region->endpoints) {
+		return -ENOENT;
+	}
+
+	return index - 1;
+}
+
+static pldm_requester_rc_t pldm_transport_shm_send(struct pldm_transport *t,
+						   pldm_tid_t tid,
+						   const void *pldm_msg,
+						   size_t msg_len)
+{
+	struct pldm_transport_shm *shm = transport_to_shm(t);
+	int index;
+
+	index = pldm_transport_shm_route(shm, tid, msg_len);
+	if (index < 0) {
+		return PLDM_REQUESTER_SEND_FAIL;
+	}
+
+	if (pldm_shm_enqueue(shm->region, pldm_shm_inbox(shm->region, index),
+			     shm->tid, pldm_msg, msg_len)) {
+		return PLDM_REQUESTER_SEND_FAIL;
+	}
+
+	pldm_shm_wake(shm->region, index);
+
+	return PLDM_REQUESTER_SUCCESS;
+}
+
+static int pldm_transport_shm_send_msgs(struct pldm_transport *t,
+					struct pldm_transport_msg *msgs,
+					size_t count)
+{
+	struct pldm_transport_shm *shm = transport_to_shm(t);
+	uint32_t woken = 0;
+	size_t sent;
+	size_t i;
+	int index;
+
+	/* Wake each destination once for the whole batch */
+	for (sent = 0; sent < count; sent++) {
+		struct pldm_transport_msg *m = &msgs[sent];
+
+		index = pldm_transport_shm_route(shm, m->tid, m->len);
+		if (index < 0 ||
+		    pldm_shm_enqueue(shm->region,
+				     pldm_shm_inbox(shm->region, index),
+				     shm->tid, m->msg, m->len)) {
+			break;
+		}
+
+		m->rc = PLDM_REQUESTER_SUCCESS;
+		woken |= 1U << index;
+	}
+
+	for (i = 0; woken; i++, woken >>= 1) {
+		if (woken & 1) {
+			pldm_shm_wake(shm->region, i);
+		}
+	}
+
+	return sent ? (int)sent : PLDM_REQUESTER_SEND_FAIL;
+}
+
+LIBPLDM_ABI_TESTING
+void pldm_transport_shm_region_destroy(struct pldm_transport_shm_region *region)
+{
+	size_t i;
+
+	if (!region) {
+		return;
+	}
+
+	if (region->base) {
+		munmap(region->base, region->len);
+	}
+
+	for (i = 0; i < region->endpoints; i++) {
+		if (region->eventfds[i] >= 0) {
+			close(region->eventfds[i]);
+		}
+	}
+
+	if (region->memfd >= 0) {
+		close(region->memfd);
+	}
+
+	free(region);
+}
+
+static struct pldm_transport_shm_region *pldm_shm_region_alloc(size_t endpoints)
+{
+	struct pldm_transport_shm_region *region;
+	size_t i;
+
+	region = calloc(1, sizeof(*region));
+	if (!region) {
+		return NULL;
+	}
+
+	region->memfd = -1;
+	region->endpoints = endpoints;
+	for (i = 0; i < endpoints; i++) {
+		region->eventfds[i] = -1;
+	}
+
+	return region;
+}
+
+static int pldm_shm_region_map(struct pldm_transport_shm_region *region)
+{
+	void *base;
+
+	base = mmap(NULL, region->len, PROT_READ | PROT_WRITE, MAP_SHARED,
+		    region->memfd, 0);
+	if (base == MAP_FAILED) {
+		return -errno;
+	}
+
+	region->base = base;
+	region->hdr = base;
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_shm_region_create(struct pldm_transport_shm_region **region,
+				     size_t endpoints, size_t slots,
+				     size_t msg_size)
+{
+	struct pldm_transport_shm_region *shm;
+	size_t inbox_stride;
+	size_t slot_stride;
+	size_t len;
+	size_t i;
+	int rc;
+
+	if (!region || *region) {
+		return -EINVAL;
+	}
+
+	if (!endpoints || endpoints > PLDM_TRANSPORT_SHM_MAX_ENDPOINTS) {
+		return -EINVAL;
+	}
+
+	if (!slots || slots > SHM_MAX_SLOTS || (slots & (slots - 1))) {
+		return -EINVAL;
+	}
+
+	if (msg_size < sizeof(struct pldm_msg_hdr) ||
+	    msg_size > SHM_MAX_MSG_SIZE) {
+		return -EINVAL;
+	}
+
+	rc = pldm_shm_layout(endpoints, slots, msg_size, &slot_stride,
+			     &inbox_stride, &len);
+	if (rc) {
+		return rc;
+	}
+
+	shm = pldm_shm_region_alloc(endpoints);
+	if (!shm) {
+		return -ENOMEM;
+	}
+	shm->len = len;
+
+	shm->memfd = memfd_create("libpldm-shm", MFD_CLOEXEC);
+	if (shm->memfd < 0) {
+		rc = -errno;
+		goto cleanup_region;
+	}
+
+	if (ftruncate(shm->memfd, (off_t)len)) {
+		rc = -errno;
+		goto cleanup_region;
+	}
+
+	for (i = 0; i < endpoints; i++) {
+		shm->eventfds[i] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+		if (shm->eventfds[i] < 0) {
+			rc = -errno;
+			goto cleanup_region;
+		}
+	}
+
+	rc = pldm_shm_region_map(shm);
+	if (rc) {
+		goto cleanup_region;
+	}
+
+	shm->hdr->magic = SHM_MAGIC;
+	shm->hdr->version = SHM_VERSION;
+	shm->hdr->endpoints = endpoints;
+	shm->hdr->slots = slots;
+	shm->hdr->msg_size = msg_size;
+	shm->hdr->slot_stride = slot_stride;
+	shm->hdr->inbox_stride = inbox_stride;
+	for (i = 0; i < endpoints; i++) {
+		pldm_shm_inbox_init(shm, pldm_shm_inbox(shm, i));
+	}
+
+	*region = shm;
+
+	return 0;
+
+cleanup_region:
+	pldm_transport_shm_region_destroy(shm);
+
+	return rc;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_shm_region_open(struct pldm_transport_shm_region **region,
+				   int memfd, const int *eventfds, size_t count)
+{
+	struct pldm_transport_shm_region *shm;
+	struct pldm_shm_header *hdr;
+	size_t inbox_stride;
+	size_t slot_stride;
+	struct stat st;
+	size_t len;
+	size_t i;
+	int rc;
+
+	if (!region || *region || memfd < 0 || !eventfds || !count ||
+	    count > PLDM_TRANSPORT_SHM_MAX_ENDPOINTS) {
+		return -EINVAL;
+	}
+
+	if (fstat(memfd, &st)) {
+		return -errno;
+	}
+
+	if ((size_t)st.st_size < sizeof(*hdr)) {
+		return -EINVAL;
+	}
+
+	shm = pldm_shm_region_alloc(count);
+	if (!shm) {
+		return -ENOMEM;
+	}
+
+	shm->memfd = dup(memfd);
+	if (shm->memfd < 0) {
+		rc = -errno;
+		goto cleanup_region;
+	}
+
+	for (i = 0; i < count; i++) {
+		shm->eventfds[i] = dup(eventfds[i]);
+		if (shm->eventfds[i] < 0) {
+			rc = -errno;
+			goto cleanup_region;
+		}
+	}
+
+	shm->len = st.st_size;
+	rc = pldm_shm_region_map(shm);
+	if (rc) {
+		goto cleanup_region;
+	}
+
+	/* Don't trust the creator's layout beyond what we can validate */
+	hdr = shm->hdr;
+	rc = -EINVAL;
+	if (hdr->magic != SHM_MAGIC || hdr->version != SHM_VERSION ||
+	    hdr->endpoints != count || !hdr->slots ||
+	    (hdr->slots & (hdr->slots - 1)) || hdr->slots > SHM_MAX_SLOTS ||
+	    hdr->msg_size < sizeof(struct pldm_msg_hdr) ||
+	    hdr->msg_size > SHM_MAX_MSG_SIZE) {
+		goto cleanup_region;
+	}
+
+	if (pldm_shm_layout(count, hdr->slots, hdr->msg_size, &slot_stride,
+			    &inbox_stride, &len) ||
+	    slot_stride != hdr->slot_stride ||
+	    inbox_stride != hdr->inbox_stride || len > shm->len) {
+		goto cleanup_region;
+	}
+
+	*region = shm;
+
+	return 0;
+
+cleanup_region:
+	pldm_transport_shm_region_destroy(shm);
+
+	return rc;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_shm_region_fds(struct pldm_transport_shm_region *region,
+				  int *memfd, int *eventfds, size_t count)
+{
+	size_t i;
+
+	if (!region || !memfd || !eventfds || count < region->endpoints) {
+		return -EINVAL;
+	}
+
+	*memfd = region->memfd;
+	for (i = 0; i < region->endpoints; i++) {
+		eventfds[i] = region->eventfds[i];
+	}
+
+	return (int)region->endpoints;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_shm_init(struct pldm_transport_shm **ctx,
+			    struct pldm_transport_shm_region *region,
+			    pldm_tid_t tid)
+{
+	struct pldm_transport_shm *shm;
+	struct pldm_shm_inbox *inbox = NULL;
+	struct pldm_shm_slot *slot;
+	uint8_t expected;
+	uint64_t count;
+	size_t i;
+	ssize_t rc;
+
+	if (!ctx || *ctx || !region) {
+		return -EINVAL;
+	}
+
+	if (tid == 0 || tid == 0xff) {
+		return -EINVAL;
+	}
+
+	shm = calloc(1, sizeof(*shm));
+	if (!shm) {
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < region->endpoints; i++) {
+		expected = 0;
+		inbox = pldm_shm_inbox(region, i);
+		if (__atomic_compare_exchange_n(&inbox->attached, &expected, 1,
+						false, __ATOMIC_ACQ_REL,
+						__ATOMIC_RELAXED)) {
+			break;
+		}
+	}
+
+	if (i == region->endpoints) {
+		free(shm);
+		return -ENOSPC;
+	}
+
+	/* Claim the TID, but don't route to the inbox until it's been reset */
+	expected = 0;
+	if (!__atomic_compare_exchange_n(&region->hdr->tid_inbox[tid],
+					 &expected, SHM_TID_CLAIMED, false,
+					 __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+		__atomic_store_n(&inbox->attached, 0, __ATOMIC_RELEASE);
+		free(shm);
+		return -EEXIST;
+	}
+
+	shm->transport.name = SHM_NAME;
+	shm->transport.version = 1;
+	shm->transport.recv = pldm_transport_shm_recv;
+	shm->transport.recv_into = pldm_transport_shm_recv_into;
+	shm->transport.send = pldm_transport_shm_send;
+	shm->transport.send_msgs = pldm_transport_shm_send_msgs;
+	shm->transport.recv_msgs = pldm_transport_shm_recv_msgs;
+	shm->transport.init_pollfd = pldm_transport_shm_init_pollfd;
+	shm->region = region;
+	shm->inbox = inbox;
+	shm->eventfd = region->eventfds[i];
+	shm->tid = tid;
+
+	/* Discard what was sent to a previous endpoint with the inbox */
+	while ((slot = pldm_shm_peek(region, inbox))) {
+		pldm_shm_release(region, inbox, slot);
+	}
+	rc = read(shm->eventfd, &count, sizeof(count));
+	(void)rc;
+	__atomic_store_n(&inbox->armed, 1, __ATOMIC_SEQ_CST);
+
+	/* Publish the inbox last, so nothing sent to the TID is discarded */
+	__atomic_store_n(&region->hdr->tid_inbox[tid], i + 1, __ATOMIC_RELEASE);
+
+	*ctx = shm;
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+void pldm_transport_shm_destroy(struct pldm_transport_shm *ctx)
+{
+	if (!ctx) {
+		return;
+	}
+
+	pldm_transport_stats_disable(&ctx->transport);
+	pldm_transport_inbox_disable(&ctx->transport);
+	__atomic_store_n(&ctx->region->hdr->tid_inbox[ctx->tid], 0,
+			 __ATOMIC_RELEASE);
+	__atomic_store_n(&ctx->inbox->attached, 0, __ATOMIC_RELEASE);
+	free(ctx);
+}
@@ -1,14 +1,24 @@
 /* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#include "container-of.h"
+#include "mctp-defines.h"
+#include "responder.h"
 #include "socket.h"
+#include "stats.h"
+#include "tid-eid-map.h"
 
 #include <errno.h>
 #include <limits.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <linux/mctp.h>
+#include <string.h>
 #include <sys/socket.h>
 
-int pldm_socket_sndbuf_init(struct pldm_socket_sndbuf *ctx, int socket)
+int pldm_socket_sndbuf_init(struct pldm_socket_sndbuf *ctx,
+			    struct pldm_transport *transport, int socket)
 {
 	FILE *fp;
 	long max_buf_size;
@@ -19,6 +29,7 @@ int pldm_socket_sndbuf_init(struct pldm_socket_sndbuf *ctx, int socket)
 		return -1;
 	}
 	ctx->socket = socket;
+	ctx->transport = transport;
 
 	fp = fopen("/proc/sys/net/core/wmem_max", "r");
 	if (fp == NULL) {
@@ -72,6 +83,7 @@ int pldm_socket_sndbuf_accomodate(struct pldm_socket_sndbuf *ctx, int msg_len)
 		return -1;
 	}
 	ctx->size = msg_len;
+	pldm_transport_stats_record_sndbuf_resize(ctx->transport);
 	return 0;
 }
 
@@ -90,3 +102,254 @@ int pldm_socket_sndbuf_get(struct pldm_socket_sndbuf *ctx)
 	ctx->size = buf_size / 2;
 	return 0;
 }
+
+int pldm_socket_txq_set_depth(struct pldm_socket_txq *ctx, size_t depth)
+{
+	struct pldm_socket_txq_entry *ring = NULL;
+
+	/* Resizing would reorder what's queued */
+	if (ctx->count) {
+		return -EBUSY;
+	}
+
+	if (depth) {
+		ring = calloc(depth, sizeof(*ring));
+		if (!ring) {
+			return -ENOMEM;
+		}
+	}
+
+	free(ctx->ring);
+	ctx->ring = ring;
+	ctx->depth = depth;
+	ctx->head = 0;
+
+	return 0;
+}
+
+void pldm_socket_txq_destroy(struct pldm_socket_txq *ctx)
+{
+	while (ctx->count) {
+		free(ctx->ring[ctx->head].buf);
+		ctx->head = (ctx->head + 1) % ctx->depth;
+		ctx->count--;
+	}
+
+	free(ctx->ring);
+	ctx->ring = NULL;
+	ctx->depth = 0;
+}
+
+static int pldm_socket_txq_push(struct pldm_socket_txq *ctx,
+				const struct msghdr *msg)
+{
+	struct pldm_socket_txq_entry *entry;
+	size_t len = 0;
+	uint8_t *buf;
+	size_t i;
+
+	if (ctx->count == ctx->depth ||
+	    msg->msg_namelen > sizeof(entry->addr)) {
+		return -ENOBUFS;
+	}
+
+	for (i = 0; i < msg->msg_iovlen; i++) {
+		len += msg->msg_iov[i].iov_len;
+	}
+
+	buf = malloc(len);
+	if (!buf) {
+		return -ENOMEM;
+	}
+
+	entry = &ctx->ring[(ctx->head + ctx->count) % ctx->depth];
+	entry->buf = buf;
+	entry->len = len;
+	for (i = 0; i < msg->msg_iovlen; i++) {
+		memcpy(buf, msg->msg_iov[i].iov_base, msg->msg_iov[i].iov_len);
+		buf += msg->msg_iov[i].iov_len;
+	}
+	entry->addrlen = msg->msg_namelen;
+	if (msg->msg_namelen) {
+		memcpy(&entry->addr, msg->msg_name, msg->msg_namelen);
+	}
+	ctx->count++;
+
+	return 0;
+}
+
+static bool pldm_socket_would_block(void)
+{
+	return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+int pldm_socket_txq_flush(struct pldm_socket_txq *ctx, int socket)
+{
+	struct pldm_socket_txq_entry *entry;
+	struct msghdr msg = { 0 };
+	struct iovec iov;
+
+	while (ctx->count) {
+		entry = &ctx->ring[ctx->head];
+		iov.iov_base = entry->buf;
+		iov.iov_len = entry->len;
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_name = entry->addrlen ? &entry->addr : NULL;
+		msg.msg_namelen = entry->addrlen;
+
+		if (sendmsg(socket, &msg, MSG_DONTWAIT) < 0) {
+			if (pldm_socket_would_block()) {
+				break;
+			}
+			/* The message can never be sent, so drop it */
+		}
+
+		free(entry->buf);
+		entry->buf = NULL;
+		ctx->head = (ctx->head + 1) % ctx->depth;
+		ctx->count--;
+	}
+
+	return (int)ctx->count;
+}
+
+pldm_requester_rc_t pldm_socket_txq_send(struct pldm_socket_txq *ctx,
+					 int socket, const struct msghdr *msg)
+{
+	if (!ctx->depth) {
+		return sendmsg(socket, msg, 0) < 0 ? PLDM_REQUESTER_SEND_FAIL :
+						     PLDM_REQUESTER_SUCCESS;
+	}
+
+	/* Messages must not overtake those already queued */
+	if (!ctx->count || !pldm_socket_txq_flush(ctx, socket)) {
+		if (sendmsg(socket, msg, MSG_DONTWAIT) >= 0) {
+			return PLDM_REQUESTER_SUCCESS;
+		}
+
+		if (!pldm_socket_would_block()) {
+			return PLDM_REQUESTER_SEND_FAIL;
+		}
+	}
+
+	return pldm_socket_txq_push(ctx, msg) ? PLDM_REQUESTER_SEND_FAIL :
+						PLDM_REQUESTER_SUCCESS;
+}
+
+#define cookie_to_mctp(c)                                                      \
+	container_of((c), struct pldm_socket_mctp_cookie, req)
+
+void pldm_socket_mctp_responder_init(struct pldm_socket_mctp_responder *ctx)
+{
+	size_t i;
+
+	pldm_responder_cookie_jar_init(&ctx->jar);
+	for (i = 0; i < PLDM_SOCKET_MCTP_COOKIES; i++) {
+		pldm_responder_cookie_put(&ctx->jar, &ctx->pool[i].req);
+	}
+}
+
+pldm_requester_rc_t
+pldm_socket_mctp_accept(struct pldm_socket_mctp_responder *ctx,
+			const struct pldm_tid_eid_map *map, bool track,
+			const struct sockaddr_mctp *addr,
+			const struct pldm_msg_hdr *hdr, pldm_tid_t *tid)
+{
+	struct pldm_socket_mctp_cookie *cookie;
+	struct pldm_responder_cookie *req;
+	int rc;
+
+	rc = pldm_tid_eid_map_get_tid(map, addr->smctp_network,
+				      addr->smctp_addr.s_addr, tid);
+	if (rc) {
+		return PLDM_REQUESTER_RECV_FAIL;
+	}
+
+	if (!(track && hdr->request)) {
+		return PLDM_REQUESTER_SUCCESS;
+	}
+
+	/*
+	 * A requester reusing an instance ID has abandoned its earlier
+	 * request, so the earlier request's cookie is recycled
+	 */
+	req = pldm_responder_cookie_untrack(&ctx->jar, *tid, hdr->instance_id,
+					    hdr->type, hdr->command);
+	if (!req) {
+		req = pldm_responder_cookie_get(&ctx->jar);
+	}
+	if (!req) {
+		return PLDM_REQUESTER_RECV_FAIL;
+	}
+
+	cookie = cookie_to_mctp(req);
+	cookie->req.tid = *tid;
+	cookie->req.instance_id = hdr->instance_id;
+	cookie->req.type = hdr->type;
+	cookie->req.command = hdr->command;
+	cookie->smctp = *addr;
+
+	rc = pldm_responder_cookie_track(&ctx->jar, &cookie->req);
+	if (rc) {
+		pldm_responder_cookie_put(&ctx->jar, &cookie->req);
+		return PLDM_REQUESTER_RECV_FAIL;
+	}
+
+	return PLDM_REQUESTER_SUCCESS;
+}
+
+pldm_requester_rc_t
+pldm_socket_mctp_route(struct pldm_socket_mctp_responder *ctx,
+		       const struct pldm_tid_eid_map *map, bool respond,
+		       pldm_tid_t tid, const struct pldm_msg_hdr *hdr,
+		       struct sockaddr_mctp *addr,
+		       struct pldm_socket_mctp_cookie **cookie)
+{
+	struct pldm_responder_cookie *req;
+	mctp_eid_t eid = 0;
+	uint32_t net = 0;
+
+	*cookie = NULL;
+	memset(addr, 0, sizeof(*addr));
+
+	if (respond && !hdr->request) {
+		req = pldm_responder_cookie_untrack(&ctx->jar, tid,
+						    hdr->instance_id, hdr->type,
+						    hdr->command);
+		if (!req) {
+			return PLDM_REQUESTER_SEND_FAIL;
+		}
+
+		*cookie = cookie_to_mctp(req);
+		*addr = (*cookie)->smctp;
+		/* Clear the TO to indicate a response */
+		addr->smctp_tag &= ~MCTP_TAG_OWNER;
+
+		return PLDM_REQUESTER_SUCCESS;
+	}
+
+	if (pldm_tid_eid_map_get_eid(map, tid, &net, &eid)) {
+		return PLDM_REQUESTER_SEND_FAIL;
+	}
+
+	addr->smctp_family = AF_MCTP;
+	addr->smctp_network = net;
+	addr->smctp_addr.s_addr = eid;
+	addr->smctp_type = MCTP_MSG_TYPE_PLDM;
+	addr->smctp_tag = MCTP_TAG_OWNER;
+
+	return PLDM_REQUESTER_SUCCESS;
+}
+
+void pldm_socket_mctp_sent(struct pldm_socket_mctp_responder *ctx,
+			   struct pldm_socket_mctp_cookie *cookie, bool sent)
+{
+	if (!cookie) {
+		return;
+	}
+
+	if (sent || pldm_responder_cookie_track(&ctx->jar, &cookie->req)) {
+		pldm_responder_cookie_put(&ctx->jar, &cookie->req);
+	}
+}
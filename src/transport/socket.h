@@ -2,14 +2,105 @@
 #ifndef LIBPLDM_SRC_TRANSPORT_SOCKET_H
 #define LIBPLDM_SRC_TRANSPORT_SOCKET_H
 
+#include "responder.h"
+#include "tid-eid-map.h"
+
+#include <libpldm/base.h>
+#include <libpldm/pldm.h>
+
+#include <linux/mctp.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/socket.h>
+
+struct pldm_transport;
+
 struct pldm_socket_sndbuf {
 	int size;
 	int socket;
 	int max_size;
+	/* Credited with resizes of the buffer in its statistics */
+	struct pldm_transport *transport;
 };
 
-int pldm_socket_sndbuf_init(struct pldm_socket_sndbuf *ctx, int socket);
+int pldm_socket_sndbuf_init(struct pldm_socket_sndbuf *ctx,
+			    struct pldm_transport *transport, int socket);
 int pldm_socket_sndbuf_accomodate(struct pldm_socket_sndbuf *ctx, int msg_len);
 int pldm_socket_sndbuf_get(struct pldm_socket_sndbuf *ctx);
 
+struct pldm_socket_txq_entry {
+	void *buf;
+	size_t len;
+	struct sockaddr_storage addr;
+	socklen_t addrlen;
+};
+
+/*
+ * Messages the socket couldn't accept without blocking, oldest first. Sends
+ * block while depth is zero
+ */
+struct pldm_socket_txq {
+	struct pldm_socket_txq_entry *ring;
+	size_t depth;
+	size_t head;
+	size_t count;
+};
+
+int pldm_socket_txq_set_depth(struct pldm_socket_txq *ctx, size_t depth);
+void pldm_socket_txq_destroy(struct pldm_socket_txq *ctx);
+pldm_requester_rc_t pldm_socket_txq_send(struct pldm_socket_txq *ctx,
+					 int socket, const struct msghdr *msg);
+int pldm_socket_txq_flush(struct pldm_socket_txq *ctx, int socket);
+
+/* Requests awaiting a response, across all requesters */
+#define PLDM_SOCKET_MCTP_COOKIES 256
+
+/* A request received over AF_MCTP, with the address to respond to */
+struct pldm_socket_mctp_cookie {
+	struct pldm_responder_cookie req;
+	struct sockaddr_mctp smctp;
+};
+
+/*
+ * Requests received over an AF_MCTP socket, tracked so their responses can be
+ * sent back to the requester's address and tag. Unused cookies are held by the
+ * jar. When none remain, the oldest unanswered request gives up its cookie.
+ */
+struct pldm_socket_mctp_responder {
+	struct pldm_responder_cookie_jar jar;
+	struct pldm_socket_mctp_cookie pool[PLDM_SOCKET_MCTP_COOKIES];
+};
+
+void pldm_socket_mctp_responder_init(struct pldm_socket_mctp_responder *ctx);
+
+/*
+ * Resolve the source TID of a received message. If track is set, requests are
+ * tracked so the response can be routed back to their source address.
+ */
+pldm_requester_rc_t
+pldm_socket_mctp_accept(struct pldm_socket_mctp_responder *ctx,
+			const struct pldm_tid_eid_map *map, bool track,
+			const struct sockaddr_mctp *addr,
+			const struct pldm_msg_hdr *hdr, pldm_tid_t *tid);
+
+/*
+ * Resolve the destination address of a message. If responding, responses
+ * claim the cookie of their request, which must be passed to
+ * pldm_socket_mctp_sent().
+ */
+pldm_requester_rc_t
+pldm_socket_mctp_route(struct pldm_socket_mctp_responder *ctx,
+		       const struct pldm_tid_eid_map *map, bool respond,
+		       pldm_tid_t tid, const struct pldm_msg_hdr *hdr,
+		       struct sockaddr_mctp *addr,
+		       struct pldm_socket_mctp_cookie **cookie);
+
+/*
+ * Release the cookie claimed by a response once it's sent. Otherwise the
+ * request is tracked again, so the caller can retry the response. cookie may
+ * be NULL.
+ */
+void pldm_socket_mctp_sent(struct pldm_socket_mctp_responder *ctx,
+			   struct pldm_socket_mctp_cookie *cookie, bool sent);
+
 #endif // LIBPLDM_SRC_TRANSPORT_SOCKET_H
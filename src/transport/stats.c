@@ -0,0 +1,326 @@
+/* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#include "compiler.h"
+#include "stats.h"
+#include "transport.h"
+
+#include <libpldm/base.h>
+#include <libpldm/transport.h>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LATENCY_SUB_BUCKETS (1U << PLDM_TRANSPORT_LATENCY_SUB_BITS)
+#define LATENCY_LIMIT_US    (UINT64_C(1) << PLDM_TRANSPORT_LATENCY_MAX_BITS)
+
+static uint64_t pldm_transport_stats_now_us(void)
+{
+	struct timespec now;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &now)) {
+		return 0;
+	}
+
+	return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+}
+
+static size_t pldm_transport_latency_bucket(uint64_t us)
+{
+	unsigned int msb;
+
+	if (us >= LATENCY_LIMIT_US) {
+		return PLDM_TRANSPORT_LATENCY_BUCKETS - 1;
+	}
+
+	if (us < LATENCY_SUB_BUCKETS) {
+		return us;
+	}
+
+	/* The octave of the value, then its linear position within it */
+	msb = 63 - __builtin_clzll(us);
+	return ((msb - PLDM_TRANSPORT_LATENCY_SUB_BITS + 1)
+		<< PLDM_TRANSPORT_LATENCY_SUB_BITS) +
+	       ((us >> (msb - PLDM_TRANSPORT_LATENCY_SUB_BITS)) &
+		(LATENCY_SUB_BUCKETS - 1));
+}
+
+LIBPLDM_ABI_TESTING
+uint64_t pldm_transport_latency_bucket_floor(size_t bucket)
+{
+	size_t octave = bucket >> PLDM_TRANSPORT_LATENCY_SUB_BITS;
+	size_t sub = bucket & (LATENCY_SUB_BUCKETS - 1);
+
+	if (bucket >= PLDM_TRANSPORT_LATENCY_BUCKETS) {
+		return LATENCY_LIMIT_US;
+	}
+
+	if (!octave) {
+		return bucket;
+	}
+
+	return (uint64_t)(LATENCY_SUB_BUCKETS + sub) << (octave - 1);
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_latency_percentile(
+	const struct pldm_transport_latency *latency, unsigned int percentile,
+	uint64_t *us)
+{
+	uint64_t target;
+	uint64_t seen = 0;
+	uint64_t bound;
+	size_t i;
+
+	if (!latency || !us || percentile > 100) {
+		return -EINVAL;
+	}
+
+	if (!latency->count) {
+		return -ENODATA;
+	}
+
+	/* The rank of the percentile, rounded up so it's at least 1 */
+	target = (latency->count * percentile + 99) / 100;
+	if (!target) {
+		target = 1;
+	}
+
+	for (i = 0; i < PLDM_TRANSPORT_LATENCY_BUCKETS; i++) {
+		seen += latency->buckets[i];
+		if (seen >= target) {
+			break;
+		}
+	}
+
+	bound = i + 1 < PLDM_TRANSPORT_LATENCY_BUCKETS ?
+			pldm_transport_latency_bucket_floor(i + 1) - 1 :
+			latency->max_us;
+	*us = bound < latency->max_us ? bound : latency->max_us;
+
+	return 0;
+}
+
+static uint32_t pldm_transport_stats_key(pldm_tid_t tid, uint8_t type,
+					 uint8_t command)
+{
+	/* The marker bit keeps keys non-zero, as zero marks an empty slot */
+	return 1U << 24 | (uint32_t)tid << 16 | (uint32_t)type << 8 | command;
+}
+
+static struct pldm_transport_stats_slot *
+pldm_transport_stats_find(struct pldm_transport_stats *stats, uint32_t key)
+{
+	size_t mask = PLDM_TRANSPORT_STATS_LATENCY_SLOTS - 1;
+	size_t i = (key * 2654435761U) >> 24;
+	size_t probes;
+
+	for (probes = 0; probes < PLDM_TRANSPORT_STATS_LATENCY_SLOTS; probes++) {
+		struct pldm_transport_stats_slot *slot =
+			&stats->slots[(i + probes) & mask];
+
+		if (slot->key == key || !slot->key) {
+			return slot;
+		}
+	}
+
+	return NULL;
+}
+
+static void pldm_transport_stats_latency(struct pldm_transport_stats *stats,
+					 pldm_tid_t tid, uint8_t type,
+					 uint8_t command, uint64_t us)
+{
+	uint32_t key = pldm_transport_stats_key(tid, type, command);
+	struct pldm_transport_stats_slot *slot;
+	struct pldm_transport_latency *latency;
+
+	slot = pldm_transport_stats_find(stats, key);
+	if (!slot) {
+		return;
+	}
+
+	if (!slot->key) {
+		slot->latency = calloc(1, sizeof(*slot->latency));
+		if (!slot->latency) {
+			return;
+		}
+		slot->key = key;
+		slot->latency->min_us = UINT64_MAX;
+	}
+
+	latency = slot->latency;
+	latency->count++;
+	latency->total_us += us;
+	if (us < latency->min_us) {
+		latency->min_us = us;
+	}
+	if (us > latency->max_us) {
+		latency->max_us = us;
+	}
+	latency->buckets[pldm_transport_latency_bucket(us)]++;
+}
+
+void pldm_transport_stats_sent(struct pldm_transport_stats *stats,
+			       pldm_tid_t tid, const void *msg, size_t len)
+{
+	const struct pldm_msg_hdr *hdr = msg;
+	struct pldm_transport_stats_tid *peer;
+
+	stats->counters.tx_msgs++;
+	stats->counters.tx_bytes += len;
+
+	if (!hdr->request || hdr->datagram) {
+		return;
+	}
+
+	peer = stats->tids[tid];
+	if (!peer) {
+		peer = calloc(1, sizeof(*peer));
+		if (!peer) {
+			return;
+		}
+		stats->tids[tid] = peer;
+	}
+
+	/* A retried request restarts the measurement */
+	peer->pending |= 1U << hdr->instance_id;
+	peer->type[hdr->instance_id] = hdr->type;
+	peer->command[hdr->instance_id] = hdr->command;
+	peer->sent_us[hdr->instance_id] = pldm_transport_stats_now_us();
+}
+
+void pldm_transport_stats_received(struct pldm_transport_stats *stats,
+				   pldm_tid_t tid, const void *msg, size_t len)
+{
+	const struct pldm_msg_hdr *hdr = msg;
+	struct pldm_transport_stats_tid *peer;
+	uint8_t iid;
+	uint64_t now;
+
+	stats->counters.rx_msgs++;
+	stats->counters.rx_bytes += len;
+
+	if (hdr->request || hdr->datagram) {
+		return;
+	}
+
+	peer = stats->tids[tid];
+	iid = hdr->instance_id;
+	if (!peer || !(peer->pending & (1U << iid)) ||
+	    peer->type[iid] != hdr->type || peer->command[iid] != hdr->command) {
+		return;
+	}
+
+	peer->pending &= ~(1U << iid);
+	now = pldm_transport_stats_now_us();
+	pldm_transport_stats_latency(stats, tid, hdr->type, hdr->command,
+				     now > peer->sent_us[iid] ?
+					     now - peer->sent_us[iid] :
+					     0);
+}
+
+static void pldm_transport_stats_release(struct pldm_transport_stats *stats)
+{
+	size_t i;
+
+	for (i = 0; i < PLDM_MAX_TIDS; i++) {
+		free(stats->tids[i]);
+	}
+
+	for (i = 0; i < PLDM_TRANSPORT_STATS_LATENCY_SLOTS; i++) {
+		free(stats->slots[i].latency);
+	}
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_stats_enable(struct pldm_transport *transport)
+{
+	if (!transport) {
+		return -EINVAL;
+	}
+
+	if (transport->stats) {
+		return 0;
+	}
+
+	transport->stats = calloc(1, sizeof(*transport->stats));
+	if (!transport->stats) {
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+void pldm_transport_stats_disable(struct pldm_transport *transport)
+{
+	if (!transport || !transport->stats) {
+		return;
+	}
+
+	pldm_transport_stats_release(transport->stats);
+	free(transport->stats);
+	transport->stats = NULL;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_stats_reset(struct pldm_transport *transport)
+{
+	if (!transport) {
+		return -EINVAL;
+	}
+
+	if (!transport->stats) {
+		return -ENODATA;
+	}
+
+	pldm_transport_stats_release(transport->stats);
+	memset(transport->stats, 0, sizeof(*transport->stats));
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_stats_get_counters(struct pldm_transport *transport,
+				      struct pldm_transport_counters *counters)
+{
+	if (!transport || !counters) {
+		return -EINVAL;
+	}
+
+	if (!transport->stats) {
+		return -ENODATA;
+	}
+
+	*counters = transport->stats->counters;
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_stats_get_latency(struct pldm_transport *transport,
+				     pldm_tid_t tid, uint8_t type,
+				     uint8_t command,
+				     struct pldm_transport_latency *latency)
+{
+	struct pldm_transport_stats_slot *slot;
+
+	if (!transport || !latency) {
+		return -EINVAL;
+	}
+
+	if (!transport->stats) {
+		return -ENODATA;
+	}
+
+	slot = pldm_transport_stats_find(
+		transport->stats, pldm_transport_stats_key(tid, type, command));
+	if (!slot || !slot->key) {
+		return -ENOENT;
+	}
+
+	*latency = *slot->latency;
+
+	return 0;
+}
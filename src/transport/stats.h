@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#ifndef LIBPLDM_SRC_TRANSPORT_STATS_H
+#define LIBPLDM_SRC_TRANSPORT_STATS_H
+
+#include "transport.h"
+
+#include <libpldm/base.h>
+#include <libpldm/transport.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Distinct (TID, type, command) latency histograms kept per transport */
+#define PLDM_TRANSPORT_STATS_LATENCY_SLOTS 256
+
+/* Requests to a TID awaiting a response, indexed by instance ID */
+struct pldm_transport_stats_tid {
+	uint32_t pending;
+	uint8_t type[PLDM_INSTANCE_MAX + 1];
+	uint8_t command[PLDM_INSTANCE_MAX + 1];
+	uint64_t sent_us[PLDM_INSTANCE_MAX + 1];
+};
+
+struct pldm_transport_stats_slot {
+	/* Zero for an empty slot */
+	uint32_t key;
+	struct pldm_transport_latency *latency;
+};
+
+struct pldm_transport_stats {
+	struct pldm_transport_counters counters;
+	/* Allocated on the first request to each TID */
+	struct pldm_transport_stats_tid *tids[PLDM_MAX_TIDS];
+	struct pldm_transport_stats_slot slots[PLDM_TRANSPORT_STATS_LATENCY_SLOTS];
+};
+
+void pldm_transport_stats_sent(struct pldm_transport_stats *stats,
+			       pldm_tid_t tid, const void *msg, size_t len);
+void pldm_transport_stats_received(struct pldm_transport_stats *stats,
+				   pldm_tid_t tid, const void *msg, size_t len);
+
+/*
+ * The hooks below are called from the transport paths, so they are inline to
+ * reduce collection to a test of the stats pointer while it is disabled
+ */
+
+static inline void pldm_transport_stats_record_send(struct pldm_transport *t,
+						    pldm_tid_t tid,
+						    const void *msg, size_t len)
+{
+	if (t->stats) {
+		pldm_transport_stats_sent(t->stats, tid, msg, len);
+	}
+}
+
+static inline void
+pldm_transport_stats_record_send_error(struct pldm_transport *t)
+{
+	if (t->stats) {
+		t->stats->counters.tx_errors++;
+	}
+}
+
+static inline void pldm_transport_stats_record_recv(struct pldm_transport *t,
+						    pldm_tid_t tid,
+						    const void *msg, size_t len)
+{
+	if (t->stats) {
+		pldm_transport_stats_received(t->stats, tid, msg, len);
+	}
+}
+
+static inline void pldm_transport_stats_record_drop(struct pldm_transport *t,
+						    pldm_requester_rc_t rc)
+{
+	/* Misuse of the API doesn't consume a message */
+	if (t->stats && rc != PLDM_REQUESTER_INVALID_SETUP) {
+		t->stats->counters.rx_drops++;
+	}
+}
+
+static inline void pldm_transport_stats_record_discard(struct pldm_transport *t)
+{
+	if (t->stats) {
+		t->stats->counters.rx_discarded++;
+	}
+}
+
+static inline void pldm_transport_stats_record_queued(struct pldm_transport *t)
+{
+	if (t->stats) {
+		t->stats->counters.rx_queued++;
+	}
+}
+
+static inline void pldm_transport_stats_record_timeout(struct pldm_transport *t)
+{
+	if (t->stats) {
+		t->stats->counters.timeouts++;
+	}
+}
+
+static inline void
+pldm_transport_stats_record_sndbuf_resize(struct pldm_transport *t)
+{
+	if (t && t->stats) {
+		t->stats->counters.sndbuf_resizes++;
+	}
+}
+
+#endif // LIBPLDM_SRC_TRANSPORT_STATS_H
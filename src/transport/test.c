@@ -185,8 +185,13 @@ int pldm_transport_test_init(struct pldm_transport_test **ctx,
 	test->transport.name = "TEST";
 	test->transport.version = 1;
 	test->transport.recv = pldm_transport_test_recv;
+	test->transport.recv_into = NULL;
 	test->transport.send = pldm_transport_test_send;
+	test->transport.send_msgs = NULL;
+	test->transport.recv_msgs = NULL;
 	test->transport.init_pollfd = pldm_transport_test_init_pollfd;
+	test->transport.stats = NULL;
+	test->transport.inbox = NULL;
 	test->seq = seq;
 	test->count = count;
 	test->cursor = 0;
@@ -208,6 +213,8 @@ cleanup_test:
 LIBPLDM_ABI_TESTING
 void pldm_transport_test_destroy(struct pldm_transport_test *ctx)
 {
+	pldm_transport_stats_disable(&ctx->transport);
+	pldm_transport_inbox_disable(&ctx->transport);
 	close(ctx->timerfd);
 	free(ctx);
 }
@@ -0,0 +1,155 @@
+/* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#include "tid-eid-map.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#define SLOT_MASK (PLDM_TID_EID_MAP_SLOTS - 1)
+
+static size_t tid_eid_map_hash(uint32_t net, mctp_eid_t eid)
+{
+	/* EIDs on one network never collide */
+	return (eid ^ ((net * 2654435761U) >> 23)) & SLOT_MASK;
+}
+
+static bool tid_eid_map_find(const struct pldm_tid_eid_map *map, uint32_t net,
+			     mctp_eid_t eid, size_t *slot)
+{
+	const struct pldm_tid_eid_map_endpoint *ep;
+	size_t i = tid_eid_map_hash(net, eid);
+	pldm_tid_t tid;
+
+	/* At most half of the slots are in use, so an empty slot exists */
+	while ((tid = map->slots[i])) {
+		ep = &map->tids[tid];
+		if (ep->net == net && ep->eid == eid) {
+			*slot = i;
+			return true;
+		}
+		i = (i + 1) & SLOT_MASK;
+	}
+
+	*slot = i;
+	return false;
+}
+
+/* Remove the slot's entry, shifting back any entries probed past it */
+static void tid_eid_map_clear_slot(struct pldm_tid_eid_map *map, size_t hole)
+{
+	const struct pldm_tid_eid_map_endpoint *ep;
+	size_t i = hole;
+	size_t home;
+
+	for (;;) {
+		i = (i + 1) & SLOT_MASK;
+		if (!map->slots[i]) {
+			break;
+		}
+
+		ep = &map->tids[map->slots[i]];
+		home = tid_eid_map_hash(ep->net, ep->eid);
+
+		/* Leave the entry if its home lies cyclically in (hole, i] */
+		if (hole <= i ? (home > hole && home <= i) :
+				(home > hole || home <= i)) {
+			continue;
+		}
+
+		map->slots[hole] = map->slots[i];
+		hole = i;
+	}
+
+	map->slots[hole] = 0;
+}
+
+static void tid_eid_map_unmap(struct pldm_tid_eid_map *map, pldm_tid_t tid)
+{
+	struct pldm_tid_eid_map_endpoint *ep = &map->tids[tid];
+	size_t slot;
+
+	if (!ep->mapped) {
+		return;
+	}
+
+	if (tid_eid_map_find(map, ep->net, ep->eid, &slot)) {
+		tid_eid_map_clear_slot(map, slot);
+	}
+
+	ep->mapped = false;
+}
+
+void pldm_tid_eid_map_init(struct pldm_tid_eid_map *map)
+{
+	memset(map, 0, sizeof(*map));
+}
+
+int pldm_tid_eid_map_insert(struct pldm_tid_eid_map *map, pldm_tid_t tid,
+			    uint32_t net, mctp_eid_t eid)
+{
+	struct pldm_tid_eid_map_endpoint *ep;
+	size_t slot;
+
+	if (!tid) {
+		return -EINVAL;
+	}
+
+	tid_eid_map_unmap(map, tid);
+
+	if (tid_eid_map_find(map, net, eid, &slot)) {
+		map->tids[map->slots[slot]].mapped = false;
+	}
+
+	ep = &map->tids[tid];
+	ep->net = net;
+	ep->eid = eid;
+	ep->mapped = true;
+	map->slots[slot] = tid;
+
+	return 0;
+}
+
+int pldm_tid_eid_map_remove(struct pldm_tid_eid_map *map, pldm_tid_t tid,
+			    mctp_eid_t eid)
+{
+	const struct pldm_tid_eid_map_endpoint *ep = &map->tids[tid];
+
+	if (!ep->mapped || ep->eid != eid) {
+		return -ENOENT;
+	}
+
+	tid_eid_map_unmap(map, tid);
+
+	return 0;
+}
+
+int pldm_tid_eid_map_get_eid(const struct pldm_tid_eid_map *map,
+			     pldm_tid_t tid, uint32_t *net, mctp_eid_t *eid)
+{
+	const struct pldm_tid_eid_map_endpoint *ep = &map->tids[tid];
+
+	if (!ep->mapped) {
+		return -ENOENT;
+	}
+
+	*net = ep->net;
+	*eid = ep->eid;
+
+	return 0;
+}
+
+int pldm_tid_eid_map_get_tid(const struct pldm_tid_eid_map *map, uint32_t net,
+			     mctp_eid_t eid, pldm_tid_t *tid)
+{
+	size_t slot;
+
+	if (tid_eid_map_find(map, net, eid, &slot) ||
+	    (net != PLDM_TID_EID_MAP_NET_ANY &&
+	     tid_eid_map_find(map, PLDM_TID_EID_MAP_NET_ANY, eid, &slot))) {
+		*tid = map->slots[slot];
+		return 0;
+	}
+
+	return -ENOENT;
+}
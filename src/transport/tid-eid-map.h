@@ -0,0 +1,55 @@
+/* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#ifndef LIBPLDM_SRC_TRANSPORT_TID_EID_MAP_H
+#define LIBPLDM_SRC_TRANSPORT_TID_EID_MAP_H
+
+#include "mctp-defines.h"
+
+#include <libpldm/base.h>
+#include <libpldm/pldm.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Matches MCTP_NET_ANY from linux/mctp.h */
+#define PLDM_TID_EID_MAP_NET_ANY 0
+
+#define PLDM_TID_EID_MAP_TIDS  256
+#define PLDM_TID_EID_MAP_SLOTS 512
+
+struct pldm_tid_eid_map_endpoint {
+	uint32_t net;
+	mctp_eid_t eid;
+	bool mapped;
+};
+
+/*
+ * A one-to-one mapping between TIDs and MCTP endpoints, where an endpoint is
+ * identified by its network and EID.
+ *
+ * TIDs index the endpoint table directly. Endpoints are found through an open
+ * addressing hash table whose slots hold the TID mapped to the endpoint, so
+ * both directions are O(1). TID 0 is never mapped and marks an empty slot.
+ */
+struct pldm_tid_eid_map {
+	struct pldm_tid_eid_map_endpoint tids[PLDM_TID_EID_MAP_TIDS];
+	pldm_tid_t slots[PLDM_TID_EID_MAP_SLOTS];
+};
+
+void pldm_tid_eid_map_init(struct pldm_tid_eid_map *map);
+
+/* Replaces any existing mapping of either the TID or the endpoint */
+int pldm_tid_eid_map_insert(struct pldm_tid_eid_map *map, pldm_tid_t tid,
+			    uint32_t net, mctp_eid_t eid);
+
+/* Removes the mapping if the TID is mapped to the EID */
+int pldm_tid_eid_map_remove(struct pldm_tid_eid_map *map, pldm_tid_t tid,
+			    mctp_eid_t eid);
+
+int pldm_tid_eid_map_get_eid(const struct pldm_tid_eid_map *map,
+			     pldm_tid_t tid, uint32_t *net, mctp_eid_t *eid);
+
+/* Falls back to mappings on PLDM_TID_EID_MAP_NET_ANY if net has no mapping */
+int pldm_tid_eid_map_get_tid(const struct pldm_tid_eid_map *map, uint32_t net,
+			     mctp_eid_t eid, pldm_tid_t *tid);
+
+#endif
@@ -1,5 +1,7 @@
 /* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
 #include "compiler.h"
+#include "inbox.h"
+#include "stats.h"
 #include "transport.h"
 
 #include <libpldm/transport.h>
@@ -12,7 +14,9 @@
 #include <poll.h>
 #endif
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/time.h>
 #include <time.h>
 #include <unistd.h>
@@ -24,6 +28,8 @@ struct pollfd {
 	short revents; /* returned events */
 };
 
+#define POLLOUT 0x004
+
 static inline int poll(struct pollfd *fds LIBPLDM_CC_UNUSED,
 		       int nfds LIBPLDM_CC_UNUSED,
 		       int timeout LIBPLDM_CC_UNUSED)
@@ -32,10 +38,23 @@ static inline int poll(struct pollfd *fds LIBPLDM_CC_UNUSED,
 }
 #endif
 
+static int64_t pldm_transport_now_ms(void)
+{
+	struct timespec now;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &now) < 0) {
+		return -1;
+	}
+
+	return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
 LIBPLDM_ABI_STABLE
 int pldm_transport_poll(struct pldm_transport *transport, int timeout)
 {
 	struct pollfd pollfd;
+	int64_t deadline = 0;
+	int64_t now;
 	int rc = 0;
 	if (!transport) {
 		return PLDM_REQUESTER_INVALID_SETUP;
@@ -46,20 +65,67 @@ int pldm_transport_poll(struct pldm_transport *transport, int timeout)
 		return 1;
 	}
 
-	rc = transport->init_pollfd(transport, &pollfd);
-	if (rc < 0) {
-		return PLDM_REQUESTER_POLL_FAIL;
+	if (timeout > 0 && transport->flush) {
+		deadline = pldm_transport_now_ms();
+		if (deadline < 0) {
+			return PLDM_REQUESTER_POLL_FAIL;
+		}
+		deadline += timeout;
 	}
 
-	rc = poll(&pollfd, 1, timeout);
-	if (rc < 0) {
-		return PLDM_REQUESTER_POLL_FAIL;
+	for (;;) {
+		rc = transport->init_pollfd(transport, &pollfd);
+		if (rc < 0) {
+			return PLDM_REQUESTER_POLL_FAIL;
+		}
+
+		rc = poll(&pollfd, 1, timeout);
+		if (rc < 0) {
+			return PLDM_REQUESTER_POLL_FAIL;
+		}
+
+		if (!rc || !(pollfd.revents & POLLOUT) || !transport->flush) {
+			break;
+		}
+
+		transport->flush(transport);
+		if (pollfd.revents & ~POLLOUT) {
+			break;
+		}
+
+		/* Only queued messages could make progress, so keep waiting */
+		if (timeout > 0) {
+			now = pldm_transport_now_ms();
+			if (now < 0) {
+				return PLDM_REQUESTER_POLL_FAIL;
+			}
+			if (now >= deadline) {
+				return 0;
+			}
+			timeout = (int)(deadline - now);
+		} else if (!timeout) {
+			return 0;
+		}
 	}
 
 	/* rc is 0 if poll(2) times out, or 1 if pollfd becomes active. */
 	return rc;
 }
 
+LIBPLDM_ABI_TESTING
+int pldm_transport_flush(struct pldm_transport *transport)
+{
+	if (!transport) {
+		return PLDM_REQUESTER_INVALID_SETUP;
+	}
+
+	if (!transport->flush) {
+		return 0;
+	}
+
+	return transport->flush(transport);
+}
+
 LIBPLDM_ABI_STABLE
 pldm_requester_rc_t pldm_transport_send_msg(struct pldm_transport *transport,
 					    pldm_tid_t tid,
@@ -74,7 +140,35 @@ pldm_requester_rc_t pldm_transport_send_msg(struct pldm_transport *transport,
 		return PLDM_REQUESTER_NOT_REQ_MSG;
 	}
 
-	return transport->send(transport, tid, pldm_msg, msg_len);
+	pldm_requester_rc_t rc =
+		transport->send(transport, tid, pldm_msg, msg_len);
+	if (rc == PLDM_REQUESTER_SUCCESS) {
+		pldm_transport_stats_record_send(transport, tid, pldm_msg,
+						 msg_len);
+	} else {
+		pldm_transport_stats_record_send_error(transport);
+	}
+
+	return rc;
+}
+
+static pldm_requester_rc_t
+pldm_transport_recv_msg_unrecorded(struct pldm_transport *transport,
+				   pldm_tid_t *tid, void **pldm_msg,
+				   size_t *msg_len)
+{
+	pldm_requester_rc_t rc =
+		transport->recv(transport, tid, pldm_msg, msg_len);
+	if (rc != PLDM_REQUESTER_SUCCESS) {
+		return rc;
+	}
+
+	if (*msg_len < sizeof(struct pldm_msg_hdr)) {
+		free(*pldm_msg);
+		*pldm_msg = NULL;
+		return PLDM_REQUESTER_INVALID_RECV_LEN;
+	}
+	return PLDM_REQUESTER_SUCCESS;
 }
 
 LIBPLDM_ABI_STABLE
@@ -86,18 +180,193 @@ pldm_requester_rc_t pldm_transport_recv_msg(struct pldm_transport *transport,
 		return PLDM_REQUESTER_INVALID_SETUP;
 	}
 
-	pldm_requester_rc_t rc =
-		transport->recv(transport, tid, pldm_msg, msg_len);
+	pldm_requester_rc_t rc = pldm_transport_recv_msg_unrecorded(
+		transport, tid, pldm_msg, msg_len);
+	if (rc == PLDM_REQUESTER_SUCCESS) {
+		pldm_transport_stats_record_recv(transport, *tid, *pldm_msg,
+						 *msg_len);
+	} else {
+		pldm_transport_stats_record_drop(transport, rc);
+	}
+
+	return rc;
+}
+
+static pldm_requester_rc_t
+pldm_transport_recv_msg_into_unrecorded(struct pldm_transport *transport,
+					pldm_tid_t *tid, void *pldm_msg,
+					size_t *msg_len)
+{
+	pldm_requester_rc_t rc;
+	size_t buf_len;
+	size_t len;
+	void *msg;
+
+	if (transport->recv_into) {
+		return transport->recv_into(transport, tid, pldm_msg, msg_len);
+	}
+
+	buf_len = *msg_len;
+	rc = pldm_transport_recv_msg_unrecorded(transport, tid, &msg, &len);
 	if (rc != PLDM_REQUESTER_SUCCESS) {
 		return rc;
 	}
 
+	memcpy(pldm_msg, msg, len < buf_len ? len : buf_len);
+	free(msg);
+	*msg_len = len;
+
+	return len > buf_len ? PLDM_REQUESTER_RECV_TRUNCATED :
+			       PLDM_REQUESTER_SUCCESS;
+}
+
+LIBPLDM_ABI_TESTING
+pldm_requester_rc_t
+pldm_transport_recv_msg_into(struct pldm_transport *transport, pldm_tid_t *tid,
+			     void *pldm_msg, size_t *msg_len)
+{
+	pldm_requester_rc_t rc;
+
+	if (!transport || !tid || !pldm_msg || !msg_len) {
+		return PLDM_REQUESTER_INVALID_SETUP;
+	}
+
 	if (*msg_len < sizeof(struct pldm_msg_hdr)) {
-		free(*pldm_msg);
-		*pldm_msg = NULL;
-		return PLDM_REQUESTER_INVALID_RECV_LEN;
+		return PLDM_REQUESTER_INVALID_SETUP;
 	}
-	return PLDM_REQUESTER_SUCCESS;
+
+	rc = pldm_transport_recv_msg_into_unrecorded(transport, tid, pldm_msg,
+						     msg_len);
+	if (rc == PLDM_REQUESTER_SUCCESS) {
+		pldm_transport_stats_record_recv(transport, *tid, pldm_msg,
+						 *msg_len);
+	} else {
+		pldm_transport_stats_record_drop(transport, rc);
+	}
+
+	return rc;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_send_msgs(struct pldm_transport *transport,
+			     struct pldm_transport_msg *msgs, size_t count)
+{
+	pldm_requester_rc_t rc;
+	size_t i;
+
+	if (!transport || (count && !msgs)) {
+		return PLDM_REQUESTER_INVALID_SETUP;
+	}
+
+	if (count > INT_MAX) {
+		count = INT_MAX;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (!msgs[i].msg || msgs[i].len < sizeof(struct pldm_msg_hdr)) {
+			return PLDM_REQUESTER_INVALID_SETUP;
+		}
+	}
+
+	if (!count) {
+		return 0;
+	}
+
+	if (transport->send_msgs) {
+		int sent = transport->send_msgs(transport, msgs, count);
+
+		for (i = 0; sent > 0 && i < (size_t)sent; i++) {
+			pldm_transport_stats_record_send(transport, msgs[i].tid,
+							 msgs[i].msg,
+							 msgs[i].len);
+		}
+		if (sent < (int)count) {
+			pldm_transport_stats_record_send_error(transport);
+		}
+
+		return sent;
+	}
+
+	for (i = 0; i < count; i++) {
+		rc = transport->send(transport, msgs[i].tid, msgs[i].msg,
+				     msgs[i].len);
+		if (rc != PLDM_REQUESTER_SUCCESS) {
+			pldm_transport_stats_record_send_error(transport);
+			return i ? (int)i : rc;
+		}
+		pldm_transport_stats_record_send(transport, msgs[i].tid,
+						 msgs[i].msg, msgs[i].len);
+		msgs[i].rc = PLDM_REQUESTER_SUCCESS;
+	}
+
+	return (int)i;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_transport_recv_msgs(struct pldm_transport *transport,
+			     struct pldm_transport_msg *msgs, size_t count)
+{
+	pldm_requester_rc_t rc;
+	size_t i;
+
+	if (!transport || (count && !msgs)) {
+		return PLDM_REQUESTER_INVALID_SETUP;
+	}
+
+	if (count > INT_MAX) {
+		count = INT_MAX;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (!msgs[i].msg || msgs[i].len < sizeof(struct pldm_msg_hdr)) {
+			return PLDM_REQUESTER_INVALID_SETUP;
+		}
+	}
+
+	if (!count) {
+		return 0;
+	}
+
+	if (transport->recv_msgs) {
+		int received = transport->recv_msgs(transport, msgs, count);
+
+		if (received < 0) {
+			pldm_transport_stats_record_drop(transport, received);
+		}
+		for (i = 0; received > 0 && i < (size_t)received; i++) {
+			if (msgs[i].rc != PLDM_REQUESTER_SUCCESS) {
+				pldm_transport_stats_record_drop(transport,
+								 msgs[i].rc);
+				continue;
+			}
+			pldm_transport_stats_record_recv(transport, msgs[i].tid,
+							 msgs[i].msg,
+							 msgs[i].len);
+		}
+
+		return received;
+	}
+
+	for (i = 0; i < count; i++) {
+		/* Only the first receive may wait for a message */
+		if (i && pldm_transport_poll(transport, 0) <= 0) {
+			break;
+		}
+
+		rc = pldm_transport_recv_msg_into(transport, &msgs[i].tid,
+						  msgs[i].msg, &msgs[i].len);
+		/*
+		 * We can't tell whether a receive failure consumed a message,
+		 * so end the batch there
+		 */
+		if (rc == PLDM_REQUESTER_RECV_FAIL ||
+		    rc == PLDM_REQUESTER_INVALID_SETUP) {
+			return i ? (int)i : rc;
+		}
+		msgs[i].rc = rc;
+	}
+
+	return (int)i;
 }
 
 static void timespec_to_timeval(const struct timespec *ts, struct timeval *tv)
@@ -143,6 +412,19 @@ static int clock_gettimeval(clockid_t clockid, struct timeval *tv)
 	return 0;
 }
 
+/* Keep a message that doesn't respond to the request for its eventual reader */
+static void pldm_transport_set_aside(struct pldm_transport *transport,
+				     pldm_tid_t tid, void *msg, size_t len)
+{
+	if (pldm_transport_inbox_put(transport, tid, msg, len)) {
+		pldm_transport_stats_record_queued(transport);
+		return;
+	}
+
+	pldm_transport_stats_record_discard(transport);
+	free(msg);
+}
+
 LIBPLDM_ABI_STABLE
 pldm_requester_rc_t
 pldm_transport_send_recv_msg(struct pldm_transport *transport, pldm_tid_t tid,
@@ -184,7 +466,8 @@ pldm_transport_send_recv_msg(struct pldm_transport *transport, pldm_tid_t tid,
 					     resp_msg_len);
 		if (rc == PLDM_REQUESTER_SUCCESS) {
 			/* This isn't the message we wanted */
-			free(*pldm_resp_msg);
+			pldm_transport_set_aside(transport, l_tid,
+						 *pldm_resp_msg, *resp_msg_len);
 		}
 	}
 	if (cnt == (PLDM_INSTANCE_MAX + 1) * PLDM_MAX_TIDS) {
@@ -214,7 +497,10 @@ pldm_transport_send_recv_msg(struct pldm_transport *transport, pldm_tid_t tid,
 		/* 0 <= `timeval_to_msec()` <= 4800, and 4800 < INT_MAX */
 		ret = pldm_transport_poll(transport,
 					  (int)(timeval_to_msec(&remaining)));
-		if (ret <= 0) {
+		if (ret == 0) {
+			break;
+		}
+		if (ret < 0) {
 			return PLDM_REQUESTER_RECV_FAIL;
 		}
 
@@ -231,12 +517,15 @@ pldm_transport_send_recv_msg(struct pldm_transport *transport, pldm_tid_t tid,
 
 		if (src_tid != tid || !pldm_msg_hdr_correlate_response(
 					      pldm_req_msg, *pldm_resp_msg)) {
-			free(*pldm_resp_msg);
+			pldm_transport_set_aside(transport, src_tid,
+						 *pldm_resp_msg, *resp_msg_len);
 			continue;
 		}
 
 		return PLDM_REQUESTER_SUCCESS;
 	}
 
+	pldm_transport_stats_record_timeout(transport);
+
 	return PLDM_REQUESTER_RECV_FAIL;
 }
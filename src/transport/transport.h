@@ -4,6 +4,9 @@
 
 #include <libpldm/base.h>
 #include <libpldm/pldm.h>
+#include <libpldm/transport.h>
+struct pldm_transport_inbox;
+struct pldm_transport_stats;
 struct pollfd;
 
 /**
@@ -12,8 +15,25 @@ struct pollfd;
  * @var name - name of the transport
  * @var version - version of transport to use
  * @var recv - pointer to the transport specific function to receive a message
+ * @var recv_into - pointer to the transport specific function to receive a
+ *		    message into a caller-provided buffer. Optional, emulated
+ *		    with recv if NULL
  * @var send - pointer to the transport specific function to send a message
+ * @var send_msgs - pointer to the transport specific function to send a batch
+ *		    of messages. Optional, emulated with send if NULL
+ * @var recv_msgs - pointer to the transport specific function to receive a
+ *		    batch of messages. Optional, emulated with recv_into or
+ *		    recv if NULL
  * @var init_pollfd - pointer to the transport specific init_pollfd function
+ * @var flush - pointer to the transport specific function to send queued
+ *		messages, returning the number still queued. Optional, for
+ *		transports whose pollfd may request POLLOUT
+ * @var stats - statistics collected by the generic transport layer, or NULL
+ *		if collection is disabled. Must be NULL on initialisation, and
+ *		released by pldm_transport_stats_disable() on destruction
+ * @var inbox - messages set aside by pldm_transport_send_recv_msg(), or NULL if
+ *		inboxes are disabled. Must be NULL on initialisation, and
+ *		released by pldm_transport_inbox_disable() on destruction
  */
 struct pldm_transport {
 	const char *name;
@@ -21,11 +41,21 @@ struct pldm_transport {
 	pldm_requester_rc_t (*recv)(struct pldm_transport *transport,
 				    pldm_tid_t *tid, void **pldm_resp_msg,
 				    size_t *msg_len);
+	pldm_requester_rc_t (*recv_into)(struct pldm_transport *transport,
+					 pldm_tid_t *tid, void *pldm_msg,
+					 size_t *msg_len);
 	pldm_requester_rc_t (*send)(struct pldm_transport *transport,
 				    pldm_tid_t tid, const void *pldm_msg,
 				    size_t msg_len);
+	int (*send_msgs)(struct pldm_transport *transport,
+			 struct pldm_transport_msg *msgs, size_t count);
+	int (*recv_msgs)(struct pldm_transport *transport,
+			 struct pldm_transport_msg *msgs, size_t count);
 	int (*init_pollfd)(struct pldm_transport *transport,
 			   struct pollfd *pollfd);
+	int (*flush)(struct pldm_transport *transport);
+	struct pldm_transport_stats *stats;
+	struct pldm_transport_inbox *inbox;
 };
 
 #endif // LIBPLDM_SRC_TRANSPORT_TRANSPORT_H
@@ -0,0 +1,1210 @@
+/* SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later */
+#include <assert.h>
+#include <endian.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libpldm/pldm.h>
+#include <libpldm/firmware_update.h>
+#include <libpldm/firmware_ua.h>
+#include <libpldm/utils.h>
+#include <compiler.h>
+
+#include "api.h"
+
+typedef uint64_t pldm_ua_time_t;
+
+/* Idle timeout for an FD, 120 seconds to match the FD's own FD_T1 */
+static const pldm_ua_time_t DEFAULT_UA_IDLE_TIMEOUT = 120000;
+
+/* Retry time for requests to an FD, 1 second */
+static const pldm_ua_time_t DEFAULT_UA_RETRY_TIME = 1000;
+
+static const uint32_t DEFAULT_UA_TRANSFER_SIZE = 512;
+
+/* Firmware data is served without per-request state, so the FD may keep
+ * any number of requests outstanding */
+static const uint8_t UA_MAX_OUTSTANDING_TRANSFER_REQ = UINT8_MAX;
+
+static const uint8_t INSTANCE_ID_COUNT = 32;
+
+/* Package header format revision without downstream device records */
+static const uint8_t PACKAGE_HEADER_FORMAT_V1 = 0x01;
+
+static const size_t PACKAGE_CHECKSUM_SIZE = 4;
+
+struct pldm_ua_package_record {
+	struct pldm_firmware_device_id_record info;
+	struct variable_field applicable_components;
+	struct variable_field image_set_version;
+	struct variable_field descriptors;
+};
+
+struct pldm_ua_package_component {
+	struct pldm_component_image_information info;
+	struct variable_field version;
+	const uint8_t *image;
+};
+
+struct pldm_ua_package {
+	uint8_t record_count;
+	struct pldm_ua_package_record *records;
+	uint16_t component_count;
+	struct pldm_ua_package_component *components;
+};
+
+struct pldm_ua_dev {
+	enum pldm_ua_dev_state {
+		// Slot is unused
+		PLDM_UA_DEV_UNUSED = 0,
+		// UA-driven states, sending the request for the state
+		PLDM_UA_DEV_REQUEST_UPDATE,
+		PLDM_UA_DEV_PASS_COMPONENT,
+		PLDM_UA_DEV_UPDATE_COMPONENT,
+		PLDM_UA_DEV_ACTIVATE,
+		PLDM_UA_DEV_CANCEL,
+		// FD-driven states, waiting for the FD's request
+		PLDM_UA_DEV_DOWNLOAD,
+		PLDM_UA_DEV_VERIFY,
+		PLDM_UA_DEV_APPLY,
+	} state;
+
+	pldm_tid_t address;
+	const struct pldm_ua_package *pkg;
+	const struct pldm_ua_package_record *record;
+	uint32_t transfer_size;
+
+	/* Package index of the component being passed or updated */
+	uint16_t comp;
+	/* Whether the FD accepted a component for update */
+	bool updated;
+
+	/* The request for the current UA-driven state */
+	bool sent;
+	bool retried;
+	uint8_t instance_id;
+	pldm_ua_time_t sent_time;
+
+	/* The last completion request from the FD, acknowledged again if the
+	 * FD retries it */
+	bool fd_req_valid;
+	uint8_t fd_req_instance_id;
+	uint8_t fd_req_command;
+
+	/* Time of the last message from the FD */
+	pldm_ua_time_t activity_time;
+
+	/* Reported by update_complete once a CancelUpdate completes */
+	int result;
+};
+
+struct pldm_ua {
+	const struct pldm_ua_ops *ops;
+	void *ops_ctx;
+
+	uint32_t transfer_size;
+	pldm_ua_time_t retry_time;
+	pldm_ua_time_t idle_timeout;
+
+	/* Device to consider first in the next pldm_ua_progress() */
+	size_t next;
+	size_t max_devices;
+	struct pldm_ua_dev devs[];
+};
+
+LIBPLDM_CC_NONNULL
+static int pldm_ua_package_parse(struct pldm_ua_package *pkg,
+				 const uint8_t *data, size_t len)
+{
+	struct pldm_package_header_information hdr;
+	struct variable_field version;
+	size_t header_end;
+	uint32_t checksum;
+	size_t pos;
+	uint8_t rc;
+	size_t i;
+
+	rc = decode_pldm_package_header_info(data, len, &hdr, &version);
+	if (rc) {
+		return rc == PLDM_ERROR_INVALID_LENGTH ? -EOVERFLOW : -EBADMSG;
+	}
+
+	if (hdr.package_header_format_version != PACKAGE_HEADER_FORMAT_V1) {
+		return -ENOTSUP;
+	}
+
+	if (hdr.package_header_size > len) {
+		return -EOVERFLOW;
+	}
+
+	if (hdr.package_header_size < PACKAGE_CHECKSUM_SIZE) {
+		return -EBADMSG;
+	}
+	header_end = hdr.package_header_size - PACKAGE_CHECKSUM_SIZE;
+
+	memcpy(&checksum, &data[header_end], sizeof(checksum));
+	if (le32toh(checksum) != pldm_edac_crc32(data, header_end)) {
+		return -EBADMSG;
+	}
+
+	pos = sizeof(hdr) + version.length;
+	if (pos >= header_end) {
+		return -EBADMSG;
+	}
+
+	pkg->record_count = data[pos++];
+	pkg->records = calloc(pkg->record_count, sizeof(*pkg->records));
+	if (pkg->record_count && !pkg->records) {
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < pkg->record_count; i++) {
+		struct pldm_ua_package_record *record = &pkg->records[i];
+		struct variable_field pkg_data;
+
+		rc = decode_firmware_device_id_record(
+			&data[pos], header_end - pos,
+			hdr.component_bitmap_bit_length, &record->info,
+			&record->applicable_components,
+			&record->image_set_version, &record->descriptors,
+			&pkg_data);
+		if (rc) {
+			return -EBADMSG;
+		}
+		pos += record->info.record_length;
+	}
+
+	if (header_end - pos < sizeof(pkg->component_count)) {
+		return -EBADMSG;
+	}
+	pkg->component_count = data[pos] | (data[pos + 1] << 8);
+	pos += sizeof(pkg->component_count);
+
+	pkg->components =
+		calloc(pkg->component_count, sizeof(*pkg->components));
+	if (pkg->component_count && !pkg->components) {
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < pkg->component_count; i++) {
+		struct pldm_ua_package_component *comp = &pkg->components[i];
+
+		rc = decode_pldm_comp_image_info(&data[pos], header_end - pos,
+						 &comp->info, &comp->version);
+		if (rc) {
+			return -EBADMSG;
+		}
+		pos += sizeof(comp->info) + comp->version.length;
+
+		if (comp->info.comp_location_offset > len ||
+		    comp->info.comp_size >
+			    len - comp->info.comp_location_offset) {
+			return -EOVERFLOW;
+		}
+		comp->image = &data[comp->info.comp_location_offset];
+	}
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_ua_package_init(struct pldm_ua_package **pkg, const void *data,
+			 size_t len)
+{
+	struct pldm_ua_package *package;
+	int rc;
+
+	if (pkg == NULL || data == NULL) {
+		return -EINVAL;
+	}
+
+	package = calloc(1, sizeof(*package));
+	if (!package) {
+		return -ENOMEM;
+	}
+
+	rc = pldm_ua_package_parse(package, data, len);
+	if (rc) {
+		pldm_ua_package_destroy(package);
+		return rc;
+	}
+
+	*pkg = package;
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+void pldm_ua_package_destroy(struct pldm_ua_package *pkg)
+{
+	if (!pkg) {
+		return;
+	}
+
+	free(pkg->records);
+	free(pkg->components);
+	free(pkg);
+}
+
+/* Whether the device has a descriptor of the given type and value */
+LIBPLDM_CC_NONNULL
+static bool
+pldm_ua_descriptor_present(const struct pldm_descriptor *descriptors,
+			   size_t count, uint16_t type,
+			   const struct variable_field *value)
+{
+	size_t i;
+
+	for (i = 0; i < count; i++) {
+		if (descriptors[i].descriptor_type == type &&
+		    descriptors[i].descriptor_length == value->length &&
+		    !memcmp(descriptors[i].descriptor_data, value->ptr,
+			    value->length)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+LIBPLDM_CC_NONNULL
+static bool
+pldm_ua_record_matches(const struct pldm_ua_package_record *record,
+		       const struct pldm_descriptor *descriptors, size_t count)
+{
+	const uint8_t *data = record->descriptors.ptr;
+	size_t remaining = record->descriptors.length;
+	size_t i;
+
+	for (i = 0; i < record->info.descriptor_count; i++) {
+		struct variable_field value;
+		uint16_t type;
+		size_t tlv_len;
+
+		if (decode_descriptor_type_length_value(data, remaining, &type,
+							&value)) {
+			return false;
+		}
+
+		if (!pldm_ua_descriptor_present(descriptors, count, type,
+						&value)) {
+			return false;
+		}
+
+		tlv_len = sizeof(type) + sizeof(uint16_t) + value.length;
+		data += tlv_len;
+		remaining -= tlv_len;
+	}
+
+	return true;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_ua_package_match(const struct pldm_ua_package *pkg,
+			  const struct pldm_descriptor *descriptors,
+			  size_t count, size_t *record)
+{
+	size_t i;
+
+	if (pkg == NULL || (descriptors == NULL && count) || record == NULL) {
+		return -EINVAL;
+	}
+
+	for (i = 0; i < pkg->record_count; i++) {
+		if (pldm_ua_record_matches(&pkg->records[i], descriptors,
+					   count)) {
+			*record = i;
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
+
+LIBPLDM_CC_NONNULL
+static pldm_ua_time_t pldm_ua_now(struct pldm_ua *ua)
+{
+	return ua->ops->now(ua->ops_ctx);
+}
+
+/* Whether component comp applies to the device */
+LIBPLDM_CC_NONNULL
+static bool pldm_ua_dev_applicable(const struct pldm_ua_dev *dev,
+				   uint16_t comp)
+{
+	const struct variable_field *bitmap =
+		&dev->record->applicable_components;
+
+	if (comp >= dev->pkg->component_count || comp / 8 >= bitmap->length) {
+		return false;
+	}
+
+	return bitmap->ptr[comp / 8] & (1 << (comp % 8));
+}
+
+/* Find the first applicable component at or after comp, returning the
+ * component count if there is none */
+LIBPLDM_CC_NONNULL
+static uint16_t pldm_ua_dev_next_comp(const struct pldm_ua_dev *dev,
+				      uint16_t comp)
+{
+	while (comp < dev->pkg->component_count &&
+	       !pldm_ua_dev_applicable(dev, comp)) {
+		comp++;
+	}
+
+	return comp;
+}
+
+LIBPLDM_CC_NONNULL
+static uint16_t pldm_ua_dev_comp_count(const struct pldm_ua_dev *dev)
+{
+	uint16_t count = 0;
+	uint16_t i;
+
+	for (i = 0; i < dev->pkg->component_count; i++) {
+		count += pldm_ua_dev_applicable(dev, i);
+	}
+
+	return count;
+}
+
+LIBPLDM_CC_NONNULL
+static struct pldm_ua_dev *pldm_ua_dev_by_address(struct pldm_ua *ua,
+						  pldm_tid_t address)
+{
+	size_t i;
+
+	for (i = 0; i < ua->max_devices; i++) {
+		if (ua->devs[i].state != PLDM_UA_DEV_UNUSED &&
+		    ua->devs[i].address == address) {
+			return &ua->devs[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Move to a UA-driven state, whose request is sent next */
+LIBPLDM_CC_NONNULL
+static void pldm_ua_dev_set_state(struct pldm_ua_dev *dev,
+				  enum pldm_ua_dev_state state)
+{
+	dev->state = state;
+	dev->sent = false;
+	dev->retried = false;
+}
+
+LIBPLDM_CC_NONNULL
+static void pldm_ua_dev_finish(struct pldm_ua *ua, struct pldm_ua_dev *dev,
+			       int result)
+{
+	pldm_tid_t address = dev->address;
+
+	memset(dev, 0x0, sizeof(*dev));
+	ua->ops->update_complete(ua->ops_ctx, address, result);
+}
+
+/* End the update with a CancelUpdate, reporting result once the FD has
+ * answered it */
+LIBPLDM_CC_NONNULL
+static void pldm_ua_dev_fail(struct pldm_ua_dev *dev, int result)
+{
+	dev->result = result;
+	pldm_ua_dev_set_state(dev, PLDM_UA_DEV_CANCEL);
+}
+
+/* Move on to the next applicable component after an UpdateComponent was
+ * declined or a component was applied */
+LIBPLDM_CC_NONNULL
+static void pldm_ua_dev_next_update(struct pldm_ua_dev *dev)
+{
+	dev->comp = pldm_ua_dev_next_comp(dev, dev->comp + 1);
+	if (dev->comp < dev->pkg->component_count) {
+		pldm_ua_dev_set_state(dev, PLDM_UA_DEV_UPDATE_COMPONENT);
+	} else if (dev->updated) {
+		pldm_ua_dev_set_state(dev, PLDM_UA_DEV_ACTIVATE);
+	} else {
+		pldm_ua_dev_fail(dev, -EALREADY);
+	}
+}
+
+LIBPLDM_ABI_TESTING
+struct pldm_ua *pldm_ua_new(const struct pldm_ua_ops *ops, void *ops_ctx,
+			    size_t max_devices)
+{
+	struct pldm_ua *ua;
+
+	if (ops == NULL || ops->update_complete == NULL || ops->now == NULL ||
+	    max_devices == 0) {
+		return NULL;
+	}
+
+	if (max_devices >
+	    (SIZE_MAX - sizeof(*ua)) / sizeof(struct pldm_ua_dev)) {
+		return NULL;
+	}
+
+	ua = calloc(1, sizeof(*ua) + max_devices * sizeof(struct pldm_ua_dev));
+	if (!ua) {
+		return NULL;
+	}
+
+	ua->ops = ops;
+	ua->ops_ctx = ops_ctx;
+	ua->transfer_size = DEFAULT_UA_TRANSFER_SIZE;
+	ua->retry_time = DEFAULT_UA_RETRY_TIME;
+	ua->idle_timeout = DEFAULT_UA_IDLE_TIMEOUT;
+	ua->max_devices = max_devices;
+
+	return ua;
+}
+
+LIBPLDM_ABI_TESTING
+void pldm_ua_destroy(struct pldm_ua *ua)
+{
+	free(ua);
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_ua_start(struct pldm_ua *ua, pldm_tid_t address,
+		  const struct pldm_ua_package *pkg, size_t record)
+{
+	struct pldm_ua_dev *dev = NULL;
+	size_t i;
+
+	if (ua == NULL || pkg == NULL || record >= pkg->record_count) {
+		return -EINVAL;
+	}
+
+	if (pldm_ua_dev_by_address(ua, address)) {
+		return -EBUSY;
+	}
+
+	for (i = 0; i < ua->max_devices; i++) {
+		if (ua->devs[i].state == PLDM_UA_DEV_UNUSED) {
+			dev = &ua->devs[i];
+			break;
+		}
+	}
+
+	if (!dev) {
+		return -ENOSPC;
+	}
+
+	memset(dev, 0x0, sizeof(*dev));
+	dev->address = address;
+	dev->pkg = pkg;
+	dev->record = &pkg->records[record];
+	dev->transfer_size = ua->transfer_size;
+	dev->activity_time = pldm_ua_now(ua);
+	dev->comp = pldm_ua_dev_next_comp(dev, 0);
+	if (dev->comp == pkg->component_count) {
+		/* Nothing applies to the device */
+		return -EINVAL;
+	}
+	pldm_ua_dev_set_state(dev, PLDM_UA_DEV_REQUEST_UPDATE);
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_ua_cancel(struct pldm_ua *ua, pldm_tid_t address)
+{
+	struct pldm_ua_dev *dev;
+
+	if (ua == NULL) {
+		return -EINVAL;
+	}
+
+	dev = pldm_ua_dev_by_address(ua, address);
+	if (!dev) {
+		return -ENOENT;
+	}
+
+	if (dev->state == PLDM_UA_DEV_REQUEST_UPDATE && !dev->sent) {
+		/* The FD hasn't heard of the update */
+		pldm_ua_dev_finish(ua, dev, -ECANCELED);
+		return 0;
+	}
+
+	pldm_ua_dev_fail(dev, -ECANCELED);
+	return 0;
+}
+
+LIBPLDM_CC_NONNULL
+static int pldm_ua_reply_cc(uint8_t ccode, const struct pldm_header_info *hdr,
+			    struct pldm_msg *resp, size_t *resp_payload_len)
+{
+	/* 1 byte completion code */
+	if (*resp_payload_len < 1) {
+		return -EOVERFLOW;
+	}
+	*resp_payload_len = 1;
+
+	if (encode_cc_only_resp(hdr->instance, PLDM_FWUP, hdr->command, ccode,
+				resp) != PLDM_SUCCESS) {
+		return -EINVAL;
+	}
+	return 0;
+}
+
+LIBPLDM_CC_NONNULL
+static int pldm_ua_fwdata(struct pldm_ua_dev *dev,
+			  const struct pldm_header_info *hdr,
+			  const struct pldm_msg *req, size_t req_payload_len,
+			  struct pldm_msg *resp, size_t *resp_payload_len)
+{
+	const struct pldm_ua_package_component *comp;
+	uint32_t offset;
+	uint32_t length;
+	uint32_t avail;
+
+	if (dev->state != PLDM_UA_DEV_DOWNLOAD) {
+		return pldm_ua_reply_cc(PLDM_FWUP_COMMAND_NOT_EXPECTED, hdr,
+					resp, resp_payload_len);
+	}
+
+	if (decode_request_firmware_data_req(req, req_payload_len, &offset,
+					     &length)) {
+		return pldm_ua_reply_cc(PLDM_ERROR_INVALID_LENGTH, hdr, resp,
+					resp_payload_len);
+	}
+
+	if (length == 0 || length > dev->transfer_size) {
+		return pldm_ua_reply_cc(PLDM_FWUP_INVALID_TRANSFER_LENGTH, hdr,
+					resp, resp_payload_len);
+	}
+
+	comp = &dev->pkg->components[dev->comp];
+	if (offset >= comp->info.comp_size) {
+		return pldm_ua_reply_cc(PLDM_FWUP_DATA_OUT_OF_RANGE, hdr, resp,
+					resp_payload_len);
+	}
+
+	if (*resp_payload_len < 1 + (size_t)length) {
+		return -EOVERFLOW;
+	}
+
+	if (encode_request_firmware_data_resp(hdr->instance, PLDM_SUCCESS,
+					      resp, 1 + length)) {
+		return -EINVAL;
+	}
+
+	/* FDs reading in fixed-size blocks may overrun the end of the image,
+	 * which is padded with zeros */
+	avail = comp->info.comp_size - offset;
+	if (avail > length) {
+		avail = length;
+	}
+	memcpy(&resp->payload[1], &comp->image[offset], avail);
+	memset(&resp->payload[1 + avail], 0x0, length - avail);
+	*resp_payload_len = 1 + length;
+
+	return 0;
+}
+
+/* Whether the result of a TransferComplete, VerifyComplete or ApplyComplete
+ * request reports success */
+static bool pldm_ua_fd_result_success(uint8_t command, uint8_t result)
+{
+	switch (command) {
+	case PLDM_TRANSFER_COMPLETE:
+		return result == PLDM_FWUP_TRANSFER_SUCCESS;
+	case PLDM_VERIFY_COMPLETE:
+		return result == PLDM_FWUP_VERIFY_SUCCESS;
+	case PLDM_APPLY_COMPLETE:
+		return result == PLDM_FWUP_APPLY_SUCCESS ||
+		       result == PLDM_FWUP_APPLY_SUCCESS_WITH_ACTIVATION_METHOD;
+	default:
+		return false;
+	}
+}
+
+/* Handle TransferComplete, VerifyComplete or ApplyComplete */
+LIBPLDM_CC_NONNULL
+static int pldm_ua_fd_complete(struct pldm_ua_dev *dev,
+			       const struct pldm_header_info *hdr,
+			       const struct pldm_msg *req,
+			       size_t req_payload_len, struct pldm_msg *resp,
+			       size_t *resp_payload_len)
+{
+	enum pldm_ua_dev_state expected;
+	bitfield16_t activation;
+	uint8_t result;
+	uint8_t rc;
+	int ret;
+
+	if (dev->fd_req_valid && dev->fd_req_command == hdr->command &&
+	    dev->fd_req_instance_id == hdr->instance) {
+		/* The FD didn't receive our response, acknowledge it again */
+		return pldm_ua_reply_cc(PLDM_SUCCESS, hdr, resp,
+					resp_payload_len);
+	}
+
+	switch (hdr->command) {
+	case PLDM_TRANSFER_COMPLETE:
+		expected = PLDM_UA_DEV_DOWNLOAD;
+		rc = decode_transfer_complete_req(req, req_payload_len,
+						  &result);
+		break;
+	case PLDM_VERIFY_COMPLETE:
+		expected = PLDM_UA_DEV_VERIFY;
+		rc = decode_verify_complete_req(req, req_payload_len, &result);
+		break;
+	case PLDM_APPLY_COMPLETE:
+		expected = PLDM_UA_DEV_APPLY;
+		rc = decode_apply_complete_req(req, req_payload_len, &result,
+					       &activation);
+		break;
+	default:
+		assert(false);
+		return -EINVAL;
+	}
+
+	if (dev->state != expected) {
+		return pldm_ua_reply_cc(PLDM_FWUP_COMMAND_NOT_EXPECTED, hdr,
+					resp, resp_payload_len);
+	}
+
+	if (rc) {
+		return pldm_ua_reply_cc(rc, hdr, resp, resp_payload_len);
+	}
+
+	ret = pldm_ua_reply_cc(PLDM_SUCCESS, hdr, resp, resp_payload_len);
+	if (ret) {
+		return ret;
+	}
+
+	dev->fd_req_valid = true;
+	dev->fd_req_command = hdr->command;
+	dev->fd_req_instance_id = hdr->instance;
+
+	if (!pldm_ua_fd_result_success(hdr->command, result)) {
+		pldm_ua_dev_fail(dev, -EIO);
+		return 0;
+	}
+
+	switch (dev->state) {
+	case PLDM_UA_DEV_DOWNLOAD:
+		dev->state = PLDM_UA_DEV_VERIFY;
+		break;
+	case PLDM_UA_DEV_VERIFY:
+		dev->state = PLDM_UA_DEV_APPLY;
+		break;
+	default:
+		dev->updated = true;
+		pldm_ua_dev_next_update(dev);
+		break;
+	}
+
+	return 0;
+}
+
+LIBPLDM_CC_NONNULL_ARGS(1, 3, 4, 6, 7)
+static int pldm_ua_handle_req(struct pldm_ua *ua, struct pldm_ua_dev *dev,
+			      const struct pldm_header_info *hdr,
+			      const struct pldm_msg *req,
+			      size_t req_payload_len, struct pldm_msg *resp,
+			      size_t *resp_payload_len)
+{
+	switch (hdr->command) {
+	case PLDM_REQUEST_FIRMWARE_DATA:
+	case PLDM_TRANSFER_COMPLETE:
+	case PLDM_VERIFY_COMPLETE:
+	case PLDM_APPLY_COMPLETE:
+		break;
+	default:
+		/* Including GetPackageData and GetDeviceMetaData, neither is
+		 * offered in RequestUpdate */
+		return pldm_ua_reply_cc(PLDM_ERROR_UNSUPPORTED_PLDM_CMD, hdr,
+					resp, resp_payload_len);
+	}
+
+	if (!dev) {
+		return pldm_ua_reply_cc(PLDM_FWUP_COMMAND_NOT_EXPECTED, hdr,
+					resp, resp_payload_len);
+	}
+
+	dev->activity_time = pldm_ua_now(ua);
+
+	if (hdr->command == PLDM_REQUEST_FIRMWARE_DATA) {
+		return pldm_ua_fwdata(dev, hdr, req, req_payload_len, resp,
+				      resp_payload_len);
+	}
+
+	return pldm_ua_fd_complete(dev, hdr, req, req_payload_len, resp,
+				   resp_payload_len);
+}
+
+LIBPLDM_CC_NONNULL
+static uint8_t pldm_ua_expected_command(const struct pldm_ua_dev *dev)
+{
+	switch (dev->state) {
+	case PLDM_UA_DEV_REQUEST_UPDATE:
+		return PLDM_REQUEST_UPDATE;
+	case PLDM_UA_DEV_PASS_COMPONENT:
+		return PLDM_PASS_COMPONENT_TABLE;
+	case PLDM_UA_DEV_UPDATE_COMPONENT:
+		return PLDM_UPDATE_COMPONENT;
+	case PLDM_UA_DEV_ACTIVATE:
+		return PLDM_ACTIVATE_FIRMWARE;
+	case PLDM_UA_DEV_CANCEL:
+		return PLDM_CANCEL_UPDATE;
+	default:
+		/* FD-driven states don't send requests */
+		return 0;
+	}
+}
+
+LIBPLDM_CC_NONNULL
+static int pldm_ua_handle_resp(struct pldm_ua *ua, struct pldm_ua_dev *dev,
+			       const struct pldm_msg *resp,
+			       size_t resp_payload_len)
+{
+	bitfield64_t non_functioning_bitmap;
+	bitfield32_t flags_enabled;
+	bool8_t non_functioning;
+	uint16_t meta_data_len;
+	uint16_t time_before;
+	uint8_t will_send;
+	uint8_t comp_resp;
+	uint8_t resp_code;
+	uint8_t cc;
+	uint8_t rc;
+
+	if (!dev->sent || dev->instance_id != resp->hdr.instance_id ||
+	    pldm_ua_expected_command(dev) != resp->hdr.command) {
+		/* Response wasn't for the expected request */
+		return -EPROTO;
+	}
+
+	/* Must have a ccode */
+	if (resp_payload_len < 1) {
+		return -EINVAL;
+	}
+
+	dev->activity_time = pldm_ua_now(ua);
+	dev->sent = false;
+
+	switch (dev->state) {
+	case PLDM_UA_DEV_REQUEST_UPDATE:
+		rc = decode_request_update_resp(resp, resp_payload_len, &cc,
+						&meta_data_len, &will_send);
+		if (!rc && cc == PLDM_FWUP_ALREADY_IN_UPDATE_MODE &&
+		    dev->retried) {
+			/* The response to the first request was lost */
+			cc = PLDM_SUCCESS;
+		}
+		if (rc || cc) {
+			/* The FD isn't in update mode, nothing to cancel */
+			pldm_ua_dev_finish(ua, dev, -EPROTO);
+			return 0;
+		}
+		pldm_ua_dev_set_state(dev, PLDM_UA_DEV_PASS_COMPONENT);
+		break;
+	case PLDM_UA_DEV_PASS_COMPONENT:
+		rc = decode_pass_component_table_resp(resp, resp_payload_len,
+						      &cc, &comp_resp,
+						      &resp_code);
+		if (rc || cc) {
+			pldm_ua_dev_fail(dev, -EPROTO);
+			return 0;
+		}
+		/* Components the FD may not update are still offered with
+		 * UpdateComponent, its response there is definitive */
+		dev->comp = pldm_ua_dev_next_comp(dev, dev->comp + 1);
+		if (dev->comp == dev->pkg->component_count) {
+			dev->comp = pldm_ua_dev_next_comp(dev, 0);
+			pldm_ua_dev_set_state(dev,
+					      PLDM_UA_DEV_UPDATE_COMPONENT);
+		} else {
+			pldm_ua_dev_set_state(dev, PLDM_UA_DEV_PASS_COMPONENT);
+		}
+		break;
+	case PLDM_UA_DEV_UPDATE_COMPONENT:
+		rc = decode_update_component_resp(resp, resp_payload_len, &cc,
+						  &comp_resp, &resp_code,
+						  &flags_enabled, &time_before);
+		if (rc || cc) {
+			pldm_ua_dev_fail(dev, -EPROTO);
+			return 0;
+		}
+		if (comp_resp == PLDM_CCR_COMP_CAN_BE_UPDATED) {
+			dev->fd_req_valid = false;
+			dev->state = PLDM_UA_DEV_DOWNLOAD;
+		} else {
+			pldm_ua_dev_next_update(dev);
+		}
+		break;
+	case PLDM_UA_DEV_ACTIVATE:
+		rc = decode_activate_firmware_resp(resp, resp_payload_len, &cc,
+						   &time_before);
+		if (!rc && (cc == PLDM_SUCCESS ||
+			    cc == PLDM_FWUP_ACTIVATION_NOT_REQUIRED)) {
+			pldm_ua_dev_finish(ua, dev, 0);
+		} else {
+			pldm_ua_dev_fail(dev, -EPROTO);
+		}
+		break;
+	case PLDM_UA_DEV_CANCEL:
+		/* Whatever the FD answered, the update is over */
+		(void)decode_cancel_update_resp(resp, resp_payload_len, &cc,
+						&non_functioning,
+						&non_functioning_bitmap);
+		pldm_ua_dev_finish(ua, dev, dev->result);
+		break;
+	default:
+		assert(false);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_ua_handle_msg(struct pldm_ua *ua, pldm_tid_t remote_address,
+		       const void *in_msg, size_t in_len, void *out_msg,
+		       size_t *out_len)
+{
+	const struct pldm_msg *msg = in_msg;
+	struct pldm_msg *resp = out_msg;
+	struct pldm_header_info hdr;
+	struct pldm_ua_dev *dev;
+	size_t resp_payload_len;
+	size_t payload_len;
+	int rc;
+
+	if (ua == NULL || in_msg == NULL || out_msg == NULL ||
+	    out_len == NULL) {
+		return -EINVAL;
+	}
+
+	if (in_len < sizeof(struct pldm_msg_hdr)) {
+		return -EOVERFLOW;
+	}
+	payload_len = in_len - sizeof(struct pldm_msg_hdr);
+
+	if (unpack_pldm_header(&msg->hdr, &hdr) != PLDM_SUCCESS) {
+		return -EINVAL;
+	}
+
+	if (hdr.pldm_type != PLDM_FWUP) {
+		/* Caller should not have passed non-pldmfw */
+		return -ENOMSG;
+	}
+
+	dev = pldm_ua_dev_by_address(ua, remote_address);
+
+	if (hdr.msg_type == PLDM_RESPONSE) {
+		*out_len = 0;
+		if (!dev) {
+			/* No response was expected */
+			return -EPROTO;
+		}
+		return pldm_ua_handle_resp(ua, dev, msg, payload_len);
+	}
+
+	if (hdr.msg_type != PLDM_REQUEST) {
+		return -EPROTO;
+	}
+
+	/* Space for header plus completion code */
+	if (*out_len < sizeof(struct pldm_msg_hdr) + 1) {
+		return -EOVERFLOW;
+	}
+	resp_payload_len = *out_len - sizeof(struct pldm_msg_hdr);
+
+	rc = pldm_ua_handle_req(ua, dev, &hdr, msg, payload_len, resp,
+				&resp_payload_len);
+	if (rc == 0) {
+		*out_len = resp_payload_len + sizeof(struct pldm_msg_hdr);
+	}
+
+	return rc;
+}
+
+/* Encode the request for a UA-driven state */
+LIBPLDM_CC_NONNULL
+static int pldm_ua_encode_req(struct pldm_ua_dev *dev, uint8_t instance_id,
+			      struct pldm_msg *req, size_t *req_payload_len)
+{
+	const struct pldm_ua_package_component *comp =
+		&dev->pkg->components[dev->comp];
+	const struct pldm_ua_package_record *record = dev->record;
+	bitfield32_t flags = { 0 };
+	uint8_t transfer_flag;
+	size_t len;
+	uint8_t rc;
+
+	switch (dev->state) {
+	case PLDM_UA_DEV_REQUEST_UPDATE:
+		len = sizeof(struct pldm_request_update_req) +
+		      record->image_set_version.length;
+		break;
+	case PLDM_UA_DEV_PASS_COMPONENT:
+		len = sizeof(struct pldm_pass_component_table_req) +
+		      comp->version.length;
+		break;
+	case PLDM_UA_DEV_UPDATE_COMPONENT:
+		len = sizeof(struct pldm_update_component_req) +
+		      comp->version.length;
+		break;
+	case PLDM_UA_DEV_ACTIVATE:
+		len = sizeof(struct pldm_activate_firmware_req);
+		break;
+	case PLDM_UA_DEV_CANCEL:
+		len = PLDM_CANCEL_UPDATE_REQ_BYTES;
+		break;
+	default:
+		assert(false);
+		return -EINVAL;
+	}
+
+	if (*req_payload_len < len) {
+		return -EOVERFLOW;
+	}
+	*req_payload_len = len;
+
+	switch (dev->state) {
+	case PLDM_UA_DEV_REQUEST_UPDATE:
+		rc = encode_request_update_req(
+			instance_id, dev->transfer_size,
+			pldm_ua_dev_comp_count(dev),
+			UA_MAX_OUTSTANDING_TRANSFER_REQ, 0,
+			record->info.comp_image_set_version_string_type,
+			record->info.comp_image_set_version_string_length,
+			&record->image_set_version, req, len);
+		break;
+	case PLDM_UA_DEV_PASS_COMPONENT:
+		transfer_flag = 0;
+		if (dev->comp == pldm_ua_dev_next_comp(dev, 0)) {
+			transfer_flag |= PLDM_START;
+		}
+		if (pldm_ua_dev_next_comp(dev, dev->comp + 1) ==
+		    dev->pkg->component_count) {
+			transfer_flag |= PLDM_END;
+		}
+		if (!transfer_flag) {
+			transfer_flag = PLDM_MIDDLE;
+		}
+		rc = encode_pass_component_table_req(
+			instance_id, transfer_flag,
+			comp->info.comp_classification,
+			comp->info.comp_identifier, 0,
+			comp->info.comp_comparison_stamp,
+			comp->info.comp_version_string_type,
+			comp->info.comp_version_string_length, &comp->version,
+			req, len);
+		break;
+	case PLDM_UA_DEV_UPDATE_COMPONENT:
+		/* ComponentOptions bit 0 is Force Update, as is bit 0 of
+		 * UpdateOptionFlags */
+		flags.bits.bit0 = comp->info.comp_options.bits.bit0;
+		rc = encode_update_component_req(
+			instance_id, comp->info.comp_classification,
+			comp->info.comp_identifier, 0,
+			comp->info.comp_comparison_stamp, comp->info.comp_size,
+			flags, comp->info.comp_version_string_type,
+			comp->info.comp_version_string_length, &comp->version,
+			req, len);
+		break;
+	case PLDM_UA_DEV_ACTIVATE:
+		rc = encode_activate_firmware_req(
+			instance_id,
+			PLDM_NOT_ACTIVATE_SELF_CONTAINED_COMPONENTS, req, len);
+		break;
+	case PLDM_UA_DEV_CANCEL:
+		rc = encode_cancel_update_req(instance_id, req, len);
+		break;
+	default:
+		assert(false);
+		return -EINVAL;
+	}
+
+	return rc ? -EINVAL : 0;
+}
+
+/* Whether the request of a UA-driven state is due to be sent */
+LIBPLDM_CC_NONNULL
+static bool pldm_ua_dev_should_send(struct pldm_ua *ua,
+				    const struct pldm_ua_dev *dev,
+				    pldm_ua_time_t now)
+{
+	if (!pldm_ua_expected_command(dev)) {
+		return false;
+	}
+
+	if (!dev->sent) {
+		return true;
+	}
+
+	/* Time going backwards doesn't trigger a retry */
+	return now >= dev->sent_time && now - dev->sent_time >= ua->retry_time;
+}
+
+/* Check the idle timeout of a device, returning true if the update ended */
+LIBPLDM_CC_NONNULL
+static bool pldm_ua_dev_timeout(struct pldm_ua *ua, struct pldm_ua_dev *dev,
+				pldm_ua_time_t now)
+{
+	if (now < dev->activity_time ||
+	    now - dev->activity_time <= ua->idle_timeout) {
+		return false;
+	}
+
+	if (dev->state == PLDM_UA_DEV_CANCEL) {
+		pldm_ua_dev_finish(ua, dev, dev->result);
+		return true;
+	}
+
+	if (dev->state == PLDM_UA_DEV_REQUEST_UPDATE) {
+		pldm_ua_dev_finish(ua, dev, -ETIMEDOUT);
+		return true;
+	}
+
+	/* Let the FD know, if it is still there */
+	dev->activity_time = now;
+	pldm_ua_dev_fail(dev, -ETIMEDOUT);
+	return false;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_ua_progress(struct pldm_ua *ua, void *out_msg, size_t *out_len,
+		     pldm_tid_t *remote_address)
+{
+	struct pldm_msg *req = out_msg;
+	size_t req_payload_len;
+	pldm_ua_time_t now;
+	size_t n;
+
+	if (ua == NULL || out_msg == NULL || out_len == NULL ||
+	    remote_address == NULL) {
+		return -EINVAL;
+	}
+
+	/* Space for header */
+	if (*out_len < sizeof(struct pldm_msg_hdr)) {
+		return -EOVERFLOW;
+	}
+	req_payload_len = *out_len - sizeof(struct pldm_msg_hdr);
+	*out_len = 0;
+
+	now = pldm_ua_now(ua);
+	for (n = 0; n < ua->max_devices; n++) {
+		size_t i = (ua->next + n) % ua->max_devices;
+		struct pldm_ua_dev *dev = &ua->devs[i];
+		uint8_t instance_id;
+		int rc;
+
+		if (dev->state == PLDM_UA_DEV_UNUSED) {
+			continue;
+		}
+
+		if (pldm_ua_dev_timeout(ua, dev, now)) {
+			continue;
+		}
+
+		if (!pldm_ua_dev_should_send(ua, dev, now)) {
+			continue;
+		}
+
+		/* Retries keep the instance ID of the request */
+		instance_id = dev->instance_id;
+		if (!dev->sent) {
+			instance_id = (instance_id + 1) % INSTANCE_ID_COUNT;
+		}
+
+		rc = pldm_ua_encode_req(dev, instance_id, req,
+					&req_payload_len);
+		if (rc) {
+			return rc;
+		}
+
+		dev->retried = dev->sent;
+		dev->sent = true;
+		dev->instance_id = instance_id;
+		dev->sent_time = now;
+		ua->next = (i + 1) % ua->max_devices;
+
+		*out_len = req_payload_len + sizeof(struct pldm_msg_hdr);
+		*remote_address = dev->address;
+		return 0;
+	}
+
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_ua_next_deadline(struct pldm_ua *ua, uint64_t *deadline)
+{
+	bool active = false;
+	pldm_ua_time_t now;
+	size_t i;
+
+	if (ua == NULL || deadline == NULL) {
+		return -EINVAL;
+	}
+
+	now = pldm_ua_now(ua);
+	for (i = 0; i < ua->max_devices; i++) {
+		const struct pldm_ua_dev *dev = &ua->devs[i];
+		pldm_ua_time_t next;
+
+		if (dev->state == PLDM_UA_DEV_UNUSED) {
+			continue;
+		}
+
+		/* pldm_ua_progress() times out past the idle time */
+		next = dev->activity_time + ua->idle_timeout + 1;
+		if (pldm_ua_expected_command(dev)) {
+			if (!dev->sent) {
+				next = now;
+			} else if (dev->sent_time + ua->retry_time < next) {
+				next = dev->sent_time + ua->retry_time;
+			}
+		}
+
+		if (!active || next < *deadline) {
+			*deadline = next;
+		}
+		active = true;
+	}
+
+	return active ? 0 : -ENODATA;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_ua_set_transfer_size(struct pldm_ua *ua, uint32_t size)
+{
+	if (ua == NULL || size < PLDM_FWUP_BASELINE_TRANSFER_SIZE) {
+		return -EINVAL;
+	}
+
+	ua->transfer_size = size;
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_ua_set_request_retry_time(struct pldm_ua *ua, uint32_t time)
+{
+	if (ua == NULL || time == 0) {
+		return -EINVAL;
+	}
+
+	ua->retry_time = time;
+	return 0;
+}
+
+LIBPLDM_ABI_TESTING
+int pldm_ua_set_idle_timeout(struct pldm_ua *ua, uint32_t time)
+{
+	if (ua == NULL || time == 0) {
+		return -EINVAL;
+	}
+
+	ua->idle_timeout = time;
+	return 0;
+}
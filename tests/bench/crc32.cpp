@@ -0,0 +1,94 @@
+/* Compare throughput of the CRC32 implementations, and check they agree */
+
+// NOLINTNEXTLINE(bugprone-suspicious-include)
+#include "crc32.c"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using crc32_fn = uint32_t (*)(uint32_t crc, const void* data, size_t size);
+
+struct variant
+{
+    const char* name;
+    crc32_fn fn;
+};
+
+/* Process roughly this many bytes per measurement */
+static constexpr size_t workload = 256 * 1024 * 1024;
+
+static bool run(const std::vector<variant>& variants,
+                const std::vector<uint8_t>& buf, size_t size)
+{
+    const size_t iterations = std::max<size_t>(1, workload / size);
+    uint32_t expected = 0;
+    bool consistent = true;
+
+    for (size_t i = 0; i < variants.size(); i++)
+    {
+        const auto& v = variants[i];
+        uint32_t crc = ~0U;
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t j = 0; j < iterations; j++)
+        {
+            crc = v.fn(crc, buf.data(), size);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        std::chrono::duration<double> elapsed = end - start;
+        double mibps = (double)(iterations * size) / elapsed.count() /
+                       (1024.0 * 1024.0);
+
+        if (i == 0)
+        {
+            expected = crc;
+        }
+        else if (crc != expected)
+        {
+            consistent = false;
+        }
+
+        printf("%10zu %-10s %10.1f MiB/s  0x%08x%s\n", size, v.name, mibps,
+               crc ^ ~0U, crc == expected ? "" : "  MISMATCH");
+    }
+
+    return consistent;
+}
+
+int main()
+{
+    std::vector<variant> variants = {
+        {"bytewise", pldm_crc32_update_bytewise},
+        {"slice8", pldm_crc32_update_slice8},
+        {"slice16", pldm_crc32_update_slice16},
+    };
+#if PLDM_CRC32_HAVE_HW
+    if (pldm_crc32_hw_supported())
+    {
+        variants.push_back({"hw", pldm_crc32_update_hw});
+    }
+#endif
+    variants.push_back({"dispatch", pldm_crc32_update});
+
+    const size_t sizes[] = {16, 64, 256, 4096, 65536, 4 * 1024 * 1024};
+    std::vector<uint8_t> buf(sizes[std::size(sizes) - 1]);
+    std::mt19937 gen(0);
+    std::uniform_int_distribution<unsigned> dist(0, UINT8_MAX);
+    bool consistent = true;
+
+    for (auto& b : buf)
+    {
+        b = dist(gen);
+    }
+
+    for (auto size : sizes)
+    {
+        consistent &= run(variants, buf, size);
+    }
+
+    return consistent ? 0 : 1;
+}
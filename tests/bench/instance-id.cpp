@@ -0,0 +1,307 @@
+/* Measure instance ID allocation rates and latencies under contention */
+
+#include <libpldm/instance-id.h>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+/* Allocations made by each worker per measurement */
+static constexpr size_t allocations = 20 * 1000;
+/* Instance IDs each worker holds before freeing the oldest */
+static constexpr size_t in_flight = 4;
+
+enum backend
+{
+    ofd,
+#ifdef LIBPLDM_API_TESTING
+    shm,
+    shm_cached,
+#endif
+};
+
+static const char* backend_name(enum backend backend)
+{
+    switch (backend)
+    {
+        case ofd:
+            return "ofd";
+#ifdef LIBPLDM_API_TESTING
+        case shm:
+            return "shm";
+        case shm_cached:
+            return "shm+cache";
+#endif
+    }
+
+    return "?";
+}
+
+struct config
+{
+    enum backend backend;
+    const char* path;
+    int fd;
+    size_t processes;
+    size_t threads;
+    size_t tids;
+};
+
+/* Per-worker results, shared with the parent across fork() */
+struct result
+{
+    uint64_t eagain;
+    bool failed;
+    uint32_t latency_ns[allocations];
+};
+
+static int open_db(const struct config& config, struct pldm_instance_db** db)
+{
+    switch (config.backend)
+    {
+        case ofd:
+            return pldm_instance_db_init(db, config.path);
+#ifdef LIBPLDM_API_TESTING
+        case shm:
+            return pldm_instance_db_init_shm(db, config.fd);
+        case shm_cached:
+            if (pldm_instance_db_init_shm(db, config.fd))
+            {
+                return -1;
+            }
+            return pldm_instance_db_set_cache(*db, in_flight);
+#endif
+    }
+
+    return -EINVAL;
+}
+
+/* Allocate and free instance IDs, holding a few in flight like a pipelined
+ * requester */
+static void worker(const struct config& config, size_t index,
+                   struct result* result)
+{
+    struct
+    {
+        pldm_tid_t tid;
+        pldm_instance_id_t iid;
+    } held[in_flight];
+    struct pldm_instance_db* db = nullptr;
+    size_t head = 0;
+    size_t count = 0;
+    size_t i;
+    int rc;
+
+    if (open_db(config, &db))
+    {
+        result->failed = true;
+        return;
+    }
+
+    for (i = 0; i < allocations; i++)
+    {
+        pldm_tid_t tid = 1 + (index + i) % config.tids;
+        pldm_instance_id_t iid;
+
+        if (count == in_flight)
+        {
+            pldm_instance_id_free(db, held[head].tid, held[head].iid);
+            head = (head + 1) % in_flight;
+            count--;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        while ((rc = pldm_instance_id_alloc(db, tid, &iid)) == -EAGAIN)
+        {
+            /* Give up the oldest held so the workers can't deadlock */
+            result->eagain++;
+            if (count)
+            {
+                pldm_instance_id_free(db, held[head].tid, held[head].iid);
+                head = (head + 1) % in_flight;
+                count--;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        if (rc)
+        {
+            result->failed = true;
+            break;
+        }
+
+        result->latency_ns[i] = std::min<int64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+                .count(),
+            UINT32_MAX);
+        held[(head + count) % in_flight] = {tid, iid};
+        count++;
+    }
+
+    for (; count; count--)
+    {
+        pldm_instance_id_free(db, held[head].tid, held[head].iid);
+        head = (head + 1) % in_flight;
+    }
+    pldm_instance_db_destroy(db);
+}
+
+static bool contend(const struct config& config)
+{
+    const size_t workers = config.processes * config.threads;
+    std::vector<pid_t> children;
+    std::vector<uint32_t> latencies;
+    struct result* results;
+    uint64_t eagain = 0;
+    bool ok = true;
+    size_t p;
+    int status;
+
+    results = static_cast<struct result*>(
+        mmap(nullptr, workers * sizeof(*results), PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+    if (results == MAP_FAILED)
+    {
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (p = 0; p < config.processes; p++)
+    {
+        pid_t pid = fork();
+
+        if (pid < 0)
+        {
+            ok = false;
+            break;
+        }
+
+        if (pid == 0)
+        {
+            std::vector<std::thread> threads;
+
+            for (size_t t = 0; t < config.threads; t++)
+            {
+                size_t index = p * config.threads + t;
+
+                threads.emplace_back(worker, std::cref(config), index,
+                                     &results[index]);
+            }
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+            _exit(0);
+        }
+
+        children.push_back(pid);
+    }
+
+    for (auto pid : children)
+    {
+        if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) ||
+            WEXITSTATUS(status))
+        {
+            ok = false;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    for (size_t w = 0; ok && w < workers; w++)
+    {
+        ok = !results[w].failed;
+        eagain += results[w].eagain;
+        latencies.insert(latencies.end(), results[w].latency_ns,
+                         results[w].latency_ns + allocations);
+    }
+    munmap(results, workers * sizeof(*results));
+
+    if (!ok)
+    {
+        fprintf(stderr, "%s: allocation failed\n",
+                backend_name(config.backend));
+        return false;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        return latencies[(size_t)(p * (latencies.size() - 1))] / 1000.0;
+    };
+    std::chrono::duration<double> elapsed = end - start;
+    printf("%-9s %2zu proc %2zu thr %3zu tid(s) %11.0f alloc/s "
+           "p50 %8.2f us p99 %8.2f us p99.9 %8.2f us EAGAIN %6.2f%%\n",
+           backend_name(config.backend), config.processes, config.threads,
+           config.tids, (double)latencies.size() / elapsed.count(),
+           percentile(0.5), percentile(0.99), percentile(0.999),
+           100.0 * eagain / (eagain + latencies.size()));
+
+    return true;
+}
+
+int main()
+{
+    const struct
+    {
+        size_t processes;
+        size_t threads;
+    } shapes[] = {{1, 1}, {4, 1}, {4, 4}};
+    const size_t tids[] = {1, 64};
+    const enum backend backends[] = {
+        ofd,
+#ifdef LIBPLDM_API_TESTING
+        shm,
+        shm_cached,
+#endif
+    };
+    char path[] = "/tmp/instance-db.XXXXXX";
+    bool ok = true;
+    int fd;
+
+    /* Sized as the installed database */
+    fd = mkstemp(path);
+    if (fd < 0 || ftruncate(fd, 256 * 32))
+    {
+        perror("instance-db");
+        return 1;
+    }
+    close(fd);
+
+    for (auto backend : backends)
+    {
+        for (auto shape : shapes)
+        {
+            for (auto n : tids)
+            {
+                struct config config = {backend, path, -1, shape.processes,
+                                        shape.threads, n};
+
+                /* A fresh database, so measurements don't interfere */
+                config.fd = memfd_create("instance-db", MFD_CLOEXEC);
+                if (config.fd < 0)
+                {
+                    ok = false;
+                    break;
+                }
+                ok &= contend(config);
+                close(config.fd);
+            }
+        }
+    }
+
+    unlink(path);
+
+    return ok ? 0 : 1;
+}
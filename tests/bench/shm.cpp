@@ -0,0 +1,209 @@
+/* Measure message rates and round-trip times of the shared-memory transport */
+
+#include <libpldm/transport.h>
+#include <libpldm/transport/shm.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+/* Messages exchanged per measurement */
+static constexpr size_t messages = 2 * 1000 * 1000;
+static constexpr size_t round_trips = 200 * 1000;
+static constexpr size_t batch = 32;
+
+static void wait(struct pldm_transport* t)
+{
+    pldm_transport_poll(t, -1);
+}
+
+/* Stream requests from one or more producers to a consumer */
+static bool stream(size_t producers, size_t size)
+{
+    struct pldm_transport_shm_region* region = nullptr;
+    std::vector<struct pldm_transport_shm*> tx(producers);
+    struct pldm_transport_shm* rx = nullptr;
+    std::vector<std::thread> threads;
+    size_t received = 0;
+    size_t i;
+
+    if (pldm_transport_shm_region_create(&region, producers + 1, 1024,
+                                         size) ||
+        pldm_transport_shm_init(&rx, region, 1))
+    {
+        return false;
+    }
+
+    for (i = 0; i < producers; i++)
+    {
+        if (pldm_transport_shm_init(&tx[i], region, 2 + i))
+        {
+            return false;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (i = 0; i < producers; i++)
+    {
+        struct pldm_transport* t = pldm_transport_shm_core(tx[i]);
+
+        threads.emplace_back([t, producers, size] {
+            std::vector<uint8_t> req(size);
+            struct pldm_transport_msg msgs[batch];
+            size_t sent = 0;
+            int rc;
+
+            req[0] = 0x80;
+            while (sent < messages / producers)
+            {
+                size_t n = std::min(batch, messages / producers - sent);
+
+                for (size_t j = 0; j < n; j++)
+                {
+                    msgs[j].tid = 1;
+                    msgs[j].msg = req.data();
+                    msgs[j].len = req.size();
+                }
+
+                rc = pldm_transport_send_msgs(t, msgs, n);
+                if (rc > 0)
+                {
+                    sent += rc;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<std::vector<uint8_t>> bufs(batch, std::vector<uint8_t>(size));
+    struct pldm_transport_msg msgs[batch];
+    struct pldm_transport* t = pldm_transport_shm_core(rx);
+    while (received < messages / producers * producers)
+    {
+        int rc;
+
+        for (i = 0; i < batch; i++)
+        {
+            msgs[i].msg = bufs[i].data();
+            msgs[i].len = size;
+        }
+
+        rc = pldm_transport_recv_msgs(t, msgs, batch);
+        if (rc > 0)
+        {
+            received += rc;
+        }
+        else
+        {
+            wait(t);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    std::chrono::duration<double> elapsed = end - start;
+    printf("stream    %2zu producer(s) %6zu B %12.0f msg/s\n", producers,
+           size, (double)received / elapsed.count());
+
+    for (auto* ctx : tx)
+    {
+        pldm_transport_shm_destroy(ctx);
+    }
+    pldm_transport_shm_destroy(rx);
+    pldm_transport_shm_region_destroy(region);
+
+    return true;
+}
+
+/* Bounce a request between a requester and a responder thread */
+static bool ping_pong(size_t size)
+{
+    struct pldm_transport_shm_region* region = nullptr;
+    struct pldm_transport_shm* req = nullptr;
+    struct pldm_transport_shm* resp = nullptr;
+    std::vector<uint8_t> msg(size);
+    size_t i;
+
+    if (pldm_transport_shm_region_create(&region, 2, 16, size) ||
+        pldm_transport_shm_init(&req, region, 1) ||
+        pldm_transport_shm_init(&resp, region, 2))
+    {
+        return false;
+    }
+
+    std::thread responder([resp, size] {
+        struct pldm_transport* t = pldm_transport_shm_core(resp);
+        std::vector<uint8_t> buf(size);
+        pldm_tid_t tid;
+
+        for (size_t n = 0; n < round_trips;)
+        {
+            size_t len = buf.size();
+
+            if (pldm_transport_recv_msg_into(t, &tid, buf.data(), &len) !=
+                PLDM_REQUESTER_SUCCESS)
+            {
+                wait(t);
+                continue;
+            }
+
+            buf[0] &= ~0x80;
+            pldm_transport_send_msg(t, tid, buf.data(), len);
+            n++;
+        }
+    });
+
+    struct pldm_transport* t = pldm_transport_shm_core(req);
+    auto start = std::chrono::steady_clock::now();
+    for (i = 0; i < round_trips; i++)
+    {
+        size_t len = msg.size();
+        pldm_tid_t tid;
+
+        msg[0] = 0x80;
+        pldm_transport_send_msg(t, 2, msg.data(), msg.size());
+        while (pldm_transport_recv_msg_into(t, &tid, msg.data(), &len) !=
+               PLDM_REQUESTER_SUCCESS)
+        {
+            wait(t);
+            len = msg.size();
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    responder.join();
+
+    std::chrono::duration<double, std::micro> elapsed = end - start;
+    printf("ping-pong              %6zu B %12.2f us/round trip\n", size,
+           elapsed.count() / round_trips);
+
+    pldm_transport_shm_destroy(req);
+    pldm_transport_shm_destroy(resp);
+    pldm_transport_shm_region_destroy(region);
+
+    return true;
+}
+
+int main()
+{
+    const size_t sizes[] = {16, 256, 4096};
+    bool ok = true;
+
+    for (auto size : sizes)
+    {
+        ok &= stream(1, size);
+        ok &= stream(4, size);
+        ok &= ping_pong(size);
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,242 @@
+#include <libpldm/base.h>
+#include <libpldm/control.h>
+#include <libpldm/pldm.h>
+
+#include "control-internal.h"
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#ifdef LIBPLDM_API_TESTING
+struct Calls
+{
+    int requests = 0;
+    int responses = 0;
+    pldm_tid_t tid = 0;
+};
+
+static int oemRequest(void* ctx, pldm_tid_t tid,
+                      const struct pldm_header_info* hdr,
+                      const struct pldm_msg* /*msg*/, size_t /*payload_len*/,
+                      struct pldm_msg* resp, size_t* resp_payload_len)
+{
+    auto* calls = static_cast<Calls*>(ctx);
+
+    calls->requests++;
+    calls->tid = tid;
+    *resp_payload_len = 1;
+    return encode_cc_only_resp(hdr->instance, hdr->pldm_type, hdr->command,
+                               PLDM_SUCCESS, resp)
+               ? -EINVAL
+               : 0;
+}
+
+static int oemResponse(void* ctx, pldm_tid_t /*tid*/,
+                       const struct pldm_header_info* /*hdr*/,
+                       const struct pldm_msg* /*msg*/, size_t /*payload_len*/,
+                       struct pldm_msg* /*resp*/, size_t* /*resp_payload_len*/)
+{
+    static_cast<Calls*>(ctx)->responses++;
+    return 0;
+}
+
+static const struct pldm_control_handler oemHandlers[] = {
+    {0x01, oemRequest, nullptr},
+    {0x02, nullptr, oemResponse},
+    {0x0a, oemRequest, oemResponse},
+};
+
+static const ver32_t oemVersions[] = {
+    {0x00, 0xf0, 0xf0, 0xf1},
+};
+
+class PldmControl : public testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        ASSERT_EQ(pldm_control_setup(&control, sizeof(control)), 0);
+        ASSERT_EQ(pldm_control_register_type(
+                      &control, PLDM_OEM, oemVersions, 1, oemHandlers,
+                      sizeof(oemHandlers) / sizeof(oemHandlers[0]), &calls),
+                  0);
+    }
+
+    /* Dispatch a message, returning the response */
+    std::vector<uint8_t> dispatch(const std::vector<uint8_t>& msg,
+                                  int expected = 0)
+    {
+        std::vector<uint8_t> resp(128);
+        size_t len = resp.size();
+
+        EXPECT_EQ(pldm_control_dispatch(&control, 9, msg.data(), msg.size(),
+                                        resp.data(), &len),
+                  expected);
+        resp.resize(expected ? 0 : len);
+        return resp;
+    }
+
+    struct pldm_control control;
+    Calls calls;
+};
+
+TEST_F(PldmControl, baseVersionCrc)
+{
+    std::vector<uint8_t> req(sizeof(pldm_msg_hdr) +
+                             PLDM_GET_VERSION_REQ_BYTES);
+    std::vector<uint8_t> resp;
+
+    ASSERT_EQ(encode_get_version_req(1, 0, PLDM_GET_FIRSTPART, PLDM_BASE,
+                                     reinterpret_cast<pldm_msg*>(req.data())),
+              PLDM_SUCCESS);
+    resp = dispatch(req);
+
+    /* Header, cc, handle, flag, version and its generated CRC32 */
+    const std::vector<uint8_t> expected = {
+        0x01, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05,
+        0x00, 0xf0, 0xf1, 0xf1, 0xba, 0xbe, 0x9d, 0x53,
+    };
+    EXPECT_EQ(resp, expected);
+}
+
+TEST_F(PldmControl, generatedCommands)
+{
+    std::vector<uint8_t> req(sizeof(pldm_msg_hdr) +
+                             PLDM_GET_COMMANDS_REQ_BYTES);
+    std::vector<uint8_t> resp;
+
+    ASSERT_EQ(encode_get_commands_req(1, PLDM_OEM, oemVersions[0],
+                                      reinterpret_cast<pldm_msg*>(req.data())),
+              PLDM_SUCCESS);
+    resp = dispatch(req);
+    ASSERT_EQ(resp.size(), sizeof(pldm_msg_hdr) + 1 + 32);
+    EXPECT_EQ(resp[3], PLDM_SUCCESS);
+
+    /* Commands with only a response handler aren't reported */
+    EXPECT_EQ(resp[4], 1 << 1);
+    EXPECT_EQ(resp[5], 1 << 2);
+    for (size_t i = 6; i < resp.size(); i++)
+    {
+        EXPECT_EQ(resp[i], 0);
+    }
+}
+
+TEST_F(PldmControl, typesFollowAddType)
+{
+    static const uint32_t platformVersions[] = {0xf1f2f000, 0};
+    static const bitfield8_t platformCommands[32] = {{0x01}};
+    std::vector<uint8_t> expected(sizeof(pldm_msg_hdr) +
+                                  PLDM_GET_TYPES_RESP_BYTES);
+    std::vector<uint8_t> req(sizeof(pldm_msg_hdr));
+    std::array<bitfield8_t, 8> types = {};
+    std::vector<uint8_t> resp;
+
+    ASSERT_EQ(encode_get_types_req(3, reinterpret_cast<pldm_msg*>(req.data())),
+              PLDM_SUCCESS);
+
+    types[PLDM_BASE / 8].byte |= 1 << (PLDM_BASE % 8);
+    types[PLDM_OEM / 8].byte |= 1 << (PLDM_OEM % 8);
+    ASSERT_EQ(encode_get_types_resp(3, PLDM_SUCCESS, types.data(),
+                                    reinterpret_cast<pldm_msg*>(
+                                        expected.data())),
+              PLDM_SUCCESS);
+    EXPECT_EQ(dispatch(req), expected);
+
+    /* The precomputed response is updated as types are added */
+    ASSERT_EQ(pldm_control_add_type(&control, PLDM_PLATFORM, platformVersions,
+                                    2, platformCommands),
+              0);
+    types[PLDM_PLATFORM / 8].byte |= 1 << (PLDM_PLATFORM % 8);
+    ASSERT_EQ(encode_get_types_resp(3, PLDM_SUCCESS, types.data(),
+                                    reinterpret_cast<pldm_msg*>(
+                                        expected.data())),
+              PLDM_SUCCESS);
+    EXPECT_EQ(dispatch(req), expected);
+
+    req.resize(sizeof(pldm_msg_hdr) + PLDM_GET_VERSION_REQ_BYTES);
+    ASSERT_EQ(encode_get_version_req(3, 0, PLDM_GET_FIRSTPART, PLDM_PLATFORM,
+                                     reinterpret_cast<pldm_msg*>(req.data())),
+              PLDM_SUCCESS);
+    resp = dispatch(req);
+    ASSERT_EQ(resp.size(), sizeof(pldm_msg_hdr) + 6 + 8);
+    EXPECT_EQ(resp[0], 0x03);
+    EXPECT_EQ(memcmp(&resp[9], platformVersions, 8), 0);
+
+    /* Types reported without handlers leave their requests to the caller */
+    EXPECT_EQ(dispatch({0x84, PLDM_PLATFORM, 0x01}, -ENOMSG).size(), 0);
+    EXPECT_EQ(dispatch({0x05, PLDM_PLATFORM, 0x01, 0x00}, -ENOMSG).size(),
+              0);
+}
+
+TEST_F(PldmControl, dispatchRequests)
+{
+    std::vector<uint8_t> resp;
+
+    resp = dispatch({0x82, PLDM_OEM, 0x0a});
+    EXPECT_EQ(calls.requests, 1);
+    EXPECT_EQ(calls.tid, 9);
+    EXPECT_EQ(resp, (std::vector<uint8_t>{0x02, PLDM_OEM, 0x0a, 0x00}));
+
+    /* Unknown command of a registered type */
+    resp = dispatch({0x83, PLDM_OEM, 0x02});
+    EXPECT_EQ(resp, (std::vector<uint8_t>{0x03, PLDM_OEM, 0x02,
+                                          PLDM_ERROR_UNSUPPORTED_PLDM_CMD}));
+
+    /* Unregistered type */
+    resp = dispatch({0x84, PLDM_PLATFORM, 0x01});
+    EXPECT_EQ(resp, (std::vector<uint8_t>{0x04, PLDM_PLATFORM, 0x01,
+                                          PLDM_ERROR_INVALID_PLDM_TYPE}));
+    EXPECT_EQ(calls.requests, 1);
+}
+
+TEST_F(PldmControl, dispatchResponses)
+{
+    EXPECT_EQ(dispatch({0x05, PLDM_OEM, 0x02, 0x00}).size(), 0);
+    EXPECT_EQ(dispatch({0x05, PLDM_OEM, 0x0a, 0x00}).size(), 0);
+    EXPECT_EQ(calls.responses, 2);
+
+    dispatch({0x05, PLDM_OEM, 0x01, 0x00}, -ENOMSG);
+    dispatch({0x05, PLDM_PLATFORM, 0x01, 0x00}, -ENOMSG);
+    EXPECT_EQ(calls.responses, 2);
+    EXPECT_EQ(calls.requests, 0);
+}
+
+TEST_F(PldmControl, registerInvalid)
+{
+    const struct pldm_control_handler duplicate[] = {
+        {0x01, oemRequest, nullptr},
+        {0x01, nullptr, oemResponse},
+    };
+    const struct pldm_control_handler empty[] = {
+        {0x01, nullptr, nullptr},
+    };
+    const std::array<ver32_t, PLDM_CONTROL_MAX_VERSIONS + 1> versions = {};
+
+    EXPECT_EQ(pldm_control_register_type(&control, PLDM_PLATFORM, oemVersions,
+                                         1, duplicate, 2, nullptr),
+              -EINVAL);
+    EXPECT_EQ(pldm_control_register_type(&control, PLDM_PLATFORM, oemVersions,
+                                         1, empty, 1, nullptr),
+              -EINVAL);
+    EXPECT_EQ(pldm_control_register_type(&control, PLDM_PLATFORM, oemVersions,
+                                         0, oemHandlers, 1, nullptr),
+              -EINVAL);
+    EXPECT_EQ(pldm_control_register_type(&control, PLDM_PLATFORM,
+                                         versions.data(), versions.size(),
+                                         oemHandlers, 1, nullptr),
+              -EINVAL);
+    EXPECT_EQ(pldm_control_register_type(&control, PLDM_CONTROL_MAX_TYPES,
+                                         oemVersions, 1, oemHandlers, 1,
+                                         nullptr),
+              -EINVAL);
+
+    /* A failed registration leaves the type unregistered */
+    EXPECT_EQ(dispatch({0x84, PLDM_PLATFORM, 0x01})[3],
+              PLDM_ERROR_INVALID_PLDM_TYPE);
+}
+#endif
@@ -0,0 +1,108 @@
+// NOLINTNEXTLINE(bugprone-suspicious-include)
+#include "crc32.c"
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+static const char checkValue[] = "123456789";
+static constexpr uint32_t checkCrc = 0xcbf43926;
+
+static uint32_t finalise(uint32_t crc)
+{
+    return crc ^ ~0U;
+}
+
+static std::vector<uint8_t> randomBuffer(size_t size)
+{
+    std::mt19937 gen(size);
+    std::uniform_int_distribution<unsigned> dist(0, UINT8_MAX);
+    std::vector<uint8_t> buf(size);
+
+    for (auto& b : buf)
+    {
+        b = dist(gen);
+    }
+
+    return buf;
+}
+
+TEST(Crc32, bytewiseCheckValue)
+{
+    EXPECT_EQ(finalise(pldm_crc32_update_bytewise(~0U, checkValue, 9)),
+              checkCrc);
+}
+
+TEST(Crc32, slice8CheckValue)
+{
+    EXPECT_EQ(finalise(pldm_crc32_update_slice8(~0U, checkValue, 9)),
+              checkCrc);
+}
+
+TEST(Crc32, slice16CheckValue)
+{
+    EXPECT_EQ(finalise(pldm_crc32_update_slice16(~0U, checkValue, 9)),
+              checkCrc);
+}
+
+TEST(Crc32, dispatchCheckValue)
+{
+    EXPECT_EQ(finalise(pldm_crc32_update(~0U, checkValue, 9)), checkCrc);
+}
+
+TEST(Crc32, emptyIsIdentity)
+{
+    EXPECT_EQ(pldm_crc32_update_slice8(0x12345678, nullptr, 0), 0x12345678u);
+    EXPECT_EQ(pldm_crc32_update_slice16(0x12345678, nullptr, 0), 0x12345678u);
+    EXPECT_EQ(pldm_crc32_update(0x12345678, nullptr, 0), 0x12345678u);
+}
+
+TEST(Crc32, tablesMatchBytewise)
+{
+    auto buf = randomBuffer(1100);
+
+    for (size_t offset = 0; offset < 16; offset++)
+    {
+        for (size_t len = 0; len + offset <= buf.size(); len += 7)
+        {
+            const uint8_t* p = buf.data() + offset;
+            uint32_t expected = pldm_crc32_update_bytewise(~0U, p, len);
+
+            ASSERT_EQ(pldm_crc32_update_slice8(~0U, p, len), expected)
+                << "offset " << offset << ", length " << len;
+            ASSERT_EQ(pldm_crc32_update_slice16(~0U, p, len), expected)
+                << "offset " << offset << ", length " << len;
+            ASSERT_EQ(pldm_crc32_update(~0U, p, len), expected)
+                << "offset " << offset << ", length " << len;
+        }
+    }
+}
+
+#if PLDM_CRC32_HAVE_HW
+TEST(Crc32, hwMatchesBytewise)
+{
+    if (!pldm_crc32_hw_supported())
+    {
+        GTEST_SKIP() << "No hardware CRC32 support";
+    }
+
+    auto buf = randomBuffer(4096 + 16);
+
+    EXPECT_EQ(finalise(pldm_crc32_update_hw(~0U, checkValue, 9)), checkCrc);
+
+    for (size_t offset = 0; offset < 16; offset++)
+    {
+        for (size_t len = 0; len + offset <= buf.size(); len++)
+        {
+            const uint8_t* p = buf.data() + offset;
+
+            ASSERT_EQ(pldm_crc32_update_hw(0x5a5a5a5a, p, len),
+                      pldm_crc32_update_bytewise(0x5a5a5a5a, p, len))
+                << "offset " << offset << ", length " << len;
+        }
+    }
+}
+#endif
@@ -0,0 +1,499 @@
+#include <libpldm/base.h>
+#include <libpldm/firmware_fd.h>
+#include <libpldm/firmware_update.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#ifdef LIBPLDM_API_TESTING
+static constexpr pldm_tid_t uaAddress = 8;
+static constexpr uint16_t compId = 0x10;
+static constexpr size_t bufSize = 1024;
+
+static const uint8_t iana[] = {0xcf, 0xc2, 0x00, 0x00};
+
+static const pldm_descriptor descriptors[] = {
+    {
+        .descriptor_type = PLDM_FWUP_IANA_ENTERPRISE_ID,
+        .descriptor_length = PLDM_FWUP_IANA_ENTERPRISE_ID_LENGTH,
+        .descriptor_data = iana,
+    },
+};
+
+static pldm_firmware_component_standalone makeComp()
+{
+    pldm_firmware_component_standalone comp{};
+    comp.comp_classification = PLDM_COMP_FIRMWARE;
+    comp.comp_identifier = compId;
+    comp.active_ver.comparison_stamp = 1;
+    comp.active_ver.str.str_type = PLDM_STR_TYPE_ASCII;
+    comp.active_ver.str.str_len = 4;
+    memcpy(comp.active_ver.str.str_data, "cv01", 4);
+    comp.pending_ver = comp.active_ver;
+    return comp;
+}
+
+static const pldm_firmware_component_standalone comp = makeComp();
+static const pldm_firmware_component_standalone* compList[] = {&comp};
+
+static const struct variable_field version = {
+    .ptr = reinterpret_cast<const uint8_t*>("cv02"),
+    .length = 4,
+};
+
+/* A RequestFirmwareData request from the FD */
+struct FwDataReq
+{
+    uint8_t instance;
+    uint32_t offset;
+    uint32_t length;
+};
+
+/* Drives a single FD through an update, scripting the UA's responses to its
+ * RequestFirmwareData requests against a test clock */
+class FirmwareFd : public testing::Test
+{
+  protected:
+    uint64_t now = 1000;
+    std::vector<std::pair<uint32_t, uint32_t>> received;
+    std::unique_ptr<pldm_fd, decltype(&free)> fd{nullptr, free};
+    struct pldm_fd_ops ops = {
+        .device_identifiers = cbDeviceIdentifiers,
+        .components = cbComponents,
+        .imageset_versions = cbImagesetVersions,
+        .update_component = cbUpdateComponent,
+        .transfer_size = cbTransferSize,
+        .firmware_data = cbFirmwareData,
+        .verify = cbVerify,
+        .apply = cbApply,
+        .activate = cbActivate,
+        .cancel_update_component = cbCancelUpdateComponent,
+        .now = cbNow,
+    };
+
+    void SetUp() override
+    {
+        fd.reset(pldm_fd_new(&ops, this, nullptr));
+        ASSERT_NE(fd, nullptr);
+    }
+
+    static int cbDeviceIdentifiers(void* /*ctx*/, uint8_t* count,
+                                   const struct pldm_descriptor** entries)
+    {
+        *count = 1;
+        *entries = descriptors;
+        return 0;
+    }
+
+    static int cbComponents(
+        void* /*ctx*/, uint16_t* count,
+        const struct pldm_firmware_component_standalone*** entries)
+    {
+        *count = 1;
+        *entries = compList;
+        return 0;
+    }
+
+    static int cbImagesetVersions(void* /*ctx*/,
+                                  struct pldm_firmware_string* active,
+                                  struct pldm_firmware_string* pending)
+    {
+        active->str_type = PLDM_STR_TYPE_ASCII;
+        active->str_len = 4;
+        memcpy(active->str_data, "set0", 4);
+        *pending = *active;
+        return 0;
+    }
+
+    static enum pldm_component_response_codes cbUpdateComponent(
+        void* /*ctx*/, bool /*update*/,
+        const struct pldm_firmware_update_component* /*comp*/)
+    {
+        return PLDM_CRC_COMP_CAN_BE_UPDATED;
+    }
+
+    static uint32_t cbTransferSize(void* /*ctx*/, uint32_t uaMax)
+    {
+        return uaMax;
+    }
+
+    static uint8_t
+        cbFirmwareData(void* ctx, uint32_t offset, const uint8_t* data,
+                       uint32_t len,
+                       const struct pldm_firmware_update_component* /*comp*/)
+    {
+        auto* self = static_cast<FirmwareFd*>(ctx);
+
+        for (uint32_t i = 0; i < len; i++)
+        {
+            EXPECT_EQ(data[i], (offset + i) & 0xff);
+        }
+        self->received.emplace_back(offset, len);
+        return PLDM_FWUP_TRANSFER_SUCCESS;
+    }
+
+    static uint8_t
+        cbVerify(void* /*ctx*/,
+                 const struct pldm_firmware_update_component* /*comp*/,
+                 bool* /*pending*/, uint8_t* /*progress*/)
+    {
+        return PLDM_FWUP_VERIFY_SUCCESS;
+    }
+
+    static uint8_t
+        cbApply(void* /*ctx*/,
+                const struct pldm_firmware_update_component* /*comp*/,
+                bool* /*pending*/, uint8_t* /*progress*/)
+    {
+        return PLDM_FWUP_APPLY_SUCCESS;
+    }
+
+    static uint8_t cbActivate(void* /*ctx*/, bool /*selfContained*/,
+                              uint16_t* /*estimatedTime*/)
+    {
+        return PLDM_SUCCESS;
+    }
+
+    static void cbCancelUpdateComponent(
+        void* /*ctx*/, const struct pldm_firmware_update_component* /*comp*/)
+    {}
+
+    static uint64_t cbNow(void* ctx)
+    {
+        return static_cast<FirmwareFd*>(ctx)->now;
+    }
+
+    /* Pass a UA request to the FD, expecting a successful response */
+    void request(std::vector<uint8_t>& req)
+    {
+        uint8_t resp[bufSize];
+        size_t respLen = sizeof(resp);
+
+        ASSERT_EQ(pldm_fd_handle_msg(fd.get(), uaAddress, req.data(),
+                                     req.size(), resp, &respLen),
+                  0);
+        ASSERT_GT(respLen, sizeof(pldm_msg_hdr));
+        EXPECT_EQ(resp[sizeof(pldm_msg_hdr)], PLDM_SUCCESS);
+    }
+
+    /* Take the FD to the Download state for a component of size bytes */
+    void startDownload(uint32_t maxTransfer, uint32_t size)
+    {
+        std::vector<uint8_t> req;
+        pldm_msg* msg;
+
+        req.assign(sizeof(pldm_msg_hdr) +
+                       sizeof(struct pldm_request_update_req) + 4,
+                   0);
+        msg = reinterpret_cast<pldm_msg*>(req.data());
+        ASSERT_EQ(encode_request_update_req(
+                      0, maxTransfer, 1, 1, 0, PLDM_STR_TYPE_ASCII, 4,
+                      &version, msg, req.size() - sizeof(pldm_msg_hdr)),
+                  0);
+        request(req);
+
+        req.assign(sizeof(pldm_msg_hdr) +
+                       sizeof(struct pldm_pass_component_table_req) + 4,
+                   0);
+        msg = reinterpret_cast<pldm_msg*>(req.data());
+        ASSERT_EQ(encode_pass_component_table_req(
+                      1, PLDM_START_AND_END, PLDM_COMP_FIRMWARE, compId, 0, 2,
+                      PLDM_STR_TYPE_ASCII, 4, &version, msg,
+                      req.size() - sizeof(pldm_msg_hdr)),
+                  0);
+        request(req);
+
+        bitfield32_t flags = {.value = 0};
+        req.assign(sizeof(pldm_msg_hdr) +
+                       sizeof(struct pldm_update_component_req) + 4,
+                   0);
+        msg = reinterpret_cast<pldm_msg*>(req.data());
+        ASSERT_EQ(encode_update_component_req(
+                      2, PLDM_COMP_FIRMWARE, compId, 0, 2, size, flags,
+                      PLDM_STR_TYPE_ASCII, 4, &version, msg,
+                      req.size() - sizeof(pldm_msg_hdr)),
+                  0);
+        request(req);
+    }
+
+    /* The next RequestFirmwareData request from the FD, if any */
+    bool next(FwDataReq& fwReq)
+    {
+        uint8_t req[bufSize];
+        size_t reqLen = sizeof(req);
+        pldm_tid_t address = 0;
+        auto* msg = reinterpret_cast<pldm_msg*>(req);
+
+        EXPECT_EQ(pldm_fd_progress(fd.get(), req, &reqLen, &address), 0);
+        if (!reqLen)
+        {
+            return false;
+        }
+        EXPECT_EQ(address, uaAddress);
+        EXPECT_EQ(msg->hdr.command, PLDM_REQUEST_FIRMWARE_DATA);
+        fwReq.instance = msg->hdr.instance_id;
+        EXPECT_EQ(decode_request_firmware_data_req(
+                      msg, reqLen - sizeof(pldm_msg_hdr), &fwReq.offset,
+                      &fwReq.length),
+                  0);
+        return true;
+    }
+
+    /* Answer a RequestFirmwareData request, returning the FD's result */
+    int respond(const FwDataReq& fwReq, uint8_t cc = PLDM_SUCCESS)
+    {
+        std::vector<uint8_t> resp(sizeof(pldm_msg_hdr) + 1);
+        size_t respLen = 0;
+        uint8_t out[bufSize];
+
+        if (cc == PLDM_SUCCESS)
+        {
+            for (uint32_t i = 0; i < fwReq.length; i++)
+            {
+                resp.push_back((fwReq.offset + i) & 0xff);
+            }
+        }
+        EXPECT_EQ(encode_request_firmware_data_resp(
+                      fwReq.instance, cc,
+                      reinterpret_cast<pldm_msg*>(resp.data()),
+                      resp.size() - sizeof(pldm_msg_hdr)),
+                  0);
+        respLen = sizeof(out);
+        return pldm_fd_handle_msg(fd.get(), uaAddress, resp.data(),
+                                  resp.size(), out, &respLen);
+    }
+
+    uint64_t deadline()
+    {
+        uint64_t deadline = 0;
+
+        EXPECT_EQ(pldm_fd_next_deadline(fd.get(), &deadline), 0);
+        return deadline;
+    }
+
+    pldm_fd_transfer_stats stats()
+    {
+        pldm_fd_transfer_stats stats{};
+
+        EXPECT_EQ(pldm_fd_get_transfer_stats(fd.get(), &stats), 0);
+        return stats;
+    }
+};
+
+TEST_F(FirmwareFd, droppedChunkRetriedWithNewInstance)
+{
+    FwDataReq first;
+    FwDataReq retry;
+    FwDataReq rest;
+
+    ASSERT_NO_FATAL_FAILURE(startDownload(256, 1024));
+
+    ASSERT_TRUE(next(first));
+    EXPECT_EQ(first.offset, 0);
+    EXPECT_EQ(first.length, 256);
+
+    /* The window of one is full until FD_T2 after the request */
+    FwDataReq none;
+    EXPECT_FALSE(next(none));
+    EXPECT_EQ(deadline(), 2000);
+    now = 1999;
+    EXPECT_FALSE(next(none));
+
+    /* The response was dropped, so the chunk is sent again, cut to the
+     * halved length, with its remainder pending in another slot */
+    now = 2000;
+    ASSERT_TRUE(next(retry));
+    EXPECT_NE(retry.instance, first.instance);
+    EXPECT_EQ(retry.offset, 0);
+    EXPECT_EQ(retry.length, 128);
+
+    /* A late response to the dropped request no longer matches */
+    EXPECT_EQ(respond(first), -EPROTO);
+    EXPECT_TRUE(received.empty());
+
+    EXPECT_EQ(respond(retry), 0);
+    ASSERT_TRUE(next(rest));
+    EXPECT_NE(rest.instance, retry.instance);
+    EXPECT_EQ(rest.offset, 128);
+    EXPECT_EQ(rest.length, 128);
+    EXPECT_EQ(respond(rest), 0);
+
+    std::vector<std::pair<uint32_t, uint32_t>> expected = {{0, 128},
+                                                           {128, 128}};
+    EXPECT_EQ(received, expected);
+}
+
+TEST_F(FirmwareFd, failedChunkSplitsIntoPendingRemainder)
+{
+    FwDataReq req;
+    FwDataReq rest;
+    FwDataReq tail;
+
+    ASSERT_NO_FATAL_FAILURE(startDownload(256, 320));
+    ASSERT_EQ(pldm_fd_set_request_window(fd.get(), 2), 0);
+
+    ASSERT_TRUE(next(req));
+    EXPECT_EQ(req.offset, 0);
+    EXPECT_EQ(req.length, 256);
+
+    /* The remainder of the failed chunk is requested before new data, while
+     * the shortened chunk waits for its retry */
+    EXPECT_EQ(respond(req, PLDM_FWUP_RETRY_REQUEST_FW_DATA), 0);
+    ASSERT_TRUE(next(rest));
+    EXPECT_EQ(rest.offset, 128);
+    EXPECT_EQ(rest.length, 128);
+
+    /* The window is full with the retry and the remainder */
+    FwDataReq none;
+    EXPECT_FALSE(next(none));
+    EXPECT_EQ(deadline(), 2000);
+
+    EXPECT_EQ(respond(rest), 0);
+    ASSERT_TRUE(next(tail));
+    EXPECT_EQ(tail.offset, 256);
+    EXPECT_EQ(tail.length, 64);
+    EXPECT_EQ(respond(tail), 0);
+
+    now = 2000;
+    ASSERT_TRUE(next(req));
+    EXPECT_EQ(req.offset, 0);
+    EXPECT_EQ(req.length, 128);
+    EXPECT_EQ(respond(req), 0);
+
+    std::vector<std::pair<uint32_t, uint32_t>> expected = {
+        {128, 128}, {256, 64}, {0, 128}};
+    EXPECT_EQ(received, expected);
+}
+
+TEST_F(FirmwareFd, windowDeadline)
+{
+    FwDataReq a;
+    FwDataReq b;
+
+    uint64_t t;
+    EXPECT_EQ(pldm_fd_next_deadline(fd.get(), &t), -ENODATA);
+
+    ASSERT_NO_FATAL_FAILURE(startDownload(256, 1024));
+    ASSERT_EQ(pldm_fd_set_request_window(fd.get(), 2), 0);
+
+    /* A request can be sent while the window has space */
+    EXPECT_EQ(deadline(), now);
+    ASSERT_TRUE(next(a));
+    EXPECT_EQ(deadline(), now);
+
+    /* With the window full, wake for the first retry */
+    now = 1100;
+    ASSERT_TRUE(next(b));
+    EXPECT_EQ(b.offset, 256);
+    EXPECT_EQ(deadline(), 2000);
+
+    /* Responses are matched by instance ID, in any order */
+    now = 1500;
+    EXPECT_EQ(respond(b), 0);
+    EXPECT_EQ(deadline(), now);
+    ASSERT_TRUE(next(b));
+    EXPECT_EQ(b.offset, 512);
+    EXPECT_EQ(deadline(), 2000);
+    EXPECT_EQ(respond(a), 0);
+    EXPECT_EQ(deadline(), now);
+}
+
+TEST_F(FirmwareFd, sizeHalvesToFloor)
+{
+    FwDataReq req;
+
+    ASSERT_NO_FATAL_FAILURE(startDownload(256, 1024));
+
+    ASSERT_TRUE(next(req));
+    EXPECT_EQ(req.length, 256);
+
+    /* Each failure halves the length of the retry, down to the baseline */
+    for (uint32_t expected : {128, 64, 32, 32})
+    {
+        EXPECT_EQ(respond(req, PLDM_FWUP_RETRY_REQUEST_FW_DATA), 0);
+        EXPECT_EQ(stats().transfer_size, expected);
+        now += 1000;
+        ASSERT_TRUE(next(req));
+        EXPECT_EQ(req.offset, 0);
+        EXPECT_EQ(req.length, expected);
+    }
+    EXPECT_EQ(stats().failures, 4);
+}
+
+TEST_F(FirmwareFd, sizeGrowsUntilSlow)
+{
+    FwDataReq req;
+
+    ASSERT_NO_FATAL_FAILURE(startDownload(256, 4096));
+
+    ASSERT_TRUE(next(req));
+    EXPECT_EQ(respond(req, PLDM_FWUP_RETRY_REQUEST_FW_DATA), 0);
+    EXPECT_EQ(stats().transfer_size, 128);
+
+    /* A retried chunk grows the length, but isn't timed */
+    now = 2000;
+    ASSERT_TRUE(next(req));
+    EXPECT_EQ(req.length, 128);
+    now = 2500;
+    EXPECT_EQ(respond(req), 0);
+    EXPECT_EQ(stats().transfer_size, 160);
+    EXPECT_EQ(stats().response_time, 0);
+
+    /* Response times in ms, and the length following each response. The
+     * length holds when a response takes over twice the smoothed time */
+    const std::vector<std::pair<uint64_t, uint32_t>> steps = {
+        {10, 192}, {10, 224}, {30, 224}, {10, 256}, {10, 256},
+    };
+    for (const auto& [rtt, size] : steps)
+    {
+        ASSERT_TRUE(next(req));
+        now += rtt;
+        EXPECT_EQ(respond(req), 0);
+        EXPECT_EQ(stats().transfer_size, size);
+    }
+    /* Smoothed over samples of 10, 10, 30, 10 and 10 ms with a gain of 1/8 */
+    EXPECT_EQ(stats().response_time, 96 / 8);
+    EXPECT_EQ(stats().failures, 1);
+}
+
+TEST_F(FirmwareFd, transferStats)
+{
+    FwDataReq req;
+    pldm_fd_transfer_stats st;
+
+    EXPECT_EQ(pldm_fd_get_transfer_stats(fd.get(), &st), -ENODATA);
+    ASSERT_NO_FATAL_FAILURE(startDownload(256, 512));
+    EXPECT_EQ(pldm_fd_get_transfer_stats(fd.get(), &st), -ENODATA);
+
+    ASSERT_TRUE(next(req));
+    now = 1100;
+    EXPECT_EQ(respond(req), 0);
+    st = stats();
+    EXPECT_EQ(st.transfer_size, 256);
+    EXPECT_EQ(st.received, 256);
+    EXPECT_EQ(st.failures, 0);
+    EXPECT_EQ(st.response_time, 100);
+    EXPECT_EQ(st.bytes_per_sec, 2560);
+
+    ASSERT_TRUE(next(req));
+    now = 1300;
+    EXPECT_EQ(respond(req), 0);
+    st = stats();
+    EXPECT_EQ(st.received, 512);
+    EXPECT_EQ(st.response_time, 900 / 8);
+    EXPECT_EQ(st.bytes_per_sec, 512 * 1000 / 300);
+
+    /* The rate stops at the end of the download */
+    now = 5000;
+    EXPECT_EQ(stats().bytes_per_sec, 512 * 1000 / 300);
+
+    /* The TransferComplete is due */
+    EXPECT_EQ(deadline(), now);
+}
+#endif
@@ -0,0 +1,661 @@
+#include <libpldm/base.h>
+#include <libpldm/firmware_fd.h>
+#include <libpldm/firmware_ua.h>
+#include <libpldm/firmware_update.h>
+#include <libpldm/utils.h>
+
+#include <endian.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#ifdef LIBPLDM_API_TESTING
+static constexpr pldm_tid_t uaAddress = 8;
+static constexpr size_t bufSize = 1024;
+
+static const uint8_t openbmcIana[] = {0xcf, 0xc2, 0x00, 0x00};
+static const uint8_t otherIana[] = {0x01, 0x02, 0x00, 0x00};
+
+static const std::vector<uint16_t> compIds = {0x10, 0x20};
+static const std::vector<uint32_t> compSizes = {1500, 301};
+
+static void put8(std::vector<uint8_t>& v, uint8_t x)
+{
+    v.push_back(x);
+}
+
+static void put16(std::vector<uint8_t>& v, uint16_t x)
+{
+    v.push_back(x & 0xff);
+    v.push_back(x >> 8);
+}
+
+static void put32(std::vector<uint8_t>& v, uint32_t x)
+{
+    put16(v, x & 0xffff);
+    put16(v, x >> 16);
+}
+
+static void putStr(std::vector<uint8_t>& v, const std::string& s)
+{
+    v.insert(v.end(), s.begin(), s.end());
+}
+
+static void set32(std::vector<uint8_t>& v, size_t pos, uint32_t x)
+{
+    uint32_t le = htole32(x);
+    memcpy(&v[pos], &le, sizeof(le));
+}
+
+struct Record
+{
+    const uint8_t* iana;
+    uint8_t applicable;
+};
+
+static std::vector<uint8_t> image(size_t comp)
+{
+    std::vector<uint8_t> data(compSizes[comp]);
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = (i * 7 + comp * 13) & 0xff;
+    }
+    return data;
+}
+
+/* A format revision 1 package with the components of compIds */
+static std::vector<uint8_t> buildPackage(const std::vector<Record>& records)
+{
+    std::vector<uint8_t> pkg(16, 0xa5);
+    std::vector<size_t> offsetPos;
+
+    put8(pkg, 0x01);
+    size_t headerSizePos = pkg.size();
+    put16(pkg, 0);
+    pkg.insert(pkg.end(), PLDM_TIMESTAMP104_SIZE, 0);
+    put16(pkg, 8);
+    put8(pkg, PLDM_STR_TYPE_ASCII);
+    put8(pkg, 4);
+    putStr(pkg, "pkg1");
+
+    put8(pkg, records.size());
+    for (const auto& record : records)
+    {
+        /* Header, bitmap, version, IANA descriptor */
+        put16(pkg, 11 + 1 + 4 + 8);
+        put8(pkg, 1);
+        put32(pkg, 0);
+        put8(pkg, PLDM_STR_TYPE_ASCII);
+        put8(pkg, 4);
+        put16(pkg, 0);
+        put8(pkg, record.applicable);
+        putStr(pkg, "set1");
+        put16(pkg, PLDM_FWUP_IANA_ENTERPRISE_ID);
+        put16(pkg, PLDM_FWUP_IANA_ENTERPRISE_ID_LENGTH);
+        pkg.insert(pkg.end(), record.iana,
+                   record.iana + PLDM_FWUP_IANA_ENTERPRISE_ID_LENGTH);
+    }
+
+    put16(pkg, compIds.size());
+    for (size_t i = 0; i < compIds.size(); i++)
+    {
+        put16(pkg, PLDM_COMP_FIRMWARE);
+        put16(pkg, compIds[i]);
+        put32(pkg, 2);
+        /* Use ComponentComparisonStamp */
+        put16(pkg, 0x0002);
+        put16(pkg, 0);
+        offsetPos.push_back(pkg.size());
+        put32(pkg, 0);
+        put32(pkg, compSizes[i]);
+        put8(pkg, PLDM_STR_TYPE_ASCII);
+        put8(pkg, 4);
+        putStr(pkg, "cv02");
+    }
+
+    size_t headerSize = pkg.size() + 4;
+    pkg[headerSizePos] = headerSize & 0xff;
+    pkg[headerSizePos + 1] = headerSize >> 8;
+
+    /* Images follow the header */
+    size_t offset = headerSize;
+    for (size_t i = 0; i < compIds.size(); i++)
+    {
+        set32(pkg, offsetPos[i], offset);
+        offset += compSizes[i];
+    }
+    put32(pkg, pldm_edac_crc32(pkg.data(), pkg.size()));
+
+    for (size_t i = 0; i < compIds.size(); i++)
+    {
+        auto data = image(i);
+        pkg.insert(pkg.end(), data.begin(), data.end());
+    }
+
+    return pkg;
+}
+
+struct Device
+{
+    pldm_tid_t address;
+    uint64_t* now;
+    std::unique_ptr<pldm_fd, decltype(&free)> fd{nullptr, free};
+    bool declineUpdate = false;
+    /* Drop all messages to the device */
+    bool unresponsive = false;
+    /* Drop the response to the next RequestUpdate */
+    bool dropRequestUpdateResp = false;
+    /* Report a modified activation method in ApplyComplete */
+    bool applyActivationMethod = false;
+    bool cancelled = false;
+    bool activated = false;
+    std::map<uint16_t, std::vector<uint8_t>> received;
+};
+
+static const pldm_descriptor deviceDescriptors[] = {
+    {
+        .descriptor_type = PLDM_FWUP_IANA_ENTERPRISE_ID,
+        .descriptor_length = PLDM_FWUP_IANA_ENTERPRISE_ID_LENGTH,
+        .descriptor_data = openbmcIana,
+    },
+};
+
+static int cbDeviceIdentifiers(void* /*ctx*/, uint8_t* count,
+                               const struct pldm_descriptor** descriptors)
+{
+    *count = 1;
+    *descriptors = deviceDescriptors;
+    return 0;
+}
+
+static pldm_firmware_component_standalone makeComp(uint16_t id)
+{
+    pldm_firmware_component_standalone comp{};
+    comp.comp_classification = PLDM_COMP_FIRMWARE;
+    comp.comp_identifier = id;
+    comp.active_ver.comparison_stamp = 1;
+    comp.active_ver.str.str_type = PLDM_STR_TYPE_ASCII;
+    comp.active_ver.str.str_len = 4;
+    memcpy(comp.active_ver.str.str_data, "cv01", 4);
+    comp.pending_ver = comp.active_ver;
+    return comp;
+}
+
+static const pldm_firmware_component_standalone comp0 = makeComp(compIds[0]);
+static const pldm_firmware_component_standalone comp1 = makeComp(compIds[1]);
+static const pldm_firmware_component_standalone* compList[] = {&comp0,
+                                                               &comp1};
+
+static int
+    cbComponents(void* /*ctx*/, uint16_t* count,
+                 const struct pldm_firmware_component_standalone*** entries)
+{
+    *count = 2;
+    *entries = compList;
+    return 0;
+}
+
+static int cbImagesetVersions(void* /*ctx*/,
+                              struct pldm_firmware_string* active,
+                              struct pldm_firmware_string* pending)
+{
+    active->str_type = PLDM_STR_TYPE_ASCII;
+    active->str_len = 4;
+    memcpy(active->str_data, "set0", 4);
+    *pending = *active;
+    return 0;
+}
+
+static enum pldm_component_response_codes
+    cbUpdateComponent(void* ctx, bool update,
+                      const struct pldm_firmware_update_component* comp)
+{
+    auto* dev = static_cast<Device*>(ctx);
+
+    if (update && dev->declineUpdate)
+    {
+        return PLDM_CRC_COMP_PREREQUISITES_NOT_MET;
+    }
+    if (update)
+    {
+        dev->received[comp->comp_identifier].assign(comp->comp_image_size,
+                                                     0);
+    }
+    return PLDM_CRC_COMP_CAN_BE_UPDATED;
+}
+
+static uint32_t cbTransferSize(void* /*ctx*/, uint32_t uaMax)
+{
+    return uaMax;
+}
+
+static uint8_t cbFirmwareData(void* ctx, uint32_t offset, const uint8_t* data,
+                              uint32_t len,
+                              const struct pldm_firmware_update_component* comp)
+{
+    auto* dev = static_cast<Device*>(ctx);
+    auto& buf = dev->received[comp->comp_identifier];
+
+    EXPECT_LE(offset + len, buf.size());
+    memcpy(buf.data() + offset, data, len);
+    return PLDM_FWUP_TRANSFER_SUCCESS;
+}
+
+static uint8_t cbVerify(void* /*ctx*/,
+                        const struct pldm_firmware_update_component* /*comp*/,
+                        bool* /*pending*/, uint8_t* /*progress*/)
+{
+    return PLDM_FWUP_VERIFY_SUCCESS;
+}
+
+static uint8_t cbApply(void* /*ctx*/,
+                       const struct pldm_firmware_update_component* /*comp*/,
+                       bool* /*pending*/, uint8_t* /*progress*/)
+{
+    return PLDM_FWUP_APPLY_SUCCESS;
+}
+
+static uint8_t cbActivate(void* ctx, bool selfContained,
+                          uint16_t* /*estimatedTime*/)
+{
+    auto* dev = static_cast<Device*>(ctx);
+
+    EXPECT_FALSE(selfContained);
+    dev->activated = true;
+    return PLDM_SUCCESS;
+}
+
+static void
+    cbCancelUpdateComponent(void* ctx,
+                            const struct pldm_firmware_update_component* /*c*/)
+{
+    static_cast<Device*>(ctx)->cancelled = true;
+}
+
+static uint64_t cbFdNow(void* ctx)
+{
+    return *static_cast<Device*>(ctx)->now;
+}
+
+static const struct pldm_fd_ops fdOps = {
+    .device_identifiers = cbDeviceIdentifiers,
+    .components = cbComponents,
+    .imageset_versions = cbImagesetVersions,
+    .update_component = cbUpdateComponent,
+    .transfer_size = cbTransferSize,
+    .firmware_data = cbFirmwareData,
+    .verify = cbVerify,
+    .apply = cbApply,
+    .activate = cbActivate,
+    .cancel_update_component = cbCancelUpdateComponent,
+    .now = cbFdNow,
+};
+
+class FirmwareUa : public testing::Test
+{
+  protected:
+    uint64_t now = 1000;
+    std::map<pldm_tid_t, int> results;
+    std::vector<std::unique_ptr<Device>> devs;
+    struct pldm_ua_ops uaOps = {
+        .update_complete = cbUpdateComplete,
+        .now = cbUaNow,
+    };
+    std::unique_ptr<pldm_ua, decltype(&pldm_ua_destroy)> ua{nullptr,
+                                                            pldm_ua_destroy};
+    std::unique_ptr<pldm_ua_package, decltype(&pldm_ua_package_destroy)> pkg{
+        nullptr, pldm_ua_package_destroy};
+    std::vector<uint8_t> pkgData;
+
+    void SetUp() override
+    {
+        pkgData = buildPackage({{openbmcIana, 0x03}});
+        struct pldm_ua_package* p = nullptr;
+        ASSERT_EQ(pldm_ua_package_init(&p, pkgData.data(), pkgData.size()), 0);
+        pkg.reset(p);
+        ua.reset(pldm_ua_new(&uaOps, this, 8));
+        ASSERT_NE(ua, nullptr);
+    }
+
+    static void cbUpdateComplete(void* ctx, pldm_tid_t address, int result)
+    {
+        auto* self = static_cast<FirmwareUa*>(ctx);
+        EXPECT_EQ(self->results.count(address), 0);
+        self->results[address] = result;
+    }
+
+    static uint64_t cbUaNow(void* ctx)
+    {
+        return static_cast<FirmwareUa*>(ctx)->now;
+    }
+
+    Device& addDevice(pldm_tid_t address)
+    {
+        devs.push_back(std::make_unique<Device>());
+        Device& dev = *devs.back();
+        dev.address = address;
+        dev.now = &now;
+        dev.fd.reset(pldm_fd_new(&fdOps, &dev, nullptr));
+        EXPECT_NE(dev.fd, nullptr);
+        return dev;
+    }
+
+    Device* device(pldm_tid_t address)
+    {
+        for (auto& dev : devs)
+        {
+            if (dev->address == address)
+            {
+                return dev.get();
+            }
+        }
+        return nullptr;
+    }
+
+    /* Pass messages between the UA and the FDs, advancing time when both
+     * sides are idle, until every update has completed */
+    void run(size_t expected)
+    {
+        for (int i = 0; i < 100000 && results.size() < expected; i++)
+        {
+            bool busy = false;
+            uint8_t req[bufSize];
+            uint8_t resp[bufSize];
+            size_t reqLen;
+            size_t respLen;
+            pldm_tid_t address;
+
+            reqLen = sizeof(req);
+            ASSERT_EQ(pldm_ua_progress(ua.get(), req, &reqLen, &address), 0);
+            if (reqLen)
+            {
+                busy = true;
+                Device* dev = device(address);
+                ASSERT_NE(dev, nullptr);
+                auto* hdr = reinterpret_cast<pldm_msg_hdr*>(req);
+                respLen = sizeof(resp);
+                if (!dev->unresponsive)
+                {
+                    ASSERT_EQ(pldm_fd_handle_msg(dev->fd.get(), uaAddress,
+                                                 req, reqLen, resp, &respLen),
+                              0);
+                }
+                bool drop = dev->unresponsive ||
+                            (hdr->command == PLDM_REQUEST_UPDATE &&
+                             dev->dropRequestUpdateResp);
+                if (hdr->command == PLDM_REQUEST_UPDATE)
+                {
+                    dev->dropRequestUpdateResp = false;
+                }
+                if (!drop && respLen)
+                {
+                    size_t outLen = sizeof(req);
+                    ASSERT_EQ(pldm_ua_handle_msg(ua.get(), address, resp,
+                                                 respLen, req, &outLen),
+                              0);
+                    EXPECT_EQ(outLen, 0);
+                }
+            }
+
+            for (auto& dev : devs)
+            {
+                if (dev->unresponsive)
+                {
+                    continue;
+                }
+                /* Fails outside the FD-driven states, with no request */
+                reqLen = sizeof(req);
+                pldm_fd_progress(dev->fd.get(), req, &reqLen, &address);
+                if (!reqLen)
+                {
+                    continue;
+                }
+                busy = true;
+                EXPECT_EQ(address, uaAddress);
+                auto* msg = reinterpret_cast<pldm_msg*>(req);
+                if (msg->hdr.command == PLDM_APPLY_COMPLETE &&
+                    dev->applyActivationMethod)
+                {
+                    /* The FD reports plain success, rewrite the
+                     * ApplyResult and ComponentActivationMethodsModification */
+                    ASSERT_EQ(reqLen, sizeof(pldm_msg_hdr) +
+                                          sizeof(pldm_apply_complete_req));
+                    msg->payload[0] =
+                        PLDM_FWUP_APPLY_SUCCESS_WITH_ACTIVATION_METHOD;
+                    msg->payload[1] = 0x01;
+                    msg->payload[2] = 0x00;
+                }
+                respLen = sizeof(resp);
+                ASSERT_EQ(pldm_ua_handle_msg(ua.get(), dev->address, req,
+                                             reqLen, resp, &respLen),
+                          0);
+                size_t outLen = sizeof(req);
+                ASSERT_EQ(pldm_fd_handle_msg(dev->fd.get(), uaAddress, resp,
+                                             respLen, req, &outLen),
+                          0);
+            }
+
+            if (!busy)
+            {
+                uint64_t deadline;
+                if (pldm_ua_next_deadline(ua.get(), &deadline) == 0 &&
+                    deadline > now)
+                {
+                    now = deadline;
+                }
+                else
+                {
+                    now += 100;
+                }
+            }
+        }
+        ASSERT_EQ(results.size(), expected);
+    }
+
+    void expectUpdated(const Device& dev)
+    {
+        EXPECT_EQ(results.at(dev.address), 0);
+        EXPECT_TRUE(dev.activated);
+        for (size_t i = 0; i < compIds.size(); i++)
+        {
+            EXPECT_EQ(dev.received.at(compIds[i]), image(i));
+        }
+    }
+};
+
+TEST_F(FirmwareUa, UpdateOneDevice)
+{
+    Device& dev = addDevice(20);
+
+    ASSERT_EQ(pldm_ua_start(ua.get(), dev.address, pkg.get(), 0), 0);
+    run(1);
+    expectUpdated(dev);
+
+    uint64_t deadline;
+    EXPECT_EQ(pldm_ua_next_deadline(ua.get(), &deadline), -ENODATA);
+}
+
+TEST_F(FirmwareUa, UpdateConcurrentDevices)
+{
+    for (pldm_tid_t address = 20; address < 28; address++)
+    {
+        Device& dev = addDevice(address);
+        if (address % 2)
+        {
+            ASSERT_EQ(pldm_fd_set_request_window(dev.fd.get(), 4), 0);
+        }
+    }
+    ASSERT_EQ(pldm_ua_set_transfer_size(ua.get(), 128), 0);
+
+    for (auto& dev : devs)
+    {
+        ASSERT_EQ(pldm_ua_start(ua.get(), dev->address, pkg.get(), 0), 0);
+    }
+    EXPECT_EQ(pldm_ua_start(ua.get(), 30, pkg.get(), 0), -ENOSPC);
+    EXPECT_EQ(pldm_ua_start(ua.get(), 20, pkg.get(), 0), -EBUSY);
+
+    run(devs.size());
+    for (auto& dev : devs)
+    {
+        expectUpdated(*dev);
+    }
+}
+
+TEST_F(FirmwareUa, LostRequestUpdateResponse)
+{
+    Device& dev = addDevice(20);
+    dev.dropRequestUpdateResp = true;
+
+    ASSERT_EQ(pldm_ua_start(ua.get(), dev.address, pkg.get(), 0), 0);
+    run(1);
+    expectUpdated(dev);
+}
+
+TEST_F(FirmwareUa, ApplyWithActivationMethod)
+{
+    Device& dev = addDevice(20);
+    dev.applyActivationMethod = true;
+
+    ASSERT_EQ(pldm_ua_start(ua.get(), dev.address, pkg.get(), 0), 0);
+    run(1);
+    expectUpdated(dev);
+}
+
+TEST_F(FirmwareUa, AllComponentsDeclined)
+{
+    Device& dev = addDevice(20);
+    dev.declineUpdate = true;
+
+    ASSERT_EQ(pldm_ua_start(ua.get(), dev.address, pkg.get(), 0), 0);
+    run(1);
+    EXPECT_EQ(results.at(dev.address), -EALREADY);
+    EXPECT_FALSE(dev.activated);
+}
+
+TEST_F(FirmwareUa, Cancel)
+{
+    Device& dev = addDevice(20);
+
+    EXPECT_EQ(pldm_ua_cancel(ua.get(), dev.address), -ENOENT);
+
+    /* Before anything was sent */
+    ASSERT_EQ(pldm_ua_start(ua.get(), dev.address, pkg.get(), 0), 0);
+    ASSERT_EQ(pldm_ua_cancel(ua.get(), dev.address), 0);
+    EXPECT_EQ(results.at(dev.address), -ECANCELED);
+    results.clear();
+
+    /* During the transfer */
+    ASSERT_EQ(pldm_ua_start(ua.get(), dev.address, pkg.get(), 0), 0);
+    for (int i = 0; i < 1000 && dev.received.empty(); i++)
+    {
+        uint8_t req[bufSize];
+        uint8_t resp[bufSize];
+        size_t reqLen = sizeof(req);
+        size_t respLen = sizeof(resp);
+        pldm_tid_t address;
+
+        ASSERT_EQ(pldm_ua_progress(ua.get(), req, &reqLen, &address), 0);
+        ASSERT_NE(reqLen, 0);
+        ASSERT_EQ(pldm_fd_handle_msg(dev.fd.get(), uaAddress, req, reqLen,
+                                     resp, &respLen),
+                  0);
+        reqLen = sizeof(req);
+        ASSERT_EQ(pldm_ua_handle_msg(ua.get(), address, resp, respLen, req,
+                                     &reqLen),
+                  0);
+    }
+    ASSERT_EQ(pldm_ua_cancel(ua.get(), dev.address), 0);
+    run(1);
+    EXPECT_EQ(results.at(dev.address), -ECANCELED);
+    EXPECT_TRUE(dev.cancelled);
+    EXPECT_FALSE(dev.activated);
+}
+
+TEST_F(FirmwareUa, UnresponsiveDevice)
+{
+    Device& dev = addDevice(20);
+    dev.unresponsive = true;
+    ASSERT_EQ(pldm_ua_set_idle_timeout(ua.get(), 5000), 0);
+
+    uint64_t start = now;
+    ASSERT_EQ(pldm_ua_start(ua.get(), dev.address, pkg.get(), 0), 0);
+    run(1);
+    EXPECT_EQ(results.at(dev.address), -ETIMEDOUT);
+    EXPECT_GT(now - start, 5000);
+}
+
+TEST_F(FirmwareUa, UnexpectedRequest)
+{
+    const pldm_request_firmware_data_req params = {.offset = 0,
+                                                   .length = 32};
+    uint8_t req[sizeof(pldm_msg_hdr) + sizeof(params)] = {};
+    size_t payloadLen = sizeof(params);
+    uint8_t resp[bufSize];
+    size_t respLen = sizeof(resp);
+
+    ASSERT_EQ(encode_request_firmware_data_req(
+                  1, &params, reinterpret_cast<pldm_msg*>(req), &payloadLen),
+              0);
+    ASSERT_EQ(pldm_ua_handle_msg(ua.get(), 20, req, sizeof(req), resp,
+                                 &respLen),
+              0);
+    ASSERT_EQ(respLen, sizeof(pldm_msg_hdr) + 1);
+    EXPECT_EQ(reinterpret_cast<pldm_msg*>(resp)->payload[0],
+              PLDM_FWUP_COMMAND_NOT_EXPECTED);
+}
+
+TEST(FirmwareUaPackage, Match)
+{
+    auto data = buildPackage({{otherIana, 0x01}, {openbmcIana, 0x02}});
+    struct pldm_ua_package* pkg = nullptr;
+    size_t record;
+
+    ASSERT_EQ(pldm_ua_package_init(&pkg, data.data(), data.size()), 0);
+    ASSERT_EQ(pldm_ua_package_match(pkg, deviceDescriptors, 1, &record), 0);
+    EXPECT_EQ(record, 1);
+
+    const pldm_descriptor unknown = {
+        .descriptor_type = PLDM_FWUP_IANA_ENTERPRISE_ID,
+        .descriptor_length = PLDM_FWUP_IANA_ENTERPRISE_ID_LENGTH,
+        .descriptor_data = "\x05\x06\x00\x00",
+    };
+    EXPECT_EQ(pldm_ua_package_match(pkg, &unknown, 1, &record), -ENOENT);
+    pldm_ua_package_destroy(pkg);
+}
+
+TEST(FirmwareUaPackage, BadChecksum)
+{
+    auto data = buildPackage({{openbmcIana, 0x03}});
+    struct pldm_ua_package* pkg = nullptr;
+
+    /* Package version string */
+    data[36]++;
+    EXPECT_EQ(pldm_ua_package_init(&pkg, data.data(), data.size()), -EBADMSG);
+}
+
+TEST(FirmwareUaPackage, Truncated)
+{
+    auto data = buildPackage({{openbmcIana, 0x03}});
+    struct pldm_ua_package* pkg = nullptr;
+
+    EXPECT_EQ(pldm_ua_package_init(&pkg, data.data(), data.size() - 1),
+              -EOVERFLOW);
+    EXPECT_EQ(pldm_ua_package_init(&pkg, data.data(), 20), -EOVERFLOW);
+}
+
+TEST(FirmwareUaPackage, UnsupportedFormat)
+{
+    auto data = buildPackage({{openbmcIana, 0x03}});
+    struct pldm_ua_package* pkg = nullptr;
+
+    data[16] = 0x02;
+    EXPECT_EQ(pldm_ua_package_init(&pkg, data.data(), data.size()), -ENOTSUP);
+}
+#endif
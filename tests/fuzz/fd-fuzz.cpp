@@ -54,6 +54,7 @@ struct fuzz_ops_ctx
     bool current_update;
     struct pldm_firmware_update_component update_comp;
     uint32_t offset;
+    uint8_t request_window;
     bool transferred;
     bool verified;
     bool applied;
@@ -225,7 +226,12 @@ static uint8_t
     assert(!fuzz_ctx->transferred);
     assert(!fuzz_ctx->verified);
     assert(!fuzz_ctx->applied);
-    assert(offset == fuzz_ctx->offset);
+    if (fuzz_ctx->request_window == 1)
+    {
+        assert(offset == fuzz_ctx->offset);
+    }
+    assert(offset + len <= fuzz_ctx->update_comp.comp_image_size);
+    /* Each chunk is provided once, so this counts the bytes received */
     fuzz_ctx->offset += len;
     assert(fuzz_ctx->offset <= fuzz_ctx->update_comp.comp_image_size);
     assert(memcmp(comp, &fuzz_ctx->update_comp, sizeof(*comp)) == 0);
@@ -394,6 +400,21 @@ extern "C" int LLVMFuzzerTestOneInput(uint8_t* input, size_t len)
     struct pldm_fd* fd = pldm_fd_new(&fuzz_ops, ops_ctx.get(), NULL);
     assert(fd);
 
+    /* Sometimes pipeline firmware data requests */
+    ops_ctx->request_window = 1;
+    if (fuzz_chance(ops_ctx.get(), 50))
+    {
+        uint8_t window;
+        rc = pldm_msgbuf_extract_uint8(fuzzctrl, window);
+        if (rc == 0)
+        {
+            window = 1 + window % PLDM_FD_REQUEST_WINDOW_MAX;
+            rc = pldm_fd_set_request_window(fd, window);
+            assert(rc == 0);
+            ops_ctx->request_window = window;
+        }
+    }
+
     while (true)
     {
         /* Arbitrary length send buffer */
@@ -411,7 +432,16 @@ extern "C" int LLVMFuzzerTestOneInput(uint8_t* input, size_t len)
         if (fuzz_chance(ops_ctx.get(), PROGRESS_PERCENT))
         {
             uint8_t address = FIXED_ADDR;
+            uint64_t deadline;
             pldm_fd_progress(fd, send_buf.data(), &len, &address);
+            pldm_fd_next_deadline(fd, &deadline);
+
+            struct pldm_fd_transfer_stats stats;
+            if (pldm_fd_get_transfer_stats(fd, &stats) == 0)
+            {
+                assert(stats.transfer_size >= PLDM_FWUP_BASELINE_TRANSFER_SIZE);
+                assert(stats.received <= ops_ctx->update_comp.comp_image_size);
+            }
         }
         else
         {
@@ -1,6 +1,11 @@
 #include <libpldm/base.h>
 #include <libpldm/instance-id.h>
 
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <array>
 #include <cerrno>
 #include <cstdlib>
 #include <cstring>
@@ -254,6 +259,29 @@ TEST_F(PldmInstanceDbTest, allocAllInstanceIds)
     ASSERT_EQ(pldm_instance_db_destroy(db), 0);
 }
 
+TEST_F(PldmInstanceDbTest, previousNotReallocated)
+{
+    static constexpr pldm_tid_t tid = 1;
+
+    struct pldm_instance_db* db = nullptr;
+    std::array<pldm_instance_id_t, pldmMaxInstanceIds> iids = {};
+    pldm_instance_id_t extra;
+
+    ASSERT_EQ(pldm_instance_db_init(&db, dbPath.c_str()), 0);
+    for (auto& iid : iids)
+    {
+        ASSERT_EQ(pldm_instance_id_alloc(db, tid, &iid), 0);
+    }
+
+    /* A late response to the previous request mustn't match the next */
+    EXPECT_EQ(pldm_instance_id_free(db, tid, iids.back()), 0);
+    EXPECT_EQ(pldm_instance_id_alloc(db, tid, &extra), -EAGAIN);
+    EXPECT_EQ(pldm_instance_id_free(db, tid, iids.front()), 0);
+    ASSERT_EQ(pldm_instance_id_alloc(db, tid, &extra), 0);
+    EXPECT_EQ(extra, iids.front());
+    ASSERT_EQ(pldm_instance_db_destroy(db), 0);
+}
+
 TEST_F(PldmInstanceDbTest, releaseConflictedSameTid)
 {
     static constexpr pldm_tid_t tid = 1;
@@ -341,3 +369,283 @@ TEST_F(PldmInstanceDbTest, freeUnallocatedInstanceId)
     EXPECT_NE(pldm_instance_id_free(db, tid, 0), 0);
     ASSERT_EQ(pldm_instance_db_destroy(db), 0);
 }
+
+#ifdef LIBPLDM_API_TESTING
+TEST_F(PldmInstanceDbTest, allocFreeBatch)
+{
+    static constexpr pldm_tid_t tid = 1;
+
+    struct pldm_instance_db* db = nullptr;
+    pldm_instance_id_t iid;
+    uint32_t first;
+    uint32_t second;
+
+    ASSERT_EQ(pldm_instance_db_init(&db, dbPath.c_str()), 0);
+    EXPECT_EQ(pldm_instance_id_alloc_batch(db, tid, 0, &first), -EINVAL);
+    EXPECT_EQ(pldm_instance_id_alloc_batch(db, tid, pldmMaxInstanceIds + 1,
+                                           &first),
+              -EINVAL);
+
+    ASSERT_EQ(pldm_instance_id_alloc_batch(db, tid, 8, &first), 0);
+    EXPECT_EQ(__builtin_popcount(first), 8);
+
+    /* All or nothing */
+    EXPECT_EQ(pldm_instance_id_alloc_batch(db, tid, pldmMaxInstanceIds - 7,
+                                           &second),
+              -EAGAIN);
+    ASSERT_EQ(pldm_instance_id_alloc_batch(db, tid, pldmMaxInstanceIds - 8,
+                                           &second),
+              0);
+    EXPECT_EQ(first & second, 0u);
+    EXPECT_EQ(first | second, 0xffffffffu);
+    EXPECT_EQ(pldm_instance_id_alloc(db, tid, &iid), -EAGAIN);
+
+    EXPECT_EQ(pldm_instance_id_free_batch(db, tid, first), 0);
+    EXPECT_EQ(pldm_instance_id_free_batch(db, tid, first), -EINVAL);
+    EXPECT_EQ(pldm_instance_id_free_batch(db, tid, second), 0);
+    ASSERT_EQ(pldm_instance_db_destroy(db), 0);
+}
+
+TEST_F(PldmInstanceDbTest, cache)
+{
+    static constexpr pldm_tid_t tid = 1;
+
+    struct pldm_instance_db* other = nullptr;
+    struct pldm_instance_db* db = nullptr;
+    pldm_instance_id_t first;
+    pldm_instance_id_t second;
+    pldm_instance_id_t iid;
+    uint32_t rest;
+
+    ASSERT_EQ(pldm_instance_db_init(&db, dbPath.c_str()), 0);
+    ASSERT_EQ(pldm_instance_db_init(&other, dbPath.c_str()), 0);
+    EXPECT_EQ(pldm_instance_db_set_cache(db, pldmMaxInstanceIds + 1), -EINVAL);
+    ASSERT_EQ(pldm_instance_db_set_cache(db, 2), 0);
+
+    EXPECT_EQ(pldm_instance_id_alloc(db, tid, &first), 0);
+    EXPECT_EQ(pldm_instance_id_free(db, tid, first), 0);
+    EXPECT_EQ(pldm_instance_id_free(db, tid, first), -EINVAL);
+    EXPECT_EQ(pldm_instance_id_alloc(db, tid, &second), 0);
+    EXPECT_NE(first, second);
+    EXPECT_EQ(pldm_instance_id_free(db, tid, second), 0);
+
+    /* Reused from the cache, but never twice in succession */
+    EXPECT_EQ(pldm_instance_id_alloc(db, tid, &iid), 0);
+    EXPECT_EQ(iid, first);
+
+    /* The cached IID remains unavailable to other users of the database.
+     * The other starts as if it had just allocated IID 31, so its first scan
+     * skips that */
+    ASSERT_EQ(pldm_instance_id_alloc_batch(other, tid, pldmMaxInstanceIds - 3,
+                                           &rest),
+              0);
+    EXPECT_EQ(rest & ((1u << first) | (1u << second)), 0u);
+    EXPECT_EQ(pldm_instance_id_alloc(other, tid, &iid), 0);
+    EXPECT_EQ(iid, pldmMaxInstanceIds - 1);
+    EXPECT_EQ(pldm_instance_id_alloc(other, tid, &iid), -EAGAIN);
+
+    /* Until it's released by shrinking the cache */
+    ASSERT_EQ(pldm_instance_db_set_cache(db, 0), 0);
+    EXPECT_EQ(pldm_instance_id_alloc(other, tid, &iid), 0);
+    EXPECT_EQ(iid, second);
+
+    ASSERT_EQ(pldm_instance_db_destroy(other), 0);
+    ASSERT_EQ(pldm_instance_db_destroy(db), 0);
+}
+
+class PldmInstanceDbShmTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        fd = memfd_create("instance-db", MFD_CLOEXEC);
+        ASSERT_GE(fd, 0);
+    }
+
+    void TearDown() override
+    {
+        ::close(fd);
+    }
+
+    int fd = -1;
+};
+
+TEST_F(PldmInstanceDbShmTest, invalid)
+{
+    struct pldm_instance_db* db = (struct pldm_instance_db*)8;
+
+    EXPECT_EQ(pldm_instance_db_init_shm(nullptr, fd), -EINVAL);
+    EXPECT_EQ(pldm_instance_db_init_shm(&db, fd), -EINVAL);
+    db = nullptr;
+    EXPECT_EQ(pldm_instance_db_init_shm(&db, -1), -EINVAL);
+
+    /* Not an instance ID database */
+    ASSERT_EQ(ftruncate(fd, 64 * 1024), 0);
+    ASSERT_EQ(pwrite(fd, "junk", 4, 0), 4);
+    EXPECT_EQ(pldm_instance_db_init_shm(&db, fd), -EINVAL);
+    EXPECT_EQ(db, nullptr);
+}
+
+TEST_F(PldmInstanceDbShmTest, allocFree)
+{
+    static constexpr pldm_tid_t tid = 1;
+
+    struct pldm_instance_db* db = nullptr;
+    pldm_instance_id_t first;
+    pldm_instance_id_t second;
+
+    ASSERT_EQ(pldm_instance_db_init_shm(&db, fd), 0);
+    EXPECT_EQ(pldm_instance_id_alloc(db, tid, &first), 0);
+    EXPECT_EQ(pldm_instance_id_free(db, tid, first), 0);
+    EXPECT_EQ(pldm_instance_id_free(db, tid, first), -EINVAL);
+    EXPECT_EQ(pldm_instance_id_alloc(db, tid, &second), 0);
+    EXPECT_NE(first, second);
+    EXPECT_EQ(pldm_instance_id_free(db, tid, second), 0);
+    ASSERT_EQ(pldm_instance_db_destroy(db), 0);
+}
+
+TEST_F(PldmInstanceDbShmTest, previousNotReallocated)
+{
+    static constexpr pldm_tid_t tid = 1;
+
+    struct pldm_instance_db* db = nullptr;
+    std::array<pldm_instance_id_t, pldmMaxInstanceIds> iids = {};
+    pldm_instance_id_t extra;
+
+    ASSERT_EQ(pldm_instance_db_init_shm(&db, fd), 0);
+    for (auto& iid : iids)
+    {
+        ASSERT_EQ(pldm_instance_id_alloc(db, tid, &iid), 0);
+    }
+
+    /* A late response to the previous request mustn't match the next */
+    EXPECT_EQ(pldm_instance_id_free(db, tid, iids.back()), 0);
+    EXPECT_EQ(pldm_instance_id_alloc(db, tid, &extra), -EAGAIN);
+    EXPECT_EQ(pldm_instance_id_free(db, tid, iids.front()), 0);
+    ASSERT_EQ(pldm_instance_id_alloc(db, tid, &extra), 0);
+    EXPECT_EQ(extra, iids.front());
+    ASSERT_EQ(pldm_instance_db_destroy(db), 0);
+}
+
+TEST_F(PldmInstanceDbShmTest, allocAllConcurrent)
+{
+    static constexpr pldm_tid_t tid = 1;
+
+    std::array<struct pldm_instance_db*, 2> dbs = {};
+    std::array<pldm_instance_id_t, pldmMaxInstanceIds> iids = {};
+    uint32_t seen = 0;
+    pldm_instance_id_t extra;
+    size_t i;
+
+    ASSERT_EQ(pldm_instance_db_init_shm(&dbs[0], fd), 0);
+    ASSERT_EQ(pldm_instance_db_init_shm(&dbs[1], fd), 0);
+
+    /* Alternating between the two objects never hands out an IID twice */
+    for (i = 0; i < iids.size(); i++)
+    {
+        ASSERT_EQ(pldm_instance_id_alloc(dbs[i % 2], tid, &iids[i]), 0);
+        EXPECT_FALSE(seen & (1u << iids[i]));
+        seen |= 1u << iids[i];
+    }
+
+    EXPECT_EQ(pldm_instance_id_alloc(dbs[0], tid, &extra), -EAGAIN);
+    EXPECT_EQ(pldm_instance_id_alloc(dbs[1], tid, &extra), -EAGAIN);
+    EXPECT_EQ(pldm_instance_id_alloc(dbs[0], tid + 1, &extra), 0);
+
+    /* Destroying an object releases its IIDs */
+    ASSERT_EQ(pldm_instance_db_destroy(dbs[1]), 0);
+    EXPECT_EQ(pldm_instance_id_alloc(dbs[0], tid, &extra), 0);
+    EXPECT_EQ(extra % 2, 1);
+    ASSERT_EQ(pldm_instance_db_destroy(dbs[0]), 0);
+}
+
+TEST_F(PldmInstanceDbShmTest, reclaimExited)
+{
+    static constexpr pldm_tid_t tid = 1;
+
+    std::array<pldm_instance_id_t, pldmMaxInstanceIds> iids = {};
+    struct pldm_instance_db* db = nullptr;
+    pldm_instance_id_t extra;
+    int status;
+    pid_t pid;
+
+    /* The child exits holding a single IID without releasing it */
+    pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0)
+    {
+        struct pldm_instance_db* child = nullptr;
+
+        if (pldm_instance_db_init_shm(&child, fd) ||
+            pldm_instance_id_alloc(child, tid, &extra))
+        {
+            _exit(1);
+        }
+        _exit(0);
+    }
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+
+    ASSERT_EQ(pldm_instance_db_init_shm(&db, fd), 0);
+    for (auto& iid : iids)
+    {
+        EXPECT_EQ(pldm_instance_id_alloc(db, tid, &iid), 0);
+    }
+    EXPECT_EQ(pldm_instance_id_alloc(db, tid, &extra), -EAGAIN);
+    ASSERT_EQ(pldm_instance_db_destroy(db), 0);
+}
+
+TEST_F(PldmInstanceDbShmTest, cacheBatch)
+{
+    static constexpr pldm_tid_t tid = 1;
+
+    struct pldm_instance_db* db = nullptr;
+    uint32_t first;
+    uint32_t second;
+
+    ASSERT_EQ(pldm_instance_db_init_shm(&db, fd), 0);
+    ASSERT_EQ(pldm_instance_db_set_cache(db, 4), 0);
+    ASSERT_EQ(pldm_instance_id_alloc_batch(db, tid, 4, &first), 0);
+    EXPECT_EQ(pldm_instance_id_free_batch(db, tid, first), 0);
+
+    /* All come from the cache */
+    ASSERT_EQ(pldm_instance_id_alloc_batch(db, tid, 4, &second), 0);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(pldm_instance_id_free_batch(db, tid, second), 0);
+    ASSERT_EQ(pldm_instance_db_destroy(db), 0);
+}
+
+TEST_F(PldmInstanceDbShmTest, allocBatchShared)
+{
+    static constexpr pldm_tid_t tid = 1;
+
+    std::array<struct pldm_instance_db*, 2> dbs = {};
+    uint32_t cached;
+    uint32_t first;
+    uint32_t second;
+
+    ASSERT_EQ(pldm_instance_db_init_shm(&dbs[0], fd), 0);
+    ASSERT_EQ(pldm_instance_db_init_shm(&dbs[1], fd), 0);
+    ASSERT_EQ(pldm_instance_db_set_cache(dbs[0], 2), 0);
+
+    /* Two of the batch come from the cache and the rest from one scan */
+    ASSERT_EQ(pldm_instance_id_alloc_batch(dbs[0], tid, 2, &cached), 0);
+    EXPECT_EQ(pldm_instance_id_free_batch(dbs[0], tid, cached), 0);
+    ASSERT_EQ(pldm_instance_id_alloc_batch(dbs[0], tid, 12, &first), 0);
+    EXPECT_EQ(__builtin_popcount(first), 12);
+    EXPECT_EQ(first & cached, cached);
+
+    /* The other object can't have those, and gets nothing if short. It
+     * starts as if it had just allocated IID 31, so that isn't offered */
+    EXPECT_EQ(pldm_instance_id_alloc_batch(dbs[1], tid, 20, &second), -EAGAIN);
+    ASSERT_EQ(pldm_instance_id_alloc_batch(dbs[1], tid, 19, &second), 0);
+    EXPECT_EQ(first & second, 0u);
+    EXPECT_EQ(first | second, 0x7fffffffu);
+
+    EXPECT_EQ(pldm_instance_id_free_batch(dbs[1], tid, second), 0);
+    EXPECT_EQ(pldm_instance_id_free_batch(dbs[0], tid, first), 0);
+    ASSERT_EQ(pldm_instance_db_destroy(dbs[1]), 0);
+    ASSERT_EQ(pldm_instance_db_destroy(dbs[0]), 0);
+}
+#endif
@@ -0,0 +1,589 @@
+#include <libpldm/base.h>
+#include <libpldm/control.h>
+#include <libpldm/multipart.h>
+#include <libpldm/pldm.h>
+#include <libpldm/utils.h>
+
+#include <endian.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#ifdef LIBPLDM_API_TESTING
+static constexpr uint32_t partSize = 64;
+static constexpr uint8_t oemCtx = 0x42;
+static constexpr pldm_tid_t tid = 9;
+
+/* Header, cc, flag, next handle, length, the part and its CRC32 */
+static constexpr size_t respSize = sizeof(pldm_msg_hdr) + 10 + partSize + 4;
+
+static int readObject(void* data, uint32_t offset, void* buf, size_t len)
+{
+    auto* object = static_cast<std::vector<uint8_t>*>(data);
+
+    if (offset + len > object->size())
+    {
+        return -EINVAL;
+    }
+
+    memcpy(buf, object->data() + offset, len);
+    return 0;
+}
+
+static int readFails(void* /*data*/, uint32_t /*offset*/, void* /*buf*/,
+                     size_t /*len*/)
+{
+    return -EIO;
+}
+
+class PldmMultipart : public testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        object.resize(1000);
+        for (size_t i = 0; i < object.size(); i++)
+        {
+            object[i] = i * 7;
+        }
+
+        ASSERT_EQ(pldm_multipart_server_init(&server, partSize), 0);
+        ASSERT_EQ(pldm_multipart_server_add_memory(server, PLDM_OEM, oemCtx,
+                                                   object.data(),
+                                                   object.size()),
+                  0);
+    }
+
+    void TearDown() override
+    {
+        pldm_multipart_client_destroy(client);
+        pldm_multipart_server_destroy(server);
+    }
+
+    /* Exchange the client's next request with the server */
+    int exchange(std::vector<uint8_t>* lastResp = nullptr)
+    {
+        std::vector<uint8_t> req(sizeof(pldm_msg_hdr) +
+                                 PLDM_MULTIPART_RECEIVE_REQ_BYTES);
+        std::vector<uint8_t> resp(respSize);
+        size_t reqLen = req.size();
+        size_t respLen = resp.size();
+
+        EXPECT_EQ(pldm_multipart_client_next_req(client, 1, req.data(),
+                                                 &reqLen),
+                  0);
+        if (!reqLen)
+        {
+            return -ENODATA;
+        }
+        EXPECT_EQ(pldm_multipart_server_handle_msg(server, tid, req.data(),
+                                                   reqLen, resp.data(),
+                                                   &respLen),
+                  0);
+        resp.resize(respLen);
+        if (lastResp)
+        {
+            *lastResp = resp;
+        }
+
+        return pldm_multipart_client_handle_resp(client, resp.data(),
+                                                 resp.size());
+    }
+
+    /* Run the transfer to its end, returning the client's last result */
+    int transfer(size_t* exchanges = nullptr)
+    {
+        size_t count = 0;
+        int rc;
+
+        while ((rc = exchange()) == 0)
+        {
+            count++;
+        }
+        if (exchanges)
+        {
+            *exchanges = count + 1;
+        }
+
+        return rc;
+    }
+
+    /* Send a request to the server, returning the response */
+    std::vector<uint8_t> request(uint8_t opflag, uint32_t handle,
+                                 uint32_t offset = 0, uint32_t length = 0,
+                                 pldm_tid_t from = tid)
+    {
+        struct pldm_multipart_receive_req req = {
+            PLDM_OEM, opflag, oemCtx, handle, offset, length,
+        };
+        std::vector<uint8_t> msg(sizeof(pldm_msg_hdr) +
+                                 PLDM_MULTIPART_RECEIVE_REQ_BYTES);
+        std::vector<uint8_t> resp(respSize);
+        size_t len = resp.size();
+
+        EXPECT_EQ(encode_base_multipart_receive_req(
+                      2, &req, reinterpret_cast<pldm_msg*>(msg.data()),
+                      PLDM_MULTIPART_RECEIVE_REQ_BYTES),
+                  0);
+        EXPECT_EQ(pldm_multipart_server_handle_msg(server, from, msg.data(),
+                                                   msg.size(), resp.data(),
+                                                   &len),
+                  0);
+        resp.resize(len);
+
+        return resp;
+    }
+
+    static struct pldm_multipart_receive_resp
+        decode(const std::vector<uint8_t>& resp, uint32_t* crc = nullptr)
+    {
+        struct pldm_multipart_receive_resp decoded = {};
+        uint32_t checksum = 0;
+
+        EXPECT_EQ(decode_base_multipart_receive_resp(
+                      reinterpret_cast<const pldm_msg*>(resp.data()),
+                      resp.size() - sizeof(pldm_msg_hdr), &decoded,
+                      &checksum),
+                  0);
+        if (crc)
+        {
+            *crc = checksum;
+        }
+
+        return decoded;
+    }
+
+    std::vector<uint8_t> object;
+    struct pldm_multipart_server* server = nullptr;
+    struct pldm_multipart_client* client = nullptr;
+};
+
+TEST_F(PldmMultipart, transferMemory)
+{
+    std::vector<uint8_t> buf(object.size());
+    size_t exchanges;
+
+    ASSERT_EQ(pldm_multipart_client_init(&client, PLDM_OEM, oemCtx, 0,
+                                         buf.data(), buf.size()),
+              0);
+    EXPECT_EQ(transfer(&exchanges), 1);
+
+    /* 16 parts and the completion */
+    EXPECT_EQ(exchanges, 17);
+    EXPECT_EQ(pldm_multipart_client_received(client), object.size());
+    EXPECT_EQ(buf, object);
+    EXPECT_EQ(exchange(), -ENODATA);
+}
+
+TEST_F(PldmMultipart, transferSource)
+{
+    std::vector<uint8_t> buf(300);
+
+    ASSERT_EQ(pldm_multipart_server_add_source(server, PLDM_OEM, oemCtx + 1,
+                                               object.size(), readObject,
+                                               &object),
+              0);
+    ASSERT_EQ(pldm_multipart_client_init(&client, PLDM_OEM, oemCtx + 1, 100,
+                                         buf.data(), buf.size()),
+              0);
+    EXPECT_EQ(transfer(), 1);
+    EXPECT_EQ(pldm_multipart_client_received(client), buf.size());
+    EXPECT_EQ(memcmp(buf.data(), &object[100], buf.size()), 0);
+}
+
+TEST_F(PldmMultipart, sectionClipped)
+{
+    std::vector<uint8_t> buf(object.size());
+
+    /* The object ends before the buffer is filled */
+    ASSERT_EQ(pldm_multipart_client_init(&client, PLDM_OEM, oemCtx, 990,
+                                         buf.data(), buf.size()),
+              0);
+    EXPECT_EQ(transfer(), 1);
+    EXPECT_EQ(pldm_multipart_client_received(client), 10);
+    EXPECT_EQ(memcmp(buf.data(), &object[990], 10), 0);
+}
+
+TEST_F(PldmMultipart, partsAndHandles)
+{
+    struct pldm_multipart_receive_resp resp;
+    uint32_t crc;
+
+    resp = decode(request(PLDM_XFER_FIRST_PART, 0, 10, 100));
+    EXPECT_EQ(resp.completion_code, PLDM_SUCCESS);
+    EXPECT_EQ(resp.transfer_flag,
+              PLDM_BASE_MULTIPART_RECEIVE_TRANSFER_FLAG_START);
+    EXPECT_EQ(resp.data.length, partSize);
+    EXPECT_EQ(resp.next_transfer_handle, partSize + 1);
+
+    /* The next part's CRC32 covers the whole section */
+    resp = decode(request(PLDM_XFER_NEXT_PART, partSize + 1, 10, 100), &crc);
+    EXPECT_EQ(resp.transfer_flag,
+              PLDM_BASE_MULTIPART_RECEIVE_TRANSFER_FLAG_END);
+    EXPECT_EQ(resp.data.length, 100 - partSize);
+    EXPECT_EQ(resp.next_transfer_handle, 0);
+    EXPECT_EQ(crc, pldm_edac_crc32(&object[10], 100));
+
+    /* A retry of the last part doesn't disturb the CRC32 */
+    resp = decode(request(PLDM_XFER_CURRENT_PART, partSize + 1, 10, 100),
+                  &crc);
+    EXPECT_EQ(resp.data.length, 100 - partSize);
+    EXPECT_EQ(crc, pldm_edac_crc32(&object[10], 100));
+
+    /* Only the current and next parts can be requested */
+    resp = decode(request(PLDM_XFER_NEXT_PART, 1, 10, 100));
+    EXPECT_EQ(resp.completion_code, PLDM_CONTROL_INVALID_DATA_TRANSFER_HANDLE);
+
+    resp = decode(request(PLDM_XFER_COMPLETE, 0));
+    EXPECT_EQ(resp.completion_code, PLDM_SUCCESS);
+    EXPECT_EQ(resp.transfer_flag,
+              PLDM_BASE_MULTIPART_RECEIVE_TRANSFER_FLAG_ACK_COMPLETION);
+    EXPECT_EQ(resp.data.length, 0);
+
+    /* The transfer is over */
+    resp = decode(request(PLDM_XFER_CURRENT_PART, partSize + 1, 10, 100));
+    EXPECT_EQ(resp.completion_code, PLDM_CONTROL_INVALID_DATA_TRANSFER_HANDLE);
+}
+
+TEST_F(PldmMultipart, firstPartRetry)
+{
+    struct pldm_multipart_receive_resp resp;
+    std::vector<uint8_t> msg;
+
+    resp = decode(request(PLDM_XFER_FIRST_PART, 0, 0, 100));
+    EXPECT_EQ(resp.next_transfer_handle, partSize + 1);
+
+    /* The first part is retried with the handle of the FirstPart request */
+    msg = request(PLDM_XFER_CURRENT_PART, 0, 0, 100);
+    resp = decode(msg);
+    EXPECT_EQ(resp.completion_code, PLDM_SUCCESS);
+    EXPECT_EQ(resp.transfer_flag,
+              PLDM_BASE_MULTIPART_RECEIVE_TRANSFER_FLAG_START);
+    EXPECT_EQ(resp.data.length, partSize);
+    EXPECT_EQ(resp.next_transfer_handle, partSize + 1);
+    EXPECT_EQ(memcmp(resp.data.ptr, object.data(), partSize), 0);
+
+    /* Only as the current part, and only while it is the current part */
+    resp = decode(request(PLDM_XFER_NEXT_PART, 0, 0, 100));
+    EXPECT_EQ(resp.completion_code, PLDM_CONTROL_INVALID_DATA_TRANSFER_HANDLE);
+    resp = decode(request(PLDM_XFER_NEXT_PART, partSize + 1, 0, 100));
+    EXPECT_EQ(resp.completion_code, PLDM_SUCCESS);
+    resp = decode(request(PLDM_XFER_CURRENT_PART, 0, 0, 100));
+    EXPECT_EQ(resp.completion_code, PLDM_CONTROL_INVALID_DATA_TRANSFER_HANDLE);
+}
+
+TEST_F(PldmMultipart, requestersTransferIndependently)
+{
+    struct pldm_multipart_receive_resp resp;
+    std::vector<uint8_t> msg;
+    uint32_t crc;
+
+    /* Another requester starts a transfer of the same object */
+    resp = decode(request(PLDM_XFER_FIRST_PART, 0, 0, 100));
+    EXPECT_EQ(resp.data.length, partSize);
+    msg = request(PLDM_XFER_FIRST_PART, 0, 500, 0, tid + 1);
+    resp = decode(msg);
+    EXPECT_EQ(resp.data.length, partSize);
+    EXPECT_EQ(memcmp(resp.data.ptr, &object[500], partSize), 0);
+
+    /* Neither disturbs the other's section or CRC32 */
+    resp = decode(request(PLDM_XFER_NEXT_PART, partSize + 1, 0, 100), &crc);
+    EXPECT_EQ(resp.transfer_flag,
+              PLDM_BASE_MULTIPART_RECEIVE_TRANSFER_FLAG_END);
+    EXPECT_EQ(resp.data.length, 100 - partSize);
+    EXPECT_EQ(crc, pldm_edac_crc32(object.data(), 100));
+    EXPECT_EQ(decode(request(PLDM_XFER_COMPLETE, 0)).completion_code,
+              PLDM_SUCCESS);
+
+    msg = request(PLDM_XFER_NEXT_PART, partSize + 1, 500, 0, tid + 1);
+    resp = decode(msg);
+    EXPECT_EQ(resp.completion_code, PLDM_SUCCESS);
+    EXPECT_EQ(memcmp(resp.data.ptr, &object[500 + partSize], partSize), 0);
+
+    /* A requester without a transfer can't continue one */
+    resp = decode(request(PLDM_XFER_NEXT_PART, 2 * partSize + 1, 500, 0,
+                          tid + 2));
+    EXPECT_EQ(resp.completion_code, PLDM_CONTROL_INVALID_DATA_TRANSFER_HANDLE);
+
+    /* Removing the object ends its transfers */
+    ASSERT_EQ(pldm_multipart_server_remove(server, PLDM_OEM, oemCtx), 0);
+    ASSERT_EQ(pldm_multipart_server_add_memory(server, PLDM_OEM, oemCtx,
+                                               object.data(), object.size()),
+              0);
+    resp = decode(request(PLDM_XFER_CURRENT_PART, partSize + 1, 500, 0,
+                          tid + 1));
+    EXPECT_EQ(resp.completion_code, PLDM_CONTROL_INVALID_DATA_TRANSFER_HANDLE);
+}
+
+TEST_F(PldmMultipart, lostResponse)
+{
+    std::vector<uint8_t> req(sizeof(pldm_msg_hdr) +
+                             PLDM_MULTIPART_RECEIVE_REQ_BYTES);
+    std::vector<uint8_t> resp(respSize);
+    std::vector<uint8_t> buf(200);
+    size_t reqLen;
+    size_t respLen;
+    int rc;
+
+    ASSERT_EQ(pldm_multipart_client_init(&client, PLDM_OEM, oemCtx, 0,
+                                         buf.data(), buf.size()),
+              0);
+    ASSERT_EQ(exchange(), 0);
+
+    /* The server answers the second request, but the response is lost */
+    reqLen = req.size();
+    respLen = resp.size();
+    ASSERT_EQ(pldm_multipart_client_next_req(client, 2, req.data(), &reqLen),
+              0);
+    ASSERT_EQ(pldm_multipart_server_handle_msg(server, tid, req.data(),
+                                               reqLen, resp.data(), &respLen),
+              0);
+
+    /* The client retries with the same request */
+    do
+    {
+        rc = exchange();
+    } while (rc == 0);
+    EXPECT_EQ(rc, 1);
+    EXPECT_EQ(memcmp(buf.data(), object.data(), buf.size()), 0);
+}
+
+TEST_F(PldmMultipart, corruptPart)
+{
+    std::vector<uint8_t> buf(100);
+    std::vector<uint8_t> resp;
+    std::vector<uint8_t> req(sizeof(pldm_msg_hdr) +
+                             PLDM_MULTIPART_RECEIVE_REQ_BYTES);
+    size_t reqLen = req.size();
+    size_t respLen = respSize;
+
+    ASSERT_EQ(pldm_multipart_client_init(&client, PLDM_OEM, oemCtx, 0,
+                                         buf.data(), buf.size()),
+              0);
+    ASSERT_EQ(exchange(), 0);
+
+    resp.resize(respSize);
+    ASSERT_EQ(pldm_multipart_client_next_req(client, 1, req.data(), &reqLen),
+              0);
+    ASSERT_EQ(pldm_multipart_server_handle_msg(server, tid, req.data(),
+                                               reqLen, resp.data(), &respLen),
+              0);
+    resp.resize(respLen);
+    resp[sizeof(pldm_msg_hdr) + 10] ^= 0x01;
+    EXPECT_EQ(pldm_multipart_client_handle_resp(client, resp.data(),
+                                                resp.size()),
+              -EBADMSG);
+
+    /* The transfer can't continue */
+    EXPECT_EQ(exchange(), -ENODATA);
+}
+
+TEST_F(PldmMultipart, errors)
+{
+    std::vector<uint8_t> buf(100);
+    std::vector<uint8_t> small(respSize - 1);
+    std::vector<uint8_t> msg(sizeof(pldm_msg_hdr) +
+                             PLDM_MULTIPART_RECEIVE_REQ_BYTES);
+    size_t len = small.size();
+
+    /* Not a MultipartReceive request */
+    EXPECT_EQ(pldm_multipart_server_handle_msg(
+                  server, tid,
+                  std::vector<uint8_t>{0x81, PLDM_BASE, 0x02}.data(), 3,
+                  small.data(), &len),
+              -ENOMSG);
+
+    ASSERT_EQ(pldm_multipart_client_init(&client, PLDM_OEM, oemCtx, 0,
+                                         buf.data(), buf.size()),
+              0);
+    len = msg.size();
+    ASSERT_EQ(pldm_multipart_client_next_req(client, 1, msg.data(), &len), 0);
+    len = small.size();
+    EXPECT_EQ(pldm_multipart_server_handle_msg(server, tid, msg.data(),
+                                               msg.size(), small.data(), &len),
+              -EOVERFLOW);
+
+    EXPECT_EQ(decode(request(PLDM_XFER_CURRENT_PART + 1, 1)).completion_code,
+              PLDM_CONTROL_INVALID_TRANSFER_OPERATION_FLAG);
+    EXPECT_EQ(decode(request(PLDM_XFER_NEXT_PART, 1)).completion_code,
+              PLDM_CONTROL_INVALID_DATA_TRANSFER_HANDLE);
+    EXPECT_EQ(decode(request(PLDM_XFER_FIRST_PART, 0, 1001)).completion_code,
+              PLDM_ERROR_INVALID_DATA);
+
+    ASSERT_EQ(pldm_multipart_server_add_source(server, PLDM_OEM, 7,
+                                               object.size(), readFails,
+                                               nullptr),
+              0);
+    EXPECT_EQ(pldm_multipart_server_add_source(server, PLDM_OEM, 7,
+                                               object.size(), readFails,
+                                               nullptr),
+              -EEXIST);
+    EXPECT_EQ(pldm_multipart_server_remove(server, PLDM_OEM, oemCtx), 0);
+    EXPECT_EQ(pldm_multipart_server_remove(server, PLDM_OEM, oemCtx),
+              -ENOENT);
+
+    /* The removed object is no longer served */
+    EXPECT_EQ(decode(request(PLDM_XFER_FIRST_PART, 0)).completion_code,
+              PLDM_ERROR_INVALID_DATA);
+    EXPECT_EQ(transfer(), -EPROTO);
+}
+
+TEST_F(PldmMultipart, partSize)
+{
+    std::vector<uint8_t> buf(object.size());
+    size_t exchanges;
+
+    EXPECT_EQ(pldm_multipart_server_set_part_size(server, 0), -EINVAL);
+    ASSERT_EQ(pldm_multipart_server_set_part_size(server, partSize / 2), 0);
+    ASSERT_EQ(pldm_multipart_client_init(&client, PLDM_OEM, oemCtx, 0,
+                                         buf.data(), buf.size()),
+              0);
+    EXPECT_EQ(transfer(&exchanges), 1);
+    EXPECT_EQ(exchanges, 33);
+    EXPECT_EQ(buf, object);
+}
+
+/* Multipart transfers of OEM and file types */
+static const bitfield8_t localProtocols[8] = {{0x80}, {0x00}, {0x00},
+                                              {0x00}, {0x00}, {0x00},
+                                              {0x00}, {0x80}};
+
+TEST(PldmMultipartPeers, negotiateAsRequester)
+{
+    struct pldm_multipart_peers* peers = nullptr;
+    struct pldm_base_negotiate_transfer_params_req req = {};
+    std::vector<uint8_t> msg(sizeof(pldm_msg_hdr) + 11);
+    size_t len = msg.size();
+    uint32_t partSize;
+
+    ASSERT_EQ(pldm_multipart_peers_init(&peers, 1024, localProtocols), 0);
+    EXPECT_EQ(pldm_multipart_peers_part_size(peers, tid, PLDM_OEM, &partSize),
+              -ENOENT);
+
+    ASSERT_EQ(pldm_multipart_peers_negotiate_req(peers, 3, msg.data(), &len),
+              0);
+    ASSERT_EQ(len, sizeof(pldm_msg_hdr) + 10);
+    EXPECT_EQ(msg[0], 0x83);
+    EXPECT_EQ(msg[2], PLDM_NEGOTIATE_TRANSFER_PARAMETERS);
+    memcpy(&req.requester_part_size, &msg[3], 2);
+    EXPECT_EQ(le16toh(req.requester_part_size), 1024);
+    EXPECT_EQ(memcmp(&msg[5], localProtocols, 8), 0);
+
+    /* The peer handles smaller parts, and file transfers only */
+    const std::vector<uint8_t> resp = {
+        0x03, 0x00, 0x07, 0x00, 0x00, 0x02, 0x80, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    };
+    ASSERT_EQ(pldm_multipart_peers_negotiate_resp(peers, tid, resp.data(),
+                                                  resp.size()),
+              0);
+    ASSERT_EQ(pldm_multipart_peers_part_size(peers, tid, PLDM_FILE, &partSize),
+              0);
+    EXPECT_EQ(partSize, 512);
+    EXPECT_EQ(pldm_multipart_peers_part_size(peers, tid, PLDM_OEM, &partSize),
+              -ENOTSUP);
+    EXPECT_EQ(pldm_multipart_peers_part_size(peers, tid + 1, PLDM_FILE,
+                                             &partSize),
+              -ENOENT);
+
+    /* The MTU leaves space for the response around the part */
+    ASSERT_EQ(pldm_multipart_peers_set_mtu(peers, tid, 256), 0);
+    ASSERT_EQ(pldm_multipart_peers_part_size(peers, tid, PLDM_FILE, &partSize),
+              0);
+    EXPECT_EQ(partSize, 256 - sizeof(pldm_msg_hdr) - 10 - 4);
+    ASSERT_EQ(pldm_multipart_peers_set_mtu(peers, tid, 17), 0);
+    EXPECT_EQ(pldm_multipart_peers_part_size(peers, tid, PLDM_FILE, &partSize),
+              -EMSGSIZE);
+
+    /* A failed negotiation forgets the previous result */
+    EXPECT_EQ(pldm_multipart_peers_negotiate_resp(
+                  peers, tid,
+                  std::vector<uint8_t>{0x03, 0x00, 0x07, PLDM_ERROR}.data(),
+                  4),
+              -EPROTO);
+    EXPECT_EQ(pldm_multipart_peers_part_size(peers, tid, PLDM_FILE, &partSize),
+              -ENOENT);
+
+    pldm_multipart_peers_destroy(peers);
+}
+
+TEST(PldmMultipartPeers, negotiateAsResponder)
+{
+    struct pldm_multipart_peers* peers = nullptr;
+    std::vector<uint8_t> resp(sizeof(pldm_msg_hdr) + 11);
+    size_t len = resp.size();
+    uint32_t partSize;
+
+    ASSERT_EQ(pldm_multipart_peers_init(&peers, 512, localProtocols), 0);
+
+    /* The peer handles larger parts, and OEM and platform transfers */
+    const std::vector<uint8_t> req = {
+        0x85, 0x00, 0x07, 0x00, 0x08, 0x04, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x80,
+    };
+    ASSERT_EQ(pldm_multipart_peers_handle_req(peers, tid, req.data(),
+                                              req.size(), resp.data(), &len),
+              0);
+    const std::vector<uint8_t> expected = {
+        0x05, 0x00, 0x07, 0x00, 0x00, 0x02, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x80,
+    };
+    resp.resize(len);
+    EXPECT_EQ(resp, expected);
+
+    ASSERT_EQ(pldm_multipart_peers_part_size(peers, tid, PLDM_OEM, &partSize),
+              0);
+    EXPECT_EQ(partSize, 512);
+    EXPECT_EQ(pldm_multipart_peers_part_size(peers, tid, PLDM_PLATFORM,
+                                             &partSize),
+              -ENOTSUP);
+
+    /* The peer forgets, and so do we */
+    EXPECT_EQ(pldm_multipart_peers_forget(peers, tid), 0);
+    EXPECT_EQ(pldm_multipart_peers_part_size(peers, tid, PLDM_OEM, &partSize),
+              -ENOENT);
+
+    len = resp.size();
+    EXPECT_EQ(pldm_multipart_peers_handle_req(
+                  peers, tid,
+                  std::vector<uint8_t>{0x85, 0x00, 0x07, 0x00}.data(), 4,
+                  resp.data(), &len),
+              0);
+    EXPECT_EQ(len, sizeof(pldm_msg_hdr) + 1);
+    EXPECT_EQ(resp[3], PLDM_ERROR_INVALID_LENGTH);
+
+    pldm_multipart_peers_destroy(peers);
+}
+
+TEST_F(PldmMultipart, negotiatedPartSize)
+{
+    struct pldm_multipart_peers* peers = nullptr;
+    std::vector<uint8_t> buf(object.size());
+    size_t exchanges;
+
+    ASSERT_EQ(pldm_multipart_peers_init(&peers, partSize, localProtocols), 0);
+    ASSERT_EQ(pldm_multipart_server_set_peers(server, peers), 0);
+
+    /* The peer negotiated parts half the server's size */
+    const std::vector<uint8_t> resp = {
+        0x03, 0x00, 0x07, 0x00, partSize / 2, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x80,
+    };
+    ASSERT_EQ(pldm_multipart_peers_negotiate_resp(peers, tid, resp.data(),
+                                                  resp.size()),
+              0);
+    ASSERT_EQ(pldm_multipart_client_init(&client, PLDM_OEM, oemCtx, 0,
+                                         buf.data(), buf.size()),
+              0);
+    EXPECT_EQ(transfer(&exchanges), 1);
+    EXPECT_EQ(exchanges, 33);
+    EXPECT_EQ(buf, object);
+
+    pldm_multipart_server_set_peers(server, nullptr);
+    pldm_multipart_peers_destroy(peers);
+}
+#endif
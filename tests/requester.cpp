@@ -0,0 +1,364 @@
+#include <libpldm/base.h>
+#include <libpldm/requester.h>
+#include <libpldm/transport.h>
+
+#include "array.h"
+#include "transport/test.h"
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#ifdef LIBPLDM_API_TESTING
+struct completion
+{
+    pldm_tid_t tid;
+    int rc;
+    std::vector<uint8_t> resp;
+};
+
+static void record(void* data, pldm_tid_t tid, int rc, const void* resp,
+                   size_t resp_len)
+{
+    auto* completions = static_cast<std::vector<completion>*>(data);
+    const auto* buf = static_cast<const uint8_t*>(resp);
+
+    completions->push_back({tid, rc, {buf, buf + resp_len}});
+}
+
+TEST(Requester, outOfOrderResponses)
+{
+    uint8_t req0[] = {0x80, 0x00, 0x04};
+    uint8_t req1[] = {0x81, 0x00, 0x04};
+    uint8_t resp0[] = {0x00, 0x00, 0x04, 0x00};
+    uint8_t resp1[] = {0x01, 0x00, 0x04, 0x00};
+    const struct pldm_transport_test_descriptor seq[] = {
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_SEND,
+            .send_msg =
+                {
+                    .dst = 1,
+                    .msg = req0,
+                    .len = sizeof(req0),
+                },
+        },
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_SEND,
+            .send_msg =
+                {
+                    .dst = 1,
+                    .msg = req1,
+                    .len = sizeof(req1),
+                },
+        },
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_RECV,
+            .recv_msg =
+                {
+                    .src = 1,
+                    .msg = resp1,
+                    .len = sizeof(resp1),
+                },
+        },
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_RECV,
+            .recv_msg =
+                {
+                    .src = 1,
+                    .msg = resp0,
+                    .len = sizeof(resp0),
+                },
+        },
+    };
+    struct pldm_transport_test* test = NULL;
+    struct pldm_requester* requester = NULL;
+    std::vector<completion> completions;
+    struct pldm_transport* ctx;
+    pldm_instance_id_t iid;
+    uint8_t req[3];
+
+    ASSERT_EQ(pldm_transport_test_init(&test, seq, ARRAY_SIZE(seq)), 0);
+    ctx = pldm_transport_test_core(test);
+    ASSERT_EQ(pldm_requester_init(&requester, ctx, NULL), 0);
+
+    /* The requester assigns the instance IDs */
+    memcpy(req, req0, sizeof(req));
+    req[0] = 0x80 | 0x1f;
+    ASSERT_EQ(pldm_requester_submit(requester, 1, req, sizeof(req), 1000,
+                                    record, &completions, &iid),
+              0);
+    EXPECT_EQ(iid, 0);
+    ASSERT_EQ(pldm_requester_submit(requester, 1, req, sizeof(req), 1000,
+                                    record, &completions, &iid),
+              0);
+    EXPECT_EQ(iid, 1);
+    EXPECT_EQ(pldm_requester_pending(requester), 2);
+
+    ASSERT_EQ(pldm_requester_process(requester, 0), 0);
+    ASSERT_EQ(completions.size(), 1);
+    EXPECT_EQ(completions[0].tid, 1);
+    EXPECT_EQ(completions[0].rc, 0);
+    EXPECT_EQ(completions[0].resp[0], resp1[0]);
+
+    ASSERT_EQ(pldm_requester_process(requester, 0), 0);
+    ASSERT_EQ(completions.size(), 2);
+    EXPECT_EQ(completions[1].rc, 0);
+    EXPECT_EQ(completions[1].resp[0], resp0[0]);
+    EXPECT_EQ(pldm_requester_pending(requester), 0);
+    EXPECT_EQ(pldm_requester_next_timeout(requester), -1);
+
+    pldm_requester_destroy(requester);
+    pldm_transport_test_destroy(test);
+}
+
+TEST(Requester, uncorrelatedResponse)
+{
+    uint8_t req[] = {0x80, 0x00, 0x04};
+    uint8_t wrongCommand[] = {0x00, 0x00, 0x05, 0x00};
+    uint8_t wrongTid[] = {0x00, 0x00, 0x04, 0x00};
+    const struct pldm_transport_test_descriptor seq[] = {
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_SEND,
+            .send_msg =
+                {
+                    .dst = 1,
+                    .msg = req,
+                    .len = sizeof(req),
+                },
+        },
+    };
+    struct pldm_transport_test* test = NULL;
+    struct pldm_requester* requester = NULL;
+    std::vector<completion> completions;
+    struct pldm_transport* ctx;
+
+    ASSERT_EQ(pldm_transport_test_init(&test, seq, ARRAY_SIZE(seq)), 0);
+    ctx = pldm_transport_test_core(test);
+    ASSERT_EQ(pldm_requester_init(&requester, ctx, NULL), 0);
+    ASSERT_EQ(pldm_requester_submit(requester, 1, req, sizeof(req), 1000,
+                                    record, &completions, NULL),
+              0);
+
+    EXPECT_EQ(pldm_requester_handle_msg(requester, 1, wrongCommand,
+                                        sizeof(wrongCommand)),
+              -ENOMSG);
+    EXPECT_EQ(
+        pldm_requester_handle_msg(requester, 2, wrongTid, sizeof(wrongTid)),
+        -ENOMSG);
+    EXPECT_EQ(pldm_requester_handle_msg(requester, 1, req, sizeof(req)),
+              -ENOMSG);
+    EXPECT_TRUE(completions.empty());
+
+    pldm_requester_destroy(requester);
+    ASSERT_EQ(completions.size(), 1);
+    EXPECT_EQ(completions[0].rc, -ECANCELED);
+    pldm_transport_test_destroy(test);
+}
+
+TEST(Requester, timeout)
+{
+    static const struct timespec delay = {0, 20 * 1000 * 1000};
+    uint8_t req[] = {0x80, 0x00, 0x04};
+    uint8_t resp[] = {0x00, 0x00, 0x04, 0x00};
+    const struct pldm_transport_test_descriptor seq[] = {
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_SEND,
+            .send_msg =
+                {
+                    .dst = 1,
+                    .msg = req,
+                    .len = sizeof(req),
+                },
+        },
+    };
+    struct pldm_transport_test* test = NULL;
+    struct pldm_requester* requester = NULL;
+    std::vector<completion> completions;
+    struct pldm_transport* ctx;
+
+    ASSERT_EQ(pldm_transport_test_init(&test, seq, ARRAY_SIZE(seq)), 0);
+    ctx = pldm_transport_test_core(test);
+    ASSERT_EQ(pldm_requester_init(&requester, ctx, NULL), 0);
+    ASSERT_EQ(pldm_requester_submit(requester, 1, req, sizeof(req), 10, record,
+                                    &completions, NULL),
+              0);
+    EXPECT_EQ(pldm_requester_expire(requester), 0);
+    EXPECT_GE(pldm_requester_next_timeout(requester), 0);
+    EXPECT_LE(pldm_requester_next_timeout(requester), 10);
+
+    nanosleep(&delay, NULL);
+    EXPECT_EQ(pldm_requester_next_timeout(requester), 0);
+    EXPECT_EQ(pldm_requester_expire(requester), 1);
+    ASSERT_EQ(completions.size(), 1);
+    EXPECT_EQ(completions[0].rc, -ETIMEDOUT);
+    EXPECT_TRUE(completions[0].resp.empty());
+
+    /* A late response is not matched */
+    EXPECT_EQ(pldm_requester_handle_msg(requester, 1, resp, sizeof(resp)),
+              -ENOMSG);
+
+    pldm_requester_destroy(requester);
+    pldm_transport_test_destroy(test);
+}
+
+TEST(Requester, retries)
+{
+    static const struct timespec delay = {0, 20 * 1000 * 1000};
+    uint8_t req[] = {0x80, 0x00, 0x04};
+    uint8_t resp[] = {0x00, 0x00, 0x04, 0x00};
+    const struct pldm_transport_test_descriptor seq[] = {
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_SEND,
+            .send_msg =
+                {
+                    .dst = 1,
+                    .msg = req,
+                    .len = sizeof(req),
+                },
+        },
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_SEND,
+            .send_msg =
+                {
+                    .dst = 1,
+                    .msg = req,
+                    .len = sizeof(req),
+                },
+        },
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_SEND,
+            .send_msg =
+                {
+                    .dst = 1,
+                    .msg = req,
+                    .len = sizeof(req),
+                },
+        },
+    };
+    struct pldm_transport_test* test = NULL;
+    struct pldm_requester* requester = NULL;
+    std::vector<completion> completions;
+    struct pldm_transport* ctx;
+
+    ASSERT_EQ(pldm_transport_test_init(&test, seq, ARRAY_SIZE(seq)), 0);
+    ctx = pldm_transport_test_core(test);
+    ASSERT_EQ(pldm_requester_init(&requester, ctx, NULL), 0);
+    ASSERT_EQ(pldm_requester_set_retries(requester, 2), 0);
+    ASSERT_EQ(pldm_requester_submit(requester, 1, req, sizeof(req), 10, record,
+                                    &completions, NULL),
+              0);
+
+    /* Each timeout sends the request again with the same instance ID */
+    nanosleep(&delay, NULL);
+    EXPECT_EQ(pldm_requester_expire(requester), 0);
+    EXPECT_GT(pldm_requester_next_timeout(requester), 0);
+    nanosleep(&delay, NULL);
+    EXPECT_EQ(pldm_requester_expire(requester), 0);
+    EXPECT_TRUE(completions.empty());
+
+    /* A response to the last retry completes the request */
+    EXPECT_EQ(pldm_requester_handle_msg(requester, 1, resp, sizeof(resp)), 0);
+    ASSERT_EQ(completions.size(), 1);
+    EXPECT_EQ(completions[0].rc, 0);
+    EXPECT_EQ(pldm_requester_pending(requester), 0);
+
+    /* A request that can't be sent at all fails without retries */
+    ASSERT_EQ(pldm_requester_set_retries(requester, 3), 0);
+    EXPECT_EQ(pldm_requester_submit(requester, 1, req, sizeof(req), 10,
+                                    record, &completions, NULL),
+              -EIO);
+    EXPECT_EQ(pldm_requester_set_retries(NULL, 1), -EINVAL);
+
+    pldm_requester_destroy(requester);
+    pldm_transport_test_destroy(test);
+}
+
+TEST(Requester, exhaustInstanceIds)
+{
+    static constexpr auto pldmMaxInstanceIds = 32;
+    std::vector<struct pldm_transport_test_descriptor> seq;
+    std::vector<std::vector<uint8_t>> reqs;
+    struct pldm_transport_test* test = NULL;
+    struct pldm_requester* requester = NULL;
+    std::vector<completion> completions;
+    struct pldm_transport* ctx;
+    uint8_t req[3];
+    int i;
+
+    for (i = 0; i < pldmMaxInstanceIds; i++)
+    {
+        reqs.push_back({static_cast<uint8_t>(0x80 | i), 0x00, 0x04});
+    }
+    for (auto& r : reqs)
+    {
+        struct pldm_transport_test_descriptor desc = {};
+
+        desc.type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_SEND;
+        desc.send_msg.dst = 1;
+        desc.send_msg.msg = r.data();
+        desc.send_msg.len = r.size();
+        seq.push_back(desc);
+    }
+
+    ASSERT_EQ(pldm_transport_test_init(&test, seq.data(), seq.size()), 0);
+    ctx = pldm_transport_test_core(test);
+    ASSERT_EQ(pldm_requester_init(&requester, ctx, NULL), 0);
+
+    for (i = 0; i < pldmMaxInstanceIds; i++)
+    {
+        memcpy(req, reqs[0].data(), sizeof(req));
+        ASSERT_EQ(pldm_requester_submit(requester, 1, req, sizeof(req), 1000,
+                                        record, &completions, NULL),
+                  0);
+    }
+
+    memcpy(req, reqs[0].data(), sizeof(req));
+    EXPECT_EQ(pldm_requester_submit(requester, 1, req, sizeof(req), 1000,
+                                    record, &completions, NULL),
+              -EAGAIN);
+
+    EXPECT_EQ(pldm_requester_cancel(requester, 1, 7), 0);
+    EXPECT_EQ(pldm_requester_cancel(requester, 1, 7), -ENOENT);
+    ASSERT_EQ(completions.size(), 1);
+    EXPECT_EQ(completions[0].rc, -ECANCELED);
+
+    pldm_requester_destroy(requester);
+    EXPECT_EQ(completions.size(), pldmMaxInstanceIds);
+    pldm_transport_test_destroy(test);
+}
+
+TEST(Requester, badArgs)
+{
+    struct pldm_transport_test* test = NULL;
+    struct pldm_requester* requester = NULL;
+    uint8_t resp[] = {0x00, 0x00, 0x04, 0x00};
+    struct pldm_transport* ctx;
+
+    ASSERT_EQ(pldm_transport_test_init(&test, NULL, 0), 0);
+    ctx = pldm_transport_test_core(test);
+    EXPECT_EQ(pldm_requester_init(NULL, ctx, NULL), -EINVAL);
+    EXPECT_EQ(pldm_requester_init(&requester, NULL, NULL), -EINVAL);
+    ASSERT_EQ(pldm_requester_init(&requester, ctx, NULL), 0);
+
+    /* Responses can't be submitted */
+    EXPECT_EQ(pldm_requester_submit(requester, 1, resp, sizeof(resp), 1000,
+                                    record, NULL, NULL),
+              -EINVAL);
+    EXPECT_EQ(pldm_requester_submit(requester, 1, resp, 2, 1000, record, NULL,
+                                    NULL),
+              -EINVAL);
+    resp[0] = 0x80;
+    EXPECT_EQ(pldm_requester_submit(requester, 1, resp, sizeof(resp), 0,
+                                    record, NULL, NULL),
+              -EINVAL);
+    EXPECT_EQ(pldm_requester_submit(requester, 1, resp, sizeof(resp), 1000,
+                                    NULL, NULL, NULL),
+              -EINVAL);
+
+    pldm_requester_destroy(requester);
+    pldm_transport_test_destroy(test);
+}
+#endif
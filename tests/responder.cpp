@@ -1,59 +1,73 @@
 // NOLINTNEXTLINE(bugprone-suspicious-include)
 #include "responder.c"
 
+#include <vector>
+
 #include <gtest/gtest.h>
 
 TEST(Responder, track_untrack_one)
 {
-    struct pldm_responder_cookie jar{};
+    struct pldm_responder_cookie_jar jar;
+
+    pldm_responder_cookie_jar_init(&jar);
     struct pldm_responder_cookie cookie = {
         .tid = 1,
         .instance_id = 1,
         .type = 0,
         .command = 0x01, /* SetTID */
         .next = nullptr,
+        .older = nullptr,
+        .newer = nullptr,
     };
 
     ASSERT_EQ(pldm_responder_cookie_track(&jar, &cookie), 0);
-    ASSERT_NE(jar.next, nullptr);
+    ASSERT_EQ(jar.count, 1);
     ASSERT_EQ(pldm_responder_cookie_untrack(&jar, 1, 1, 0, 0x01), &cookie);
-    ASSERT_EQ(jar.next, nullptr);
+    ASSERT_EQ(jar.count, 0);
 }
 
 TEST(Responder, untrack_none)
 {
-    struct pldm_responder_cookie jar{};
+    struct pldm_responder_cookie_jar jar;
+
+    pldm_responder_cookie_jar_init(&jar);
 
-    ASSERT_EQ(jar.next, nullptr);
+    ASSERT_EQ(jar.count, 0);
     ASSERT_EQ(pldm_responder_cookie_untrack(&jar, 1, 1, 0, 0x01), nullptr);
-    ASSERT_EQ(jar.next, nullptr);
+    ASSERT_EQ(jar.count, 0);
 }
 
 TEST(Responder, track_one_untrack_bad)
 {
-    struct pldm_responder_cookie jar{};
+    struct pldm_responder_cookie_jar jar;
+
+    pldm_responder_cookie_jar_init(&jar);
     struct pldm_responder_cookie cookie = {
         .tid = 1,
         .instance_id = 1,
         .type = 0,
         .command = 0x01, /* SetTID */
         .next = nullptr,
+        .older = nullptr,
+        .newer = nullptr,
     };
 
     ASSERT_EQ(pldm_responder_cookie_track(&jar, &cookie), 0);
-    ASSERT_NE(jar.next, nullptr);
+    ASSERT_EQ(jar.count, 1);
     ASSERT_EQ(pldm_responder_cookie_untrack(&jar, 2, 1, 0, 0x01), nullptr);
     ASSERT_EQ(pldm_responder_cookie_untrack(&jar, 1, 2, 0, 0x01), nullptr);
     ASSERT_EQ(pldm_responder_cookie_untrack(&jar, 1, 1, 1, 0x01), nullptr);
     ASSERT_EQ(pldm_responder_cookie_untrack(&jar, 1, 1, 0, 0x02), nullptr);
-    ASSERT_NE(jar.next, nullptr);
+    ASSERT_EQ(jar.count, 1);
     ASSERT_EQ(pldm_responder_cookie_untrack(&jar, 1, 1, 0, 0x01), &cookie);
-    ASSERT_EQ(jar.next, nullptr);
+    ASSERT_EQ(jar.count, 0);
 }
 
 TEST(Responder, track_untrack_two)
 {
-    struct pldm_responder_cookie jar{};
+    struct pldm_responder_cookie_jar jar;
+
+    pldm_responder_cookie_jar_init(&jar);
     struct pldm_responder_cookie cookies[] = {
         {
             .tid = 1,
@@ -61,6 +75,8 @@ TEST(Responder, track_untrack_two)
             .type = 0,
             .command = 0x01, /* SetTID */
             .next = nullptr,
+            .older = nullptr,
+            .newer = nullptr,
         },
         {
             .tid = 2,
@@ -68,13 +84,166 @@ TEST(Responder, track_untrack_two)
             .type = 0,
             .command = 0x01, /* SetTID */
             .next = nullptr,
+            .older = nullptr,
+            .newer = nullptr,
         },
     };
 
     ASSERT_EQ(pldm_responder_cookie_track(&jar, &cookies[0]), 0);
     ASSERT_EQ(pldm_responder_cookie_track(&jar, &cookies[1]), 0);
-    ASSERT_NE(jar.next, nullptr);
+    ASSERT_EQ(jar.count, 2);
     ASSERT_EQ(pldm_responder_cookie_untrack(&jar, 2, 1, 0, 0x01), &cookies[1]);
     ASSERT_EQ(pldm_responder_cookie_untrack(&jar, 1, 1, 0, 0x01), &cookies[0]);
-    ASSERT_EQ(jar.next, nullptr);
+    ASSERT_EQ(jar.count, 0);
+}
+
+TEST(Responder, track_duplicate)
+{
+    struct pldm_responder_cookie_jar jar;
+    struct pldm_responder_cookie cookies[] = {
+        {
+            .tid = 1,
+            .instance_id = 1,
+            .type = 0,
+            .command = 0x01,
+            .next = NULL,
+            .older = NULL,
+            .newer = NULL,
+        },
+        {
+            .tid = 1,
+            .instance_id = 1,
+            .type = 0,
+            .command = 0x01,
+            .next = NULL,
+            .older = NULL,
+            .newer = NULL,
+        },
+    };
+
+    pldm_responder_cookie_jar_init(&jar);
+    ASSERT_EQ(pldm_responder_cookie_track(&jar, &cookies[0]), 0);
+    ASSERT_EQ(pldm_responder_cookie_track(&jar, &cookies[1]),
+              PLDM_REQUESTER_INVALID_SETUP);
+    ASSERT_EQ(jar.count, 1);
+    ASSERT_EQ(pldm_responder_cookie_untrack(&jar, 1, 1, 0, 0x01), &cookies[0]);
+    ASSERT_EQ(jar.count, 0);
+}
+
+TEST(Responder, track_untrack_many)
+{
+    std::vector<struct pldm_responder_cookie> cookies;
+    struct pldm_responder_cookie_jar jar;
+
+    pldm_responder_cookie_jar_init(&jar);
+    for (int tid = 1; tid < 33; tid++)
+    {
+        for (int iid = 0; iid < 32; iid++)
+        {
+            cookies.push_back({
+                .tid = static_cast<pldm_tid_t>(tid),
+                .instance_id = static_cast<pldm_instance_id_t>(iid),
+                .type = 2,
+                .command = 0x0a,
+                .next = NULL,
+                .older = NULL,
+                .newer = NULL,
+            });
+        }
+    }
+
+    /* More cookies than buckets, so chains must form */
+    for (auto& cookie : cookies)
+    {
+        ASSERT_EQ(pldm_responder_cookie_track(&jar, &cookie), 0);
+    }
+    ASSERT_EQ(jar.count, cookies.size());
+
+    for (auto it = cookies.rbegin(); it != cookies.rend(); it++)
+    {
+        ASSERT_EQ(pldm_responder_cookie_untrack(&jar, it->tid, it->instance_id,
+                                                it->type, it->command),
+                  &*it);
+    }
+    ASSERT_EQ(jar.count, 0);
+}
+
+TEST(Responder, evict_oldest)
+{
+    struct pldm_responder_cookie cookies[3] = {};
+    struct pldm_responder_cookie_jar jar;
+    size_t i;
+
+    pldm_responder_cookie_jar_init(&jar);
+    EXPECT_EQ(pldm_responder_cookie_evict(&jar), nullptr);
+
+    for (i = 0; i < 3; i++)
+    {
+        cookies[i].tid = 1;
+        cookies[i].instance_id = static_cast<pldm_instance_id_t>(i);
+        cookies[i].command = 0x01; /* SetTID */
+        ASSERT_EQ(pldm_responder_cookie_track(&jar, &cookies[i]), 0);
+    }
+
+    /* Untracking the oldest makes its successor the oldest */
+    ASSERT_EQ(pldm_responder_cookie_untrack(&jar, 1, 0, 0, 0x01), &cookies[0]);
+    EXPECT_EQ(pldm_responder_cookie_evict(&jar), &cookies[1]);
+    EXPECT_EQ(jar.count, 1);
+
+    /* Tracking again makes a cookie the newest */
+    ASSERT_EQ(pldm_responder_cookie_track(&jar, &cookies[0]), 0);
+    EXPECT_EQ(pldm_responder_cookie_evict(&jar), &cookies[2]);
+    EXPECT_EQ(pldm_responder_cookie_evict(&jar), &cookies[0]);
+    EXPECT_EQ(pldm_responder_cookie_evict(&jar), nullptr);
+    EXPECT_EQ(jar.count, 0);
+    EXPECT_EQ(pldm_responder_cookie_untrack(&jar, 1, 2, 0, 0x01), nullptr);
+}
+
+TEST(Responder, get_put_exhausted)
+{
+    std::vector<struct pldm_responder_cookie> pool(256);
+    struct pldm_responder_cookie_jar jar;
+    struct pldm_responder_cookie* cookie;
+    size_t i;
+
+    pldm_responder_cookie_jar_init(&jar);
+    EXPECT_EQ(pldm_responder_cookie_get(&jar), nullptr);
+    for (auto& unused : pool)
+    {
+        pldm_responder_cookie_put(&jar, &unused);
+    }
+
+    /* Leave every request in the pool unanswered */
+    for (i = 0; i < pool.size(); i++)
+    {
+        cookie = pldm_responder_cookie_get(&jar);
+        ASSERT_NE(cookie, nullptr);
+        cookie->tid = static_cast<pldm_tid_t>(1 + i / 32);
+        cookie->instance_id = static_cast<pldm_instance_id_t>(i % 32);
+        cookie->type = 0;
+        cookie->command = 0x02; /* GetTID */
+        ASSERT_EQ(pldm_responder_cookie_track(&jar, cookie), 0);
+    }
+    ASSERT_EQ(jar.count, pool.size());
+
+    /* A further request claims the cookie of the oldest */
+    cookie = pldm_responder_cookie_get(&jar);
+    ASSERT_NE(cookie, nullptr);
+    EXPECT_EQ(cookie->tid, 1);
+    EXPECT_EQ(cookie->instance_id, 0);
+    EXPECT_EQ(jar.count, pool.size() - 1);
+    EXPECT_EQ(pldm_responder_cookie_untrack(&jar, 1, 0, 0, 0x02), nullptr);
+
+    cookie->tid = 9;
+    cookie->instance_id = 0;
+    ASSERT_EQ(pldm_responder_cookie_track(&jar, cookie), 0);
+
+    /* The next oldest is reclaimed after that, and answers still route */
+    EXPECT_EQ(pldm_responder_cookie_untrack(&jar, 9, 0, 0, 0x02), cookie);
+    pldm_responder_cookie_put(&jar, cookie);
+    EXPECT_EQ(pldm_responder_cookie_get(&jar), cookie);
+    cookie = pldm_responder_cookie_get(&jar);
+    ASSERT_NE(cookie, nullptr);
+    EXPECT_EQ(cookie->tid, 1);
+    EXPECT_EQ(cookie->instance_id, 1);
 }
@@ -0,0 +1,235 @@
+#include <libpldm/timer-wheel.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#ifdef LIBPLDM_API_TESTING
+struct expiry
+{
+    struct pldm_timer timer;
+    uint64_t fired_at;
+    int count;
+};
+
+static uint64_t now;
+
+static void record(void*, struct pldm_timer* timer)
+{
+    auto* e = reinterpret_cast<struct expiry*>(timer);
+
+    e->fired_at = now;
+    e->count++;
+}
+
+class TimerWheel : public testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        now = 1000;
+        ASSERT_EQ(pldm_timer_wheel_init(&wheel, now), 0);
+    }
+
+    void TearDown() override
+    {
+        pldm_timer_wheel_destroy(wheel);
+    }
+
+    int advance(uint64_t to)
+    {
+        now = to;
+        return pldm_timer_wheel_advance(wheel, now);
+    }
+
+    struct pldm_timer_wheel* wheel = nullptr;
+};
+
+TEST_F(TimerWheel, expiry)
+{
+    struct expiry a = {};
+    struct expiry b = {};
+
+    EXPECT_EQ(pldm_timer_wheel_next_timeout(wheel, now), -1);
+    ASSERT_EQ(pldm_timer_wheel_add(wheel, &a.timer, 1010, record, nullptr), 0);
+    ASSERT_EQ(pldm_timer_wheel_add(wheel, &b.timer, 1100, record, nullptr), 0);
+    EXPECT_TRUE(pldm_timer_pending(&a.timer));
+    EXPECT_EQ(pldm_timer_wheel_add(wheel, &a.timer, 1010, record, nullptr),
+              -EBUSY);
+    EXPECT_EQ(pldm_timer_wheel_next_timeout(wheel, now), 10);
+
+    EXPECT_EQ(advance(1009), 0);
+    EXPECT_EQ(pldm_timer_wheel_next_timeout(wheel, now), 1);
+    EXPECT_EQ(advance(1050), 1);
+    EXPECT_EQ(a.fired_at, 1050);
+    EXPECT_FALSE(pldm_timer_pending(&a.timer));
+
+    /* Distant timers may be reported early, but never late */
+    EXPECT_GT(pldm_timer_wheel_next_timeout(wheel, now), 0);
+    EXPECT_LE(pldm_timer_wheel_next_timeout(wheel, now), 50);
+    EXPECT_EQ(advance(1099), 0);
+    EXPECT_EQ(advance(1100), 1);
+    EXPECT_EQ(b.count, 1);
+    EXPECT_EQ(pldm_timer_wheel_next_timeout(wheel, now), -1);
+}
+
+TEST_F(TimerWheel, del)
+{
+    struct expiry a = {};
+
+    EXPECT_EQ(pldm_timer_wheel_del(wheel, &a.timer), -ENOENT);
+    ASSERT_EQ(pldm_timer_wheel_add(wheel, &a.timer, 5000, record, nullptr), 0);
+    EXPECT_EQ(pldm_timer_wheel_del(wheel, &a.timer), 0);
+    EXPECT_FALSE(pldm_timer_pending(&a.timer));
+    EXPECT_EQ(pldm_timer_wheel_next_timeout(wheel, now), -1);
+    EXPECT_EQ(advance(10000), 0);
+    EXPECT_EQ(a.count, 0);
+}
+
+TEST_F(TimerWheel, past)
+{
+    struct expiry a = {};
+
+    EXPECT_EQ(advance(2000), 0);
+    ASSERT_EQ(pldm_timer_wheel_add(wheel, &a.timer, 1500, record, nullptr), 0);
+    EXPECT_EQ(pldm_timer_wheel_next_timeout(wheel, now), 0);
+    EXPECT_EQ(advance(2000), 1);
+    EXPECT_EQ(a.count, 1);
+}
+
+TEST_F(TimerWheel, horizon)
+{
+    /* Beyond the reach of the top level of the wheel */
+    const uint64_t far = now + (UINT64_C(1) << 40);
+    struct expiry a = {};
+
+    ASSERT_EQ(pldm_timer_wheel_add(wheel, &a.timer, far, record, nullptr), 0);
+    EXPECT_EQ(advance(far - (UINT64_C(1) << 37)), 0);
+    EXPECT_EQ(advance(far - 1), 0);
+    EXPECT_EQ(advance(far), 1);
+    EXPECT_EQ(a.fired_at, far);
+}
+
+TEST_F(TimerWheel, randomized)
+{
+    static constexpr int count = 5000;
+    std::vector<struct expiry> timers(count);
+    std::vector<uint64_t> expires(count);
+    std::mt19937_64 gen(0);
+    std::uniform_int_distribution<uint64_t> when(0, 20 * 1000 * 1000);
+    std::uniform_int_distribution<uint64_t> step(0, 70 * 1000);
+    uint64_t prev;
+    int fired = 0;
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        timers[i] = {};
+        expires[i] = now + when(gen);
+        ASSERT_EQ(pldm_timer_wheel_add(wheel, &timers[i].timer, expires[i],
+                                       record, nullptr),
+                  0);
+    }
+
+    /* Each timer fires in the first advance that reaches its expiry */
+    while (fired < count)
+    {
+        int next = pldm_timer_wheel_next_timeout(wheel, now);
+        int rc;
+
+        ASSERT_GE(next, 0);
+        prev = now;
+        rc = advance(now + std::min<uint64_t>(step(gen), next));
+        ASSERT_GE(rc, 0);
+        fired += rc;
+        for (i = 0; i < count; i++)
+        {
+            if (expires[i] > prev && expires[i] <= now)
+            {
+                EXPECT_EQ(timers[i].count, 1);
+                EXPECT_EQ(timers[i].fired_at, now);
+            }
+        }
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        EXPECT_EQ(timers[i].count, 1);
+    }
+}
+
+struct chain
+{
+    struct pldm_timer timer;
+    struct pldm_timer_wheel* wheel;
+    struct pldm_timer* victim;
+    int rearms;
+    int count;
+};
+
+static void rearm(void* data, struct pldm_timer* timer)
+{
+    auto* c = static_cast<struct chain*>(data);
+
+    c->count++;
+    if (c->victim)
+    {
+        EXPECT_EQ(pldm_timer_wheel_del(c->wheel, c->victim), 0);
+        c->victim = nullptr;
+    }
+    if (c->rearms)
+    {
+        c->rearms--;
+        EXPECT_EQ(pldm_timer_wheel_add(c->wheel, timer, now + 10, rearm, c),
+                  0);
+    }
+}
+
+TEST_F(TimerWheel, callbacks)
+{
+    struct chain c = {};
+    struct chain victim = {};
+
+    c.wheel = wheel;
+    c.victim = &victim.timer;
+    c.rearms = 2;
+    victim.wheel = wheel;
+
+    /* Expiring together, the first to fire removes the other */
+    ASSERT_EQ(pldm_timer_wheel_add(wheel, &victim.timer, 1010, rearm, &victim),
+              0);
+    ASSERT_EQ(pldm_timer_wheel_add(wheel, &c.timer, 1010, rearm, &c), 0);
+    EXPECT_EQ(advance(1010), 1);
+    EXPECT_EQ(c.count, 1);
+    EXPECT_EQ(victim.count, 0);
+
+    EXPECT_EQ(advance(1020), 1);
+    EXPECT_EQ(advance(1030), 1);
+    EXPECT_EQ(advance(1040), 0);
+    EXPECT_EQ(c.count, 3);
+}
+
+TEST(TimerWheelInit, badArgs)
+{
+    struct pldm_timer_wheel* wheel = nullptr;
+    struct pldm_timer timer = {};
+
+    EXPECT_EQ(pldm_timer_wheel_init(nullptr, 0), -EINVAL);
+    ASSERT_EQ(pldm_timer_wheel_init(&wheel, 0), 0);
+    EXPECT_EQ(pldm_timer_wheel_init(&wheel, 0), -EINVAL);
+    EXPECT_EQ(pldm_timer_wheel_add(wheel, &timer, 1, nullptr, nullptr),
+              -EINVAL);
+    EXPECT_EQ(pldm_timer_wheel_add(nullptr, &timer, 1, record, nullptr),
+              -EINVAL);
+    EXPECT_EQ(pldm_timer_wheel_advance(nullptr, 0), -EINVAL);
+    EXPECT_EQ(pldm_timer_wheel_next_timeout(nullptr, 0), -EINVAL);
+
+    /* Destroying the wheel leaves its timers ready for reuse */
+    ASSERT_EQ(pldm_timer_wheel_add(wheel, &timer, 1, record, nullptr), 0);
+    pldm_timer_wheel_destroy(wheel);
+    EXPECT_FALSE(pldm_timer_pending(&timer));
+}
+#endif
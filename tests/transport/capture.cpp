@@ -0,0 +1,259 @@
+#include <libpldm/base.h>
+#include <libpldm/transport.h>
+#include <libpldm/transport/capture.h>
+
+#include "array.h"
+#include "transport/test.h"
+
+#include <poll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#ifdef LIBPLDM_API_TESTING
+static void append(std::vector<uint8_t>& capture, uint32_t delta_us,
+                   pldm_tid_t tid, enum pldm_transport_capture_dir dir,
+                   const std::vector<uint8_t>& msg)
+{
+    const uint32_t len = msg.size();
+    uint8_t rec[PLDM_TRANSPORT_CAPTURE_RECORD_SIZE];
+
+    /* The capture format is little-endian, as are the hosts we test on */
+    memcpy(&rec[0], &delta_us, sizeof(delta_us));
+    memcpy(&rec[4], &len, sizeof(len));
+    rec[8] = tid;
+    rec[9] = dir;
+    capture.insert(capture.end(), rec, rec + sizeof(rec));
+    capture.insert(capture.end(), msg.begin(), msg.end());
+}
+
+static std::vector<uint8_t> header()
+{
+    std::vector<uint8_t> capture(PLDM_TRANSPORT_CAPTURE_HEADER_SIZE);
+    const uint32_t magic = PLDM_TRANSPORT_CAPTURE_MAGIC;
+    const uint16_t version = PLDM_TRANSPORT_CAPTURE_VERSION;
+
+    memcpy(&capture[0], &magic, sizeof(magic));
+    memcpy(&capture[4], &version, sizeof(version));
+
+    return capture;
+}
+
+TEST(Capture, record)
+{
+    uint8_t req[] = {0x81, 0x00, 0x01, 0x01};
+    uint8_t resp[] = {0x01, 0x00, 0x01, 0x00};
+    const struct pldm_transport_test_descriptor seq[] = {
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_SEND,
+            .send_msg =
+                {
+                    .dst = 1,
+                    .msg = req,
+                    .len = sizeof(req),
+                },
+        },
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_RECV,
+            .recv_msg =
+                {
+                    .src = 1,
+                    .msg = resp,
+                    .len = sizeof(resp),
+                },
+        },
+    };
+    struct pldm_transport_capture* capture = nullptr;
+    struct pldm_transport_test* test = nullptr;
+    std::vector<uint8_t> expected = header();
+    std::vector<uint8_t> buf(128);
+    uint32_t delta;
+    size_t len;
+    void* msg;
+    ssize_t rc;
+    int fd;
+
+    fd = memfd_create("capture", MFD_CLOEXEC);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(pldm_transport_test_init(&test, seq, ARRAY_SIZE(seq)), 0);
+    ASSERT_EQ(pldm_transport_capture_init(
+                  &capture, pldm_transport_test_core(test), fd),
+              0);
+
+    ASSERT_EQ(pldm_transport_send_recv_msg(
+                  pldm_transport_capture_core(capture), 1, req, sizeof(req),
+                  &msg, &len),
+              PLDM_REQUESTER_SUCCESS);
+    EXPECT_EQ(len, sizeof(resp));
+    free(msg);
+    ASSERT_EQ(pldm_transport_capture_flush(capture), 0);
+    pldm_transport_capture_destroy(capture);
+    pldm_transport_test_destroy(test);
+
+    append(expected, 0, 1, PLDM_TRANSPORT_CAPTURE_TX, {req, req + 4});
+    append(expected, 0, 1, PLDM_TRANSPORT_CAPTURE_RX, {resp, resp + 4});
+    rc = pread(fd, buf.data(), buf.size(), 0);
+    close(fd);
+    ASSERT_EQ(rc, (ssize_t)expected.size());
+    buf.resize(rc);
+
+    /* The timestamps aren't predictable, so copy them before comparing */
+    memcpy(&expected[8], &buf[8], 8);
+    memcpy(&delta, &buf[16], sizeof(delta));
+    memcpy(&expected[16], &delta, sizeof(delta));
+    memcpy(&delta, &buf[30], sizeof(delta));
+    memcpy(&expected[30], &delta, sizeof(delta));
+    EXPECT_EQ(buf, expected);
+}
+
+TEST(Capture, replayRequester)
+{
+    std::vector<uint8_t> capture = header();
+    struct pldm_transport_replay_progress progress;
+    struct pldm_transport_replay* replay = nullptr;
+    const uint8_t req[] = {0x85, 0x00, 0x01, 0x01};
+    struct pldm_transport* ctx;
+    uint8_t* resp;
+    size_t len;
+
+    /* Captured with instance ID 1, replayed with instance ID 5 */
+    append(capture, 100, 1, PLDM_TRANSPORT_CAPTURE_TX, {0x81, 0x00, 0x01, 0x01});
+    append(capture, 100, 1, PLDM_TRANSPORT_CAPTURE_RX,
+           {0x01, 0x00, 0x01, 0x00, 0xaa});
+    ASSERT_EQ(pldm_transport_replay_init(&replay, capture.data(),
+                                         capture.size(),
+                                         PLDM_TRANSPORT_REPLAY_FLAT_OUT),
+              0);
+    ctx = pldm_transport_replay_core(replay);
+
+    /* The response waits for the request */
+    EXPECT_EQ(pldm_transport_poll(ctx, 0), 0);
+    ASSERT_EQ(pldm_transport_send_recv_msg(ctx, 1, req, sizeof(req),
+                                           (void**)&resp, &len),
+              PLDM_REQUESTER_SUCCESS);
+    ASSERT_EQ(len, 5);
+    EXPECT_EQ(resp[0], 0x05);
+    EXPECT_EQ(resp[4], 0xaa);
+    free(resp);
+
+    EXPECT_EQ(pldm_transport_replay_get_progress(replay, &progress), 1);
+    EXPECT_EQ(progress.records, 2);
+    EXPECT_EQ(progress.received, 1);
+    EXPECT_EQ(progress.sent, 1);
+    EXPECT_EQ(progress.mismatched, 0);
+
+    EXPECT_EQ(pldm_transport_send_msg(ctx, 1, req, sizeof(req)),
+              PLDM_REQUESTER_SEND_FAIL);
+    EXPECT_EQ(pldm_transport_replay_get_progress(replay, &progress), 1);
+    EXPECT_EQ(progress.unexpected, 1);
+    pldm_transport_replay_destroy(replay);
+}
+
+TEST(Capture, replayResponder)
+{
+    std::vector<uint8_t> capture = header();
+    struct pldm_transport_replay_progress progress;
+    struct pldm_transport_replay* replay = nullptr;
+    const uint8_t wrong[] = {0x02, 0x00, 0x01, 0x01};
+    struct pldm_transport* ctx;
+    pldm_tid_t tid;
+    uint8_t* req;
+    size_t len;
+
+    append(capture, 0, 9, PLDM_TRANSPORT_CAPTURE_RX, {0x82, 0x00, 0x01});
+    append(capture, 0, 9, PLDM_TRANSPORT_CAPTURE_TX, {0x02, 0x00, 0x01, 0x00});
+    ASSERT_EQ(pldm_transport_replay_init(&replay, capture.data(),
+                                         capture.size(), 1),
+              0);
+    ctx = pldm_transport_replay_core(replay);
+
+    ASSERT_EQ(pldm_transport_poll(ctx, 1000), 1);
+    ASSERT_EQ(pldm_transport_recv_msg(ctx, &tid, (void**)&req, &len),
+              PLDM_REQUESTER_SUCCESS);
+    EXPECT_EQ(tid, 9);
+    EXPECT_EQ(len, 3);
+    EXPECT_EQ(req[0], 0x82);
+    free(req);
+    EXPECT_EQ(pldm_transport_recv_msg(ctx, &tid, (void**)&req, &len),
+              PLDM_REQUESTER_RECV_FAIL);
+
+    /* Sends that differ from the capture are tolerated, but counted */
+    EXPECT_EQ(pldm_transport_send_msg(ctx, 9, wrong, sizeof(wrong)),
+              PLDM_REQUESTER_SUCCESS);
+    EXPECT_EQ(pldm_transport_replay_get_progress(replay, &progress), 1);
+    EXPECT_EQ(progress.mismatched, 1);
+    pldm_transport_replay_destroy(replay);
+}
+
+TEST(Capture, replayPace)
+{
+    using namespace std::chrono;
+    std::vector<uint8_t> capture = header();
+    struct pldm_transport_replay* replay = nullptr;
+    struct pldm_transport* ctx;
+    steady_clock::time_point start;
+    pldm_tid_t tid;
+    void* msg;
+    size_t len;
+
+    append(capture, 0, 1, PLDM_TRANSPORT_CAPTURE_RX, {0x81, 0x00, 0x01});
+    append(capture, 200000, 1, PLDM_TRANSPORT_CAPTURE_RX, {0x82, 0x00, 0x01});
+
+    /* Accelerated tenfold, the second message is due 20ms after the first */
+    ASSERT_EQ(pldm_transport_replay_init(&replay, capture.data(),
+                                         capture.size(), 10),
+              0);
+    ctx = pldm_transport_replay_core(replay);
+    ASSERT_EQ(pldm_transport_recv_msg(ctx, &tid, &msg, &len),
+              PLDM_REQUESTER_SUCCESS);
+    free(msg);
+    start = steady_clock::now();
+    EXPECT_EQ(pldm_transport_recv_msg(ctx, &tid, &msg, &len),
+              PLDM_REQUESTER_RECV_FAIL);
+    ASSERT_EQ(pldm_transport_poll(ctx, 1000), 1);
+    ASSERT_EQ(pldm_transport_recv_msg(ctx, &tid, &msg, &len),
+              PLDM_REQUESTER_SUCCESS);
+    free(msg);
+    EXPECT_GE(steady_clock::now() - start, milliseconds(19));
+    EXPECT_EQ(pldm_transport_poll(ctx, 0), 0);
+    pldm_transport_replay_destroy(replay);
+}
+
+TEST(Capture, replayMalformed)
+{
+    struct pldm_transport_replay* replay = nullptr;
+    std::vector<uint8_t> capture = header();
+
+    EXPECT_EQ(pldm_transport_replay_init(&replay, capture.data(), 8, 1),
+              -EPROTO);
+    EXPECT_EQ(pldm_transport_replay_init(nullptr, capture.data(),
+                                         capture.size(), 1),
+              -EINVAL);
+
+    /* Shorter than a PLDM message header */
+    append(capture, 0, 1, PLDM_TRANSPORT_CAPTURE_RX, {0x81, 0x00});
+    EXPECT_EQ(pldm_transport_replay_init(&replay, capture.data(),
+                                         capture.size(), 1),
+              -EPROTO);
+
+    capture = header();
+    append(capture, 0, 1, PLDM_TRANSPORT_CAPTURE_RX, {0x81, 0x00, 0x01});
+    EXPECT_EQ(pldm_transport_replay_init(&replay, capture.data(),
+                                         capture.size() - 1, 1),
+              -EPROTO);
+
+    capture[0] ^= 0xff;
+    EXPECT_EQ(pldm_transport_replay_init(&replay, capture.data(),
+                                         capture.size(), 1),
+              -EPROTO);
+    EXPECT_EQ(replay, nullptr);
+}
+#endif
@@ -0,0 +1,372 @@
+#include <libpldm/base.h>
+#include <libpldm/event-loop.h>
+#include <libpldm/requester.h>
+#include <libpldm/transport.h>
+
+#include "array.h"
+#include "transport/test.h"
+#include "transport/transport.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+struct received
+{
+    pldm_tid_t tid;
+    uint8_t type;
+};
+
+static void record(void* data, struct pldm_transport*, pldm_tid_t tid,
+                   const void* msg, size_t)
+{
+    auto* msgs = static_cast<std::vector<received>*>(data);
+    const auto* hdr = static_cast<const struct pldm_msg_hdr*>(msg);
+
+    msgs->push_back({tid, static_cast<uint8_t>(hdr->type)});
+}
+
+TEST(EventLoop, dispatchByType)
+{
+    uint8_t base[] = {0x81, 0x00, 0x04};
+    uint8_t platform[] = {0x82, 0x02, 0x11};
+    const struct pldm_transport_test_descriptor seq[] = {
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_RECV,
+            .recv_msg =
+                {
+                    .src = 1,
+                    .msg = base,
+                    .len = sizeof(base),
+                },
+        },
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_RECV,
+            .recv_msg =
+                {
+                    .src = 2,
+                    .msg = platform,
+                    .len = sizeof(platform),
+                },
+        },
+    };
+    struct pldm_transport_test* test = NULL;
+    struct pldm_event_loop* loop = NULL;
+    std::vector<received> platformMsgs;
+    std::vector<received> baseMsgs;
+    struct pldm_transport* ctx;
+
+    ASSERT_EQ(pldm_transport_test_init(&test, seq, ARRAY_SIZE(seq)), 0);
+    ctx = pldm_transport_test_core(test);
+    ASSERT_EQ(pldm_event_loop_init(&loop), 0);
+    ASSERT_EQ(pldm_event_loop_add_transport(loop, ctx, NULL), 0);
+    EXPECT_EQ(pldm_event_loop_add_transport(loop, ctx, NULL), -EEXIST);
+    ASSERT_EQ(pldm_event_loop_set_handler(loop, PLDM_BASE, record, &baseMsgs),
+              0);
+    ASSERT_EQ(pldm_event_loop_set_handler(loop, PLDM_PLATFORM, record,
+                                          &platformMsgs),
+              0);
+    EXPECT_EQ(pldm_event_loop_set_handler(loop, 64, record, NULL), -EINVAL);
+
+    EXPECT_EQ(pldm_event_loop_run_once(loop, 100), 1);
+    EXPECT_EQ(pldm_event_loop_run_once(loop, 100), 1);
+    ASSERT_EQ(baseMsgs.size(), 1);
+    EXPECT_EQ(baseMsgs[0].tid, 1);
+    ASSERT_EQ(platformMsgs.size(), 1);
+    EXPECT_EQ(platformMsgs[0].tid, 2);
+    EXPECT_EQ(platformMsgs[0].type, PLDM_PLATFORM);
+
+    EXPECT_EQ(pldm_event_loop_remove_transport(loop, ctx), 0);
+    EXPECT_EQ(pldm_event_loop_remove_transport(loop, ctx), -ENOENT);
+
+    pldm_event_loop_destroy(loop);
+    pldm_transport_test_destroy(test);
+}
+
+static void complete(void* data, pldm_tid_t, int rc, const void*, size_t)
+{
+    *static_cast<int*>(data) = rc;
+}
+
+TEST(EventLoop, requesterResponse)
+{
+    uint8_t req[] = {0x80, 0x00, 0x04};
+    uint8_t resp[] = {0x00, 0x00, 0x04, 0x00};
+    const struct pldm_transport_test_descriptor seq[] = {
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_SEND,
+            .send_msg =
+                {
+                    .dst = 1,
+                    .msg = req,
+                    .len = sizeof(req),
+                },
+        },
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_RECV,
+            .recv_msg =
+                {
+                    .src = 1,
+                    .msg = resp,
+                    .len = sizeof(resp),
+                },
+        },
+    };
+    struct pldm_requester* requester = NULL;
+    struct pldm_transport_test* test = NULL;
+    struct pldm_event_loop* loop = NULL;
+    std::vector<received> baseMsgs;
+    struct pldm_transport* ctx;
+    int result = 1;
+
+    ASSERT_EQ(pldm_transport_test_init(&test, seq, ARRAY_SIZE(seq)), 0);
+    ctx = pldm_transport_test_core(test);
+    ASSERT_EQ(pldm_requester_init(&requester, ctx, NULL), 0);
+    ASSERT_EQ(pldm_requester_submit(requester, 1, req, sizeof(req), 1000,
+                                    complete, &result, NULL),
+              0);
+
+    ASSERT_EQ(pldm_event_loop_init(&loop), 0);
+    ASSERT_EQ(pldm_event_loop_add_transport(loop, ctx, requester), 0);
+    ASSERT_EQ(pldm_event_loop_set_handler(loop, PLDM_BASE, record, &baseMsgs),
+              0);
+
+    EXPECT_EQ(pldm_event_loop_run_once(loop, 100), 1);
+    EXPECT_EQ(result, 0);
+    EXPECT_TRUE(baseMsgs.empty());
+
+    pldm_event_loop_destroy(loop);
+    pldm_requester_destroy(requester);
+    pldm_transport_test_destroy(test);
+}
+
+struct ticker
+{
+    struct pldm_event_loop* loop;
+    int count;
+};
+
+static void tick(void* data, struct pldm_event_loop_timer* timer)
+{
+    auto* t = static_cast<ticker*>(data);
+
+    if (++t->count == 3)
+    {
+        EXPECT_EQ(pldm_event_loop_remove_timer(t->loop, timer), 0);
+        pldm_event_loop_stop(t->loop);
+    }
+}
+
+TEST(EventLoop, periodicTimer)
+{
+    struct pldm_event_loop_timer* timer = NULL;
+    struct pldm_event_loop* loop = NULL;
+    ticker t = {};
+
+    ASSERT_EQ(pldm_event_loop_init(&loop), 0);
+    t.loop = loop;
+    EXPECT_EQ(pldm_event_loop_add_timer(loop, 0, 1, tick, &t, &timer),
+              -EINVAL);
+    ASSERT_EQ(pldm_event_loop_add_timer(loop, 1, 1, tick, &t, &timer), 0);
+
+    EXPECT_EQ(pldm_event_loop_run(loop), 0);
+    EXPECT_EQ(t.count, 3);
+
+    /* The timer is gone, so nothing is left to dispatch */
+    EXPECT_EQ(pldm_event_loop_run_once(loop, 5), 0);
+
+    pldm_event_loop_destroy(loop);
+}
+
+/* A transport receiving each read of its fd as a message */
+struct fd_transport
+{
+    struct pldm_transport transport;
+    int fd;
+};
+
+static int fdInitPollfd(struct pldm_transport* t, struct pollfd* pollfd)
+{
+    auto* f = reinterpret_cast<fd_transport*>(t);
+
+    pollfd->fd = f->fd;
+    pollfd->events = POLLIN;
+    return 0;
+}
+
+static pldm_requester_rc_t fdRecv(struct pldm_transport* t, pldm_tid_t* tid,
+                                  void** msg, size_t* len)
+{
+    auto* f = reinterpret_cast<fd_transport*>(t);
+    uint8_t buf[64];
+    ssize_t rc;
+
+    rc = read(f->fd, buf, sizeof(buf));
+    if (rc <= 0)
+    {
+        return PLDM_REQUESTER_RECV_FAIL;
+    }
+
+    *msg = malloc(rc);
+    if (!*msg)
+    {
+        return PLDM_REQUESTER_RECV_FAIL;
+    }
+
+    memcpy(*msg, buf, rc);
+    *len = rc;
+    *tid = 1;
+    return PLDM_REQUESTER_SUCCESS;
+}
+
+static void recordHangup(void* data, struct pldm_transport* transport)
+{
+    auto* hungUp = static_cast<std::vector<struct pldm_transport*>*>(data);
+
+    hungUp->push_back(transport);
+}
+
+static void fdTransportInit(fd_transport* f, int fd)
+{
+    f->transport.name = "fd";
+    f->transport.recv = fdRecv;
+    f->transport.init_pollfd = fdInitPollfd;
+    f->fd = fd;
+}
+
+TEST(EventLoop, hangupRemovesTransport)
+{
+    std::vector<struct pldm_transport*> hungUp;
+    struct pldm_event_loop* loop = NULL;
+    fd_transport f = {};
+    int fds[2];
+
+    ASSERT_EQ(pipe(fds), 0);
+    fdTransportInit(&f, fds[0]);
+
+    ASSERT_EQ(pldm_event_loop_init(&loop), 0);
+    ASSERT_EQ(pldm_event_loop_add_transport(loop, &f.transport, NULL), 0);
+    ASSERT_EQ(pldm_event_loop_set_hangup_handler(loop, recordHangup, &hungUp),
+              0);
+
+    /* Nothing to dispatch while the pipe is open */
+    EXPECT_EQ(pldm_event_loop_run_once(loop, 0), 0);
+    EXPECT_TRUE(hungUp.empty());
+
+    close(fds[1]);
+    EXPECT_EQ(pldm_event_loop_run_once(loop, 0), 0);
+    ASSERT_EQ(hungUp.size(), 1);
+    EXPECT_EQ(hungUp[0], &f.transport);
+    EXPECT_EQ(pldm_event_loop_remove_transport(loop, &f.transport), -ENOENT);
+
+    /* The hung-up fd no longer wakes the loop */
+    EXPECT_EQ(pldm_event_loop_run_once(loop, 0), 0);
+    EXPECT_EQ(hungUp.size(), 1);
+
+    pldm_event_loop_destroy(loop);
+    close(fds[0]);
+}
+
+TEST(EventLoop, hangupDrainsPendingMessages)
+{
+    std::vector<struct pldm_transport*> hungUp;
+    uint8_t base[] = {0x81, 0x00, 0x04};
+    struct pldm_event_loop* loop = NULL;
+    std::vector<received> msgs;
+    fd_transport f = {};
+    int fds[2];
+
+    ASSERT_EQ(pipe(fds), 0);
+    fdTransportInit(&f, fds[0]);
+
+    ASSERT_EQ(pldm_event_loop_init(&loop), 0);
+    ASSERT_EQ(pldm_event_loop_add_transport(loop, &f.transport, NULL), 0);
+    ASSERT_EQ(pldm_event_loop_set_handler(loop, PLDM_BASE, record, &msgs), 0);
+    ASSERT_EQ(pldm_event_loop_set_hangup_handler(loop, recordHangup, &hungUp),
+              0);
+
+    ASSERT_EQ(write(fds[1], base, sizeof(base)), (ssize_t)sizeof(base));
+    close(fds[1]);
+
+    /* The message is received although the pipe has hung up */
+    EXPECT_EQ(pldm_event_loop_run_once(loop, 0), 1);
+    ASSERT_EQ(msgs.size(), 1);
+    EXPECT_EQ(msgs[0].type, PLDM_BASE);
+    EXPECT_TRUE(hungUp.empty());
+
+    /* Once drained the transport is removed */
+    EXPECT_EQ(pldm_event_loop_run_once(loop, 0), 0);
+    EXPECT_EQ(hungUp.size(), 1);
+
+    pldm_event_loop_destroy(loop);
+    close(fds[0]);
+}
+
+TEST(EventLoop, socketErrorKeepsTransport)
+{
+    std::vector<struct pldm_transport*> hungUp;
+    uint8_t base[] = {0x81, 0x00, 0x04};
+    struct pldm_event_loop* loop = NULL;
+    struct sockaddr_in addr = {};
+    std::vector<received> msgs;
+    socklen_t len = sizeof(addr);
+    fd_transport f = {};
+    int peer;
+    int sd;
+
+    /* Find a port with no listener, for which a datagram is refused */
+    peer = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(peer, 0);
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(bind(peer, reinterpret_cast<struct sockaddr*>(&addr), len), 0);
+    ASSERT_EQ(
+        getsockname(peer, reinterpret_cast<struct sockaddr*>(&addr), &len), 0);
+    close(peer);
+
+    sd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    ASSERT_GE(sd, 0);
+    ASSERT_EQ(connect(sd, reinterpret_cast<struct sockaddr*>(&addr), len), 0);
+    fdTransportInit(&f, sd);
+
+    ASSERT_EQ(pldm_event_loop_init(&loop), 0);
+    ASSERT_EQ(pldm_event_loop_add_transport(loop, &f.transport, NULL), 0);
+    ASSERT_EQ(pldm_event_loop_set_handler(loop, PLDM_BASE, record, &msgs), 0);
+    ASSERT_EQ(pldm_event_loop_set_hangup_handler(loop, recordHangup, &hungUp),
+              0);
+
+    /* The refusal is reported as a pending error on the socket */
+    ASSERT_EQ(send(sd, base, sizeof(base), 0), (ssize_t)sizeof(base));
+    EXPECT_EQ(pldm_event_loop_run_once(loop, 100), 0);
+    EXPECT_TRUE(hungUp.empty());
+
+    /* The error is cleared, and the socket still receives */
+    EXPECT_EQ(pldm_event_loop_run_once(loop, 0), 0);
+
+    peer = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(peer, 0);
+    ASSERT_EQ(bind(peer, reinterpret_cast<struct sockaddr*>(&addr), len), 0);
+    len = sizeof(addr);
+    ASSERT_EQ(
+        getsockname(sd, reinterpret_cast<struct sockaddr*>(&addr), &len), 0);
+    ASSERT_EQ(sendto(peer, base, sizeof(base), 0,
+                     reinterpret_cast<struct sockaddr*>(&addr), len),
+              (ssize_t)sizeof(base));
+
+    EXPECT_EQ(pldm_event_loop_run_once(loop, 100), 1);
+    EXPECT_EQ(msgs.size(), 1);
+    EXPECT_TRUE(hungUp.empty());
+
+    pldm_event_loop_destroy(loop);
+    close(peer);
+    close(sd);
+}
@@ -0,0 +1,192 @@
+#include <libpldm/base.h>
+#include <libpldm/transport.h>
+#include <libpldm/transport/io-uring.h>
+
+#include "array.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#ifdef LIBPLDM_API_TESTING
+/* The mctp-demux-daemon framing, over a socketpair standing in for the daemon */
+class IoUring : public testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        int rc;
+
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv), 0);
+        rc = pldm_transport_io_uring_init(&ctx, sv[0],
+                                          PLDM_TRANSPORT_IO_URING_MCTP_DEMUX);
+        if (rc == -ENOSYS || rc == -EPERM)
+        {
+            GTEST_SKIP() << "io_uring is unavailable";
+        }
+        ASSERT_EQ(rc, 0);
+        ASSERT_EQ(pldm_transport_io_uring_map_tid(ctx, 1, 0, 9), 0);
+        ASSERT_EQ(pldm_transport_io_uring_map_tid(ctx, 2, 0, 10), 0);
+        transport = pldm_transport_io_uring_core(ctx);
+    }
+
+    void TearDown() override
+    {
+        pldm_transport_io_uring_destroy(ctx);
+        close(sv[0]);
+        close(sv[1]);
+    }
+
+    /* Send a message to the transport from the endpoint at eid */
+    void inject(uint8_t eid, const std::vector<uint8_t>& msg)
+    {
+        std::vector<uint8_t> frame = {eid, 0x01};
+
+        frame.insert(frame.end(), msg.begin(), msg.end());
+        ASSERT_EQ(write(sv[1], frame.data(), frame.size()),
+                  static_cast<ssize_t>(frame.size()));
+    }
+
+    struct pldm_transport_io_uring* ctx = nullptr;
+    struct pldm_transport* transport = nullptr;
+    int sv[2] = {-1, -1};
+};
+
+TEST_F(IoUring, send)
+{
+    uint8_t req[] = {0x80, 0x00, 0x04};
+    uint8_t frame[8];
+
+    ASSERT_EQ(pldm_transport_send_msg(transport, 1, req, sizeof(req)),
+              PLDM_REQUESTER_SUCCESS);
+    ASSERT_EQ(read(sv[1], frame, sizeof(frame)), 2 + sizeof(req));
+    EXPECT_EQ(frame[0], 9);
+    EXPECT_EQ(frame[1], 0x01);
+    EXPECT_EQ(memcmp(&frame[2], req, sizeof(req)), 0);
+
+    /* Unmapped TIDs can't be reached */
+    EXPECT_EQ(pldm_transport_send_msg(transport, 3, req, sizeof(req)),
+              PLDM_REQUESTER_SEND_FAIL);
+}
+
+TEST_F(IoUring, pollAndRecv)
+{
+    std::vector<uint8_t> resp = {0x00, 0x00, 0x04, 0x00};
+    pldm_tid_t tid = 0;
+    size_t len = 0;
+    void* msg = nullptr;
+
+    EXPECT_EQ(pldm_transport_poll(transport, 0), 0);
+
+    inject(10, resp);
+    ASSERT_EQ(pldm_transport_poll(transport, 1000), 1);
+    ASSERT_EQ(pldm_transport_recv_msg(transport, &tid, &msg, &len),
+              PLDM_REQUESTER_SUCCESS);
+    EXPECT_EQ(tid, 2);
+    ASSERT_EQ(len, resp.size());
+    EXPECT_EQ(memcmp(msg, resp.data(), len), 0);
+    free(msg);
+
+    /* Messages from unmapped endpoints are rejected */
+    inject(11, resp);
+    ASSERT_EQ(pldm_transport_poll(transport, 1000), 1);
+    EXPECT_EQ(pldm_transport_recv_msg(transport, &tid, &msg, &len),
+              PLDM_REQUESTER_RECV_FAIL);
+    EXPECT_EQ(pldm_transport_poll(transport, 0), 0);
+}
+
+TEST_F(IoUring, batches)
+{
+    uint8_t reqs[3][3] = {
+        {0x80, 0x00, 0x04}, {0x81, 0x00, 0x04}, {0x82, 0x00, 0x04}};
+    struct pldm_transport_msg msgs[3] = {};
+    uint8_t bufs[3][8];
+    uint8_t frame[8];
+    size_t i;
+
+    for (i = 0; i < ARRAY_SIZE(msgs); i++)
+    {
+        msgs[i].tid = 1 + (i & 1);
+        msgs[i].msg = reqs[i];
+        msgs[i].len = sizeof(reqs[i]);
+    }
+    ASSERT_EQ(pldm_transport_send_msgs(transport, msgs, ARRAY_SIZE(msgs)), 3);
+    for (i = 0; i < ARRAY_SIZE(msgs); i++)
+    {
+        ASSERT_EQ(read(sv[1], frame, sizeof(frame)), 2 + sizeof(reqs[i]));
+        EXPECT_EQ(frame[0], 9 + (i & 1));
+        EXPECT_EQ(frame[2], reqs[i][0]);
+    }
+
+    for (i = 0; i < ARRAY_SIZE(reqs); i++)
+    {
+        inject(9, {static_cast<uint8_t>(i), 0x00, 0x04, 0x00});
+    }
+    for (i = 0; i < ARRAY_SIZE(msgs); i++)
+    {
+        msgs[i].msg = bufs[i];
+        msgs[i].len = sizeof(bufs[i]);
+    }
+    ASSERT_EQ(pldm_transport_recv_msgs(transport, msgs, ARRAY_SIZE(msgs)), 3);
+    for (i = 0; i < ARRAY_SIZE(msgs); i++)
+    {
+        EXPECT_EQ(msgs[i].rc, PLDM_REQUESTER_SUCCESS);
+        EXPECT_EQ(msgs[i].tid, 1);
+        EXPECT_EQ(msgs[i].len, 4);
+        EXPECT_EQ(bufs[i][0], i);
+    }
+}
+
+static void record(void* data, pldm_tid_t, const void* msg, size_t)
+{
+    auto* iids = static_cast<std::vector<uint8_t>*>(data);
+
+    iids->push_back(*static_cast<const uint8_t*>(msg));
+}
+
+TEST_F(IoUring, processExhaustsBuffers)
+{
+    /* More messages than the transport has receive buffers */
+    static constexpr int count = 40;
+    std::vector<uint8_t> iids;
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        inject(9, {static_cast<uint8_t>(i), 0x00, 0x04, 0x00});
+    }
+
+    while (iids.size() < count)
+    {
+        ASSERT_EQ(pldm_transport_poll(transport, 1000), 1);
+        ASSERT_GE(pldm_transport_io_uring_process(ctx, record, &iids), 0);
+    }
+
+    /* Messages are delivered once each, in order */
+    ASSERT_EQ(iids.size(), count);
+    for (i = 0; i < count; i++)
+    {
+        EXPECT_EQ(iids[i], i);
+    }
+}
+
+TEST(IoUringInit, badArgs)
+{
+    struct pldm_transport_io_uring* ctx = nullptr;
+
+    EXPECT_EQ(pldm_transport_io_uring_init(
+                  nullptr, 0, PLDM_TRANSPORT_IO_URING_MCTP_DEMUX),
+              -EINVAL);
+    EXPECT_EQ(pldm_transport_io_uring_init(&ctx, -1,
+                                           PLDM_TRANSPORT_IO_URING_MCTP_DEMUX),
+              -EINVAL);
+    EXPECT_EQ(pldm_transport_io_uring_process(nullptr, record, nullptr),
+              -EINVAL);
+}
+#endif
@@ -0,0 +1,155 @@
+#include <libpldm/base.h>
+#include <libpldm/transport.h>
+#include <libpldm/transport/mctp-demux.h>
+
+#include "transport/transport.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#ifdef LIBPLDM_API_TESTING
+/* Stands in for mctp-demux-daemon on its abstract socket */
+class MctpDemux : public testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        static const char path[] = "\0mctp-mux";
+        struct sockaddr_un addr = {};
+        uint8_t type;
+
+        listener = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        ASSERT_GE(listener, 0);
+        addr.sun_family = AF_UNIX;
+        memcpy(addr.sun_path, path, sizeof(path) - 1);
+        if (bind(listener, reinterpret_cast<struct sockaddr*>(&addr),
+                 sizeof(addr.sun_family) + sizeof(path) - 1))
+        {
+            GTEST_SKIP() << "mctp-demux-daemon's socket is in use";
+        }
+        ASSERT_EQ(listen(listener, 1), 0);
+
+        ASSERT_EQ(pldm_transport_mctp_demux_init(&demux), 0);
+        peer = accept(listener, nullptr, nullptr);
+        ASSERT_GE(peer, 0);
+        ASSERT_EQ(read(peer, &type, sizeof(type)), 1);
+        ASSERT_EQ(pldm_transport_mctp_demux_map_tid(demux, 1, 9), 0);
+        transport = pldm_transport_mctp_demux_core(demux);
+    }
+
+    void TearDown() override
+    {
+        pldm_transport_mctp_demux_destroy(demux);
+        if (peer >= 0)
+        {
+            close(peer);
+        }
+        close(listener);
+    }
+
+    pldm_requester_rc_t send(uint32_t seq)
+    {
+        std::vector<uint8_t> msg(1024);
+
+        msg[0] = 0x80;
+        memcpy(&msg[3], &seq, sizeof(seq));
+
+        return pldm_transport_send_msg(transport, 1, msg.data(), msg.size());
+    }
+
+    /* Send until the socket is full, returning the number sent */
+    uint32_t fill()
+    {
+        uint32_t seq;
+
+        for (seq = 0; seq < 100000; seq++)
+        {
+            EXPECT_EQ(send(seq), PLDM_REQUESTER_SUCCESS);
+            if (pldm_transport_flush(transport) > 0)
+            {
+                return seq + 1;
+            }
+        }
+
+        ADD_FAILURE() << "The socket never filled";
+        return seq;
+    }
+
+    struct pldm_transport_mctp_demux* demux = nullptr;
+    struct pldm_transport* transport = nullptr;
+    int listener = -1;
+    int peer = -1;
+};
+
+TEST_F(MctpDemux, sendQueue)
+{
+    struct pollfd pollfd;
+    uint8_t frame[2048];
+    uint32_t received;
+    uint32_t total;
+    uint32_t seq;
+    ssize_t len;
+    int i;
+
+    ASSERT_EQ(pldm_transport_mctp_demux_set_send_queue(demux, 16), 0);
+    total = fill();
+    for (i = 0; i < 15; i++)
+    {
+        ASSERT_EQ(send(total++), PLDM_REQUESTER_SUCCESS);
+    }
+    EXPECT_EQ(pldm_transport_flush(transport), 16);
+
+    /* Backpressure, rather than blocking */
+    EXPECT_EQ(send(total), PLDM_REQUESTER_SEND_FAIL);
+    EXPECT_EQ(pldm_transport_mctp_demux_set_send_queue(demux, 0), -EBUSY);
+
+    /*
+     * The queued messages are wanted on POLLOUT. The public init_pollfd API
+     * needs PLDM_HAS_POLL, so ask the transport directly.
+     */
+    ASSERT_EQ(transport->init_pollfd(transport, &pollfd), 0);
+    EXPECT_TRUE(pollfd.events & POLLOUT);
+
+    /* Each is delivered once, in order, as the daemon drains the socket */
+    for (received = 0; received < total;)
+    {
+        len = recv(peer, frame, sizeof(frame), MSG_DONTWAIT);
+        if (len < 0)
+        {
+            ASSERT_EQ(errno, EAGAIN);
+            ASSERT_EQ(pldm_transport_poll(transport, 10), 0);
+            continue;
+        }
+
+        ASSERT_EQ(len, 2 + 1024);
+        EXPECT_EQ(frame[0], 9);
+        memcpy(&seq, &frame[2 + 3], sizeof(seq));
+        ASSERT_EQ(seq, received);
+        received++;
+    }
+
+    EXPECT_EQ(pldm_transport_flush(transport), 0);
+    ASSERT_EQ(transport->init_pollfd(transport, &pollfd), 0);
+    EXPECT_FALSE(pollfd.events & POLLOUT);
+    EXPECT_EQ(pldm_transport_mctp_demux_set_send_queue(demux, 0), 0);
+    EXPECT_EQ(send(0), PLDM_REQUESTER_SUCCESS);
+}
+
+TEST_F(MctpDemux, sendQueueDestroy)
+{
+    /* Messages still queued are freed with the transport */
+    ASSERT_EQ(pldm_transport_mctp_demux_set_send_queue(demux, 4), 0);
+    fill();
+    EXPECT_EQ(send(0), PLDM_REQUESTER_SUCCESS);
+    EXPECT_EQ(pldm_transport_flush(transport), 2);
+}
+#endif
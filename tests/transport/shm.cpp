@@ -0,0 +1,382 @@
+#include <libpldm/base.h>
+#include <libpldm/transport.h>
+#include <libpldm/transport/shm.h>
+
+#include "array.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#ifdef LIBPLDM_API_TESTING
+class Shm : public testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        ASSERT_EQ(pldm_transport_shm_region_create(&region, 4, 8, 64), 0);
+        ASSERT_EQ(pldm_transport_shm_init(&a, region, 1), 0);
+        ASSERT_EQ(pldm_transport_shm_init(&b, region, 2), 0);
+    }
+
+    void TearDown() override
+    {
+        pldm_transport_shm_destroy(a);
+        pldm_transport_shm_destroy(b);
+        pldm_transport_shm_region_destroy(region);
+    }
+
+    struct pldm_transport_shm_region* region = nullptr;
+    struct pldm_transport_shm* a = nullptr;
+    struct pldm_transport_shm* b = nullptr;
+};
+
+TEST_F(Shm, pingPong)
+{
+    uint8_t req[] = {0x80, 0x00, 0x04};
+    uint8_t resp[] = {0x00, 0x00, 0x04, 0x00};
+    struct pldm_transport* ta = pldm_transport_shm_core(a);
+    struct pldm_transport* tb = pldm_transport_shm_core(b);
+    pldm_tid_t tid = 0;
+    size_t len = 0;
+    void* msg = nullptr;
+
+    EXPECT_EQ(pldm_transport_poll(tb, 0), 0);
+    EXPECT_EQ(pldm_transport_recv_msg(tb, &tid, &msg, &len),
+              PLDM_REQUESTER_RECV_FAIL);
+
+    ASSERT_EQ(pldm_transport_send_msg(ta, 2, req, sizeof(req)),
+              PLDM_REQUESTER_SUCCESS);
+    ASSERT_EQ(pldm_transport_poll(tb, 1000), 1);
+    ASSERT_EQ(pldm_transport_recv_msg(tb, &tid, &msg, &len),
+              PLDM_REQUESTER_SUCCESS);
+    EXPECT_EQ(tid, 1);
+    ASSERT_EQ(len, sizeof(req));
+    EXPECT_EQ(memcmp(msg, req, len), 0);
+    free(msg);
+
+    /* Drained, so the endpoint waits for the next message */
+    EXPECT_EQ(pldm_transport_recv_msg(tb, &tid, &msg, &len),
+              PLDM_REQUESTER_RECV_FAIL);
+    EXPECT_EQ(pldm_transport_poll(tb, 0), 0);
+
+    ASSERT_EQ(pldm_transport_send_msg(tb, 1, resp, sizeof(resp)),
+              PLDM_REQUESTER_SUCCESS);
+    ASSERT_EQ(pldm_transport_poll(ta, 1000), 1);
+    ASSERT_EQ(pldm_transport_recv_msg(ta, &tid, &msg, &len),
+              PLDM_REQUESTER_SUCCESS);
+    EXPECT_EQ(tid, 2);
+    ASSERT_EQ(len, sizeof(resp));
+    EXPECT_EQ(memcmp(msg, resp, len), 0);
+    free(msg);
+}
+
+TEST_F(Shm, sendFailures)
+{
+    struct pldm_transport* ta = pldm_transport_shm_core(a);
+    uint8_t big[65] = {0x80, 0x00, 0x04};
+    uint8_t req[] = {0x80, 0x00, 0x04, 0x00};
+    uint8_t buf[4];
+    pldm_tid_t tid = 0;
+    size_t len;
+    int i;
+
+    /* Unattached TIDs can't be reached */
+    EXPECT_EQ(pldm_transport_send_msg(ta, 3, req, sizeof(req)),
+              PLDM_REQUESTER_SEND_FAIL);
+    EXPECT_EQ(pldm_transport_send_msg(ta, 2, big, sizeof(big)),
+              PLDM_REQUESTER_SEND_FAIL);
+
+    /* The inbox holds eight messages */
+    for (i = 0; i < 8; i++)
+    {
+        req[0] = 0x80 | i;
+        ASSERT_EQ(pldm_transport_send_msg(ta, 2, req, sizeof(req)),
+                  PLDM_REQUESTER_SUCCESS);
+    }
+    EXPECT_EQ(pldm_transport_send_msg(ta, 2, req, sizeof(req)),
+              PLDM_REQUESTER_SEND_FAIL);
+
+    /* A short buffer loses the message, freeing its slot */
+    len = 3;
+    EXPECT_EQ(pldm_transport_recv_msg_into(pldm_transport_shm_core(b), &tid,
+                                           buf, &len),
+              PLDM_REQUESTER_RECV_TRUNCATED);
+    EXPECT_EQ(len, sizeof(req));
+    EXPECT_EQ(pldm_transport_send_msg(ta, 2, req, sizeof(req)),
+              PLDM_REQUESTER_SUCCESS);
+
+    len = sizeof(buf);
+    ASSERT_EQ(pldm_transport_recv_msg_into(pldm_transport_shm_core(b), &tid,
+                                           buf, &len),
+              PLDM_REQUESTER_SUCCESS);
+    EXPECT_EQ(buf[0], 0x81);
+}
+
+TEST_F(Shm, oversizedLength)
+{
+    struct pldm_transport* ta = pldm_transport_shm_core(a);
+    struct pldm_transport* tb = pldm_transport_shm_core(b);
+    int eventfds[PLDM_TRANSPORT_SHM_MAX_ENDPOINTS];
+    uint8_t req[37] = {0x80, 0x00, 0x04};
+    uint8_t buf[64];
+    pldm_tid_t tid = 0;
+    struct stat st;
+    void* msg;
+    size_t len;
+    int memfd;
+
+    for (size_t i = 3; i < sizeof(req); i++)
+    {
+        req[i] = 0xc0 + i;
+    }
+    ASSERT_EQ(pldm_transport_send_msg(ta, 2, req, sizeof(req)),
+              PLDM_REQUESTER_SUCCESS);
+    ASSERT_EQ(pldm_transport_send_msg(ta, 2, req, sizeof(req)),
+              PLDM_REQUESTER_SUCCESS);
+
+    /* Act as a faulty peer, overwriting the length in the slot header just
+     * before each message */
+    ASSERT_EQ(pldm_transport_shm_region_fds(region, &memfd, eventfds,
+                                            ARRAY_SIZE(eventfds)),
+              4);
+    ASSERT_EQ(fstat(memfd, &st), 0);
+    void* base =
+        mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    ASSERT_NE(base, MAP_FAILED);
+    auto* mem = static_cast<uint8_t*>(base);
+    int corrupted = 0;
+    for (size_t i = 16; i + sizeof(req) <= (size_t)st.st_size; i += 4)
+    {
+        if (memcmp(mem + i, req, sizeof(req)))
+        {
+            continue;
+        }
+        for (size_t j = i - 16; j < i; j += 4)
+        {
+            uint32_t field;
+            memcpy(&field, mem + j, sizeof(field));
+            if (field == sizeof(req))
+            {
+                field = 0x10000;
+                memcpy(mem + j, &field, sizeof(field));
+                corrupted++;
+                break;
+            }
+        }
+    }
+    munmap(base, st.st_size);
+    ASSERT_EQ(corrupted, 2);
+
+    /* Both receive paths drop the message and free its slot */
+    EXPECT_EQ(pldm_transport_recv_msg(tb, &tid, &msg, &len),
+              PLDM_REQUESTER_RECV_FAIL);
+    len = sizeof(buf);
+    EXPECT_EQ(pldm_transport_recv_msg_into(tb, &tid, buf, &len),
+              PLDM_REQUESTER_RECV_FAIL);
+
+    ASSERT_EQ(pldm_transport_send_msg(ta, 2, req, 3),
+              PLDM_REQUESTER_SUCCESS);
+    len = sizeof(buf);
+    ASSERT_EQ(pldm_transport_recv_msg_into(tb, &tid, buf, &len),
+              PLDM_REQUESTER_SUCCESS);
+    EXPECT_EQ(len, 3);
+    EXPECT_EQ(tid, 1);
+}
+
+TEST_F(Shm, batches)
+{
+    uint8_t reqs[3][3] = {
+        {0x80, 0x00, 0x04}, {0x81, 0x00, 0x04}, {0x82, 0x00, 0x04}};
+    struct pldm_transport_msg msgs[3] = {};
+    uint8_t bufs[3][8];
+    size_t i;
+
+    for (i = 0; i < ARRAY_SIZE(msgs); i++)
+    {
+        msgs[i].tid = 2;
+        msgs[i].msg = reqs[i];
+        msgs[i].len = sizeof(reqs[i]);
+    }
+    ASSERT_EQ(pldm_transport_send_msgs(pldm_transport_shm_core(a), msgs,
+                                       ARRAY_SIZE(msgs)),
+              3);
+
+    ASSERT_EQ(pldm_transport_poll(pldm_transport_shm_core(b), 1000), 1);
+    for (i = 0; i < ARRAY_SIZE(msgs); i++)
+    {
+        msgs[i].msg = bufs[i];
+        msgs[i].len = sizeof(bufs[i]);
+    }
+    ASSERT_EQ(pldm_transport_recv_msgs(pldm_transport_shm_core(b), msgs,
+                                       ARRAY_SIZE(msgs)),
+              3);
+    for (i = 0; i < ARRAY_SIZE(msgs); i++)
+    {
+        EXPECT_EQ(msgs[i].rc, PLDM_REQUESTER_SUCCESS);
+        EXPECT_EQ(msgs[i].tid, 1);
+        EXPECT_EQ(msgs[i].len, 3);
+        EXPECT_EQ(bufs[i][0], reqs[i][0]);
+    }
+
+    /* Readiness persists until the inbox is seen empty */
+    msgs[0].len = sizeof(bufs[0]);
+    EXPECT_EQ(pldm_transport_recv_msgs(pldm_transport_shm_core(b), msgs, 1),
+              PLDM_REQUESTER_RECV_FAIL);
+    EXPECT_EQ(pldm_transport_poll(pldm_transport_shm_core(b), 0), 0);
+}
+
+TEST_F(Shm, multipleProducers)
+{
+    static constexpr int producers = 2;
+    static constexpr int count = 1000;
+    struct pldm_transport_shm* c = nullptr;
+    std::vector<std::thread> threads;
+    int next[producers] = {};
+    int received = 0;
+    int i;
+
+    ASSERT_EQ(pldm_transport_shm_init(&c, region, 3), 0);
+
+    /* TIDs 1 and 2 send numbered requests to TID 3 */
+    for (i = 0; i < producers; i++)
+    {
+        struct pldm_transport* t = pldm_transport_shm_core(i ? b : a);
+
+        threads.emplace_back([t] {
+            uint8_t req[5] = {0x80, 0x00, 0x04};
+            uint16_t n;
+
+            for (n = 0; n < count;)
+            {
+                memcpy(&req[3], &n, sizeof(n));
+                if (pldm_transport_send_msg(t, 3, req, sizeof(req)) ==
+                    PLDM_REQUESTER_SUCCESS)
+                {
+                    n++;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    /* Each producer's messages arrive in the order they were sent */
+    while (received < producers * count)
+    {
+        uint8_t buf[8];
+        pldm_tid_t tid;
+        size_t len = sizeof(buf);
+        uint16_t n;
+
+        if (pldm_transport_recv_msg_into(pldm_transport_shm_core(c), &tid, buf,
+                                         &len) != PLDM_REQUESTER_SUCCESS)
+        {
+            ASSERT_EQ(pldm_transport_poll(pldm_transport_shm_core(c), 5000),
+                      1);
+            continue;
+        }
+
+        ASSERT_TRUE(tid == 1 || tid == 2);
+        ASSERT_EQ(len, 5);
+        memcpy(&n, &buf[3], sizeof(n));
+        EXPECT_EQ(n, next[tid - 1]);
+        next[tid - 1] = n + 1;
+        received++;
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    pldm_transport_shm_destroy(c);
+}
+
+TEST_F(Shm, attach)
+{
+    struct pldm_transport_shm* c = nullptr;
+    struct pldm_transport_shm* d = nullptr;
+    struct pldm_transport_shm* e = nullptr;
+    uint8_t req[] = {0x80, 0x00, 0x04};
+
+    EXPECT_EQ(pldm_transport_shm_init(&c, region, 1), -EEXIST);
+    EXPECT_EQ(pldm_transport_shm_init(&c, region, 0), -EINVAL);
+    ASSERT_EQ(pldm_transport_shm_init(&c, region, 3), 0);
+    ASSERT_EQ(pldm_transport_shm_init(&d, region, 4), 0);
+    EXPECT_EQ(pldm_transport_shm_init(&e, region, 5), -ENOSPC);
+
+    /* A new endpoint doesn't see what was sent to the last one */
+    ASSERT_EQ(pldm_transport_send_msg(pldm_transport_shm_core(a), 4, req,
+                                      sizeof(req)),
+              PLDM_REQUESTER_SUCCESS);
+    pldm_transport_shm_destroy(d);
+    EXPECT_EQ(pldm_transport_send_msg(pldm_transport_shm_core(a), 4, req,
+                                      sizeof(req)),
+              PLDM_REQUESTER_SEND_FAIL);
+    ASSERT_EQ(pldm_transport_shm_init(&e, region, 5), 0);
+
+    EXPECT_EQ(pldm_transport_poll(pldm_transport_shm_core(e), 0), 0);
+
+    pldm_transport_shm_destroy(e);
+    pldm_transport_shm_destroy(c);
+}
+
+TEST_F(Shm, open)
+{
+    struct pldm_transport_shm_region* other = nullptr;
+    struct pldm_transport_shm* c = nullptr;
+    uint8_t req[] = {0x80, 0x00, 0x04};
+    int eventfds[PLDM_TRANSPORT_SHM_MAX_ENDPOINTS];
+    pldm_tid_t tid = 0;
+    uint8_t buf[4];
+    size_t len = sizeof(buf);
+    int memfd;
+
+    ASSERT_EQ(pldm_transport_shm_region_fds(region, &memfd, eventfds,
+                                            ARRAY_SIZE(eventfds)),
+              4);
+    EXPECT_EQ(pldm_transport_shm_region_open(&other, memfd, eventfds, 3),
+              -EINVAL);
+    ASSERT_EQ(pldm_transport_shm_region_open(&other, memfd, eventfds, 4), 0);
+
+    /* Endpoints attached through either mapping reach each other */
+    ASSERT_EQ(pldm_transport_shm_init(&c, other, 3), 0);
+    ASSERT_EQ(pldm_transport_send_msg(pldm_transport_shm_core(c), 1, req,
+                                      sizeof(req)),
+              PLDM_REQUESTER_SUCCESS);
+    ASSERT_EQ(pldm_transport_recv_msg_into(pldm_transport_shm_core(a), &tid,
+                                           buf, &len),
+              PLDM_REQUESTER_SUCCESS);
+    EXPECT_EQ(tid, 3);
+    EXPECT_EQ(len, sizeof(req));
+
+    pldm_transport_shm_destroy(c);
+    pldm_transport_shm_region_destroy(other);
+}
+
+TEST(ShmRegion, badArgs)
+{
+    struct pldm_transport_shm_region* region = nullptr;
+
+    EXPECT_EQ(pldm_transport_shm_region_create(nullptr, 2, 8, 64), -EINVAL);
+    EXPECT_EQ(pldm_transport_shm_region_create(&region, 0, 8, 64), -EINVAL);
+    EXPECT_EQ(pldm_transport_shm_region_create(
+                  &region, PLDM_TRANSPORT_SHM_MAX_ENDPOINTS + 1, 8, 64),
+              -EINVAL);
+    EXPECT_EQ(pldm_transport_shm_region_create(&region, 2, 6, 64), -EINVAL);
+    EXPECT_EQ(pldm_transport_shm_region_create(&region, 2, 8, 2), -EINVAL);
+    EXPECT_EQ(pldm_transport_shm_region_create(&region, 2, 8, 65537),
+              -EINVAL);
+    EXPECT_EQ(region, nullptr);
+}
+#endif
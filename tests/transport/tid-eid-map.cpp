@@ -0,0 +1,167 @@
+// NOLINTNEXTLINE(bugprone-suspicious-include)
+#include "transport/tid-eid-map.c"
+
+#include <cerrno>
+#include <map>
+#include <random>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+TEST(TidEidMap, mapBothWays)
+{
+    struct pldm_tid_eid_map map;
+    mctp_eid_t eid;
+    pldm_tid_t tid;
+    uint32_t net;
+
+    pldm_tid_eid_map_init(&map);
+    ASSERT_EQ(pldm_tid_eid_map_insert(&map, 1, 0, 9), 0);
+    ASSERT_EQ(pldm_tid_eid_map_get_eid(&map, 1, &net, &eid), 0);
+    EXPECT_EQ(net, 0);
+    EXPECT_EQ(eid, 9);
+    ASSERT_EQ(pldm_tid_eid_map_get_tid(&map, 0, 9, &tid), 0);
+    EXPECT_EQ(tid, 1);
+    EXPECT_EQ(pldm_tid_eid_map_get_tid(&map, 0, 8, &tid), -ENOENT);
+    EXPECT_EQ(pldm_tid_eid_map_get_eid(&map, 2, &net, &eid), -ENOENT);
+}
+
+TEST(TidEidMap, rejectTidZero)
+{
+    struct pldm_tid_eid_map map;
+
+    pldm_tid_eid_map_init(&map);
+    EXPECT_EQ(pldm_tid_eid_map_insert(&map, 0, 0, 9), -EINVAL);
+}
+
+TEST(TidEidMap, remapTid)
+{
+    struct pldm_tid_eid_map map;
+    mctp_eid_t eid;
+    pldm_tid_t tid;
+    uint32_t net;
+
+    pldm_tid_eid_map_init(&map);
+    ASSERT_EQ(pldm_tid_eid_map_insert(&map, 1, 0, 9), 0);
+    ASSERT_EQ(pldm_tid_eid_map_insert(&map, 1, 0, 10), 0);
+    EXPECT_EQ(pldm_tid_eid_map_get_tid(&map, 0, 9, &tid), -ENOENT);
+    ASSERT_EQ(pldm_tid_eid_map_get_eid(&map, 1, &net, &eid), 0);
+    EXPECT_EQ(eid, 10);
+}
+
+TEST(TidEidMap, remapEndpoint)
+{
+    struct pldm_tid_eid_map map;
+    mctp_eid_t eid;
+    pldm_tid_t tid;
+    uint32_t net;
+
+    pldm_tid_eid_map_init(&map);
+    ASSERT_EQ(pldm_tid_eid_map_insert(&map, 1, 0, 9), 0);
+    ASSERT_EQ(pldm_tid_eid_map_insert(&map, 2, 0, 9), 0);
+    EXPECT_EQ(pldm_tid_eid_map_get_eid(&map, 1, &net, &eid), -ENOENT);
+    ASSERT_EQ(pldm_tid_eid_map_get_tid(&map, 0, 9, &tid), 0);
+    EXPECT_EQ(tid, 2);
+}
+
+TEST(TidEidMap, removeChecksTid)
+{
+    struct pldm_tid_eid_map map;
+    pldm_tid_t tid;
+
+    pldm_tid_eid_map_init(&map);
+    ASSERT_EQ(pldm_tid_eid_map_insert(&map, 1, 0, 9), 0);
+    ASSERT_EQ(pldm_tid_eid_map_insert(&map, 2, 0, 10), 0);
+    EXPECT_EQ(pldm_tid_eid_map_remove(&map, 2, 9), -ENOENT);
+    EXPECT_EQ(pldm_tid_eid_map_remove(&map, 3, 9), -ENOENT);
+    ASSERT_EQ(pldm_tid_eid_map_get_tid(&map, 0, 9, &tid), 0);
+    EXPECT_EQ(tid, 1);
+    EXPECT_EQ(pldm_tid_eid_map_remove(&map, 1, 9), 0);
+    EXPECT_EQ(pldm_tid_eid_map_get_tid(&map, 0, 9, &tid), -ENOENT);
+    ASSERT_EQ(pldm_tid_eid_map_get_tid(&map, 0, 10, &tid), 0);
+    EXPECT_EQ(tid, 2);
+}
+
+TEST(TidEidMap, networks)
+{
+    struct pldm_tid_eid_map map;
+    pldm_tid_t tid;
+
+    pldm_tid_eid_map_init(&map);
+    ASSERT_EQ(pldm_tid_eid_map_insert(&map, 1, 1, 9), 0);
+    ASSERT_EQ(pldm_tid_eid_map_insert(&map, 2, 2, 9), 0);
+    ASSERT_EQ(pldm_tid_eid_map_insert(&map, 3, 0, 10), 0);
+
+    ASSERT_EQ(pldm_tid_eid_map_get_tid(&map, 1, 9, &tid), 0);
+    EXPECT_EQ(tid, 1);
+    ASSERT_EQ(pldm_tid_eid_map_get_tid(&map, 2, 9, &tid), 0);
+    EXPECT_EQ(tid, 2);
+    EXPECT_EQ(pldm_tid_eid_map_get_tid(&map, 3, 9, &tid), -ENOENT);
+
+    /* Mappings on any network match messages from every network */
+    ASSERT_EQ(pldm_tid_eid_map_get_tid(&map, 1, 10, &tid), 0);
+    EXPECT_EQ(tid, 3);
+}
+
+TEST(TidEidMap, randomised)
+{
+    std::map<std::pair<uint32_t, mctp_eid_t>, pldm_tid_t> endpoints;
+    std::map<pldm_tid_t, std::pair<uint32_t, mctp_eid_t>> tids;
+    struct pldm_tid_eid_map map;
+    std::mt19937 gen(1);
+    mctp_eid_t eid;
+    pldm_tid_t tid;
+    uint32_t net;
+    int i;
+
+    pldm_tid_eid_map_init(&map);
+    for (i = 0; i < 100000; i++)
+    {
+        pldm_tid_t t = 1 + gen() % 255;
+        mctp_eid_t e = gen() % 256;
+        uint32_t n = gen() % 3;
+
+        if (gen() % 3)
+        {
+            ASSERT_EQ(pldm_tid_eid_map_insert(&map, t, n, e), 0);
+            if (tids.count(t))
+            {
+                endpoints.erase(tids[t]);
+            }
+            if (endpoints.count({n, e}))
+            {
+                tids.erase(endpoints[{n, e}]);
+            }
+            tids[t] = {n, e};
+            endpoints[{n, e}] = t;
+        }
+        else if (tids.count(t))
+        {
+            ASSERT_EQ(pldm_tid_eid_map_remove(&map, t, tids[t].second), 0);
+            endpoints.erase(tids[t]);
+            tids.erase(t);
+        }
+    }
+
+    for (i = 1; i < 256; i++)
+    {
+        int rc = pldm_tid_eid_map_get_eid(&map, i, &net, &eid);
+        if (tids.count(i))
+        {
+            ASSERT_EQ(rc, 0);
+            EXPECT_EQ(net, tids[i].first);
+            EXPECT_EQ(eid, tids[i].second);
+        }
+        else
+        {
+            EXPECT_EQ(rc, -ENOENT);
+        }
+    }
+
+    for (const auto& [ep, t] : endpoints)
+    {
+        ASSERT_EQ(pldm_tid_eid_map_get_tid(&map, ep.first, ep.second, &tid),
+                  0);
+        EXPECT_EQ(tid, t);
+    }
+}
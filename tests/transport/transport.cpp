@@ -3,6 +3,8 @@
 #include "array.h"
 #include "transport/test.h"
 
+#include <cerrno>
+
 #include <gtest/gtest.h>
 
 TEST(Transport, create)
@@ -72,6 +74,220 @@ TEST(Transport, recv_one)
     pldm_transport_test_destroy(test);
 }
 
+#ifdef LIBPLDM_API_TESTING
+TEST(Transport, recv_one_into)
+{
+    uint8_t msg[] = {0x01, 0x00, 0x01, 0x00};
+    const pldm_tid_t src_tid = 1;
+    const struct pldm_transport_test_descriptor seq[] = {
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_RECV,
+            .recv_msg =
+                {
+                    .src = src_tid,
+                    .msg = msg,
+                    .len = sizeof(msg),
+                },
+        },
+    };
+    struct pldm_transport_test* test = NULL;
+    struct pldm_transport* ctx;
+    uint8_t buf[16];
+    size_t len;
+    int rc;
+    pldm_tid_t tid;
+
+    EXPECT_EQ(pldm_transport_test_init(&test, seq, ARRAY_SIZE(seq)), 0);
+    ctx = pldm_transport_test_core(test);
+    len = sizeof(buf);
+    rc = pldm_transport_recv_msg_into(ctx, &tid, buf, &len);
+    EXPECT_EQ(rc, PLDM_REQUESTER_SUCCESS);
+    EXPECT_EQ(len, sizeof(msg));
+    EXPECT_EQ(memcmp(buf, msg, len), 0);
+    EXPECT_EQ(tid, src_tid);
+    pldm_transport_test_destroy(test);
+}
+#endif
+
+#ifdef LIBPLDM_API_TESTING
+TEST(Transport, recv_one_into_truncated)
+{
+    uint8_t msg[] = {0x01, 0x00, 0x01, 0x00, 0xaa, 0xbb};
+    const struct pldm_transport_test_descriptor seq[] = {
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_RECV,
+            .recv_msg =
+                {
+                    .src = 1,
+                    .msg = msg,
+                    .len = sizeof(msg),
+                },
+        },
+    };
+    struct pldm_transport_test* test = NULL;
+    struct pldm_transport* ctx;
+    uint8_t buf[4];
+    size_t len;
+    int rc;
+    pldm_tid_t tid;
+
+    EXPECT_EQ(pldm_transport_test_init(&test, seq, ARRAY_SIZE(seq)), 0);
+    ctx = pldm_transport_test_core(test);
+    len = sizeof(buf);
+    rc = pldm_transport_recv_msg_into(ctx, &tid, buf, &len);
+    EXPECT_EQ(rc, PLDM_REQUESTER_RECV_TRUNCATED);
+    EXPECT_EQ(len, sizeof(msg));
+    EXPECT_EQ(memcmp(buf, msg, sizeof(buf)), 0);
+    pldm_transport_test_destroy(test);
+}
+#endif
+
+#ifdef LIBPLDM_API_TESTING
+TEST(Transport, recv_into_short_buffer)
+{
+    struct pldm_transport_test* test = NULL;
+    struct pldm_transport* ctx;
+    uint8_t buf[2];
+    size_t len;
+    int rc;
+    pldm_tid_t tid;
+
+    EXPECT_EQ(pldm_transport_test_init(&test, NULL, 0), 0);
+    ctx = pldm_transport_test_core(test);
+    len = sizeof(buf);
+    rc = pldm_transport_recv_msg_into(ctx, &tid, buf, &len);
+    EXPECT_EQ(rc, PLDM_REQUESTER_INVALID_SETUP);
+    pldm_transport_test_destroy(test);
+}
+#endif
+
+#ifdef LIBPLDM_API_TESTING
+TEST(Transport, send_msgs)
+{
+    uint8_t msg1[] = {0x81, 0x00, 0x01, 0x01};
+    uint8_t msg2[] = {0x82, 0x00, 0x01, 0x01};
+    const struct pldm_transport_test_descriptor seq[] = {
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_SEND,
+            .send_msg =
+                {
+                    .dst = 1,
+                    .msg = msg1,
+                    .len = sizeof(msg1),
+                },
+        },
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_SEND,
+            .send_msg =
+                {
+                    .dst = 2,
+                    .msg = msg2,
+                    .len = sizeof(msg2),
+                },
+        },
+    };
+    struct pldm_transport_msg msgs[] = {
+        {1, msg1, sizeof(msg1), PLDM_REQUESTER_SEND_FAIL},
+        {2, msg2, sizeof(msg2), PLDM_REQUESTER_SEND_FAIL},
+    };
+    struct pldm_transport_test* test = NULL;
+    struct pldm_transport* ctx;
+    int rc;
+
+    EXPECT_EQ(pldm_transport_test_init(&test, seq, ARRAY_SIZE(seq)), 0);
+    ctx = pldm_transport_test_core(test);
+    rc = pldm_transport_send_msgs(ctx, msgs, ARRAY_SIZE(msgs));
+    EXPECT_EQ(rc, 2);
+    EXPECT_EQ(msgs[0].rc, PLDM_REQUESTER_SUCCESS);
+    EXPECT_EQ(msgs[1].rc, PLDM_REQUESTER_SUCCESS);
+    pldm_transport_test_destroy(test);
+}
+#endif
+
+#ifdef LIBPLDM_API_TESTING
+TEST(Transport, send_msgs_stops_on_failure)
+{
+    uint8_t msg1[] = {0x81, 0x00, 0x01, 0x01};
+    uint8_t msg2[] = {0x82, 0x00, 0x01, 0x01};
+    const struct pldm_transport_test_descriptor seq[] = {
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_SEND,
+            .send_msg =
+                {
+                    .dst = 1,
+                    .msg = msg1,
+                    .len = sizeof(msg1),
+                },
+        },
+    };
+    struct pldm_transport_msg msgs[] = {
+        {1, msg1, sizeof(msg1), PLDM_REQUESTER_SEND_FAIL},
+        {2, msg2, sizeof(msg2), PLDM_REQUESTER_SEND_FAIL},
+    };
+    struct pldm_transport_test* test = NULL;
+    struct pldm_transport* ctx;
+    int rc;
+
+    EXPECT_EQ(pldm_transport_test_init(&test, seq, ARRAY_SIZE(seq)), 0);
+    ctx = pldm_transport_test_core(test);
+    rc = pldm_transport_send_msgs(ctx, msgs, ARRAY_SIZE(msgs));
+    EXPECT_EQ(rc, 1);
+    rc = pldm_transport_send_msgs(ctx, &msgs[1], 1);
+    EXPECT_EQ(rc, PLDM_REQUESTER_SEND_FAIL);
+    pldm_transport_test_destroy(test);
+}
+#endif
+
+#ifdef LIBPLDM_API_TESTING
+TEST(Transport, recv_msgs)
+{
+    uint8_t msg1[] = {0x01, 0x00, 0x01, 0x00};
+    uint8_t msg2[] = {0x02, 0x00, 0x01, 0x00, 0xaa};
+    const struct pldm_transport_test_descriptor seq[] = {
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_RECV,
+            .recv_msg =
+                {
+                    .src = 1,
+                    .msg = msg1,
+                    .len = sizeof(msg1),
+                },
+        },
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_RECV,
+            .recv_msg =
+                {
+                    .src = 2,
+                    .msg = msg2,
+                    .len = sizeof(msg2),
+                },
+        },
+    };
+    uint8_t bufs[3][4];
+    struct pldm_transport_msg msgs[] = {
+        {0, bufs[0], sizeof(bufs[0]), PLDM_REQUESTER_RECV_FAIL},
+        {0, bufs[1], sizeof(bufs[1]), PLDM_REQUESTER_RECV_FAIL},
+        {0, bufs[2], sizeof(bufs[2]), PLDM_REQUESTER_RECV_FAIL},
+    };
+    struct pldm_transport_test* test = NULL;
+    struct pldm_transport* ctx;
+    int rc;
+
+    EXPECT_EQ(pldm_transport_test_init(&test, seq, ARRAY_SIZE(seq)), 0);
+    ctx = pldm_transport_test_core(test);
+    rc = pldm_transport_recv_msgs(ctx, msgs, ARRAY_SIZE(msgs));
+    ASSERT_EQ(rc, 2);
+    EXPECT_EQ(msgs[0].rc, PLDM_REQUESTER_SUCCESS);
+    EXPECT_EQ(msgs[0].tid, 1);
+    EXPECT_EQ(msgs[0].len, sizeof(msg1));
+    EXPECT_EQ(memcmp(bufs[0], msg1, sizeof(msg1)), 0);
+    EXPECT_EQ(msgs[1].rc, PLDM_REQUESTER_RECV_TRUNCATED);
+    EXPECT_EQ(msgs[1].len, sizeof(msg2));
+    EXPECT_EQ(msgs[2].rc, PLDM_REQUESTER_RECV_FAIL);
+    pldm_transport_test_destroy(test);
+}
+#endif
+
 TEST(Transport, send_recv_drain_one_unwanted)
 {
     uint8_t unwanted[] = {0x01, 0x00, 0x01, 0x01};
@@ -171,3 +387,235 @@ TEST(Transport, send_recv_req_echo)
     free(msg);
     pldm_transport_test_destroy(test);
 }
+
+#ifdef LIBPLDM_API_TESTING
+TEST(Transport, stats_send_recv)
+{
+    uint8_t req[] = {0x81, 0x00, 0x01, 0x01};
+    uint8_t echo[] = {0x81, 0x00, 0x01, 0x01};
+    uint8_t resp[] = {0x01, 0x00, 0x01, 0x00};
+    const struct pldm_transport_test_descriptor seq[] = {
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_SEND,
+            .send_msg =
+                {
+                    .dst = 1,
+                    .msg = req,
+                    .len = sizeof(req),
+                },
+        },
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_RECV,
+            .recv_msg =
+                {
+                    .src = 1,
+                    .msg = echo,
+                    .len = sizeof(echo),
+                },
+        },
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_RECV,
+            .recv_msg =
+                {
+                    .src = 1,
+                    .msg = resp,
+                    .len = sizeof(resp),
+                },
+        },
+    };
+    struct pldm_transport_counters counters;
+    struct pldm_transport_latency latency;
+    struct pldm_transport_test* test = NULL;
+    struct pldm_transport* ctx;
+    uint64_t us;
+    size_t len;
+    void* msg;
+    size_t i;
+    int rc;
+
+    EXPECT_EQ(pldm_transport_test_init(&test, seq, ARRAY_SIZE(seq)), 0);
+    ctx = pldm_transport_test_core(test);
+    EXPECT_EQ(pldm_transport_stats_get_counters(ctx, &counters), -ENODATA);
+    ASSERT_EQ(pldm_transport_stats_enable(ctx), 0);
+    ASSERT_EQ(pldm_transport_stats_enable(ctx), 0);
+
+    rc = pldm_transport_send_recv_msg(ctx, 1, req, sizeof(req), &msg, &len);
+    ASSERT_EQ(rc, PLDM_REQUESTER_SUCCESS);
+    free(msg);
+
+    ASSERT_EQ(pldm_transport_stats_get_counters(ctx, &counters), 0);
+    EXPECT_EQ(counters.tx_msgs, 1);
+    EXPECT_EQ(counters.tx_bytes, sizeof(req));
+    EXPECT_EQ(counters.rx_msgs, 2);
+    EXPECT_EQ(counters.rx_bytes, sizeof(echo) + sizeof(resp));
+    EXPECT_EQ(counters.rx_discarded, 1);
+    EXPECT_EQ(counters.timeouts, 0);
+
+    ASSERT_EQ(pldm_transport_stats_get_latency(ctx, 1, 0x00, 0x01, &latency),
+              0);
+    EXPECT_EQ(latency.count, 1);
+    EXPECT_LE(latency.min_us, latency.max_us);
+    for (i = 0; i < PLDM_TRANSPORT_LATENCY_BUCKETS; i++)
+    {
+        if (latency.buckets[i])
+        {
+            break;
+        }
+    }
+    ASSERT_LT(i, PLDM_TRANSPORT_LATENCY_BUCKETS);
+    EXPECT_LE(pldm_transport_latency_bucket_floor(i), latency.max_us);
+    ASSERT_EQ(pldm_transport_latency_percentile(&latency, 99, &us), 0);
+    EXPECT_EQ(us, latency.max_us);
+    EXPECT_EQ(pldm_transport_stats_get_latency(ctx, 1, 0x00, 0x02, &latency),
+              -ENOENT);
+
+    ASSERT_EQ(pldm_transport_stats_reset(ctx), 0);
+    ASSERT_EQ(pldm_transport_stats_get_counters(ctx, &counters), 0);
+    EXPECT_EQ(counters.tx_msgs, 0);
+    EXPECT_EQ(pldm_transport_stats_get_latency(ctx, 1, 0x00, 0x01, &latency),
+              -ENOENT);
+
+    pldm_transport_stats_disable(ctx);
+    EXPECT_EQ(pldm_transport_stats_reset(ctx), -ENODATA);
+    pldm_transport_test_destroy(test);
+}
+#endif
+
+#ifdef LIBPLDM_API_TESTING
+TEST(Transport, stats_latency_buckets)
+{
+    struct pldm_transport_latency latency = {};
+    uint64_t us;
+    size_t i;
+
+    /* Buckets are exact up to 8us, then split each doubling into eight */
+    EXPECT_EQ(pldm_transport_latency_bucket_floor(0), 0);
+    EXPECT_EQ(pldm_transport_latency_bucket_floor(7), 7);
+    EXPECT_EQ(pldm_transport_latency_bucket_floor(8), 8);
+    EXPECT_EQ(pldm_transport_latency_bucket_floor(16), 16);
+    EXPECT_EQ(pldm_transport_latency_bucket_floor(17), 18);
+    for (i = 1; i < PLDM_TRANSPORT_LATENCY_BUCKETS; i++)
+    {
+        EXPECT_GT(pldm_transport_latency_bucket_floor(i),
+                  pldm_transport_latency_bucket_floor(i - 1));
+    }
+
+    EXPECT_EQ(pldm_transport_latency_percentile(&latency, 50, &us), -ENODATA);
+    EXPECT_EQ(pldm_transport_latency_percentile(&latency, 101, &us), -EINVAL);
+
+    /* 90 responses in [16, 18), and 10 in [1024, 1152) */
+    latency.count = 100;
+    latency.max_us = 1100;
+    latency.buckets[16] = 90;
+    latency.buckets[64] = 10;
+    ASSERT_EQ(pldm_transport_latency_percentile(&latency, 50, &us), 0);
+    EXPECT_EQ(us, 17);
+    ASSERT_EQ(pldm_transport_latency_percentile(&latency, 90, &us), 0);
+    EXPECT_EQ(us, 17);
+    ASSERT_EQ(pldm_transport_latency_percentile(&latency, 95, &us), 0);
+    EXPECT_EQ(us, 1100);
+}
+#endif
+
+#ifdef LIBPLDM_API_TESTING
+TEST(Transport, inbox_send_recv)
+{
+    uint8_t unsolicited[] = {0x81, 0x02, 0x0a, 0x00};
+    uint8_t overflow[] = {0x82, 0x02, 0x0a, 0x00};
+    uint8_t req[] = {0x81, 0x00, 0x01, 0x01};
+    uint8_t other[] = {0x01, 0x00, 0x01, 0x00, 0x00};
+    uint8_t resp[] = {0x01, 0x00, 0x01, 0x00};
+    const struct pldm_transport_test_descriptor seq[] = {
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_RECV,
+            .recv_msg =
+                {
+                    .src = 2,
+                    .msg = unsolicited,
+                    .len = sizeof(unsolicited),
+                },
+        },
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_RECV,
+            .recv_msg =
+                {
+                    .src = 2,
+                    .msg = overflow,
+                    .len = sizeof(overflow),
+                },
+        },
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_SEND,
+            .send_msg =
+                {
+                    .dst = 1,
+                    .msg = req,
+                    .len = sizeof(req),
+                },
+        },
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_RECV,
+            .recv_msg =
+                {
+                    .src = 3,
+                    .msg = other,
+                    .len = sizeof(other),
+                },
+        },
+        {
+            .type = PLDM_TRANSPORT_TEST_ELEMENT_MSG_RECV,
+            .recv_msg =
+                {
+                    .src = 1,
+                    .msg = resp,
+                    .len = sizeof(resp),
+                },
+        },
+    };
+    struct pldm_transport_counters counters;
+    struct pldm_transport_test* test = NULL;
+    struct pldm_transport* ctx;
+    size_t len;
+    void* msg;
+    int rc;
+
+    EXPECT_EQ(pldm_transport_test_init(&test, seq, ARRAY_SIZE(seq)), 0);
+    ctx = pldm_transport_test_core(test);
+    EXPECT_EQ(pldm_transport_inbox_enable(ctx, 0), -EINVAL);
+    ASSERT_EQ(pldm_transport_inbox_enable(ctx, 1), 0);
+    ASSERT_EQ(pldm_transport_inbox_enable(ctx, 4), 0);
+    ASSERT_EQ(pldm_transport_stats_enable(ctx), 0);
+
+    rc = pldm_transport_send_recv_msg(ctx, 1, req, sizeof(req), &msg, &len);
+    ASSERT_EQ(rc, PLDM_REQUESTER_SUCCESS);
+    EXPECT_EQ(len, sizeof(resp));
+    EXPECT_EQ(memcmp(msg, resp, len), 0);
+    free(msg);
+
+    /* The inboxes hold one message each, so the second request overflowed */
+    ASSERT_EQ(pldm_transport_stats_get_counters(ctx, &counters), 0);
+    EXPECT_EQ(counters.rx_queued, 2);
+    EXPECT_EQ(counters.rx_discarded, 1);
+
+    EXPECT_EQ(pldm_transport_inbox_pending(ctx, 2, 0x02), 1);
+    EXPECT_EQ(pldm_transport_inbox_pending(ctx, 3, 0x00), 1);
+    EXPECT_EQ(pldm_transport_inbox_pending(ctx, 2, 0x00), 0);
+
+    ASSERT_EQ(pldm_transport_inbox_recv(ctx, 2, 0x02, &msg, &len),
+              PLDM_REQUESTER_SUCCESS);
+    EXPECT_EQ(len, sizeof(unsolicited));
+    EXPECT_EQ(memcmp(msg, unsolicited, len), 0);
+    free(msg);
+    EXPECT_EQ(pldm_transport_inbox_recv(ctx, 2, 0x02, &msg, &len),
+              PLDM_REQUESTER_RECV_FAIL);
+
+    /* Disabling inboxes frees what remains queued */
+    pldm_transport_inbox_disable(ctx);
+    EXPECT_EQ(pldm_transport_inbox_pending(ctx, 3, 0x00), 0);
+    EXPECT_EQ(pldm_transport_inbox_recv(ctx, 3, 0x00, &msg, &len),
+              PLDM_REQUESTER_RECV_FAIL);
+    EXPECT_EQ(pldm_transport_inbox_recv(ctx, 3, 0x00, nullptr, &len),
+              PLDM_REQUESTER_INVALID_SETUP);
+    pldm_transport_test_destroy(test);
+}
+#endif
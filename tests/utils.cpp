@@ -1,6 +1,8 @@
 #include <libpldm/pldm_types.h>
 #include <libpldm/utils.h>
 
+#include <algorithm>
+#include <cerrno>
 #include <cstring>
 #include <vector>
 
@@ -20,6 +22,131 @@ TEST(Crc8, CheckSumTest)
     EXPECT_EQ(checksum, 0xf4);
 }
 
+#ifdef LIBPLDM_API_TESTING
+TEST(Crc32, IncrementalMatchesOneShot)
+{
+    std::vector<uint8_t> data(1000);
+    struct pldm_edac_crc32_ctx ctx;
+    uint32_t crc;
+
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = (i * 131) ^ (i >> 3);
+    }
+
+    ASSERT_EQ(pldm_edac_crc32_init(&ctx), 0);
+    for (size_t off = 0, chunk = 1; off < data.size(); off += chunk, chunk++)
+    {
+        chunk = std::min(chunk, data.size() - off);
+        ASSERT_EQ(pldm_edac_crc32_update(&ctx, &data[off], chunk), 0);
+    }
+    ASSERT_EQ(pldm_edac_crc32_final(&ctx, &crc), 0);
+    EXPECT_EQ(crc, pldm_edac_crc32(data.data(), data.size()));
+}
+
+TEST(Crc32, IncrementalEmpty)
+{
+    struct pldm_edac_crc32_ctx ctx;
+    uint32_t crc;
+
+    ASSERT_EQ(pldm_edac_crc32_init(&ctx), 0);
+    EXPECT_EQ(pldm_edac_crc32_update(&ctx, nullptr, 0), 0);
+    ASSERT_EQ(pldm_edac_crc32_final(&ctx, &crc), 0);
+    EXPECT_EQ(crc, 0u);
+}
+
+TEST(Crc32, IncrementalBadArgs)
+{
+    struct pldm_edac_crc32_ctx ctx;
+    uint32_t crc;
+
+    EXPECT_EQ(pldm_edac_crc32_init(nullptr), -EINVAL);
+    ASSERT_EQ(pldm_edac_crc32_init(&ctx), 0);
+    EXPECT_EQ(pldm_edac_crc32_update(nullptr, "a", 1), -EINVAL);
+    EXPECT_EQ(pldm_edac_crc32_update(&ctx, nullptr, 1), -EINVAL);
+    EXPECT_EQ(pldm_edac_crc32_final(nullptr, &crc), -EINVAL);
+    EXPECT_EQ(pldm_edac_crc32_final(&ctx, nullptr), -EINVAL);
+}
+
+TEST(Crc32, Combine)
+{
+    const char* data = "123456789";
+
+    for (size_t split = 0; split <= 9; split++)
+    {
+        uint32_t crc1 = pldm_edac_crc32(data, split);
+        uint32_t crc2 = pldm_edac_crc32(data + split, 9 - split);
+        EXPECT_EQ(pldm_edac_crc32_combine(crc1, crc2, 9 - split), 0xcbf43926)
+            << "split " << split;
+    }
+}
+
+TEST(Crc32, CombineLarge)
+{
+    std::vector<uint8_t> data(3 * 65536 + 17);
+
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = i * 7;
+    }
+
+    size_t split = data.size() / 3;
+    uint32_t crc1 = pldm_edac_crc32(data.data(), split);
+    uint32_t crc2 = pldm_edac_crc32(&data[split], data.size() - split);
+    EXPECT_EQ(pldm_edac_crc32_combine(crc1, crc2, data.size() - split),
+              pldm_edac_crc32(data.data(), data.size()));
+}
+#endif
+
+#ifdef LIBPLDM_API_TESTING
+TEST(Crc8, IncrementalMatchesOneShot)
+{
+    const char* data = "123456789";
+    struct pldm_edac_crc8_ctx ctx;
+    uint8_t crc;
+
+    ASSERT_EQ(pldm_edac_crc8_init(&ctx), 0);
+    ASSERT_EQ(pldm_edac_crc8_update(&ctx, data, 4), 0);
+    ASSERT_EQ(pldm_edac_crc8_update(&ctx, data + 4, 0), 0);
+    ASSERT_EQ(pldm_edac_crc8_update(&ctx, data + 4, 5), 0);
+    ASSERT_EQ(pldm_edac_crc8_final(&ctx, &crc), 0);
+    EXPECT_EQ(crc, 0xf4);
+}
+
+TEST(Crc8, IncrementalBadArgs)
+{
+    struct pldm_edac_crc8_ctx ctx;
+    uint8_t crc;
+
+    EXPECT_EQ(pldm_edac_crc8_init(nullptr), -EINVAL);
+    ASSERT_EQ(pldm_edac_crc8_init(&ctx), 0);
+    EXPECT_EQ(pldm_edac_crc8_update(nullptr, "a", 1), -EINVAL);
+    EXPECT_EQ(pldm_edac_crc8_update(&ctx, nullptr, 1), -EINVAL);
+    EXPECT_EQ(pldm_edac_crc8_final(nullptr, &crc), -EINVAL);
+    EXPECT_EQ(pldm_edac_crc8_final(&ctx, nullptr), -EINVAL);
+}
+
+TEST(Crc8, Combine)
+{
+    std::vector<uint8_t> data(777);
+
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = (i * 13) ^ 0xa5;
+    }
+
+    for (size_t split = 0; split <= data.size(); split += 37)
+    {
+        uint8_t crc1 = pldm_edac_crc8(data.data(), split);
+        uint8_t crc2 =
+            pldm_edac_crc8(data.data() + split, data.size() - split);
+        EXPECT_EQ(pldm_edac_crc8_combine(crc1, crc2, data.size() - split),
+                  pldm_edac_crc8(data.data(), data.size()))
+            << "split " << split;
+    }
+}
+#endif
+
 TEST(Ver2string, Ver2string)
 {
     ver32_t version{0x61, 0x10, 0xf7, 0xf3};